@@ -16,11 +16,27 @@ struct AVLTree_Node
     int32_t height;
 };
 
+// A chunk of consecutive nodes that a pooled tree hands out one after the other
+typedef struct AVLTree_Chunk
+{
+    struct AVLTree_Chunk *next;
+    size_t used;
+    size_t capacity;
+    struct AVLTree_Node nodes[];
+} AVLTree_Chunk_t;
+
 struct AVLTree
 {
     struct AVLTree_Node *root;
     avl_tree_node_comparator cmp;
     int32_t count;
+    uint8_t is_pooled; // Whether the nodes come from the chunks below instead of malloc
+    AVLTree_Chunk_t *chunks; // The chunks of a pooled tree, in the order in which they are used
+    AVLTree_Chunk_t *chunk; // The chunk that new nodes are taken from
+    struct AVLTree_Node *free_nodes; // The released nodes of a pooled tree, linked through their left child
+#ifdef VORONOI_STATS
+    uint64_t rotations; // The number of rotations performed so far
+#endif
 };
 
 
@@ -53,9 +69,104 @@ AVLTree_ptr_t avl_tree_new(avl_tree_node_comparator cmp)
     tree->cmp = cmp;
     tree->root = NULL;
     tree->count = 0;
+    tree->is_pooled = 0;
+    tree->chunks = tree->chunk = NULL;
+    tree->free_nodes = NULL;
+#ifdef VORONOI_STATS
+    tree->rotations = 0;
+#endif
+    return tree;
+}
+
+/**
+ * Allocates memory for a balanced binary search tree whose nodes are kept in a pool.
+ * The nodes are carved out of large chunks in the order in which they are allocated, and released nodes are reused
+ * last in, first out. Nodes that are created together, e.g. the subtree that replaces a leaf, therefore share cache
+ * lines, and the pool is recycled as a whole when the tree is cleared.
+ * Nodes of a pooled tree must be created with avl_tree_node_alloc and released with avl_tree_node_release.
+ *
+ * @param cmp the comparator function to be used when traversing the tree
+ * @return a tree handle
+ */
+AVLTree_ptr_t avl_tree_new_pooled(avl_tree_node_comparator cmp)
+{
+    AVLTree_ptr_t tree = avl_tree_new(cmp);
+    if (NULL == tree) return NULL;
+    tree->is_pooled = 1;
     return tree;
 }
 
+/**
+ * Allocates a node holding some data for the tree, from its pool if it has one
+ *
+ * @param self the tree handle
+ * @param data the data that the tree node will hold
+ * @return a handle to the node, NULL if the memory could not be allocated
+ */
+AVLTree_Node_ptr_t avl_tree_node_alloc(AVLTree_ptr_t self, void *data)
+{
+    if (! self->is_pooled) return avl_tree_node_new(data);
+    AVLTree_Node_ptr_t node = self->free_nodes;
+    if (node)
+    {
+        self->free_nodes = node->left;
+    }
+    else
+    {
+        if (! self->chunk || self->chunk->used == self->chunk->capacity)
+        {
+            AVLTree_Chunk_t *next = self->chunk ? self->chunk->next : self->chunks;
+            if (! next)
+            {
+                // Grow geometrically, so that a small tree stays small and a large one needs few chunks
+                size_t capacity = self->chunk ? 2 * self->chunk->capacity : 256;
+                capacity = capacity < 65536 ? capacity : 65536;
+                next = malloc(sizeof(AVLTree_Chunk_t) + capacity * sizeof(AVLTree_Node_t));
+                if (NULL == next) return NULL;
+                next->next = NULL;
+                next->capacity = capacity;
+                if (self->chunk)
+                {
+                    self->chunk->next = next;
+                }
+                else
+                {
+                    self->chunks = next;
+                }
+            }
+            next->used = 0;
+            self->chunk = next;
+        }
+        node = &self->chunk->nodes[self->chunk->used++];
+    }
+    node->left = node->right = node->parent = NULL;
+    node->data = data;
+    node->height = 0;
+    return node;
+}
+
+/**
+ * Deallocates the node and its children, or returns them to the pool of the tree
+ *
+ * @param self the tree handle
+ * @param node the node
+ */
+void avl_tree_node_release(AVLTree_ptr_t self, AVLTree_Node_ptr_t node)
+{
+    if (! self->is_pooled)
+    {
+        avl_tree_node_destroy(node);
+        return;
+    }
+    if (node)
+    {
+        avl_tree_node_release(self, node->left);
+        avl_tree_node_release(self, node->right);
+        node->left = self->free_nodes;
+        self->free_nodes = node;
+    }
+}
+
 /**
  * Deallocates the memory for the given node
  * This function also deallocates the memory of the node's children
@@ -87,7 +198,16 @@ void avl_tree_destroy(AVLTree_ptr_t self)
 {
     if (self)
     {
-        if (self->root)
+        if (self->is_pooled)
+        {
+            while (self->chunks)
+            {
+                AVLTree_Chunk_t *next = self->chunks->next;
+                free(self->chunks);
+                self->chunks = next;
+            }
+        }
+        else if (self->root)
         {
             avl_tree_node_destroy(self->root);
         }
@@ -96,6 +216,27 @@ void avl_tree_destroy(AVLTree_ptr_t self)
 }
 
 
+/**
+ * Makes parent point to replacement instead of child
+ *
+ * @param parent the parent node, can be NULL
+ * @param child the current child of the parent
+ * @param replacement the new child of the parent
+ */
+static void avl_tree_node_replace_child(AVLTree_Node_ptr_t parent, AVLTree_Node_ptr_t child,
+                                        AVLTree_Node_ptr_t replacement)
+{
+    if (! parent) return;
+    if (parent->left == child)
+    {
+        parent->left = replacement;
+    }
+    else if (parent->right == child)
+    {
+        parent->right = replacement;
+    }
+}
+
 /**
  * Performs a left rotation of a subtree given a starting position
  *
@@ -112,7 +253,12 @@ static AVLTree_Node_ptr_t avl_tree_node_rotate_left(AVLTree_Node_ptr_t node)
 {
     AVLTree_Node_ptr_t median = node->right;
     node->right = median->left;
+    if (node->right)
+    {
+        node->right->parent = node;
+    }
     median->left = node;
+    avl_tree_node_replace_child(node->parent, node, median);
     median->parent = node->parent;
     node->parent = median;
     return median;
@@ -134,7 +280,12 @@ static AVLTree_Node_ptr_t avl_tree_node_rotate_right(AVLTree_Node_ptr_t node)
 {
     AVLTree_Node_ptr_t median = node->left;
     node->left = median->right;
+    if (node->left)
+    {
+        node->left->parent = node;
+    }
     median->right = node;
+    avl_tree_node_replace_child(node->parent, node, median);
     median->parent = node->parent;
     node->parent = median;
     return median;
@@ -230,10 +381,12 @@ static AVLTree_Node_ptr_t avl_tree_node_balance(AVLTree_ptr_t self, AVLTree_Node
         if (left_left_height > left_right_height)
         {
             current = avl_tree_node_rotate_right(current);
+            VORONOI_STATS_ADD(self->rotations, 1);
         }
         else
         {
             current = avl_tree_node_rotate_left_right(current);
+            VORONOI_STATS_ADD(self->rotations, 2);
         }
         avl_tree_node_update_height(current->left);
         avl_tree_node_update_height(current->right);
@@ -245,11 +398,15 @@ static AVLTree_Node_ptr_t avl_tree_node_balance(AVLTree_ptr_t self, AVLTree_Node
         if (right_left_height > right_right_height)
         {
             current = avl_tree_node_rotate_right_left(current);
+            VORONOI_STATS_ADD(self->rotations, 2);
         }
         else
         {
             current = avl_tree_node_rotate_left(current);
+            VORONOI_STATS_ADD(self->rotations, 1);
         }
+        avl_tree_node_update_height(current->left);
+        avl_tree_node_update_height(current->right);
     }
     avl_tree_node_update_height(current);
     // Readjust the root pointer
@@ -290,7 +447,7 @@ static void avl_tree_add_node(AVLTree_ptr_t self, AVLTree_Node_ptr_t current, vo
     {
         if (! current->left)
         {
-            current->left = avl_tree_node_new(data);
+            current->left = avl_tree_node_alloc(self, data);
             current->left->parent = current;
             self->count++;
         }
@@ -304,7 +461,7 @@ static void avl_tree_add_node(AVLTree_ptr_t self, AVLTree_Node_ptr_t current, vo
     {
         if (! current->right)
         {
-            current->right = avl_tree_node_new(data);
+            current->right = avl_tree_node_alloc(self, data);
             current->right->parent = current;
             self->count++;
         }
@@ -316,6 +473,28 @@ static void avl_tree_add_node(AVLTree_ptr_t self, AVLTree_Node_ptr_t current, vo
     }
 }
 
+/**
+ * Removes all nodes from the tree, such that it can be filled again.
+ * The data held by the nodes is not deallocated
+ *
+ * @param self the tree handle
+ */
+void avl_tree_clear(AVLTree_ptr_t self)
+{
+    if (self->is_pooled)
+    {
+        // Start over with the first chunk instead of releasing node by node
+        self->chunk = NULL;
+        self->free_nodes = NULL;
+    }
+    else
+    {
+        avl_tree_node_destroy(self->root);
+    }
+    self->root = NULL;
+    self->count = 0;
+}
+
 /**
  * Inserts the data into the tree
  *
@@ -328,7 +507,7 @@ void avl_tree_insert(AVLTree_ptr_t self, void *data)
     if (! data) return;
     if (! self->root)
     {
-        self->root = avl_tree_node_new(data);
+        self->root = avl_tree_node_alloc(self, data);
         self->count++;
         return;
     }
@@ -376,7 +555,7 @@ static AVLTree_Node_ptr_t avl_tree_node_remove(AVLTree_ptr_t self, AVLTree_Node_
             self->root = NULL;
         }
         self->count--;
-        avl_tree_node_destroy(current);
+        avl_tree_node_release(self, current);
         return NULL;
     }
 
@@ -404,8 +583,8 @@ static AVLTree_Node_ptr_t avl_tree_node_remove(AVLTree_ptr_t self, AVLTree_Node_
             current->right = avl_tree_node_remove(self, current->right, successor->data);
         }
     }
-    avl_tree_balance(self, current);
-    return current;
+    // Only balance this level. The callers further up the recursion take care of their own levels.
+    return avl_tree_node_balance(self, current);
 }
 
 /**
@@ -450,8 +629,8 @@ AVLTree_Node_ptr_t avl_tree_find(AVLTree_ptr_t self, void *data)
 }
 
 /**
- * Replaces the node with a subtree
- * The node must be a leaf node for this to work
+ * Replaces the node with a subtree and rebalances the tree
+ * The node must be a leaf node for this to work. It is detached from the tree, but not deallocated.
  *
  * @param self the tree handle
  * @param node the node to replace
@@ -478,13 +657,151 @@ avl_tree_replace_leaf_node(AVLTree_ptr_t self, AVLTree_Node_ptr_t node, AVLTree_
     {
         self->root = replacement;
     }
+    // The subtree can be higher than the leaf it replaces, so restore the balance all the way up to the root
     if (replacement)
     {
-        avl_tree_node_update_height(replacement);
+        avl_tree_balance(self, replacement);
     }
     else if (node->parent)
     {
-        avl_tree_node_update_height(node->parent);
+        avl_tree_balance(self, node->parent);
     }
+    node->parent = NULL;
     return self->root;
-}
\ No newline at end of file
+}
+
+/**
+ * Removes the leaf node together with its parent. The sibling of the leaf node takes the place of the parent.
+ * This is the reverse of replacing a leaf with a subtree of three nodes.
+ * Both nodes are deallocated.
+ *
+ * @param self the tree handle
+ * @param node the leaf node to remove
+ * @return the data of the removed parent, NULL if the node was the root
+ */
+void *avl_tree_remove_leaf_node(AVLTree_ptr_t self, AVLTree_Node_ptr_t node)
+{
+    if (! avl_tree_node_is_leaf(node)) return NULL;
+    AVLTree_Node_ptr_t parent = node->parent;
+    if (! parent)
+    {
+        self->root = NULL;
+        avl_tree_node_release(self, node);
+        return NULL;
+    }
+    AVLTree_Node_ptr_t sibling = parent->left == node ? parent->right : parent->left;
+    AVLTree_Node_ptr_t grandparent = parent->parent;
+    avl_tree_node_replace_child(grandparent, parent, sibling);
+    if (sibling)
+    {
+        sibling->parent = grandparent;
+    }
+    if (! grandparent)
+    {
+        self->root = sibling;
+    }
+    void *data = parent->data;
+    parent->left = parent->right = NULL;
+    avl_tree_node_release(self, node);
+    avl_tree_node_release(self, parent);
+    if (grandparent)
+    {
+        avl_tree_balance(self, grandparent);
+    }
+    return data;
+}
+
+/**
+ * Allocates a node for the tree holding some data and the two given subtrees
+ *
+ * @param self the tree handle
+ * @param data the data that the tree node will hold
+ * @param left the left subtree, can be NULL
+ * @param right the right subtree, can be NULL
+ * @return a handle to the node
+ */
+AVLTree_Node_ptr_t
+avl_tree_node_join(AVLTree_ptr_t self, void *data, AVLTree_Node_ptr_t left, AVLTree_Node_ptr_t right)
+{
+    AVLTree_Node_ptr_t node = avl_tree_node_alloc(self, data);
+    if (NULL == node) return NULL;
+    node->left = left;
+    node->right = right;
+    if (left)
+    {
+        left->parent = node;
+    }
+    if (right)
+    {
+        right->parent = node;
+    }
+    avl_tree_node_update_height(node);
+    return node;
+}
+
+/**
+ * Yields the root node of the tree
+ *
+ * @param self the tree handle
+ * @return the root node, NULL if the tree is empty
+ */
+AVLTree_Node_ptr_t avl_tree_root(AVLTree_ptr_t self)
+{
+    return self->root;
+}
+
+/**
+ * Yields the data held by the node
+ *
+ * @param node the node
+ * @return its data
+ */
+void *avl_tree_node_data(AVLTree_Node_ptr_t node)
+{
+    return node->data;
+}
+
+/**
+ * Yields the left child of the node
+ *
+ * @param node the node
+ * @return the left child, NULL if there is none
+ */
+AVLTree_Node_ptr_t avl_tree_node_left(AVLTree_Node_ptr_t node)
+{
+    return node->left;
+}
+
+/**
+ * Yields the right child of the node
+ *
+ * @param node the node
+ * @return the right child, NULL if there is none
+ */
+AVLTree_Node_ptr_t avl_tree_node_right(AVLTree_Node_ptr_t node)
+{
+    return node->right;
+}
+
+#ifdef VORONOI_STATS
+/**
+ * Yields the number of rotations performed to balance the tree since it was created
+ *
+ * @param self the tree handle
+ * @return the number of rotations
+ */
+uint64_t avl_tree_rotations(AVLTree_ptr_t self)
+{
+    return self->rotations;
+}
+
+/**
+ * Yields the size of a tree node
+ *
+ * @return the size in bytes
+ */
+size_t avl_tree_node_size()
+{
+    return sizeof(AVLTree_Node_t);
+}
+#endif
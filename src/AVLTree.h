@@ -4,6 +4,9 @@
 
 #ifndef VORONOI_AVLTREE_H
 #define VORONOI_AVLTREE_H
+#include <stddef.h>
+#include <stdint.h>
+#include "VoronoiStats.h"
 
 typedef struct AVLTree_Node AVLTree_Node_t;
 typedef AVLTree_Node_t* AVLTree_Node_ptr_t;
@@ -53,6 +56,35 @@ int32_t avl_tree_node_height(AVLTree_Node_ptr_t node);
  */
 AVLTree_ptr_t avl_tree_new(avl_tree_node_comparator cmp);
 
+/**
+ * Allocates memory for a balanced binary search tree whose nodes are kept in a pool.
+ * The nodes are carved out of large chunks in the order in which they are allocated, and released nodes are reused
+ * last in, first out. Nodes that are created together, e.g. the subtree that replaces a leaf, therefore share cache
+ * lines, and the pool is recycled as a whole when the tree is cleared.
+ * Nodes of a pooled tree must be created with avl_tree_node_alloc and released with avl_tree_node_release.
+ *
+ * @param cmp the comparator function to be used when traversing the tree
+ * @return a tree handle
+ */
+AVLTree_ptr_t avl_tree_new_pooled(avl_tree_node_comparator cmp);
+
+/**
+ * Allocates a node holding some data for the tree, from its pool if it has one
+ *
+ * @param self the tree handle
+ * @param data the data that the tree node will hold
+ * @return a handle to the node, NULL if the memory could not be allocated
+ */
+AVLTree_Node_ptr_t avl_tree_node_alloc(AVLTree_ptr_t self, void *data);
+
+/**
+ * Deallocates the node and its children, or returns them to the pool of the tree
+ *
+ * @param self the tree handle
+ * @param node the node
+ */
+void avl_tree_node_release(AVLTree_ptr_t self, AVLTree_Node_ptr_t node);
+
 /**
  * Deallocates the memory used by self
  *
@@ -60,6 +92,14 @@ AVLTree_ptr_t avl_tree_new(avl_tree_node_comparator cmp);
  */
 void avl_tree_destroy(AVLTree_ptr_t self);
 
+/**
+ * Removes all nodes from the tree, such that it can be filled again.
+ * The data held by the nodes is not deallocated
+ *
+ * @param self the tree handle
+ */
+void avl_tree_clear(AVLTree_ptr_t self);
+
 /**
  * Inserts the data into the tree
  *
@@ -86,8 +126,8 @@ AVLTree_Node_ptr_t avl_tree_remove(AVLTree_ptr_t self, void *data);
 AVLTree_Node_ptr_t avl_tree_find(AVLTree_ptr_t self, void *data);
 
 /**
- * Replaces the node with a subtree
- * The node must be a leaf node for this to work
+ * Replaces the node with a subtree and rebalances the tree
+ * The node must be a leaf node for this to work. It is detached from the tree, but not deallocated.
  *
  * @param self the tree handle
  * @param node the node to replace
@@ -97,4 +137,76 @@ AVLTree_Node_ptr_t avl_tree_find(AVLTree_ptr_t self, void *data);
 AVLTree_Node_ptr_t
 avl_tree_replace_leaf_node(AVLTree_ptr_t self, AVLTree_Node_ptr_t node, AVLTree_Node_ptr_t replacement);
 
+/**
+ * Removes the leaf node together with its parent. The sibling of the leaf node takes the place of the parent.
+ * This is the reverse of replacing a leaf with a subtree of three nodes.
+ * Both nodes are deallocated.
+ *
+ * @param self the tree handle
+ * @param node the leaf node to remove
+ * @return the data of the removed parent, NULL if the node was the root
+ */
+void *avl_tree_remove_leaf_node(AVLTree_ptr_t self, AVLTree_Node_ptr_t node);
+
+/**
+ * Allocates a node for the tree holding some data and the two given subtrees
+ *
+ * @param self the tree handle
+ * @param data the data that the tree node will hold
+ * @param left the left subtree, can be NULL
+ * @param right the right subtree, can be NULL
+ * @return a handle to the node
+ */
+AVLTree_Node_ptr_t
+avl_tree_node_join(AVLTree_ptr_t self, void *data, AVLTree_Node_ptr_t left, AVLTree_Node_ptr_t right);
+
+/**
+ * Yields the root node of the tree
+ *
+ * @param self the tree handle
+ * @return the root node, NULL if the tree is empty
+ */
+AVLTree_Node_ptr_t avl_tree_root(AVLTree_ptr_t self);
+
+/**
+ * Yields the data held by the node
+ *
+ * @param node the node
+ * @return its data
+ */
+void *avl_tree_node_data(AVLTree_Node_ptr_t node);
+
+/**
+ * Yields the left child of the node
+ *
+ * @param node the node
+ * @return the left child, NULL if there is none
+ */
+AVLTree_Node_ptr_t avl_tree_node_left(AVLTree_Node_ptr_t node);
+
+/**
+ * Yields the right child of the node
+ *
+ * @param node the node
+ * @return the right child, NULL if there is none
+ */
+AVLTree_Node_ptr_t avl_tree_node_right(AVLTree_Node_ptr_t node);
+
+#ifdef VORONOI_STATS
+/**
+ * Yields the number of rotations performed to balance the tree since it was created
+ *
+ * @param self the tree handle
+ * @return the number of rotations
+ */
+uint64_t avl_tree_rotations(AVLTree_ptr_t self);
+
+/**
+ * Yields the size of a tree node
+ *
+ * @return the size in bytes
+ */
+size_t avl_tree_node_size();
+#endif
+
 #endif //VORONOI_AVLTREE_H
@@ -0,0 +1,231 @@
+//
+// Micro-benchmarks for the balanced tree under the access patterns of the beach line
+//
+// Usage: voronoi_avl_tree_bench [--size elements] [--seed seed]
+//
+// Prints one JSON record per workload and operation, see bench_report.
+//
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "AVLTree.c"
+#include "Bench.c"
+
+static uint64_t comparisons = 0;
+
+static uint64_t random_state;
+
+static uint64_t random_next(uint64_t bound)
+{
+    random_state = random_state * 6364136223846793005ULL + 1442695040888963407ULL;
+    return (random_state >> 33) % bound;
+}
+
+static int8_t comparator(void *first, void *second)
+{
+    comparisons++;
+    uint64_t first_key = *(uint64_t *) first;
+    uint64_t second_key = *(uint64_t *) second;
+    if (first_key > second_key) return 1;
+    else if (first_key < second_key) return -1;
+    else return 0;
+}
+
+/**
+ * Measures the operations between two calls
+ */
+typedef struct {
+    double start;
+    Bench_Counter_t counter;
+    uint8_t is_pooled; // Whether the trees under test keep their nodes in a pool
+} Bench_Measure_t;
+
+static void measure_start(Bench_Measure_t *measure)
+{
+    comparisons = 0;
+    bench_counter_start(&measure->counter);
+    measure->start = bench_now();
+}
+
+static void measure_stop(Bench_Measure_t *measure, const char *workload, size_t size, size_t operations)
+{
+    double elapsed = bench_now() - measure->start;
+    int64_t cache_misses = bench_counter_stop(&measure->counter);
+    bench_report(measure->is_pooled ? "avl_tree_pooled" : "avl_tree", workload, size, operations, elapsed, comparisons, cache_misses);
+}
+
+/**
+ * Keys that arrive and leave in ascending order
+ */
+static void bench_monotone(Bench_Measure_t *measure, uint64_t *keys, size_t size)
+{
+    AVLTree_ptr_t tree = measure->is_pooled ? avl_tree_new_pooled(comparator) : avl_tree_new(comparator);
+    for (size_t i = 0; i < size; i++)
+    {
+        keys[i] = i;
+    }
+    measure_start(measure);
+    for (size_t i = 0; i < size; i++)
+    {
+        avl_tree_insert(tree, &keys[i]);
+    }
+    measure_stop(measure, "monotone_insert", size, size);
+    measure_start(measure);
+    for (size_t i = 0; i < size; i++)
+    {
+        avl_tree_find(tree, &keys[i]);
+    }
+    measure_stop(measure, "monotone_find", size, size);
+    measure_start(measure);
+    for (size_t i = 0; i < size; i++)
+    {
+        avl_tree_remove(tree, &keys[i]);
+    }
+    measure_stop(measure, "monotone_remove", size, size);
+    avl_tree_destroy(tree);
+}
+
+/**
+ * A sliding window: the smallest key is removed and a new largest key is inserted
+ */
+static void bench_near_min(Bench_Measure_t *measure, uint64_t *keys, size_t size)
+{
+    AVLTree_ptr_t tree = measure->is_pooled ? avl_tree_new_pooled(comparator) : avl_tree_new(comparator);
+    for (size_t i = 0; i < 2 * size; i++)
+    {
+        keys[i] = i;
+    }
+    for (size_t i = 0; i < size; i++)
+    {
+        avl_tree_insert(tree, &keys[i]);
+    }
+    measure_start(measure);
+    for (size_t i = 0; i < size; i++)
+    {
+        avl_tree_remove(tree, &keys[i]);
+        avl_tree_insert(tree, &keys[size + i]);
+    }
+    measure_stop(measure, "near_min_remove_insert", size, 2 * size);
+    avl_tree_destroy(tree);
+}
+
+/**
+ * Like the arcs around a new site, short runs of neighbouring keys are looked up, removed and inserted again
+ */
+static void bench_localised(Bench_Measure_t *measure, uint64_t *keys, size_t size)
+{
+    AVLTree_ptr_t tree = measure->is_pooled ? avl_tree_new_pooled(comparator) : avl_tree_new(comparator);
+    // Insert in random order, the upper half of the array holds the order
+    uint64_t *order = &keys[size];
+    for (size_t i = 0; i < size; i++)
+    {
+        keys[i] = order[i] = i;
+    }
+    for (size_t i = size; i > 1; i--)
+    {
+        size_t j = random_next(i);
+        uint64_t index = order[i - 1];
+        order[i - 1] = order[j];
+        order[j] = index;
+    }
+    for (size_t i = 0; i < size; i++)
+    {
+        avl_tree_insert(tree, &keys[order[i]]);
+    }
+
+    size_t run = size < 16 ? size : 16;
+    size_t rounds = size / run;
+    measure_start(measure);
+    for (size_t r = 0; r < rounds; r++)
+    {
+        size_t start = random_next(size - run + 1);
+        for (size_t i = start; i < start + run; i++)
+        {
+            avl_tree_find(tree, &keys[i]);
+        }
+        for (size_t i = start; i < start + run; i++)
+        {
+            avl_tree_remove(tree, &keys[i]);
+        }
+        for (size_t i = start; i < start + run; i++)
+        {
+            avl_tree_insert(tree, &keys[i]);
+        }
+    }
+    measure_stop(measure, "localised_find_remove_insert", size, 3 * rounds * run);
+    avl_tree_destroy(tree);
+}
+
+/**
+ * Lookups of random keys in a tree that was filled in random order, like the locates of new sites on the beach line
+ */
+static void bench_random_find(Bench_Measure_t *measure, uint64_t *keys, size_t size)
+{
+    AVLTree_ptr_t tree = measure->is_pooled ? avl_tree_new_pooled(comparator) : avl_tree_new(comparator);
+    uint64_t *order = &keys[size];
+    for (size_t i = 0; i < size; i++)
+    {
+        keys[i] = order[i] = i;
+    }
+    for (size_t i = size; i > 1; i--)
+    {
+        size_t j = random_next(i);
+        uint64_t index = order[i - 1];
+        order[i - 1] = order[j];
+        order[j] = index;
+    }
+    for (size_t i = 0; i < size; i++)
+    {
+        avl_tree_insert(tree, &keys[order[i]]);
+    }
+    measure_start(measure);
+    for (size_t i = 0; i < size; i++)
+    {
+        avl_tree_find(tree, &keys[random_next(size)]);
+    }
+    measure_stop(measure, "random_find", size, size);
+    avl_tree_destroy(tree);
+}
+
+int main(int argc, char *argv[])
+{
+    size_t size = 1000000;
+    random_state = 1;
+    for (int i = 1; i + 1 < argc; i += 2)
+    {
+        if (0 == strcmp(argv[i], "--size")) size = strtoull(argv[i + 1], NULL, 10);
+        else if (0 == strcmp(argv[i], "--seed")) random_state = strtoull(argv[i + 1], NULL, 10);
+        else
+        {
+            fprintf(stderr, "voronoi_avl_tree_bench: unknown option %s\n", argv[i]);
+            return EXIT_FAILURE;
+        }
+    }
+    if (0 == size)
+    {
+        size = 1;
+    }
+    uint64_t *keys = malloc(2 * size * sizeof(uint64_t));
+    if (NULL == keys)
+    {
+        fprintf(stderr, "voronoi_avl_tree_bench: not enough memory for %zu elements\n", size);
+        return EXIT_FAILURE;
+    }
+
+    Bench_Measure_t measure;
+    bench_counter_open(&measure.counter);
+    // Every workload runs on a tree with nodes from malloc and on a pooled tree
+    for (uint8_t is_pooled = 0; is_pooled < 2; is_pooled++)
+    {
+        measure.is_pooled = is_pooled;
+        bench_monotone(&measure, keys, size);
+        bench_near_min(&measure, keys, size);
+        bench_localised(&measure, keys, size);
+        bench_random_find(&measure, keys, size);
+    }
+    bench_counter_close(&measure.counter);
+    free(keys);
+    return EXIT_SUCCESS;
+}
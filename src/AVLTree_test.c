@@ -195,6 +195,104 @@ void test_tree_remove_deep()
     avl_tree_destroy(tree);
 }
 
+void test_tree_replace_and_remove_leaf()
+{
+    // Init
+    AVLTree_t *tree = avl_tree_new(comparator);
+    int32_t values[7] = {10, 15, 20, 25, 30, 35, 40};
+    avl_tree_insert(tree, (void *) &values[0]);
+
+    // Execute: grow the tree to the right by repeatedly splitting the rightmost leaf
+    for (size_t i = 1; i < 7; i += 2)
+    {
+        AVLTree_Node_ptr_t leaf = tree->root;
+        while (leaf->right)
+        {
+            leaf = leaf->right;
+        }
+        AVLTree_Node_ptr_t replacement = avl_tree_node_join(tree, &values[i], avl_tree_node_alloc(tree, leaf->data),
+                                                            avl_tree_node_alloc(tree, &values[i + 1]));
+        avl_tree_replace_leaf_node(tree, leaf, replacement);
+        avl_tree_node_release(tree, leaf);
+    }
+
+    // Assert: the splits are rebalanced
+    assert(*(int32_t *) tree->root->data == 25);
+    assert(avl_tree_node_height(tree->root) == 2);
+    assert(tree->root->left->parent == tree->root);
+    assert(tree->root->right->parent == tree->root);
+
+    // Execute: collapse the leftmost leaf with its parent
+    AVLTree_Node_ptr_t leaf = tree->root;
+    while (leaf->left)
+    {
+        leaf = leaf->left;
+    }
+    assert(*(int32_t *) avl_tree_remove_leaf_node(tree, leaf) == 15);
+
+    // Assert
+    assert(*(int32_t *) tree->root->left->data == 20);
+    assert(avl_tree_node_is_leaf(tree->root->left));
+    assert(tree->root->left->parent == tree->root);
+
+    avl_tree_destroy(tree);
+}
+
+/**
+ * Checks that the tree holds the values from first to last in order
+ */
+static void assert_in_order(AVLTree_Node_ptr_t node, int32_t **next)
+{
+    if (! node) return;
+    assert(! node->left || node->left->parent == node);
+    assert(! node->right || node->right->parent == node);
+    assert_in_order(node->left, next);
+    assert(node->data == *next);
+    (*next)++;
+    assert_in_order(node->right, next);
+}
+
+void test_tree_pooled()
+{
+    // Init
+    AVLTree_t *tree = avl_tree_new_pooled(comparator);
+    int32_t values[1000];
+    for (int32_t i = 0; i < 1000; i++)
+    {
+        values[i] = i;
+    }
+
+    // Execute: fill the pool beyond its first chunk, empty it again, then fill it with every other value
+    for (size_t round = 0; round < 2; round++)
+    {
+        for (size_t i = 0; i < 1000; i++)
+        {
+            avl_tree_insert(tree, &values[(i * 7) % 1000]);
+        }
+        for (size_t i = 0; i < 1000; i += 2)
+        {
+            avl_tree_remove(tree, &values[i]);
+        }
+        AVLTree_Chunk_t *chunk = tree->chunk;
+        for (size_t i = 0; i < 1000; i += 2)
+        {
+            avl_tree_insert(tree, &values[i]);
+        }
+
+        // Assert: the released nodes are reused and the tree stays ordered and balanced
+        assert(tree->chunk == chunk);
+        assert(tree->count == 1000);
+        assert(avl_tree_node_height(tree->root) < 15);
+        int32_t *next = &values[0];
+        assert_in_order(tree->root, &next);
+        assert(next == &values[1000]);
+        avl_tree_clear(tree);
+        assert(tree->root == NULL);
+    }
+
+    avl_tree_destroy(tree);
+}
+
 int main(int argc, char *argv[])
 {
     test_node_rotate_left();
@@ -204,4 +302,6 @@ int main(int argc, char *argv[])
     test_tree_insert();
     test_tree_insert_deep();
     test_tree_remove_deep();
+    test_tree_replace_and_remove_leaf();
+    test_tree_pooled();
 }
\ No newline at end of file
@@ -0,0 +1,135 @@
+//
+// Timers and hardware counters shared by the benchmarks
+//
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <sys/resource.h>
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+#include "Bench.h"
+
+/**
+ * Reads the monotonic clock
+ *
+ * @return the current time in nanoseconds
+ */
+double bench_now()
+{
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return (double) time.tv_sec * 1e9 + (double) time.tv_nsec;
+}
+
+/**
+ * Yields the peak resident set size of the process
+ *
+ * @return the size in kilobytes
+ */
+long bench_peak_rss()
+{
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;
+}
+
+/**
+ * Opens a counter of the cache misses of the calling thread
+ *
+ * @param self the counter handle
+ */
+void bench_counter_open(Bench_Counter_t *self)
+{
+    self->fd = -1;
+#ifdef __linux__
+    struct perf_event_attr attributes;
+    memset(&attributes, 0, sizeof(attributes));
+    attributes.type = PERF_TYPE_HARDWARE;
+    attributes.size = sizeof(attributes);
+    attributes.config = PERF_COUNT_HW_CACHE_MISSES;
+    attributes.disabled = 1;
+    attributes.exclude_kernel = 1;
+    attributes.exclude_hv = 1;
+    self->fd = (int) syscall(SYS_perf_event_open, &attributes, 0, -1, -1, 0);
+#endif
+}
+
+/**
+ * Resets the counter and starts counting
+ *
+ * @param self the counter handle
+ */
+void bench_counter_start(Bench_Counter_t *self)
+{
+#ifdef __linux__
+    if (self->fd < 0) return;
+    ioctl(self->fd, PERF_EVENT_IOC_RESET, 0);
+    ioctl(self->fd, PERF_EVENT_IOC_ENABLE, 0);
+#endif
+}
+
+/**
+ * Stops counting
+ *
+ * @param self the counter handle
+ * @return the number of events since the start, -1 if the counter is unavailable
+ */
+int64_t bench_counter_stop(Bench_Counter_t *self)
+{
+#ifdef __linux__
+    if (self->fd < 0) return -1;
+    ioctl(self->fd, PERF_EVENT_IOC_DISABLE, 0);
+    uint64_t value;
+    if (read(self->fd, &value, sizeof(value)) != sizeof(value)) return -1;
+    return (int64_t) value;
+#else
+    return -1;
+#endif
+}
+
+/**
+ * Closes the counter
+ *
+ * @param self the counter handle
+ */
+void bench_counter_close(Bench_Counter_t *self)
+{
+#ifdef __linux__
+    if (self->fd >= 0) close(self->fd);
+#endif
+    self->fd = -1;
+}
+
+/**
+ * Prints the JSON record of a micro-benchmark
+ *
+ * @param structure the name of the data structure
+ * @param workload the name of the workload
+ * @param size the number of elements held by the structure
+ * @param operations the number of operations performed
+ * @param elapsed the time taken in nanoseconds
+ * @param comparisons the number of comparator calls
+ * @param cache_misses the number of cache misses, -1 if they were not counted
+ */
+void bench_report(const char *structure, const char *workload, size_t size, size_t operations, double elapsed,
+                  uint64_t comparisons, int64_t cache_misses)
+{
+    printf("{\"structure\": \"%s\", \"workload\": \"%s\", \"size\": %zu, \"operations\": %zu, "
+           "\"ops_per_second\": %.0f, \"comparisons_per_op\": %.2f, ",
+           structure, workload, size, operations, (double) operations / elapsed * 1e9,
+           (double) comparisons / (double) operations);
+    if (cache_misses < 0)
+    {
+        printf("\"cache_misses_per_op\": null}\n");
+    }
+    else
+    {
+        printf("\"cache_misses_per_op\": %.3f}\n", (double) cache_misses / (double) operations);
+    }
+    fflush(stdout);
+}
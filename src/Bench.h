@@ -0,0 +1,76 @@
+//
+// Timers and hardware counters shared by the benchmarks
+//
+
+#ifndef VORONOI_BENCH_H
+#define VORONOI_BENCH_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * A hardware event counter, e.g. for cache misses. It is unavailable if the platform or the permissions
+ * of the process do not allow to read it, in which case it reads as -1
+ */
+typedef struct {
+    int fd;
+} Bench_Counter_t;
+
+/**
+ * Reads the monotonic clock
+ *
+ * @return the current time in nanoseconds
+ */
+double bench_now();
+
+/**
+ * Yields the peak resident set size of the process
+ *
+ * @return the size in kilobytes
+ */
+long bench_peak_rss();
+
+/**
+ * Opens a counter of the cache misses of the calling thread
+ *
+ * @param self the counter handle
+ */
+void bench_counter_open(Bench_Counter_t *self);
+
+/**
+ * Resets the counter and starts counting
+ *
+ * @param self the counter handle
+ */
+void bench_counter_start(Bench_Counter_t *self);
+
+/**
+ * Stops counting
+ *
+ * @param self the counter handle
+ * @return the number of events since the start, -1 if the counter is unavailable
+ */
+int64_t bench_counter_stop(Bench_Counter_t *self);
+
+/**
+ * Closes the counter
+ *
+ * @param self the counter handle
+ */
+void bench_counter_close(Bench_Counter_t *self);
+
+/**
+ * Prints the JSON record of a micro-benchmark
+ *
+ * @param structure the name of the data structure
+ * @param workload the name of the workload
+ * @param size the number of elements held by the structure
+ * @param operations the number of operations performed
+ * @param elapsed the time taken in nanoseconds
+ * @param comparisons the number of comparator calls
+ * @param cache_misses the number of cache misses, -1 if they were not counted
+ */
+void bench_report(const char *structure, const char *workload, size_t size, size_t operations, double elapsed,
+                  uint64_t comparisons, int64_t cache_misses);
+
+#endif //VORONOI_BENCH_H
@@ -0,0 +1,1094 @@
+//
+// Record storage for the doubly connected edge list
+//
+
+#include <stdlib.h>
+#include <string.h>
+#include "DCEL.h"
+#include "VoronoiTrace.h"
+
+// The smallest number of bytes requested from the allocator for a block of records
+#define DCEL_BLOCK_SIZE 65536
+
+struct DCEL_Block {
+    struct DCEL_Block *next; // The previously allocated block
+    size_t used; // The number of bytes handed out from the block
+    size_t capacity; // The number of bytes the block can hold
+    double data[]; // The records. Declared as double to align them properly
+};
+
+/**
+ * Carves size bytes out of the current block of self, allocating a new block if necessary
+ *
+ * @param self the edge list handle
+ * @param size the number of bytes
+ * @return a pointer to the memory, NULL if it could not be allocated
+ */
+static void *dcel_alloc(DCEL_t *self, size_t size)
+{
+    // Keep every record aligned to the widest member type
+    size = (size + sizeof(double) - 1) & ~(sizeof(double) - 1);
+    struct DCEL_Block *block = self->blocks;
+    if (! block || block->used + size > block->capacity)
+    {
+        size_t capacity = size > DCEL_BLOCK_SIZE ? size : DCEL_BLOCK_SIZE;
+        block = malloc(sizeof(struct DCEL_Block) + capacity);
+        if (NULL == block) return NULL;
+        block->used = 0;
+        block->capacity = capacity;
+        block->next = self->blocks;
+        self->blocks = block;
+    }
+    void *record = (char *) block->data + block->used;
+    block->used += size;
+    return record;
+}
+
+/**
+ * Makes sure that the pointer array can hold at least count elements
+ *
+ * @param array the address of the array
+ * @param capacity the address of the current capacity of the array
+ * @param count the requested number of elements
+ * @return 1 on success, 0 if the memory could not be allocated
+ */
+static uint8_t dcel_grow(void ***array, size_t *capacity, size_t count)
+{
+    if (count <= *capacity) return 1;
+    size_t new_capacity = *capacity ? *capacity : 16;
+    while (new_capacity < count)
+    {
+        new_capacity *= 2;
+    }
+    void **grown = realloc(*array, new_capacity * sizeof(void *));
+    if (NULL == grown) return 0;
+    *array = grown;
+    *capacity = new_capacity;
+    return 1;
+}
+
+/**
+ * Initializes an empty edge list
+ *
+ * @param self the edge list handle
+ */
+void dcel_init(DCEL_t *self)
+{
+    memset(self, 0, sizeof(DCEL_t));
+}
+
+/**
+ * Reserves room for the given number of records, so that they can be created without further reallocations
+ *
+ * @param self the edge list handle
+ * @param vertices the number of vertices
+ * @param half_edges the number of half-edges
+ * @param faces the number of faces
+ * @return 1 on success, 0 if the memory could not be allocated
+ */
+uint8_t dcel_reserve(DCEL_t *self, size_t vertices, size_t half_edges, size_t faces)
+{
+    if (! dcel_grow((void ***) &self->vertices, &self->vertex_capacity, self->vertex_count + vertices)) return 0;
+    if (! dcel_grow((void ***) &self->half_edges, &self->half_edge_capacity, self->half_edge_count + half_edges)) return 0;
+    if (! dcel_grow((void ***) &self->faces, &self->face_capacity, self->face_count + faces)) return 0;
+
+    // Allocate a single block for all records, unless the current one still has enough room
+    size_t bytes = vertices * sizeof(DCEL_Vertex_t) + half_edges * sizeof(DCEL_HalfEdge_t) + faces * sizeof(DCEL_Face_t);
+    struct DCEL_Block *block = self->blocks;
+    if (bytes > 0 && (! block || block->used + bytes > block->capacity))
+    {
+        block = malloc(sizeof(struct DCEL_Block) + bytes);
+        if (NULL == block) return 0;
+        block->used = 0;
+        block->capacity = bytes;
+        block->next = self->blocks;
+        self->blocks = block;
+    }
+    return 1;
+}
+
+/**
+ * Creates a vertex at the given position
+ *
+ * @param self the edge list handle
+ * @param position the position of the vertex
+ * @return a handle to the vertex, NULL if the memory could not be allocated
+ */
+DCEL_Vertex_ptr_t dcel_vertex_new(DCEL_t *self, Point_Real_t position)
+{
+    if (! dcel_grow((void ***) &self->vertices, &self->vertex_capacity, self->vertex_count + 1)) return NULL;
+    DCEL_Vertex_ptr_t vertex = dcel_alloc(self, sizeof(DCEL_Vertex_t));
+    if (NULL == vertex) return NULL;
+    vertex->position = position;
+    vertex->inc_edge = NULL;
+    self->vertices[self->vertex_count++] = vertex;
+    return vertex;
+}
+
+/**
+ * Creates a half-edge on the boundary of face. All links except for the incident face are left empty
+ *
+ * @param self the edge list handle
+ * @param face the incident face
+ * @return a handle to the half-edge, NULL if the memory could not be allocated
+ */
+DCEL_HalfEdge_ptr_t dcel_half_edge_new(DCEL_t *self, DCEL_Face_ptr_t face)
+{
+    if (! dcel_grow((void ***) &self->half_edges, &self->half_edge_capacity, self->half_edge_count + 1)) return NULL;
+    DCEL_HalfEdge_ptr_t half_edge = dcel_alloc(self, sizeof(DCEL_HalfEdge_t));
+    if (NULL == half_edge) return NULL;
+    half_edge->origin = NULL;
+    half_edge->inc_face = face;
+    half_edge->twin = half_edge->next = half_edge->prev = NULL;
+    self->half_edges[self->half_edge_count++] = half_edge;
+    return half_edge;
+}
+
+/**
+ * Creates a face for the cell of the site
+ *
+ * @param self the edge list handle
+ * @param site the site of the cell
+ * @param index the index of the site
+ * @return a handle to the face, NULL if the memory could not be allocated
+ */
+DCEL_Face_ptr_t dcel_face_new(DCEL_t *self, Point_t site, size_t index)
+{
+    if (! dcel_grow((void ***) &self->faces, &self->face_capacity, self->face_count + 1)) return NULL;
+    DCEL_Face_ptr_t face = dcel_alloc(self, sizeof(DCEL_Face_t));
+    if (NULL == face) return NULL;
+    face->inc_edge = NULL;
+    face->inner_edges = NULL;
+    face->site = site;
+    face->index = index;
+    self->faces[self->face_count++] = face;
+    return face;
+}
+
+// Marks a record that has not been given its new position yet
+#define DCEL_UNPLACED ((size_t) -1)
+
+/**
+ * The position of a face on a space-filling curve
+ */
+typedef struct {
+    uint64_t key;
+    size_t index; // The position of the face in the faces array
+} DCEL_Curve_Key_t;
+
+/**
+ * The old and new positions of the records while the edge list is reordered. The old records are stamped with their
+ * old positions while the new ones are worked out, then with their new positions. A link can thus be followed
+ * to the position of its record without a lookup table
+ */
+typedef struct {
+    size_t *vertex_ranks; // The new position of each vertex by its old position
+    size_t *half_edge_ranks;
+    size_t *face_ranks;
+    DCEL_Vertex_t *vertices; // The records at their new positions
+    DCEL_HalfEdge_t *half_edges;
+    DCEL_Face_t *faces;
+} DCEL_Reorder_t;
+
+/**
+ * Spreads the bits of value apart, such that bit i moves to bit 2i
+ */
+static uint64_t dcel_spread_bits(uint32_t value)
+{
+    uint64_t bits = value;
+    bits = (bits | bits << 16) & 0x0000FFFF0000FFFFULL;
+    bits = (bits | bits << 8) & 0x00FF00FF00FF00FFULL;
+    bits = (bits | bits << 4) & 0x0F0F0F0F0F0F0F0FULL;
+    bits = (bits | bits << 2) & 0x3333333333333333ULL;
+    bits = (bits | bits << 1) & 0x5555555555555555ULL;
+    return bits;
+}
+
+/**
+ * Computes the distance of a point along the Hilbert curve that fills the 2^32 x 2^32 grid
+ */
+static uint64_t dcel_hilbert_key(uint32_t x, uint32_t y)
+{
+    uint64_t key = 0;
+    for (uint32_t s = 1U << 31; s > 0; s >>= 1)
+    {
+        uint32_t rx = (x & s) > 0;
+        uint32_t ry = (y & s) > 0;
+        key += (uint64_t) s * s * ((3 * rx) ^ ry);
+        // Rotate the quadrant, such that the curve enters and leaves it at the right corners
+        if (0 == ry)
+        {
+            if (1 == rx)
+            {
+                x = ~x;
+                y = ~y;
+            }
+            uint32_t swap = x;
+            x = y;
+            y = swap;
+        }
+    }
+    return key;
+}
+
+static int dcel_curve_key_compare(const void *first, const void *second)
+{
+    const DCEL_Curve_Key_t *a = (const DCEL_Curve_Key_t *) first;
+    const DCEL_Curve_Key_t *b = (const DCEL_Curve_Key_t *) second;
+    if (a->key != b->key) return a->key < b->key ? -1 : 1;
+    if (a->index != b->index) return a->index < b->index ? -1 : 1;
+    return 0;
+}
+
+static void dcel_stamp(void *record, size_t position)
+{
+    memcpy(record, &position, sizeof(size_t));
+}
+
+static size_t dcel_stamp_read(const void *record)
+{
+    size_t position;
+    memcpy(&position, record, sizeof(size_t));
+    return position;
+}
+
+// Follow a link to the new record, once the old records are stamped with their new positions
+static DCEL_Vertex_ptr_t dcel_reorder_vertex(const DCEL_Reorder_t *reorder, DCEL_Vertex_ptr_t vertex)
+{
+    return vertex ? &reorder->vertices[dcel_stamp_read(vertex)] : NULL;
+}
+
+static DCEL_HalfEdge_ptr_t dcel_reorder_half_edge(const DCEL_Reorder_t *reorder, DCEL_HalfEdge_ptr_t half_edge)
+{
+    return half_edge ? &reorder->half_edges[dcel_stamp_read(half_edge)] : NULL;
+}
+
+static DCEL_Face_ptr_t dcel_reorder_face(const DCEL_Reorder_t *reorder, DCEL_Face_ptr_t face)
+{
+    return face ? &reorder->faces[dcel_stamp_read(face)] : NULL;
+}
+
+/**
+ * Sorts the faces along the curve through their sites. The sites are scaled down to 32 bits per coordinate first
+ *
+ * @param faces the copies of the faces
+ * @param count the number of faces
+ * @param curve the curve
+ * @param keys receives the faces in curve order
+ */
+static void dcel_sort_faces(const DCEL_Face_t *faces, size_t count, DCEL_Curve_t curve, DCEL_Curve_Key_t *keys)
+{
+    if (0 == count) return;
+    uint64_t min_x = faces[0].site.x, min_y = faces[0].site.y, span = 0;
+    for (size_t i = 1; i < count; i++)
+    {
+        if (faces[i].site.x < min_x) min_x = faces[i].site.x;
+        if (faces[i].site.y < min_y) min_y = faces[i].site.y;
+    }
+    for (size_t i = 0; i < count; i++)
+    {
+        span |= (faces[i].site.x - min_x) | (faces[i].site.y - min_y);
+    }
+    uint32_t shift = 0;
+    while (span >> shift > UINT32_MAX) shift++;
+    for (size_t i = 0; i < count; i++)
+    {
+        uint32_t x = (uint32_t) ((faces[i].site.x - min_x) >> shift);
+        uint32_t y = (uint32_t) ((faces[i].site.y - min_y) >> shift);
+        keys[i].key = DCEL_CURVE_HILBERT == curve ? dcel_hilbert_key(x, y)
+                                                  : dcel_spread_bits(x) | dcel_spread_bits(y) << 1;
+        keys[i].index = i;
+    }
+    qsort(keys, count, sizeof(DCEL_Curve_Key_t), dcel_curve_key_compare);
+}
+
+/**
+ * Renumbers the records of self such that neighbouring cells are close to each other in memory.
+ * The faces are sorted along the curve through their sites, the half-edges follow in the order of a walk around
+ * each face and the vertices in the order in which the walk reaches them. All records move into a single new block
+ * and every link is rewritten, so the handles of the records become invalid.
+ *
+ * The position of a face in faces no longer matches the index of its site afterwards, face->index still does.
+ * The inner_edges arrays of the faces are not owned by the edge list and are kept as they are.
+ *
+ * @param self the edge list handle
+ * @param curve the curve that orders the faces
+ * @return 1 on success, 0 if the memory could not be allocated, in which case self is unchanged
+ */
+uint8_t dcel_reorder(DCEL_t *self, DCEL_Curve_t curve)
+{
+    size_t vertex_count = self->vertex_count;
+    size_t half_edge_count = self->half_edge_count;
+    size_t face_count = self->face_count;
+    size_t bytes = vertex_count * sizeof(DCEL_Vertex_t) + half_edge_count * sizeof(DCEL_HalfEdge_t) +
+                   face_count * sizeof(DCEL_Face_t);
+    DCEL_Reorder_t reorder;
+    reorder.vertex_ranks = malloc((vertex_count + half_edge_count + face_count + 1) * sizeof(size_t));
+    size_t *half_edge_order = malloc((half_edge_count + 1) * sizeof(size_t));
+    DCEL_Curve_Key_t *keys = malloc((face_count + 1) * sizeof(DCEL_Curve_Key_t));
+    DCEL_Vertex_t *vertex_copies = malloc((vertex_count + 1) * sizeof(DCEL_Vertex_t));
+    DCEL_HalfEdge_t *half_edge_copies = malloc((half_edge_count + 1) * sizeof(DCEL_HalfEdge_t));
+    DCEL_Face_t *face_copies = malloc((face_count + 1) * sizeof(DCEL_Face_t));
+    struct DCEL_Block *block = malloc(sizeof(struct DCEL_Block) + bytes);
+    if (! reorder.vertex_ranks || ! half_edge_order || ! keys || ! vertex_copies || ! half_edge_copies ||
+        ! face_copies || ! block)
+    {
+        free(reorder.vertex_ranks);
+        free(half_edge_order);
+        free(keys);
+        free(vertex_copies);
+        free(half_edge_copies);
+        free(face_copies);
+        free(block);
+        return 0;
+    }
+    reorder.half_edge_ranks = reorder.vertex_ranks + vertex_count;
+    reorder.face_ranks = reorder.half_edge_ranks + half_edge_count;
+    reorder.vertices = (DCEL_Vertex_t *) block->data;
+    reorder.half_edges = (DCEL_HalfEdge_t *) (reorder.vertices + vertex_count);
+    reorder.faces = (DCEL_Face_t *) (reorder.half_edges + half_edge_count);
+
+    // Keep a copy of every record and stamp the record with its old position
+    for (size_t i = 0; i < vertex_count; i++)
+    {
+        vertex_copies[i] = *self->vertices[i];
+        dcel_stamp(self->vertices[i], i);
+        reorder.vertex_ranks[i] = DCEL_UNPLACED;
+    }
+    for (size_t i = 0; i < half_edge_count; i++)
+    {
+        half_edge_copies[i] = *self->half_edges[i];
+        dcel_stamp(self->half_edges[i], i);
+        reorder.half_edge_ranks[i] = DCEL_UNPLACED;
+    }
+    for (size_t i = 0; i < face_count; i++)
+    {
+        face_copies[i] = *self->faces[i];
+        dcel_stamp(self->faces[i], i);
+    }
+
+    dcel_sort_faces(face_copies, face_count, curve, keys);
+    size_t rank = 0;
+    for (size_t k = 0; k < face_count; k++)
+    {
+        size_t face = keys[k].index;
+        reorder.face_ranks[face] = k;
+        // Open chains start at inc_edge, closed ones end where they started
+        DCEL_HalfEdge_ptr_t half_edge = face_copies[face].inc_edge;
+        while (half_edge)
+        {
+            size_t h = dcel_stamp_read(half_edge);
+            if (reorder.half_edge_ranks[h] != DCEL_UNPLACED) break;
+            half_edge_order[rank] = h;
+            reorder.half_edge_ranks[h] = rank++;
+            half_edge = half_edge_copies[h].next;
+        }
+    }
+    // The half-edges that bound no face, like the outer sides of a clip polygon, go last
+    for (size_t h = 0; h < half_edge_count; h++)
+    {
+        if (reorder.half_edge_ranks[h] != DCEL_UNPLACED) continue;
+        half_edge_order[rank] = h;
+        reorder.half_edge_ranks[h] = rank++;
+    }
+    rank = 0;
+    for (size_t r = 0; r < half_edge_count; r++)
+    {
+        DCEL_Vertex_ptr_t origin = half_edge_copies[half_edge_order[r]].origin;
+        if (! origin) continue;
+        size_t v = dcel_stamp_read(origin);
+        if (reorder.vertex_ranks[v] == DCEL_UNPLACED) reorder.vertex_ranks[v] = rank++;
+    }
+    for (size_t v = 0; v < vertex_count; v++)
+    {
+        if (reorder.vertex_ranks[v] == DCEL_UNPLACED) reorder.vertex_ranks[v] = rank++;
+    }
+
+    // Write the records to their new positions and follow the links through the stamps
+    for (size_t i = 0; i < vertex_count; i++) dcel_stamp(self->vertices[i], reorder.vertex_ranks[i]);
+    for (size_t i = 0; i < half_edge_count; i++) dcel_stamp(self->half_edges[i], reorder.half_edge_ranks[i]);
+    for (size_t i = 0; i < face_count; i++) dcel_stamp(self->faces[i], reorder.face_ranks[i]);
+    for (size_t i = 0; i < vertex_count; i++)
+    {
+        DCEL_Vertex_ptr_t vertex = &reorder.vertices[reorder.vertex_ranks[i]];
+        vertex->position = vertex_copies[i].position;
+        vertex->inc_edge = dcel_reorder_half_edge(&reorder, vertex_copies[i].inc_edge);
+    }
+    for (size_t i = 0; i < half_edge_count; i++)
+    {
+        DCEL_HalfEdge_ptr_t half_edge = &reorder.half_edges[reorder.half_edge_ranks[i]];
+        half_edge->origin = dcel_reorder_vertex(&reorder, half_edge_copies[i].origin);
+        half_edge->inc_face = dcel_reorder_face(&reorder, half_edge_copies[i].inc_face);
+        half_edge->twin = dcel_reorder_half_edge(&reorder, half_edge_copies[i].twin);
+        half_edge->next = dcel_reorder_half_edge(&reorder, half_edge_copies[i].next);
+        half_edge->prev = dcel_reorder_half_edge(&reorder, half_edge_copies[i].prev);
+    }
+    for (size_t i = 0; i < face_count; i++)
+    {
+        DCEL_Face_ptr_t face = &reorder.faces[reorder.face_ranks[i]];
+        *face = face_copies[i];
+        face->inc_edge = dcel_reorder_half_edge(&reorder, face_copies[i].inc_edge);
+    }
+    for (size_t i = 0; i < vertex_count; i++) self->vertices[i] = &reorder.vertices[i];
+    for (size_t i = 0; i < half_edge_count; i++) self->half_edges[i] = &reorder.half_edges[i];
+    for (size_t i = 0; i < face_count; i++) self->faces[i] = &reorder.faces[i];
+
+    struct DCEL_Block *old = self->blocks;
+    while (old)
+    {
+        struct DCEL_Block *next = old->next;
+        free(old);
+        old = next;
+    }
+    block->next = NULL;
+    block->used = block->capacity = bytes;
+    self->blocks = block;
+
+    free(reorder.vertex_ranks);
+    free(half_edge_order);
+    free(keys);
+    free(vertex_copies);
+    free(half_edge_copies);
+    free(face_copies);
+    return 1;
+}
+
+// The number of half-edges per block of the parallel passes of dcel_merge
+#define DCEL_MERGE_BLOCK 65536
+
+/**
+ * The two half-edges of an edge whose faces belong to different pieces, see dcel_merge
+ */
+typedef struct {
+    uint64_t key; // The indices of both sites, the smaller one in the upper half. 0 while the slot is free
+    DCEL_HalfEdge_ptr_t half_edges[2]; // The half-edge on the face of the smaller and of the larger index
+} DCEL_Seam_t;
+
+/**
+ * The share of one piece in the merged edge list
+ */
+typedef struct {
+    size_t *vertex_ranks; // The position of each vertex of the piece among the vertices it contributes
+    Point_Real_t *positions; // The positions of the vertices of the piece, whose records are stamped
+    uint8_t *keeps; // Whether the piece contributes each of its half-edges, see dcel_merge_keeps
+    size_t vertex_count; // The number of vertices the piece contributes, the copies of seam vertices included
+    size_t half_edge_count;
+    size_t face_count;
+    size_t seam_count; // The number of contributed half-edges whose twin lies on a face of another piece
+    size_t first_vertex; // The position of the first contributed vertex among all vertex copies
+    size_t first_half_edge;
+} DCEL_Merge_Piece_t;
+
+/**
+ * The records of the merged edge list while they are linked
+ */
+typedef struct {
+    const size_t *owners;
+    size_t face_count;
+    DCEL_Vertex_t *vertices; // The copies of the vertices, the copies of one seam vertex from different pieces included
+    DCEL_HalfEdge_t *half_edges;
+    DCEL_Face_t *faces;
+    DCEL_Seam_t *seams; // An open addressing table of the seam edges
+    uint64_t seam_mask; // The number of slots of seams minus one
+} DCEL_Merge_t;
+
+/**
+ * Returns whether the piece contributes the half-edge, that is whether it owns its face.
+ * The outer sides of a clip polygon bound no face and go with the face on their other side
+ */
+static uint8_t dcel_merge_keeps(const DCEL_Merge_t *merge, size_t piece, DCEL_HalfEdge_ptr_t half_edge)
+{
+    DCEL_Face_ptr_t face = half_edge->inc_face;
+    if (! face && half_edge->twin) face = half_edge->twin->inc_face;
+    return face && face->index < merge->face_count && merge->owners[face->index] == piece;
+}
+
+/**
+ * Counts the records that a piece contributes and numbers its vertices. The vertex records of the piece are stamped
+ * with their positions in the vertices array of the piece
+ *
+ * @return 1 on success, 0 if the memory could not be allocated
+ */
+static uint8_t dcel_merge_count(const DCEL_Merge_t *merge, DCEL_Merge_Piece_t *share, DCEL_t *piece, size_t p)
+{
+    share->vertex_ranks = malloc((piece->vertex_count + 1) * sizeof(size_t));
+    share->positions = malloc((piece->vertex_count + 1) * sizeof(Point_Real_t));
+    share->keeps = malloc(piece->half_edge_count + 1);
+    if (! share->vertex_ranks || ! share->positions || ! share->keeps) return 0;
+    for (size_t i = 0; i < piece->vertex_count; i++)
+    {
+        share->positions[i] = piece->vertices[i]->position;
+        share->vertex_ranks[i] = DCEL_UNPLACED;
+        dcel_stamp(piece->vertices[i], i);
+    }
+    for (size_t i = 0; i < piece->half_edge_count; i++)
+    {
+        DCEL_HalfEdge_ptr_t half_edge = piece->half_edges[i];
+        share->keeps[i] = dcel_merge_keeps(merge, p, half_edge);
+        if (! share->keeps[i]) continue;
+        share->half_edge_count++;
+        if (half_edge->twin && ! dcel_merge_keeps(merge, p, half_edge->twin)) share->seam_count++;
+        if (half_edge->origin)
+        {
+            size_t v = dcel_stamp_read(half_edge->origin);
+            if (DCEL_UNPLACED == share->vertex_ranks[v]) share->vertex_ranks[v] = share->vertex_count++;
+        }
+    }
+    for (size_t i = 0; i < piece->face_count; i++)
+    {
+        size_t index = piece->faces[i]->index;
+        share->face_count += index < merge->face_count && merge->owners[index] == p;
+    }
+    return 1;
+}
+
+/**
+ * Enters a half-edge of a seam into the table, where it meets its twin from the other piece.
+ * Threads claim the slot of an edge with an atomic compare and swap, after which each of both half-edges
+ * has its own place in the slot
+ *
+ * @param merge the merge state
+ * @param half_edge the half-edge
+ * @param face the index of the site of its face
+ * @param neighbour the index of the site of the face of its twin
+ */
+static void dcel_merge_seam(DCEL_Merge_t *merge, DCEL_HalfEdge_ptr_t half_edge, size_t face, size_t neighbour)
+{
+    uint64_t low = face < neighbour ? face : neighbour;
+    uint64_t high = face < neighbour ? neighbour : face;
+    uint64_t key = low << 32 | high;
+    uint64_t slot = (key * 0x9E3779B97F4A7C15ULL) >> 32 & merge->seam_mask;
+    while (1)
+    {
+        DCEL_Seam_t *seam = &merge->seams[slot];
+        uint64_t seen;
+        #pragma omp atomic compare capture
+        {
+            seen = seam->key;
+            if (seam->key == 0)
+            {
+                seam->key = key;
+            }
+        }
+        if (0 == seen || key == seen)
+        {
+            seam->half_edges[face < neighbour ? 0 : 1] = half_edge;
+            return;
+        }
+        slot = (slot + 1) & merge->seam_mask;
+    }
+}
+
+/**
+ * Copies the records that a piece contributes into the merged edge list and links them among each other.
+ * The half-edges whose twin lies on a face of another piece are entered into the seam table instead.
+ * The half-edge records of the piece are stamped with the positions of their copies
+ */
+static void dcel_merge_copy(DCEL_Merge_t *merge, DCEL_Merge_Piece_t *share, DCEL_t *piece, size_t p)
+{
+    DCEL_HalfEdge_t *half_edges = merge->half_edges + share->first_half_edge;
+    size_t count = 0;
+    for (size_t i = 0; i < piece->half_edge_count; i++)
+    {
+        // The stamp only overwrites the origin of the record, after it was copied
+        if (share->keeps[i]) half_edges[count] = *piece->half_edges[i];
+        dcel_stamp(piece->half_edges[i], share->keeps[i] ? share->first_half_edge + count++ : DCEL_UNPLACED);
+    }
+    for (size_t j = 0; j < count; j++)
+    {
+        DCEL_HalfEdge_ptr_t half_edge = &half_edges[j];
+        DCEL_HalfEdge_ptr_t twin = half_edge->twin;
+        if (half_edge->origin)
+        {
+            size_t rank = share->vertex_ranks[dcel_stamp_read(half_edge->origin)];
+            half_edge->origin = &merge->vertices[share->first_vertex + rank];
+        }
+        half_edge->next = half_edge->next ? &merge->half_edges[dcel_stamp_read(half_edge->next)] : NULL;
+        half_edge->prev = half_edge->prev ? &merge->half_edges[dcel_stamp_read(half_edge->prev)] : NULL;
+        half_edge->twin = NULL;
+        if (twin && dcel_stamp_read(twin) != DCEL_UNPLACED)
+        {
+            half_edge->twin = &merge->half_edges[dcel_stamp_read(twin)];
+        }
+        else if (twin)
+        {
+            dcel_merge_seam(merge, half_edge, half_edge->inc_face->index, twin->inc_face->index);
+        }
+        half_edge->inc_face = half_edge->inc_face ? &merge->faces[half_edge->inc_face->index] : NULL;
+    }
+    for (size_t i = 0; i < piece->vertex_count; i++)
+    {
+        if (DCEL_UNPLACED == share->vertex_ranks[i]) continue;
+        DCEL_Vertex_ptr_t vertex = &merge->vertices[share->first_vertex + share->vertex_ranks[i]];
+        vertex->position = share->positions[i];
+        vertex->inc_edge = NULL;
+    }
+    for (size_t i = 0; i < piece->face_count; i++)
+    {
+        DCEL_Face_ptr_t face = piece->faces[i];
+        if (face->index >= merge->face_count || merge->owners[face->index] != p) continue;
+        merge->faces[face->index] = *face;
+        DCEL_HalfEdge_ptr_t inc_edge = face->inc_edge;
+        merge->faces[face->index].inc_edge = inc_edge ? &merge->half_edges[dcel_stamp_read(inc_edge)] : NULL;
+    }
+}
+
+static DCEL_HalfEdge_ptr_t dcel_merge_lower(DCEL_HalfEdge_ptr_t best, DCEL_HalfEdge_ptr_t half_edge)
+{
+    if (! half_edge->inc_face) return best;
+    if (! best || half_edge->inc_face->index < best->inc_face->index) return half_edge;
+    return best;
+}
+
+/**
+ * Turns around the origin of a half-edge through all half-edges that leave it, in both directions until the turn
+ * closes or reaches the outside of a clip polygon. Every piece around a seam vertex brought its own copy of it,
+ * and the copy of the lowest face around the vertex is the one that is kept
+ *
+ * @param half_edge the half-edge
+ * @return the half-edge of the lowest face that leaves the origin
+ */
+static DCEL_HalfEdge_ptr_t dcel_merge_lowest_around(DCEL_HalfEdge_ptr_t half_edge)
+{
+    DCEL_HalfEdge_ptr_t best = dcel_merge_lower(NULL, half_edge);
+    DCEL_HalfEdge_ptr_t current = half_edge;
+    while (current->prev && current->prev->twin)
+    {
+        current = current->prev->twin;
+        if (current == half_edge) return best;
+        best = dcel_merge_lower(best, current);
+    }
+    current = half_edge;
+    while (current->twin && current->twin->next)
+    {
+        current = current->twin->next;
+        best = dcel_merge_lower(best, current);
+    }
+    return best;
+}
+
+/**
+ * Merges pieces of one diagram into a single edge list. Every site belongs to one piece, which holds the correct
+ * cell of the site, like the tiles of a large diagram that were built independently. The half-edges between two
+ * cells of the same piece are linked right away. The edges between cells of different pieces, the seams,
+ * are matched by the indices of their two sites in a lock-free hash table, and the vertices on the seams,
+ * which every piece around them brings along, are merged into one.
+ *
+ * The pieces are copied in parallel, then the seams are linked and the vertices merged in parallel.
+ * The result does not depend on the number of threads: the half-edges come in the order of the pieces and their
+ * half_edges arrays, the vertices in the order of the half-edges that leave them from their lowest face
+ * and face i is the face of site i.
+ *
+ * The records of the pieces are overwritten on the way, the pieces can only be cleared or destroyed afterwards.
+ *
+ * @param self the edge list that receives the merged diagram, cleared first
+ * @param pieces the pieces
+ * @param piece_count the number of pieces
+ * @param owners the piece of every site index. Every face of the merged diagram is taken from the piece of its site
+ * @param face_count the number of sites, which must be less than 2^32
+ * @return 1 on success, 0 if the memory could not be allocated or the pieces do not agree on their seams
+ */
+uint8_t dcel_merge(DCEL_t *self, DCEL_t *pieces, size_t piece_count, const size_t *owners, size_t face_count)
+{
+    dcel_clear(self);
+    DCEL_Merge_t merge;
+    memset(&merge, 0, sizeof(DCEL_Merge_t));
+    merge.owners = owners;
+    merge.face_count = face_count;
+    DCEL_Merge_Piece_t *shares = calloc(piece_count + 1, sizeof(DCEL_Merge_Piece_t));
+    if (NULL == shares) return 0;
+    uint8_t success = 1;
+    #pragma omp parallel for schedule(dynamic) default(none) shared(merge, shares, pieces, piece_count) \
+        reduction(&:success)
+    for (size_t p = 0; p < piece_count; p++)
+    {
+        voronoi_trace_begin("merge_count");
+        success &= dcel_merge_count(&merge, &shares[p], &pieces[p], p);
+        voronoi_trace_end("merge_count");
+    }
+
+    size_t vertex_count = 0, half_edge_count = 0, faces = 0, seam_count = 0;
+    for (size_t p = 0; p < piece_count; p++)
+    {
+        shares[p].first_vertex = vertex_count;
+        shares[p].first_half_edge = half_edge_count;
+        vertex_count += shares[p].vertex_count;
+        half_edge_count += shares[p].half_edge_count;
+        faces += shares[p].face_count;
+        seam_count += shares[p].seam_count;
+    }
+    merge.seam_mask = 1;
+    while (merge.seam_mask < seam_count) merge.seam_mask <<= 1;
+    merge.seams = calloc(merge.seam_mask, sizeof(DCEL_Seam_t));
+    merge.seam_mask--;
+    size_t blocks = (half_edge_count + DCEL_MERGE_BLOCK - 1) / DCEL_MERGE_BLOCK;
+    DCEL_HalfEdge_ptr_t *lowest = malloc((half_edge_count + 1) * sizeof(DCEL_HalfEdge_ptr_t));
+    size_t *block_vertices = calloc(blocks + 1, sizeof(size_t));
+    success = success && faces == face_count && merge.seams && lowest && block_vertices &&
+              dcel_grow((void ***) &self->vertices, &self->vertex_capacity, vertex_count) &&
+              dcel_grow((void ***) &self->half_edges, &self->half_edge_capacity, half_edge_count) &&
+              dcel_grow((void ***) &self->faces, &self->face_capacity, face_count);
+    if (success)
+    {
+        merge.vertices = dcel_alloc(self, (vertex_count + 1) * sizeof(DCEL_Vertex_t));
+        merge.half_edges = dcel_alloc(self, (half_edge_count + 1) * sizeof(DCEL_HalfEdge_t));
+        merge.faces = dcel_alloc(self, (face_count + 1) * sizeof(DCEL_Face_t));
+        success = merge.vertices && merge.half_edges && merge.faces;
+    }
+
+    if (success)
+    {
+        #pragma omp parallel for schedule(dynamic) default(none) shared(merge, shares, pieces, piece_count)
+        for (size_t p = 0; p < piece_count; p++)
+        {
+            voronoi_trace_begin("merge_copy");
+            dcel_merge_copy(&merge, &shares[p], &pieces[p], p);
+            voronoi_trace_end("merge_copy");
+        }
+
+        size_t unmatched = 0;
+        #pragma omp parallel default(none) shared(merge) reduction(+:unmatched)
+        {
+            voronoi_trace_begin("merge_seams");
+            #pragma omp for schedule(static) nowait
+            for (size_t slot = 0; slot <= merge.seam_mask; slot++)
+            {
+                DCEL_Seam_t *seam = &merge.seams[slot];
+                if (! seam->key) continue;
+                if (! seam->half_edges[0] || ! seam->half_edges[1])
+                {
+                    unmatched++;
+                    continue;
+                }
+                seam->half_edges[0]->twin = seam->half_edges[1];
+                seam->half_edges[1]->twin = seam->half_edges[0];
+            }
+            voronoi_trace_end("merge_seams");
+        }
+        success = 0 == unmatched;
+    }
+
+    if (success)
+    {
+        // The vertex of every half-edge is the copy that the lowest face around it brought along, and that
+        // face numbers it. The copies are only replaced once all of them are known
+        #pragma omp parallel for schedule(static) default(none) shared(merge, lowest, block_vertices, blocks, \
+            half_edge_count)
+        for (size_t b = 0; b < blocks; b++)
+        {
+            voronoi_trace_begin("merge_turns");
+            size_t end = (b + 1) * DCEL_MERGE_BLOCK < half_edge_count ? (b + 1) * DCEL_MERGE_BLOCK : half_edge_count;
+            for (size_t h = b * DCEL_MERGE_BLOCK; h < end; h++)
+            {
+                DCEL_HalfEdge_ptr_t half_edge = &merge.half_edges[h];
+                lowest[h] = half_edge->origin ? dcel_merge_lowest_around(half_edge) : NULL;
+                block_vertices[b] += lowest[h] == half_edge;
+            }
+            voronoi_trace_end("merge_turns");
+        }
+        size_t position = 0;
+        for (size_t b = 0; b < blocks; b++)
+        {
+            size_t count = block_vertices[b];
+            block_vertices[b] = position;
+            position += count;
+        }
+        #pragma omp parallel for schedule(static) default(none) shared(self, merge, lowest, block_vertices, blocks, \
+            half_edge_count)
+        for (size_t b = 0; b < blocks; b++)
+        {
+            size_t end = (b + 1) * DCEL_MERGE_BLOCK < half_edge_count ? (b + 1) * DCEL_MERGE_BLOCK : half_edge_count;
+            voronoi_trace_begin("merge_vertices");
+            size_t vertex = block_vertices[b];
+            for (size_t h = b * DCEL_MERGE_BLOCK; h < end; h++)
+            {
+                DCEL_HalfEdge_ptr_t half_edge = &merge.half_edges[h];
+                self->half_edges[h] = half_edge;
+                // The origins of the lowest half-edges are read by other threads and stay as they are
+                if (lowest[h] && lowest[h] != half_edge)
+                {
+                    half_edge->origin = lowest[h]->origin;
+                }
+                else if (lowest[h])
+                {
+                    half_edge->origin->inc_edge = half_edge;
+                    self->vertices[vertex++] = half_edge->origin;
+                }
+            }
+            voronoi_trace_end("merge_vertices");
+        }
+        for (size_t i = 0; i < face_count; i++)
+        {
+            self->faces[i] = &merge.faces[i];
+        }
+        self->vertex_count = position;
+        self->half_edge_count = half_edge_count;
+        self->face_count = face_count;
+    }
+
+    for (size_t p = 0; p < piece_count; p++)
+    {
+        free(shares[p].vertex_ranks);
+        free(shares[p].positions);
+        free(shares[p].keeps);
+    }
+    free(shares);
+    free(merge.seams);
+    free(lowest);
+    free(block_vertices);
+    if (! success) dcel_clear(self);
+    return success;
+}
+
+/**
+ * The fingerprint of one cell, see dcel_diff
+ */
+typedef struct {
+    uint64_t x; // The position of the site, which identifies the cell
+    uint64_t y;
+    uint64_t hash; // The hash of the boundary of the cell
+    size_t index; // The index of the site
+} DCEL_Diff_Cell_t;
+
+/**
+ * Scrambles the bits of value, the finalizer of splitmix64
+ */
+static uint64_t dcel_hash_mix(uint64_t value)
+{
+    value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    value = (value ^ (value >> 27)) * 0x94D049BB133111EBULL;
+    return value ^ (value >> 31);
+}
+
+/**
+ * Hashes the position of a vertex. A missing vertex, the end of an edge at infinity, has a hash of its own
+ */
+static uint64_t dcel_hash_vertex(DCEL_Vertex_ptr_t vertex)
+{
+    if (! vertex) return 0x9E3779B97F4A7C15ULL;
+    // Both zeros compare equal, so they hash alike
+    double x = vertex->position.x + 0.0;
+    double y = vertex->position.y + 0.0;
+    uint64_t x_bits, y_bits;
+    memcpy(&x_bits, &x, sizeof(uint64_t));
+    memcpy(&y_bits, &y, sizeof(uint64_t));
+    return dcel_hash_mix(dcel_hash_mix(x_bits) + y_bits);
+}
+
+/**
+ * Fingerprints the cell of a face. Every half-edge on its boundary is hashed from its two ends and the site on its
+ * other side, and the hashes are summed up, which does not depend on where the walk around the face starts.
+ * The neighbours are identified by the positions of their sites like the cells themselves
+ *
+ * @param face the face
+ * @param cell receives the fingerprint
+ * @return 1 if the face has a boundary, 0 if it is empty and thus no cell
+ */
+static uint8_t dcel_diff_fingerprint(DCEL_Face_ptr_t face, DCEL_Diff_Cell_t *cell)
+{
+    DCEL_HalfEdge_ptr_t start = face->inc_edge;
+    if (! start) return 0;
+    cell->x = face->site.x;
+    cell->y = face->site.y;
+    cell->index = face->index;
+    uint64_t hash = 0;
+    size_t degree = 0;
+    DCEL_HalfEdge_ptr_t half_edge = start;
+    do
+    {
+        DCEL_Face_ptr_t neighbour = half_edge->twin->inc_face;
+        // The ends are weighed differently, so the direction of the half-edge counts
+        uint64_t edge = dcel_hash_vertex(half_edge->origin) + 3 * dcel_hash_vertex(half_edge->twin->origin);
+        edge = dcel_hash_mix(edge);
+        if (neighbour) edge = dcel_hash_mix(dcel_hash_mix(edge + neighbour->site.x) + neighbour->site.y);
+        hash += edge;
+        degree++;
+        half_edge = half_edge->next;
+    } while (half_edge && half_edge != start);
+    cell->hash = dcel_hash_mix(hash + degree);
+    return 1;
+}
+
+static int dcel_diff_cell_compare(const void *first, const void *second)
+{
+    const DCEL_Diff_Cell_t *a = (const DCEL_Diff_Cell_t *) first;
+    const DCEL_Diff_Cell_t *b = (const DCEL_Diff_Cell_t *) second;
+    if (a->x != b->x) return a->x < b->x ? -1 : 1;
+    if (a->y != b->y) return a->y < b->y ? -1 : 1;
+    return 0;
+}
+
+/**
+ * Fingerprints the cells of an edge list in parallel and sorts them by the positions of their sites
+ *
+ * @param dcel the edge list
+ * @param count receives the number of cells
+ * @return the cells, NULL if the memory could not be allocated
+ */
+static DCEL_Diff_Cell_t *dcel_diff_cells(const DCEL_t *dcel, size_t *count)
+{
+    size_t face_count = dcel->face_count;
+    DCEL_Diff_Cell_t *cells = malloc((face_count + 1) * sizeof(DCEL_Diff_Cell_t));
+    uint8_t *is_cell = malloc(face_count + 1);
+    if (NULL == cells || NULL == is_cell)
+    {
+        free(cells);
+        free(is_cell);
+        return NULL;
+    }
+    DCEL_Face_ptr_t *faces = dcel->faces;
+    #pragma omp parallel default(none) shared(faces, face_count, cells, is_cell)
+    {
+        voronoi_trace_begin("diff_fingerprint");
+        #pragma omp for schedule(static) nowait
+        for (size_t i = 0; i < face_count; i++)
+        {
+            is_cell[i] = dcel_diff_fingerprint(faces[i], &cells[i]);
+        }
+        voronoi_trace_end("diff_fingerprint");
+    }
+
+    // Drop the empty faces. The faces come in the order of the input, which is rarely sorted by position, so the pass
+    // checks the order and the cells are only sorted if they have to be
+    size_t kept = 0;
+    uint8_t is_sorted = 1;
+    for (size_t i = 0; i < face_count; i++)
+    {
+        if (! is_cell[i]) continue;
+        if (kept && dcel_diff_cell_compare(&cells[kept - 1], &cells[i]) >= 0) is_sorted = 0;
+        cells[kept++] = cells[i];
+    }
+    free(is_cell);
+    if (! is_sorted) qsort(cells, kept, sizeof(DCEL_Diff_Cell_t), dcel_diff_cell_compare);
+    *count = kept;
+    return cells;
+}
+
+/**
+ * Compares the cells of two diagrams. Cells are identified by the positions of their sites, see DCEL_Diff_t
+ *
+ * Both diagrams are fingerprinted in parallel, one hash per cell, and the cells are sorted by the positions of their
+ * sites unless they already are. A single merge of the two sorted lists then finds the differences.
+ *
+ * @param self receives the differences, overwritten
+ * @param before the earlier diagram
+ * @param after the later diagram
+ * @return 1 on success, 0 if the memory could not be allocated, in which case self is empty
+ */
+uint8_t dcel_diff(DCEL_Diff_t *self, const DCEL_t *before, const DCEL_t *after)
+{
+    memset(self, 0, sizeof(DCEL_Diff_t));
+    size_t before_count = 0, after_count = 0;
+    DCEL_Diff_Cell_t *before_cells = dcel_diff_cells(before, &before_count);
+    DCEL_Diff_Cell_t *after_cells = before_cells ? dcel_diff_cells(after, &after_count) : NULL;
+    self->added = malloc((after_count + 1) * sizeof(size_t));
+    self->removed = malloc((before_count + 1) * sizeof(size_t));
+    self->changed = malloc((after_count + 1) * sizeof(size_t));
+    if (! before_cells || ! after_cells || ! self->added || ! self->removed || ! self->changed)
+    {
+        free(before_cells);
+        free(after_cells);
+        dcel_diff_destroy(self);
+        return 0;
+    }
+
+    voronoi_trace_begin("diff_merge");
+    size_t b = 0, a = 0;
+    while (b < before_count || a < after_count)
+    {
+        int order = b == before_count ? 1 : a == after_count ? -1 :
+                    dcel_diff_cell_compare(&before_cells[b], &after_cells[a]);
+        if (order < 0)
+        {
+            self->removed[self->removed_count++] = before_cells[b++].index;
+        }
+        else if (order > 0)
+        {
+            self->added[self->added_count++] = after_cells[a++].index;
+        }
+        else
+        {
+            if (before_cells[b].hash != after_cells[a].hash)
+            {
+                self->changed[self->changed_count++] = after_cells[a].index;
+            }
+            b++;
+            a++;
+        }
+    }
+    voronoi_trace_end("diff_merge");
+    free(before_cells);
+    free(after_cells);
+    return 1;
+}
+
+/**
+ * Frees the arrays of self. The differences are empty afterwards
+ *
+ * @param self the differences
+ */
+void dcel_diff_destroy(DCEL_Diff_t *self)
+{
+    if (self)
+    {
+        free(self->added);
+        free(self->removed);
+        free(self->changed);
+        memset(self, 0, sizeof(DCEL_Diff_t));
+    }
+}
+
+/**
+ * Removes all records from self but keeps its memory, such that the next diagram can be built without allocations.
+ * The records handed out before become invalid
+ *
+ * @param self the edge list handle
+ */
+void dcel_clear(DCEL_t *self)
+{
+    self->vertex_count = self->half_edge_count = self->face_count = 0;
+    struct DCEL_Block *block = self->blocks;
+    if (block && block->next)
+    {
+        // Merge the blocks into one, records are only carved out of the newest block
+        size_t capacity = 0;
+        while (block)
+        {
+            struct DCEL_Block *next = block->next;
+            capacity += block->capacity;
+            free(block);
+            block = next;
+        }
+        self->blocks = block = malloc(sizeof(struct DCEL_Block) + capacity);
+        if (NULL == block) return;
+        block->next = NULL;
+        block->capacity = capacity;
+    }
+    if (block)
+    {
+        block->used = 0;
+    }
+}
+
+/**
+ * Frees the records and the arrays of self. The edge list is empty afterwards
+ *
+ * @param self the edge list handle
+ */
+void dcel_destroy(DCEL_t *self)
+{
+    if (self)
+    {
+        struct DCEL_Block *block = self->blocks;
+        while (block)
+        {
+            struct DCEL_Block *next = block->next;
+            free(block);
+            block = next;
+        }
+        free(self->vertices);
+        free(self->half_edges);
+        free(self->faces);
+        dcel_init(self);
+    }
+}
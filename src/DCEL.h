@@ -11,12 +11,13 @@
 
 #ifndef VORONOI_DCEL_H
 #define VORONOI_DCEL_H
+#include <stddef.h>
 #include "Point.h"
 
 struct DCEL_HalfEdge;
 
 typedef struct {
-    Point_t position; // The position of the vertex in the space
+    Point_Real_t position; // The position of the vertex in the space
     struct DCEL_HalfEdge *inc_edge; // An arbitrary half-edge that is incident to this vertex
 } DCEL_Vertex_t;
 
@@ -25,6 +26,8 @@ typedef DCEL_Vertex_t *DCEL_Vertex_ptr_t;
 typedef struct {
     struct DCEL_HalfEdge *inc_edge; // An arbitrary half-edge that is incident to this face on its outer boundary
     struct DCEL_HalfEdge **inner_edges; // Holds a pointer to a half-edge for each hole in the face
+    Point_t site; // The site whose cell is represented by this face
+    size_t index; // The index of the site, e.g. its position in the input of the algorithm
 } DCEL_Face_t;
 
 typedef DCEL_Face_t *DCEL_Face_ptr_t;
@@ -39,15 +42,171 @@ typedef struct DCEL_HalfEdge {
 
 typedef DCEL_HalfEdge_t *DCEL_HalfEdge_ptr_t;
 
+// A chunk of memory from which the records of an edge list are carved out
+struct DCEL_Block;
+
 /**
  * A doubly connected edge list that can be used to represent complex geometrical shapes as a sequence of interconnected
  * line segments. An example for such a geometrical shape is the Voronoi diagram.
+ *
+ * The records are owned by the edge list and are released all at once by dcel_destroy.
+ * Faces are traversed counter-clockwise. A half-edge that runs off to infinity has no origin on its twin,
+ * a half-edge that comes in from infinity has no origin itself. The chain of such an unbounded face is therefore open:
+ * its first half-edge has no prev and its last half-edge has no next. The inc_edge of an unbounded face is its first half-edge.
  */
 typedef struct {
     DCEL_Vertex_ptr_t *vertices;
     DCEL_HalfEdge_ptr_t *half_edges;
     DCEL_Face_ptr_t *faces;
+    size_t vertex_count;
+    size_t half_edge_count;
+    size_t face_count;
+    size_t vertex_capacity;
+    size_t half_edge_capacity;
+    size_t face_capacity;
+    struct DCEL_Block *blocks; // The memory blocks backing the records
 } DCEL_t;
 
+/**
+ * Initializes an empty edge list
+ *
+ * @param self the edge list handle
+ */
+void dcel_init(DCEL_t *self);
+
+/**
+ * Reserves room for the given number of records, so that they can be created without further reallocations
+ *
+ * @param self the edge list handle
+ * @param vertices the number of vertices
+ * @param half_edges the number of half-edges
+ * @param faces the number of faces
+ * @return 1 on success, 0 if the memory could not be allocated
+ */
+uint8_t dcel_reserve(DCEL_t *self, size_t vertices, size_t half_edges, size_t faces);
+
+/**
+ * Creates a vertex at the given position
+ *
+ * @param self the edge list handle
+ * @param position the position of the vertex
+ * @return a handle to the vertex, NULL if the memory could not be allocated
+ */
+DCEL_Vertex_ptr_t dcel_vertex_new(DCEL_t *self, Point_Real_t position);
+
+/**
+ * Creates a half-edge on the boundary of face. All links except for the incident face are left empty
+ *
+ * @param self the edge list handle
+ * @param face the incident face
+ * @return a handle to the half-edge, NULL if the memory could not be allocated
+ */
+DCEL_HalfEdge_ptr_t dcel_half_edge_new(DCEL_t *self, DCEL_Face_ptr_t face);
+
+/**
+ * Creates a face for the cell of the site
+ *
+ * @param self the edge list handle
+ * @param site the site of the cell
+ * @param index the index of the site
+ * @return a handle to the face, NULL if the memory could not be allocated
+ */
+DCEL_Face_ptr_t dcel_face_new(DCEL_t *self, Point_t site, size_t index);
+
+/**
+ * The space-filling curves along which the records of an edge list can be reordered
+ */
+typedef enum {
+    DCEL_CURVE_MORTON, // The Z-order curve, which interleaves the bits of the coordinates
+    DCEL_CURVE_HILBERT // The Hilbert curve, which never jumps between distant quadrants
+} DCEL_Curve_t;
+
+/**
+ * Renumbers the records of self such that neighbouring cells are close to each other in memory.
+ * The faces are sorted along the curve through their sites, the half-edges follow in the order of a walk around
+ * each face and the vertices in the order in which the walk reaches them. All records move into a single new block
+ * and every link is rewritten, so the handles of the records become invalid.
+ *
+ * The position of a face in faces no longer matches the index of its site afterwards, face->index still does.
+ * The inner_edges arrays of the faces are not owned by the edge list and are kept as they are.
+ *
+ * @param self the edge list handle
+ * @param curve the curve that orders the faces
+ * @return 1 on success, 0 if the memory could not be allocated, in which case self is unchanged
+ */
+uint8_t dcel_reorder(DCEL_t *self, DCEL_Curve_t curve);
+
+/**
+ * Merges pieces of one diagram into a single edge list. Every site belongs to one piece, which holds the correct
+ * cell of the site, like the tiles of a large diagram that were built independently. The edges between cells of
+ * different pieces are matched by the indices of their two sites in a lock-free hash table, and the copies of
+ * the vertices on these seams are merged into one. All phases run in parallel.
+ *
+ * The result does not depend on the number of threads: the half-edges come in the order of the pieces and their
+ * half_edges arrays, the vertices in the order of the half-edges that leave them from their lowest face
+ * and face i is the face of site i. The records of the pieces are overwritten, the pieces can only be cleared or
+ * destroyed afterwards.
+ *
+ * @param self the edge list that receives the merged diagram, cleared first
+ * @param pieces the pieces
+ * @param piece_count the number of pieces
+ * @param owners the piece of every site index. Every face of the merged diagram is taken from the piece of its site
+ * @param face_count the number of sites, which must be less than 2^32
+ * @return 1 on success, 0 if the memory could not be allocated or the pieces do not agree on their seams
+ */
+uint8_t dcel_merge(DCEL_t *self, DCEL_t *pieces, size_t piece_count, const size_t *owners, size_t face_count);
+
+/**
+ * The cells that differ between two diagrams, given by the indices of their sites.
+ *
+ * A cell is identified by the position of its site, so a site that moves counts as removed and added. A cell of
+ * a site in both diagrams has changed if its boundary has: a vertex moved, or it gained or lost a neighbour.
+ * Faces without edges, such as those of duplicate sites or those clipped away, are no cells.
+ * The indices come in the order of the positions of the sites, x first.
+ */
+typedef struct {
+    size_t *added; // The indices in the later diagram of the cells that only it has
+    size_t *removed; // The indices in the earlier diagram of the cells that only it has
+    size_t *changed; // The indices in the later diagram of the cells that changed
+    size_t added_count;
+    size_t removed_count;
+    size_t changed_count;
+} DCEL_Diff_t;
+
+/**
+ * Compares the cells of two diagrams, typically of successive time steps over mostly the same sites.
+ * Every cell is reduced to a hash of its boundary, which is compared with that of the cell of the same site.
+ * The cells are hashed in parallel and sorted by the positions of their sites, which takes O(n log n) time unless
+ * the faces already come in that order, in which case the time is linear.
+ * Two different boundaries share a hash with a probability of about 2^-64, in which case a change goes unreported
+ *
+ * @param self receives the differences, overwritten
+ * @param before the earlier diagram
+ * @param after the later diagram
+ * @return 1 on success, 0 if the memory could not be allocated, in which case self is empty
+ */
+uint8_t dcel_diff(DCEL_Diff_t *self, const DCEL_t *before, const DCEL_t *after);
+
+/**
+ * Frees the arrays of self. The differences are empty afterwards
+ *
+ * @param self the differences
+ */
+void dcel_diff_destroy(DCEL_Diff_t *self);
+
+/**
+ * Removes all records from self but keeps its memory, such that the next diagram can be built without allocations.
+ * The records handed out before become invalid
+ *
+ * @param self the edge list handle
+ */
+void dcel_clear(DCEL_t *self);
+
+/**
+ * Frees the records and the arrays of self. The edge list is empty afterwards
+ *
+ * @param self the edge list handle
+ */
+void dcel_destroy(DCEL_t *self);
 
 #endif //VORONOI_DCEL_H
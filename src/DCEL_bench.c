@@ -0,0 +1,160 @@
+//
+// Micro-benchmarks for the traversal of the edge list before and after its records are reordered
+//
+// Usage: voronoi_dcel_bench [--size sites] [--seed seed]
+//
+// Builds the diagram of uniformly distributed sites and walks around every face in the order of the faces array,
+// reading each neighbouring face like a neighbour query or a renderer would. The walk is measured on the records
+// as the sweep creates them and after reordering them along the Morton and the Hilbert curve.
+// Then the diagram is merged from two pieces that own alternating vertical strips of 64 across the plane,
+// which makes many seams, see dcel_merge.
+// Prints one JSON record per layout and operation, see bench_report.
+//
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "Point.c"
+#include "DCEL.c"
+#include "Delaunay.c"
+#include "PQueue.c"
+#include "RadixQueue.c"
+#include "AVLTree.c"
+#include "VoronoiClip.c"
+#include "VoronoiCells.c"
+#include "VoronoiSites.c"
+#include "VoronoiTrace.c"
+#include "Voronoi.c"
+#include "Bench.c"
+
+static uint64_t random_state;
+
+static uint64_t random_next(uint64_t bound)
+{
+    random_state = random_state * 6364136223846793005ULL + 1442695040888963407ULL;
+    return (random_state >> 33) % bound;
+}
+
+// Keeps the compiler from dropping the walks
+static volatile double sink;
+
+/**
+ * Walks once around every face and visits the vertices and the neighbouring faces on the way
+ *
+ * @param dcel the edge list
+ * @return the number of half-edges visited
+ */
+static size_t bench_face_walk(const DCEL_t *dcel)
+{
+    size_t visited = 0;
+    double sum = 0;
+    for (size_t i = 0; i < dcel->face_count; i++)
+    {
+        DCEL_HalfEdge_ptr_t start = dcel->faces[i]->inc_edge;
+        DCEL_HalfEdge_ptr_t half_edge = start;
+        while (half_edge)
+        {
+            if (half_edge->origin) sum += half_edge->origin->position.x;
+            if (half_edge->twin->inc_face) sum += (double) half_edge->twin->inc_face->site.y;
+            visited++;
+            half_edge = half_edge->next;
+            if (half_edge == start) break;
+        }
+    }
+    sink = sum;
+    return visited;
+}
+
+static void bench_layout(DCEL_t *dcel, const char *structure, Bench_Counter_t *counter)
+{
+    // Warm up once, then measure a few rounds
+    size_t rounds = 5;
+    bench_face_walk(dcel);
+    size_t visited = 0;
+    bench_counter_start(counter);
+    double start = bench_now();
+    for (size_t round = 0; round < rounds; round++)
+    {
+        visited += bench_face_walk(dcel);
+    }
+    double elapsed = bench_now() - start;
+    bench_report(structure, "face_walk", dcel->face_count, visited, elapsed, 0, bench_counter_stop(counter));
+}
+
+int main(int argc, char *argv[])
+{
+    size_t size = 1000000;
+    random_state = 1;
+    for (int i = 1; i + 1 < argc; i += 2)
+    {
+        if (0 == strcmp(argv[i], "--size")) size = strtoull(argv[i + 1], NULL, 10);
+        else if (0 == strcmp(argv[i], "--seed")) random_state = strtoull(argv[i + 1], NULL, 10);
+        else
+        {
+            fprintf(stderr, "voronoi_dcel_bench: unknown option %s\n", argv[i]);
+            return EXIT_FAILURE;
+        }
+    }
+    Point_t *points = malloc(size * sizeof(Point_t));
+    Point_t_ptr *sites = malloc(size * sizeof(Point_t_ptr));
+    if (NULL == points || NULL == sites)
+    {
+        fprintf(stderr, "voronoi_dcel_bench: not enough memory for %zu sites\n", size);
+        return EXIT_FAILURE;
+    }
+    for (size_t i = 0; i < size; i++)
+    {
+        point_init(&points[i], random_next(1ULL << 30), random_next(1ULL << 30));
+        sites[i] = &points[i];
+    }
+
+    Bench_Counter_t counter;
+    bench_counter_open(&counter);
+    const char *structures[2] = {"dcel_morton", "dcel_hilbert"};
+    for (DCEL_Curve_t curve = DCEL_CURVE_MORTON; curve <= DCEL_CURVE_HILBERT; curve++)
+    {
+        DCEL_t dcel = voronoi_diagram(sites, size);
+        if (DCEL_CURVE_MORTON == curve) bench_layout(&dcel, "dcel_sweep", &counter);
+        bench_counter_start(&counter);
+        double start = bench_now();
+        if (! dcel_reorder(&dcel, curve))
+        {
+            fprintf(stderr, "voronoi_dcel_bench: not enough memory to reorder the records\n");
+            return EXIT_FAILURE;
+        }
+        double elapsed = bench_now() - start;
+        bench_report(structures[curve], "reorder", dcel.face_count, dcel.half_edge_count, elapsed, 0,
+                     bench_counter_stop(&counter));
+        bench_layout(&dcel, structures[curve], &counter);
+        dcel_destroy(&dcel);
+    }
+    // Both pieces hold the whole diagram, so that only the merge is measured
+    DCEL_t pieces[2] = {voronoi_diagram(sites, size), voronoi_diagram(sites, size)};
+    size_t *owners = malloc((size + 1) * sizeof(size_t));
+    DCEL_t merged;
+    dcel_init(&merged);
+    for (size_t i = 0; i < size; i++)
+    {
+        owners[i] = (size_t) (points[i].x >> 24) % 2;
+    }
+    bench_counter_start(&counter);
+    double start = bench_now();
+    if (! owners || ! dcel_merge(&merged, pieces, 2, owners, size))
+    {
+        fprintf(stderr, "voronoi_dcel_bench: not enough memory to merge the pieces\n");
+        return EXIT_FAILURE;
+    }
+    double elapsed = bench_now() - start;
+    bench_report("dcel_merge", "strips", merged.face_count, merged.half_edge_count, elapsed, 0,
+                 bench_counter_stop(&counter));
+    dcel_destroy(&pieces[0]);
+    dcel_destroy(&pieces[1]);
+    dcel_destroy(&merged);
+    free(owners);
+
+    bench_counter_close(&counter);
+    free(sites);
+    free(points);
+    return EXIT_SUCCESS;
+}
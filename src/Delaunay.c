@@ -0,0 +1,122 @@
+//
+// Compact storage for a Delaunay triangulation
+//
+
+#include <stdlib.h>
+#include <string.h>
+#include "Delaunay.h"
+
+/**
+ * Initializes an empty triangulation
+ *
+ * @param self the triangulation handle
+ */
+void delaunay_init(Delaunay_t *self)
+{
+    memset(self, 0, sizeof(Delaunay_t));
+}
+
+/**
+ * Reserves room for the given number of triangles in addition to the present ones
+ *
+ * @param self the triangulation handle
+ * @param count the number of triangles
+ * @return 1 on success, 0 if the memory could not be allocated
+ */
+uint8_t delaunay_reserve(Delaunay_t *self, size_t count)
+{
+    if (self->count + count <= self->capacity) return 1;
+    size_t capacity = self->capacity ? self->capacity : 16;
+    while (capacity < self->count + count)
+    {
+        capacity *= 2;
+    }
+    uint32_t *triangles = realloc(self->triangles, 3 * capacity * sizeof(uint32_t));
+    if (NULL == triangles) return 0;
+    self->triangles = triangles;
+    uint32_t *adjacency = realloc(self->adjacency, 3 * capacity * sizeof(uint32_t));
+    if (NULL == adjacency) return 0;
+    self->adjacency = adjacency;
+    self->capacity = capacity;
+    return 1;
+}
+
+/**
+ * Appends a triangle without neighbours
+ *
+ * @param self the triangulation handle
+ * @param a the first site index
+ * @param b the second site index
+ * @param c the third site index, such that a, b and c are in counter-clockwise order
+ * @return the index of the triangle, DELAUNAY_NONE if the memory could not be allocated
+ */
+uint32_t delaunay_add_triangle(Delaunay_t *self, uint32_t a, uint32_t b, uint32_t c)
+{
+    if (! delaunay_reserve(self, 1)) return DELAUNAY_NONE;
+    size_t t = self->count++;
+    self->triangles[3 * t] = a;
+    self->triangles[3 * t + 1] = b;
+    self->triangles[3 * t + 2] = c;
+    self->adjacency[3 * t] = self->adjacency[3 * t + 1] = self->adjacency[3 * t + 2] = DELAUNAY_NONE;
+    return (uint32_t) t;
+}
+
+/**
+ * Yields the position of the site of triangle t that is opposite the edge (a, b)
+ *
+ * @param self the triangulation handle
+ * @param t the triangle
+ * @param a the first site index of the edge
+ * @param b the second site index of the edge
+ * @return the position within the triangle arrays
+ */
+static size_t delaunay_opposite(Delaunay_t *self, uint32_t t, uint32_t a, uint32_t b)
+{
+    size_t i = 3 * (size_t) t;
+    while (self->triangles[i] == a || self->triangles[i] == b)
+    {
+        i++;
+    }
+    return i;
+}
+
+/**
+ * Marks the triangles t and u as neighbours across their common edge (a, b)
+ *
+ * @param self the triangulation handle
+ * @param t the first triangle
+ * @param u the second triangle
+ * @param a the first site index of the common edge
+ * @param b the second site index of the common edge
+ */
+void delaunay_link(Delaunay_t *self, uint32_t t, uint32_t u, uint32_t a, uint32_t b)
+{
+    self->adjacency[delaunay_opposite(self, t, a, b)] = u;
+    self->adjacency[delaunay_opposite(self, u, a, b)] = t;
+}
+
+/**
+ * Removes all triangles from self but keeps its arrays, such that the next triangulation can be recorded
+ * without allocations
+ *
+ * @param self the triangulation handle
+ */
+void delaunay_clear(Delaunay_t *self)
+{
+    self->count = 0;
+}
+
+/**
+ * Frees the arrays of self. The triangulation is empty afterwards
+ *
+ * @param self the triangulation handle
+ */
+void delaunay_destroy(Delaunay_t *self)
+{
+    if (self)
+    {
+        free(self->triangles);
+        free(self->adjacency);
+        delaunay_init(self);
+    }
+}
@@ -0,0 +1,82 @@
+//
+// Compact storage for a Delaunay triangulation
+//
+
+#ifndef VORONOI_DELAUNAY_H
+#define VORONOI_DELAUNAY_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Marks a missing triangle, e.g. the neighbour across an edge of the convex hull
+#define DELAUNAY_NONE UINT32_MAX
+
+/**
+ * A triangulation stored as flat index arrays.
+ *
+ * Triangle t is made of the sites triangles[3t], triangles[3t+1] and triangles[3t+2] in counter-clockwise order,
+ * where a site is identified by its index in the input of the algorithm.
+ * adjacency[3t+i] is the triangle on the other side of the edge opposite triangles[3t+i],
+ * DELAUNAY_NONE if that edge is on the convex hull.
+ */
+typedef struct {
+    uint32_t *triangles;
+    uint32_t *adjacency;
+    size_t count; // The number of triangles
+    size_t capacity; // The number of triangles that fit into the arrays
+} Delaunay_t;
+
+/**
+ * Initializes an empty triangulation
+ *
+ * @param self the triangulation handle
+ */
+void delaunay_init(Delaunay_t *self);
+
+/**
+ * Reserves room for the given number of triangles in addition to the present ones
+ *
+ * @param self the triangulation handle
+ * @param count the number of triangles
+ * @return 1 on success, 0 if the memory could not be allocated
+ */
+uint8_t delaunay_reserve(Delaunay_t *self, size_t count);
+
+/**
+ * Appends a triangle without neighbours
+ *
+ * @param self the triangulation handle
+ * @param a the first site index
+ * @param b the second site index
+ * @param c the third site index, such that a, b and c are in counter-clockwise order
+ * @return the index of the triangle, DELAUNAY_NONE if the memory could not be allocated
+ */
+uint32_t delaunay_add_triangle(Delaunay_t *self, uint32_t a, uint32_t b, uint32_t c);
+
+/**
+ * Marks the triangles t and u as neighbours across their common edge (a, b)
+ *
+ * @param self the triangulation handle
+ * @param t the first triangle
+ * @param u the second triangle
+ * @param a the first site index of the common edge
+ * @param b the second site index of the common edge
+ */
+void delaunay_link(Delaunay_t *self, uint32_t t, uint32_t u, uint32_t a, uint32_t b);
+
+/**
+ * Removes all triangles from self but keeps its arrays, such that the next triangulation can be recorded
+ * without allocations
+ *
+ * @param self the triangulation handle
+ */
+void delaunay_clear(Delaunay_t *self);
+
+/**
+ * Frees the arrays of self. The triangulation is empty afterwards
+ *
+ * @param self the triangulation handle
+ */
+void delaunay_destroy(Delaunay_t *self);
+
+#endif //VORONOI_DELAUNAY_H
@@ -11,95 +11,27 @@
  * http://jamiemorgenstern.com/teaching/su-122/lectures/14
  */
 
-/**
- * Swaps the node at index first with the node at index second
- *
- * @param self the queue handle
- * @param first the first node index
- * @param second the second node index
- */
-static void swap(PQueue_t *self, uint64_t first, uint64_t second)
-{
-    void* tmp = self->heap[first];
-    self->heap[first] = self->heap[second];
-    self->heap[second] = tmp;
-}
-
-/**
- * Restores the ordering invariant of the heap tree after an enqueue operation
- *
- * @param self the queue handle
- * @param i the current node index of the heap tree
- * @return the new node index
- */
-static uint64_t sift_up(PQueue_t *self, uint64_t i)
-{
-    // Iterate until we reach the root node index, which is 1
-    uint64_t current = i;
-    while (current > 1)
-    {
-        // Compute the position of the parent node
-        uint64_t parent = current/2;
-        // If the parent has a lower priority than its child, swap them
-        if (self->cmp(self->heap[parent], self->heap[current]) == -1)
-        {
-            swap(self, parent, current);
-        }
-        // Set the current node to the parent node to continue the iteration
-        current = parent;
-    }
-    return current;
-}
+// The heap operations, with the comparator of the queue behind a function pointer
+#define PQUEUE_PREFIX priority_queue
+#define PQUEUE_LINKAGE
+#define PQUEUE_COMPARE(self, first, second) (self)->cmp(first, second)
+#include "PQueueTemplate.h"
 
 /**
- * Restores the ordering invariant of the heap tree after a dequeue operation
+ * Allocates an array of count nodes whose child groups, which start at the index 2, are aligned to a cache line
  *
- * @param self the queue handle
- * @param i the current node index of the heap three
+ * @param count the number of nodes
+ * @param size the size of a node
+ * @param block receives the allocation to free later on
+ * @return the array, or NULL if the memory could not be allocated
  */
-static void sift_down(PQueue_t *self, uint64_t i)
+static void *priority_queue_aligned_array(uint64_t count, size_t size, void **block)
 {
-    while(1)
-    {
-        // Compute the positions of i's children
-        uint64_t left_child = 2*i;
-        uint64_t right_child = 2*i+1;
-        uint64_t current_child;
-
-        // We need to take the path of highest priority
-        // We therefore compare the priority measurements of the children
-        // First, let's check if i even has both children
-        if (right_child >= self->next)
-        {
-            if (left_child >= self->next)
-            {
-                // i is a leaf node, so we return gracefully
-                return;
-            }
-            // i has no right child, but it does have a left child
-            // This is the only path to take
-            current_child = left_child;
-        }
-        // i has both children, so compare their priorities to determine the path
-        else if (self->cmp(self->heap[left_child], self->heap[right_child]) >= 0)
-        {
-            // The left child has a higher or equal priority to the right child. We therefore take its path.
-            current_child = left_child;
-        }
-        else
-        {
-            // The right child has a higher priority than the left child. We therefore take its path
-            current_child = right_child;
-        }
-        if (self->cmp(self->heap[current_child], self->heap[i]) <= 0) return;
-        else
-        {
-            // Swap the child with the current node if its priority is higher
-            swap(self, current_child, i);
-            // Continue the iteration on the next layer of the heap
-            i = current_child;
-        }
-    }
+    *block = calloc(count * size + 2 * PQUEUE_CACHE_LINE, 1);
+    if (NULL == *block) return NULL;
+    uintptr_t groups = (uintptr_t) *block + 2 * size;
+    groups = (groups + PQUEUE_CACHE_LINE - 1) & ~((uintptr_t) PQUEUE_CACHE_LINE - 1);
+    return (void *) (groups - 2 * size);
 }
 
 /**
@@ -112,10 +44,14 @@ static void sift_down(PQueue_t *self, uint64_t i)
 PQueue_t *priority_queue_new(uint64_t size, priority_queue_comparator comparator)
 {
     PQueue_t *queue = malloc(sizeof(PQueue_t));
-    queue->heap = calloc(size, sizeof(void*));
+    queue->heap = priority_queue_aligned_array(size, sizeof(void*), &queue->heap_block);
+    queue->keys = priority_queue_aligned_array(size, sizeof(double), &queue->keys_block);
     queue->size = size;
     queue->cmp = comparator;
     queue->next = 1;
+#ifdef VORONOI_STATS
+    queue->comparisons = 0;
+#endif
     return queue;
 }
 
@@ -151,64 +87,19 @@ uint8_t priority_queue_is_full(PQueue_t *self)
  */
 void priority_queue_enqueue(PQueue_t *self, void *element)
 {
-    if (! priority_queue_is_full(self))
-    {
-        // Add the node to the end of the tree
-        // This breaks the ordering invariant of the algorithm!
-        self->heap[self->next] = element;
-        self->next++;
-        // Reconstruct the ordering invariant by pushing the element up in the tree
-        sift_up(self, self->next-1);
-    }
+    priority_queue_enqueue_keyed(self, element, 0);
 }
 
 /**
- * Delete the element with the highest priority from self
+ * Returns the element with the highest priority without removing it
  *
  * @param self the queue handle
- * @return the data element of the dequeued node
+ * @return the data element of the root node, or NULL if the queue is empty
  */
-void *priority_queue_dequeue(PQueue_t *self)
+void *priority_queue_peek(PQueue_t *self)
 {
     if (priority_queue_is_empty(self)) return NULL;
-    else
-    {
-        void* prev_root = self->heap[1];
-        // Swap the last element with the root
-        // This effectively dequeues the root element whilst preserving the tree structure of the heap
-        swap(self, 1, self->next-1);
-        self->next--;
-        if (self->next > 1) sift_down(self, 1);
-        return prev_root;
-    }
-}
-
-/**
- * Deletes the element at position idx from the queue
- *
- * @param self the queue handle
- * @param idx the position of the element to delete
- */
-void priority_queue_delete(PQueue_t *self, size_t idx)
-{
-    // The invariant is broken here
-    swap(self, idx, self->next-1);
-    self->next--;
-    if (idx < self->next)
-    {
-        // Determine the parent of the node that broke the invariant
-        size_t parent = idx/2;
-        // If the parent's priority is lower than the node, sift up to restore the invariant
-        if (parent >= 1 && self->cmp(self->heap[parent], self->heap[idx]) == -1)
-        {
-            sift_up(self, idx);
-        }
-        // If the parent's priority is higher than this node's, sift down to restore the invariant
-        else
-        {
-            sift_down(self, idx);
-        }
-    }
+    return self->heap[1];
 }
 
 /**
@@ -220,10 +111,8 @@ void priority_queue_destroy(PQueue_t *self)
 {
     if (self)
     {
-        if (self->heap)
-        {
-            free(self->heap);
-        }
+        free(self->heap_block);
+        free(self->keys_block);
         free(self);
     }
 }
\ No newline at end of file
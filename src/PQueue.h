@@ -11,6 +11,23 @@
 #include <stdlib.h>
 #include <stdint.h>
 #include <string.h>
+#include "VoronoiStats.h"
+
+/**
+ * The number of children of every heap node, fixed at compile time. The children of a node are stored next to each
+ * other and every group starts on a cache line, so a 4-ary heap of pointers reads half a line per level and an 8-ary
+ * heap a whole line. A wider heap is shallower, but compares more children per level.
+ */
+#ifndef PQUEUE_ARITY
+#define PQUEUE_ARITY 2
+#endif
+
+#if PQUEUE_ARITY != 2 && PQUEUE_ARITY != 4 && PQUEUE_ARITY != 8
+#error "PQUEUE_ARITY must be 2, 4 or 8"
+#endif
+
+// The size of the cache line the child groups are aligned to
+#define PQUEUE_CACHE_LINE 64
 
 /**
  * A comparator function responsible for prioritizing one element over the other
@@ -35,12 +52,23 @@ typedef int8_t (*priority_queue_comparator)(void* first, void* second);
  * This means that the standard interface of a priority queue won't cut it. We need  an additional operation that allows us to
  * remove elements from the queue at an arbitrary index provided by the user! We implement this operation and call it 'delete'.
  * Note that a delete, compared to a dequeue, has a time complexity of O(log n) and not O(1).
+ *
+ * Every node also carries an inline key next to the element. Elements with a higher key have a higher priority and
+ * the comparator only breaks ties between equal keys, so the children of a node are usually picked by scanning an array
+ * of doubles without following a single element pointer. Elements enqueued without a key all share the key 0,
+ * in which case the comparator alone decides.
  */
 typedef struct {
     uint64_t size; // The size of the underlying heap
     uint64_t next; // Index where the next element should be added
     priority_queue_comparator cmp; // A comparator function that determines the priority of the heap nodes
     void **heap; // An efficient representation of a heap tree
+    double *keys; // The inline key of each heap node, keys[i] belongs to heap[i]
+    void *heap_block; // The allocation behind heap, which is aligned inside of it
+    void *keys_block; // The allocation behind keys
+#ifdef VORONOI_STATS
+    uint64_t comparisons; // The number of comparator calls
+#endif
 } PQueue_t;
 
 /**
@@ -76,6 +104,16 @@ uint8_t priority_queue_is_full(PQueue_t *self);
  */
 void priority_queue_enqueue(PQueue_t *self, void *element);
 
+/**
+ * Insert element with an inline key into self. The key must agree with the comparator: if the key of one element is
+ * higher than the key of another, the comparator must give it a higher priority as well
+ *
+ * @param self the queue handle
+ * @param element the element to enqueue
+ * @param key the priority of the element, higher keys are dequeued first
+ */
+void priority_queue_enqueue_keyed(PQueue_t *self, void *element, double key);
+
 /**
  * Delete the element with the highest priority from self
  *
@@ -84,6 +122,14 @@ void priority_queue_enqueue(PQueue_t *self, void *element);
  */
 void *priority_queue_dequeue(PQueue_t *self);
 
+/**
+ * Returns the element with the highest priority without removing it
+ *
+ * @param self the queue handle
+ * @return the data element of the root node, or NULL if the queue is empty
+ */
+void *priority_queue_peek(PQueue_t *self);
+
 /**
  * Deletes the element at position idx from the queue
  *
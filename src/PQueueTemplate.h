@@ -0,0 +1,235 @@
+//
+// The heap operations of PQueue_t as a macro template, instantiated once per comparator
+//
+// Define before including:
+//   PQUEUE_PREFIX                         the prefix of the function names, e.g. priority_queue
+//   PQUEUE_LINKAGE                        the linkage of the enqueue, dequeue and delete functions, e.g. static inline
+//   PQUEUE_COMPARE(self, first, second)   compares two elements like a priority_queue_comparator
+//
+// PQueue.c instantiates the template with the comparator of the queue, and a user with a fixed element type can
+// instantiate it with its comparator itself, which the compiler then inlines into the sift loops. All instances work
+// on the same PQueue_t, so a queue from priority_queue_new can be passed to any of them. The macros are undefined
+// at the end, such that one translation unit can hold several instances.
+//
+
+#include "PQueue.h"
+
+#if ! defined(PQUEUE_PREFIX) || ! defined(PQUEUE_LINKAGE) || ! defined(PQUEUE_COMPARE)
+#error "PQUEUE_PREFIX, PQUEUE_LINKAGE and PQUEUE_COMPARE must be defined before including PQueueTemplate.h"
+#endif
+
+#define PQUEUE_JOIN(prefix, name) prefix##_##name
+#define PQUEUE_EXPAND(prefix, name) PQUEUE_JOIN(prefix, name)
+#define PQUEUE_NAME(name) PQUEUE_EXPAND(PQUEUE_PREFIX, name)
+
+// The index of the first child and of the parent of node i. The root has the index 1
+#ifndef PQUEUE_FIRST_CHILD
+#define PQUEUE_FIRST_CHILD(i) (PQUEUE_ARITY * ((i) - 1) + 2)
+#define PQUEUE_PARENT(i) (((i) - 2) / PQUEUE_ARITY + 1)
+#endif
+
+/**
+ * Moves the node at index from into the slot at index to. The slot at from becomes the hole
+ *
+ * @param self the queue handle
+ * @param to the index of the hole
+ * @param from the node index
+ */
+static inline void PQUEUE_NAME(move)(PQueue_t *self, uint64_t to, uint64_t from)
+{
+    self->heap[to] = self->heap[from];
+    self->keys[to] = self->keys[from];
+}
+
+/**
+ * Compares the priorities of two elements
+ *
+ * @param self the queue handle
+ * @param first the first element
+ * @param second the second element
+ * @return the result of the comparator
+ */
+static inline int8_t PQUEUE_NAME(compare)(PQueue_t *self, void *first, void *second)
+{
+    (void) self;
+    VORONOI_STATS_ADD(self->comparisons, 1);
+    return PQUEUE_COMPARE(self, first, second);
+}
+
+/**
+ * Compares the priority of the node at index i with the priority of an element that is not in the heap yet.
+ * The inline keys decide and the comparator breaks ties
+ *
+ * @param self the queue handle
+ * @param i the node index
+ * @param element the element
+ * @param key the inline key of the element
+ * @return -1, 0 or 1 like the comparator
+ */
+static inline int8_t PQUEUE_NAME(compare_node)(PQueue_t *self, uint64_t i, void *element, double key)
+{
+    if (self->keys[i] > key) return 1;
+    if (self->keys[i] < key) return -1;
+    return PQUEUE_NAME(compare)(self, self->heap[i], element);
+}
+
+/**
+ * Finds the child of highest priority among the children first up to, but excluding, last. The keys of a child group
+ * are contiguous, so the first loop compiles to a branch-free scan. Only children that tie with the highest key
+ * are passed to the comparator, and on equal priority the leftmost child wins
+ *
+ * @param self the queue handle
+ * @param first the index of the first child
+ * @param last the index after the last child
+ * @return the index of the child of highest priority
+ */
+static inline uint64_t PQUEUE_NAME(highest_child)(PQueue_t *self, uint64_t first, uint64_t last)
+{
+    const double *keys = self->keys;
+    double highest = keys[first];
+    for (uint64_t child = first + 1; child < last; child++)
+    {
+        highest = keys[child] > highest ? keys[child] : highest;
+    }
+    uint64_t best = last;
+    for (uint64_t child = first; child < last; child++)
+    {
+        if (keys[child] != highest) continue;
+        if (best == last || PQUEUE_NAME(compare)(self, self->heap[child], self->heap[best]) > 0) best = child;
+    }
+    return best;
+}
+
+/**
+ * Restores the ordering invariant of the heap tree after an enqueue operation. Starting from the hole at index i,
+ * the parents of lower priority than element move down one level each, and element is written once into the slot
+ * where the hole stops. The walk ends at the first parent of higher or equal priority, so on random keys an enqueue
+ * only climbs a constant number of levels on average
+ *
+ * @param self the queue handle
+ * @param i the index of the hole
+ * @param element the element to place
+ * @param key the inline key of the element
+ * @return the new node index
+ */
+static inline uint64_t PQUEUE_NAME(sift_up)(PQueue_t *self, uint64_t i, void *element, double key)
+{
+    // Iterate until we reach the root node index, which is 1
+    uint64_t current = i;
+    while (current > 1)
+    {
+        // Compute the position of the parent node
+        uint64_t parent = PQUEUE_PARENT(current);
+        // The invariant holds above a parent of higher or equal priority
+        if (PQUEUE_NAME(compare_node)(self, parent, element, key) >= 0) break;
+        // Otherwise the parent moves down into the hole
+        PQUEUE_NAME(move)(self, current, parent);
+        current = parent;
+    }
+    self->heap[current] = element;
+    self->keys[current] = key;
+    return current;
+}
+
+/**
+ * Restores the ordering invariant of the heap tree after a dequeue operation. The child of highest priority moves
+ * up into the hole at index i until no child has a higher priority than element, which is then written once
+ *
+ * @param self the queue handle
+ * @param i the index of the hole
+ * @param element the element to place
+ * @param key the inline key of the element
+ */
+static inline void PQUEUE_NAME(sift_down)(PQueue_t *self, uint64_t i, void *element, double key)
+{
+    while(1)
+    {
+        // Compute the positions of i's children
+        uint64_t first_child = PQUEUE_FIRST_CHILD(i);
+        // i is a leaf node, so the element belongs here
+        if (first_child >= self->next) break;
+        uint64_t last_child = first_child + PQUEUE_ARITY;
+        if (last_child > self->next) last_child = self->next;
+
+        // We need to take the path of highest priority
+        uint64_t current_child = PQUEUE_NAME(highest_child)(self, first_child, last_child);
+        if (PQUEUE_NAME(compare_node)(self, current_child, element, key) <= 0) break;
+        // Move the child up if its priority is higher and continue on the next layer of the heap
+        PQUEUE_NAME(move)(self, i, current_child);
+        i = current_child;
+    }
+    self->heap[i] = element;
+    self->keys[i] = key;
+}
+
+/**
+ * Insert element with an inline key into self. The key must agree with the comparator: if the key of one element is
+ * higher than the key of another, the comparator must give it a higher priority as well
+ *
+ * @param self the queue handle
+ * @param element the element to enqueue
+ * @param key the priority of the element, higher keys are dequeued first
+ */
+PQUEUE_LINKAGE void PQUEUE_NAME(enqueue_keyed)(PQueue_t *self, void *element, double key)
+{
+    if (self->next != self->size)
+    {
+        // Open a hole at the end of the tree and move it up to where the element keeps the ordering invariant
+        self->next++;
+        PQUEUE_NAME(sift_up)(self, self->next-1, element, key);
+    }
+}
+
+/**
+ * Delete the element with the highest priority from self
+ *
+ * @param self the queue handle
+ * @return the data element of the dequeued node
+ */
+PQUEUE_LINKAGE void *PQUEUE_NAME(dequeue)(PQueue_t *self)
+{
+    if (self->next == 1) return NULL;
+    else
+    {
+        void* prev_root = self->heap[1];
+        // The root becomes a hole and the last element is placed into it
+        // This effectively dequeues the root element whilst preserving the tree structure of the heap
+        self->next--;
+        if (self->next > 1) PQUEUE_NAME(sift_down)(self, 1, self->heap[self->next], self->keys[self->next]);
+        return prev_root;
+    }
+}
+
+/**
+ * Deletes the element at position idx from the queue
+ *
+ * @param self the queue handle
+ * @param idx the position of the element to delete
+ */
+PQUEUE_LINKAGE void PQUEUE_NAME(delete)(PQueue_t *self, size_t idx)
+{
+    // The deleted node becomes a hole and the last element has to be placed into it
+    self->next--;
+    if (idx < self->next)
+    {
+        void *element = self->heap[self->next];
+        double key = self->keys[self->next];
+        // If the parent's priority is lower than the element, sift up to restore the invariant
+        if (idx > 1 && PQUEUE_NAME(compare_node)(self, PQUEUE_PARENT(idx), element, key) == -1)
+        {
+            PQUEUE_NAME(sift_up)(self, idx, element, key);
+        }
+        // If the parent's priority is higher than the element's, sift down to restore the invariant
+        else
+        {
+            PQUEUE_NAME(sift_down)(self, idx, element, key);
+        }
+    }
+}
+
+#undef PQUEUE_NAME
+#undef PQUEUE_EXPAND
+#undef PQUEUE_JOIN
+#undef PQUEUE_PREFIX
+#undef PQUEUE_LINKAGE
+#undef PQUEUE_COMPARE
@@ -0,0 +1,202 @@
+//
+// Micro-benchmarks for the priority queue under the access patterns of the sweep
+//
+// Usage: voronoi_queue_bench [--size elements] [--seed seed]
+//
+// Prints one JSON record per workload and operation, see bench_report. Every workload runs once with the comparator
+// alone and once with inline keys. The arity of the heap is fixed at compile time, so there is one build of this
+// benchmark per arity: voronoi_queue_bench, voronoi_queue_4ary_bench and voronoi_queue_8ary_bench.
+//
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include "PQueue.c"
+#include "Bench.c"
+
+static uint64_t comparisons = 0;
+
+static uint64_t random_state;
+
+static uint64_t random_next(uint64_t bound)
+{
+    random_state = random_state * 6364136223846793005ULL + 1442695040888963407ULL;
+    return (random_state >> 33) % bound;
+}
+
+/**
+ * Prefers the smaller key, like the event queue prefers the event that the sweep line reaches first
+ */
+static int8_t min_heap_comparator(void *first, void *second)
+{
+    comparisons++;
+    uint64_t first_key = *(uint64_t *) first;
+    uint64_t second_key = *(uint64_t *) second;
+    if (first_key < second_key) return 1;
+    else if (first_key > second_key) return -1;
+    else return 0;
+}
+
+/**
+ * Measures the operations between two calls
+ */
+typedef struct {
+    uint8_t is_keyed; // Whether the elements are enqueued with inline keys
+    double start;
+    uint64_t comparisons;
+    Bench_Counter_t counter;
+} Bench_Measure_t;
+
+static void measure_start(Bench_Measure_t *measure)
+{
+    comparisons = 0;
+    bench_counter_start(&measure->counter);
+    measure->start = bench_now();
+}
+
+static void measure_stop(Bench_Measure_t *measure, const char *workload, size_t size, size_t operations)
+{
+    double elapsed = bench_now() - measure->start;
+    int64_t cache_misses = bench_counter_stop(&measure->counter);
+    char structure[32];
+    snprintf(structure, sizeof(structure), "pqueue_%dary%s", PQUEUE_ARITY, measure->is_keyed ? "_keyed" : "");
+    bench_report(structure, workload, size, operations, elapsed, comparisons, cache_misses);
+}
+
+/**
+ * Enqueues the key, with the key as the inline key as well if the workload is keyed
+ */
+static void enqueue(const Bench_Measure_t *measure, PQueue_t *queue, uint64_t *key)
+{
+    if (measure->is_keyed) priority_queue_enqueue_keyed(queue, key, -(double) *key);
+    else priority_queue_enqueue(queue, key);
+}
+
+/**
+ * The site events: keys arrive in priority order and leave in the same order
+ */
+static void bench_monotone(Bench_Measure_t *measure, uint64_t *keys, size_t size)
+{
+    PQueue_t *queue = priority_queue_new(size + 1, min_heap_comparator);
+    for (size_t i = 0; i < size; i++)
+    {
+        keys[i] = i;
+    }
+    measure_start(measure);
+    for (size_t i = 0; i < size; i++)
+    {
+        enqueue(measure, queue, &keys[i]);
+    }
+    measure_stop(measure, "monotone_enqueue", size, size);
+    measure_start(measure);
+    for (size_t i = 0; i < size; i++)
+    {
+        priority_queue_dequeue(queue);
+    }
+    measure_stop(measure, "monotone_dequeue", size, size);
+    priority_queue_destroy(queue);
+}
+
+/**
+ * Fills a heap with random keys and drains it again, the throughput of a full event queue
+ */
+static void bench_random(Bench_Measure_t *measure, uint64_t *keys, size_t size)
+{
+    PQueue_t *queue = priority_queue_new(size + 1, min_heap_comparator);
+    for (size_t i = 0; i < size; i++)
+    {
+        keys[i] = random_next(64 * size);
+    }
+    measure_start(measure);
+    for (size_t i = 0; i < size; i++)
+    {
+        enqueue(measure, queue, &keys[i]);
+    }
+    measure_stop(measure, "random_enqueue", size, size);
+    measure_start(measure);
+    for (size_t i = 0; i < size; i++)
+    {
+        priority_queue_dequeue(queue);
+    }
+    measure_stop(measure, "random_dequeue", size, size);
+    priority_queue_destroy(queue);
+}
+
+/**
+ * The circle events: every dequeue is followed by an enqueue of a key just behind the minimum
+ */
+static void bench_near_min(Bench_Measure_t *measure, uint64_t *keys, size_t size)
+{
+    PQueue_t *queue = priority_queue_new(size + 1, min_heap_comparator);
+    for (size_t i = 0; i < size; i++)
+    {
+        keys[i] = random_next(64 * size);
+        enqueue(measure, queue, &keys[i]);
+    }
+    measure_start(measure);
+    for (size_t i = 0; i < size; i++)
+    {
+        uint64_t *key = (uint64_t *) priority_queue_dequeue(queue);
+        *key += 1 + random_next(64);
+        enqueue(measure, queue, key);
+    }
+    measure_stop(measure, "near_min_dequeue_enqueue", size, 2 * size);
+    priority_queue_destroy(queue);
+}
+
+/**
+ * The invalidated circle events: deletes of recently enqueued elements near the bottom of the heap
+ */
+static void bench_localised_delete(Bench_Measure_t *measure, uint64_t *keys, size_t size)
+{
+    PQueue_t *queue = priority_queue_new(size + 1, min_heap_comparator);
+    for (size_t i = 0; i < size; i++)
+    {
+        keys[i] = random_next(64 * size);
+        enqueue(measure, queue, &keys[i]);
+    }
+    size_t operations = size / 2;
+    measure_start(measure);
+    for (size_t i = 0; i < operations; i++)
+    {
+        size_t last = queue->next - 1;
+        priority_queue_delete(queue, last - random_next(last / 2 + 1));
+    }
+    measure_stop(measure, "localised_delete", size, operations);
+    priority_queue_destroy(queue);
+}
+
+int main(int argc, char *argv[])
+{
+    size_t size = 1000000;
+    random_state = 1;
+    for (int i = 1; i + 1 < argc; i += 2)
+    {
+        if (0 == strcmp(argv[i], "--size")) size = strtoull(argv[i + 1], NULL, 10);
+        else if (0 == strcmp(argv[i], "--seed")) random_state = strtoull(argv[i + 1], NULL, 10);
+        else
+        {
+            fprintf(stderr, "voronoi_queue_bench: unknown option %s\n", argv[i]);
+            return EXIT_FAILURE;
+        }
+    }
+    uint64_t *keys = malloc((size + 1) * sizeof(uint64_t));
+    if (NULL == keys)
+    {
+        fprintf(stderr, "voronoi_queue_bench: not enough memory for %zu elements\n", size);
+        return EXIT_FAILURE;
+    }
+
+    Bench_Measure_t measure;
+    bench_counter_open(&measure.counter);
+    for (uint8_t is_keyed = 0; is_keyed <= 1; is_keyed++)
+    {
+        measure.is_keyed = is_keyed;
+        bench_monotone(&measure, keys, size);
+        bench_random(&measure, keys, size);
+        bench_near_min(&measure, keys, size);
+        bench_localised_delete(&measure, keys, size);
+    }
+    bench_counter_close(&measure.counter);
+    free(keys);
+    return EXIT_SUCCESS;
+}
@@ -24,6 +24,8 @@ void test_priority_queue_init()
     priority_queue_destroy(queue);
 }
 
+// The slots below are those of a binary heap
+#if PQUEUE_ARITY == 2
 void test_priority_queue_enqueue()
 {
     PQueue_t *queue = priority_queue_new(10, min_heap_comparator);
@@ -99,10 +101,80 @@ void test_priority_queue_dequeue()
     assert(priority_queue_is_empty(queue));
     priority_queue_destroy(queue);
 }
+#endif
+
+void test_priority_queue_alignment()
+{
+    PQueue_t *queue = priority_queue_new(100, min_heap_comparator);
+    // No group of children straddles two cache lines
+    for (uint64_t i = 1; PQUEUE_ARITY * (i - 1) + 2 < 100; i++)
+    {
+        uintptr_t children = (uintptr_t) &queue->heap[PQUEUE_ARITY * (i - 1) + 2];
+        uintptr_t keys = (uintptr_t) &queue->keys[PQUEUE_ARITY * (i - 1) + 2];
+        assert(children % PQUEUE_CACHE_LINE + PQUEUE_ARITY * sizeof(void *) <= PQUEUE_CACHE_LINE);
+        assert(keys % PQUEUE_CACHE_LINE + PQUEUE_ARITY * sizeof(double) <= PQUEUE_CACHE_LINE);
+    }
+    priority_queue_destroy(queue);
+}
+
+void test_priority_queue_order()
+{
+    int32_t values[200];
+    uint32_t state = 7;
+    for (int32_t i = 0; i < 200; i++)
+    {
+        state = state * 1103515245 + 12345;
+        values[i] = (int32_t) (state >> 16) % 50;
+    }
+
+    // Without keys the comparator alone orders the elements
+    PQueue_t *queue = priority_queue_new(201, min_heap_comparator);
+    for (int32_t i = 0; i < 200; i++)
+    {
+        priority_queue_enqueue(queue, &values[i]);
+    }
+    int32_t previous = -1;
+    for (int32_t i = 0; i < 200; i++)
+    {
+        int32_t value = *(int32_t *) priority_queue_dequeue(queue);
+        assert(value >= previous);
+        previous = value;
+    }
+    assert(priority_queue_is_empty(queue));
+    void *element = priority_queue_dequeue(queue);
+    assert(element == NULL);
+
+    // With keys, which agree with the comparator, the order is the same
+    for (int32_t i = 0; i < 200; i++)
+    {
+        priority_queue_enqueue_keyed(queue, &values[i], -values[i] / 10);
+    }
+    // Delete a few elements from the middle of the heap
+    for (size_t idx = 50; idx > 10; idx -= 10)
+    {
+        priority_queue_delete(queue, idx);
+    }
+    previous = -1;
+    size_t count = 0;
+    while (! priority_queue_is_empty(queue))
+    {
+        int32_t value = *(int32_t *) priority_queue_dequeue(queue);
+        assert(value >= previous);
+        previous = value;
+        count++;
+    }
+    assert(count == 196);
+    priority_queue_destroy(queue);
+}
+
 
 int main(int argc, char *argv[])
 {
     test_priority_queue_init();
+#if PQUEUE_ARITY == 2
     test_priority_queue_enqueue();
     test_priority_queue_dequeue();
+#endif
+    test_priority_queue_alignment();
+    test_priority_queue_order();
 }
\ No newline at end of file
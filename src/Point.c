@@ -16,8 +16,28 @@ void point_init(Point_t *self, uint64_t x, uint64_t y)
 {
     self->x = x;
     self->y = y;
+#ifdef VORONOI_WEIGHTED
+    self->weight = 0;
+#endif
 }
 
+#ifdef VORONOI_WEIGHTED
+/**
+ * Initializes a point with the given x and y coordinates and weight
+ *
+ * @param self the point handle
+ * @param x the x coordinate
+ * @param y the y coordinate
+ * @param weight the weight
+ */
+void point_init_weighted(Point_t *self, uint64_t x, uint64_t y, double weight)
+{
+    self->x = x;
+    self->y = y;
+    self->weight = weight;
+}
+#endif
+
 /**
  * Frees the memory block used by self
  *
@@ -38,5 +58,8 @@ void point_destroy(Point_t *self)
  */
 double point_euclidean_distance(Point_t *self, Point_t *other)
 {
-    return sqrt(pow( self->x - other->x, 2) + pow( self->y - other->y, 2));
+    // The coordinates are unsigned, so they are subtracted as doubles
+    double dx = (double) self->x - (double) other->x;
+    double dy = (double) self->y - (double) other->y;
+    return sqrt(dx * dx + dy * dy);
 }
@@ -7,13 +7,28 @@
 #include <stdint.h>
 
 // A pair (x, y)
+// Built with VORONOI_WEIGHTED, a point carries an additive weight as well. The cell of a weighted site holds the
+// points q for which |q - site| - weight is smallest, so with the radii of disks as weights the cells are those of
+// the disks. Only the differences between the weights matter.
 typedef struct {
     uint64_t x;
     uint64_t y;
+#ifdef VORONOI_WEIGHTED
+    double weight;
+#endif
 } Point_t;
 
 typedef Point_t* Point_t_ptr;
 
+// A pair (x, y) of real coordinates
+// Used for positions that are computed from the sites rather than given, e.g. the vertices of a diagram
+typedef struct {
+    double x;
+    double y;
+} Point_Real_t;
+
+typedef Point_Real_t* Point_Real_ptr_t;
+
 /**
  * Initializes a point with the given x and y coordinates
  *
@@ -23,6 +38,18 @@ typedef Point_t* Point_t_ptr;
  */
 void point_init(Point_t *self, uint64_t x, uint64_t y);
 
+#ifdef VORONOI_WEIGHTED
+/**
+ * Initializes a point with the given x and y coordinates and weight
+ *
+ * @param self the point handle
+ * @param x the x coordinate
+ * @param y the y coordinate
+ * @param weight the weight
+ */
+void point_init_weighted(Point_t *self, uint64_t x, uint64_t y, double weight);
+#endif
+
 /**
  * Frees the memory block used by self
  *
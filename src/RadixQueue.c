@@ -0,0 +1,194 @@
+//
+// A monotone priority queue over integer keys
+//
+
+#include <stdlib.h>
+#include <string.h>
+#include "RadixQueue.h"
+
+/**
+ * Returns the bucket of key, that is the highest bit in which it differs from the last dequeued key
+ *
+ * @param self the queue handle
+ * @param key a key above the last one
+ * @return the bucket index
+ */
+static uint64_t radix_queue_bucket(Radix_Queue_t *self, uint64_t key)
+{
+    return 63 - (uint64_t) __builtin_clzll(key ^ self->last);
+}
+
+/**
+ * Makes sure that a bucket has room for count more entries
+ *
+ * @param bucket the bucket
+ * @param count the number of entries to make room for
+ * @return 1 on success, 0 if the memory could not be allocated
+ */
+static uint8_t radix_queue_bucket_reserve(Radix_Queue_Bucket_t *bucket, uint64_t count)
+{
+    if (bucket->count + count <= bucket->capacity) return 1;
+    uint64_t capacity = bucket->capacity ? 2 * bucket->capacity : 16;
+    while (capacity < bucket->count + count) capacity *= 2;
+    Radix_Queue_Entry_t *entries = realloc(bucket->entries, capacity * sizeof(Radix_Queue_Entry_t));
+    if (NULL == entries) return 0;
+    bucket->entries = entries;
+    bucket->capacity = capacity;
+    return 1;
+}
+
+/**
+ * Appends an entry to a bucket, growing it if needed
+ *
+ * @param bucket the bucket
+ * @param element the element
+ * @param key the key of the element
+ * @return 1 on success, 0 if the memory could not be allocated, in which case the bucket is unchanged
+ */
+static uint8_t radix_queue_bucket_push(Radix_Queue_Bucket_t *bucket, void *element, uint64_t key)
+{
+    if (! radix_queue_bucket_reserve(bucket, 1)) return 0;
+    bucket->entries[bucket->count].element = element;
+    bucket->entries[bucket->count].key = key;
+    bucket->count++;
+    return 1;
+}
+
+/**
+ * Moves the smallest key into the heap of ties: the smallest key of the lowest non-empty bucket becomes the last key
+ * and the remaining entries of that bucket spread over the buckets below it. The buckets below are grown before
+ * any entry moves, so no entry is lost if that fails
+ *
+ * @param self the queue handle
+ * @return 1 on success, 0 if the memory could not be allocated, in which case the queue is unchanged
+ */
+static uint8_t radix_queue_refill(Radix_Queue_t *self)
+{
+    uint64_t b = 0;
+    while (0 == self->buckets[b].count) b++;
+    Radix_Queue_Bucket_t *bucket = &self->buckets[b];
+    uint64_t last = bucket->entries[0].key;
+    for (uint64_t i = 1; i < bucket->count; i++)
+    {
+        if (bucket->entries[i].key < last) last = bucket->entries[i].key;
+    }
+    uint64_t previous = self->last;
+    self->last = last;
+    uint64_t counts[RADIX_QUEUE_BUCKETS] = {0};
+    for (uint64_t i = 0; i < bucket->count; i++)
+    {
+        if (bucket->entries[i].key != last) counts[radix_queue_bucket(self, bucket->entries[i].key)]++;
+    }
+    for (uint64_t below = 0; below < b; below++)
+    {
+        if (! radix_queue_bucket_reserve(&self->buckets[below], counts[below]))
+        {
+            self->last = previous;
+            return 0;
+        }
+    }
+    for (uint64_t i = 0; i < bucket->count; i++)
+    {
+        Radix_Queue_Entry_t entry = bucket->entries[i];
+        if (entry.key == last) priority_queue_enqueue(self->ties, entry.element);
+        else radix_queue_bucket_push(&self->buckets[radix_queue_bucket(self, entry.key)], entry.element, entry.key);
+    }
+    bucket->count = 0;
+    return 1;
+}
+
+/**
+ * Allocate memory for a radix queue with a maximum capacity of size
+ *
+ * @param size the maximum size of the queue
+ * @param comparator orders the elements of equal keys
+ * @return a handle to a Radix_Queue_t object, NULL if the memory could not be allocated
+ */
+Radix_Queue_t *radix_queue_new(uint64_t size, priority_queue_comparator comparator)
+{
+    Radix_Queue_t *queue = malloc(sizeof(Radix_Queue_t));
+    if (NULL == queue) return NULL;
+    memset(queue, 0, sizeof(Radix_Queue_t));
+    queue->size = size;
+    queue->ties = priority_queue_new(size, comparator);
+    if (NULL == queue->ties)
+    {
+        free(queue);
+        return NULL;
+    }
+    return queue;
+}
+
+/**
+ * Returns a flag indicating whether self is empty or not
+ *
+ * @param self the queue handle
+ * @return 1 if it is empty, 0 otherwise
+ */
+uint8_t radix_queue_is_empty(Radix_Queue_t *self)
+{
+    return self->count == 0;
+}
+
+/**
+ * Insert element into self
+ *
+ * @param self the queue handle
+ * @param element the element to enqueue
+ * @param key the priority of the element, smaller keys are dequeued first
+ * @return 1 on success, 0 if the queue is full or the memory could not be allocated
+ */
+uint8_t radix_queue_enqueue(Radix_Queue_t *self, void *element, uint64_t key)
+{
+    if (self->count + 1 >= self->size) return 0;
+    if (key <= self->last) priority_queue_enqueue(self->ties, element);
+    else if (! radix_queue_bucket_push(&self->buckets[radix_queue_bucket(self, key)], element, key)) return 0;
+    self->count++;
+    return 1;
+}
+
+/**
+ * Delete the element with the smallest key from self
+ *
+ * @param self the queue handle
+ * @return the element, or NULL if the queue is empty or the memory for moving the entries could not be allocated
+ */
+void *radix_queue_dequeue(Radix_Queue_t *self)
+{
+    if (radix_queue_is_empty(self)) return NULL;
+    if (priority_queue_is_empty(self->ties) && ! radix_queue_refill(self)) return NULL;
+    self->count--;
+    if (0 == self->count) self->last = 0;
+    return priority_queue_dequeue(self->ties);
+}
+
+/**
+ * Returns the element with the smallest key without removing it
+ *
+ * @param self the queue handle
+ * @return the element, or NULL if the queue is empty or the memory for moving the entries could not be allocated
+ */
+void *radix_queue_peek(Radix_Queue_t *self)
+{
+    if (radix_queue_is_empty(self)) return NULL;
+    if (priority_queue_is_empty(self->ties) && ! radix_queue_refill(self)) return NULL;
+    return priority_queue_peek(self->ties);
+}
+
+/**
+ * Frees the memory chunks used by self
+ *
+ * @param self the queue handle
+ */
+void radix_queue_destroy(Radix_Queue_t *self)
+{
+    if (self)
+    {
+        for (uint64_t b = 0; b < RADIX_QUEUE_BUCKETS; b++)
+        {
+            free(self->buckets[b].entries);
+        }
+        priority_queue_destroy(self->ties);
+        free(self);
+    }
+}
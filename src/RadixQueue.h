@@ -0,0 +1,95 @@
+//
+// A monotone priority queue over integer keys
+//
+
+#ifndef VORONOI_RADIXQUEUE_H
+#define VORONOI_RADIXQUEUE_H
+
+#include <stdint.h>
+#include "PQueue.h"
+
+// One bucket per bit of the keys
+#define RADIX_QUEUE_BUCKETS 64
+
+typedef struct {
+    void *element;
+    uint64_t key;
+} Radix_Queue_Entry_t;
+
+typedef struct {
+    Radix_Queue_Entry_t *entries;
+    uint64_t count;
+    uint64_t capacity;
+} Radix_Queue_Bucket_t;
+
+/**
+ * A radix heap: a priority queue for integer keys that are dequeued in non-decreasing order, smallest key first.
+ *
+ * Bucket b holds the keys whose highest bit that differs from the last dequeued key is bit b. Once the elements equal
+ * to the last key run out, the lowest non-empty bucket is scanned for its smallest key, which becomes the last key,
+ * and the rest of the bucket moves to lower buckets. Every key moves down at most 64 times in total, so enqueue
+ * is O(1) and dequeue amortised O(log C), where C is the spread of the keys, without comparing two elements.
+ *
+ * Elements with equal keys are ordered by the comparator, which is only called for them: they wait in a binary heap.
+ * A key below the last dequeued key breaks the monotonicity, it is treated as equal to the last key instead.
+ * The queue starts over from the key 0 whenever it runs empty.
+ */
+typedef struct {
+    uint64_t size; // The maximum size of the queue, which holds up to size - 1 elements like PQueue_t
+    uint64_t last; // The key of the last dequeued element, no key in the buckets is smaller
+    uint64_t count; // The number of elements in the queue
+    PQueue_t *ties; // The elements whose key equals last, ordered by the comparator
+    Radix_Queue_Bucket_t buckets[RADIX_QUEUE_BUCKETS];
+} Radix_Queue_t;
+
+/**
+ * Allocate memory for a radix queue with a maximum capacity of size
+ *
+ * @param size the maximum size of the queue
+ * @param comparator orders the elements of equal keys
+ * @return a handle to a Radix_Queue_t object, NULL if the memory could not be allocated
+ */
+Radix_Queue_t *radix_queue_new(uint64_t size, priority_queue_comparator comparator);
+
+/**
+ * Returns a flag indicating whether self is empty or not
+ *
+ * @param self the queue handle
+ * @return 1 if it is empty, 0 otherwise
+ */
+uint8_t radix_queue_is_empty(Radix_Queue_t *self);
+
+/**
+ * Insert element into self
+ *
+ * @param self the queue handle
+ * @param element the element to enqueue
+ * @param key the priority of the element, smaller keys are dequeued first
+ * @return 1 on success, 0 if the queue is full or the memory could not be allocated
+ */
+uint8_t radix_queue_enqueue(Radix_Queue_t *self, void *element, uint64_t key);
+
+/**
+ * Delete the element with the smallest key from self
+ *
+ * @param self the queue handle
+ * @return the element, or NULL if the queue is empty or the memory for moving the entries could not be allocated
+ */
+void *radix_queue_dequeue(Radix_Queue_t *self);
+
+/**
+ * Returns the element with the smallest key without removing it
+ *
+ * @param self the queue handle
+ * @return the element, or NULL if the queue is empty or the memory for moving the entries could not be allocated
+ */
+void *radix_queue_peek(Radix_Queue_t *self);
+
+/**
+ * Frees the memory chunks used by self
+ *
+ * @param self the queue handle
+ */
+void radix_queue_destroy(Radix_Queue_t *self);
+
+#endif //VORONOI_RADIXQUEUE_H
@@ -0,0 +1,149 @@
+//
+// Tests for the radix queue
+//
+
+#include <assert.h>
+#include "PQueue.c"
+#include "RadixQueue.c"
+
+typedef struct {
+    uint64_t key;
+    uint32_t order; // Breaks the ties between equal keys
+} Radix_Test_Element_t;
+
+static int8_t order_comparator(void *first, void *second)
+{
+    uint32_t first_order = ((Radix_Test_Element_t *) first)->order;
+    uint32_t second_order = ((Radix_Test_Element_t *) second)->order;
+    if (first_order < second_order) return 1;
+    else if (first_order > second_order) return -1;
+    else return 0;
+}
+
+void test_radix_queue_init()
+{
+    Radix_Queue_t *queue = radix_queue_new(10, order_comparator);
+    assert(queue != NULL);
+    assert(radix_queue_is_empty(queue));
+    Radix_Test_Element_t *element = radix_queue_dequeue(queue);
+    assert(element == NULL);
+    radix_queue_destroy(queue);
+}
+
+void test_radix_queue_order()
+{
+    Radix_Test_Element_t elements[1000];
+    uint64_t state = 3;
+    for (uint32_t i = 0; i < 1000; i++)
+    {
+        state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+        // Few distinct keys spread over the whole range, so that there are ties and every bucket is used
+        elements[i].key = (state >> 58) << 58 | (state >> 60);
+        elements[i].order = 1000 - i;
+    }
+    Radix_Queue_t *queue = radix_queue_new(1001, order_comparator);
+    // Enqueue half of the elements up front and the rest while draining, each at or above the last key
+    for (uint32_t i = 0; i < 500; i++)
+    {
+        radix_queue_enqueue(queue, &elements[i], elements[i].key);
+    }
+    Radix_Test_Element_t *previous = NULL;
+    uint32_t count = 0;
+    uint32_t next = 500;
+    while (! radix_queue_is_empty(queue))
+    {
+        Radix_Test_Element_t *element = radix_queue_dequeue(queue);
+        if (previous) assert(previous->key <= element->key);
+        previous = element;
+        count++;
+        for (uint32_t i = 0; i < 2 && next < 1000; i++, next++)
+        {
+            if (elements[next].key < element->key) elements[next].key = element->key;
+            radix_queue_enqueue(queue, &elements[next], elements[next].key);
+        }
+    }
+    assert(count == 1000);
+    radix_queue_destroy(queue);
+}
+
+void test_radix_queue_ties()
+{
+    Radix_Test_Element_t elements[100];
+    Radix_Queue_t *queue = radix_queue_new(101, order_comparator);
+    for (uint32_t i = 0; i < 100; i++)
+    {
+        elements[i].key = 1000 + i % 2;
+        elements[i].order = (i * 37) % 100;
+        radix_queue_enqueue(queue, &elements[i], elements[i].key);
+    }
+    // Equal keys come out in the order of the comparator
+    Radix_Test_Element_t *previous = radix_queue_dequeue(queue);
+    for (uint32_t i = 1; i < 100; i++)
+    {
+        Radix_Test_Element_t *element = radix_queue_dequeue(queue);
+        assert(previous->key < element->key || previous->order < element->order);
+        previous = element;
+    }
+    assert(radix_queue_is_empty(queue));
+    radix_queue_destroy(queue);
+}
+
+void test_radix_queue_below_last()
+{
+    Radix_Test_Element_t first = {100, 3};
+    Radix_Test_Element_t second = {200, 2};
+    Radix_Test_Element_t late = {50, 1};
+    Radix_Queue_t *queue = radix_queue_new(10, order_comparator);
+    radix_queue_enqueue(queue, &first, first.key);
+    radix_queue_enqueue(queue, &second, second.key);
+    Radix_Test_Element_t *element = radix_queue_dequeue(queue);
+    assert(element == &first);
+    // A key below the last one counts as the last key and comes next
+    radix_queue_enqueue(queue, &late, late.key);
+    element = radix_queue_dequeue(queue);
+    assert(element == &late);
+    element = radix_queue_dequeue(queue);
+    assert(element == &second);
+    assert(radix_queue_is_empty(queue));
+
+    // The queue starts over once it is empty
+    radix_queue_enqueue(queue, &late, late.key);
+    radix_queue_enqueue(queue, &first, first.key);
+    element = radix_queue_dequeue(queue);
+    assert(element == &late);
+    element = radix_queue_dequeue(queue);
+    assert(element == &first);
+    radix_queue_destroy(queue);
+}
+
+void test_radix_queue_full()
+{
+    Radix_Test_Element_t elements[4] = {{300, 4}, {100, 3}, {200, 2}, {50, 1}};
+    Radix_Queue_t *queue = radix_queue_new(4, order_comparator);
+    for (uint32_t i = 0; i < 3; i++)
+    {
+        uint8_t is_enqueued = radix_queue_enqueue(queue, &elements[i], elements[i].key);
+        assert(is_enqueued);
+    }
+    // A full queue turns the element down and keeps its count
+    uint8_t is_enqueued = radix_queue_enqueue(queue, &elements[3], elements[3].key);
+    assert(! is_enqueued);
+    assert(queue->count == 3);
+    Radix_Test_Element_t *element = radix_queue_dequeue(queue);
+    assert(element == &elements[1]);
+    element = radix_queue_dequeue(queue);
+    assert(element == &elements[2]);
+    element = radix_queue_dequeue(queue);
+    assert(element == &elements[0]);
+    assert(radix_queue_is_empty(queue));
+    radix_queue_destroy(queue);
+}
+
+int main(int argc, char *argv[])
+{
+    test_radix_queue_init();
+    test_radix_queue_order();
+    test_radix_queue_ties();
+    test_radix_queue_below_last();
+    test_radix_queue_full();
+}
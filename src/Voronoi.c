@@ -2,81 +2,1109 @@
 // Created by denko on 5/7/2021.
 //
 
+#include <math.h>
+#include <string.h>
 #include "Voronoi.h"
 #include "PQueue.h"
+#include "RadixQueue.h"
 #include "AVLTree.h"
+#include "VoronoiCells.h"
+#include "VoronoiSites.h"
+#include "VoronoiTrace.h"
 
-static Voronoi_SiteEvent_ptr_t voronoi_site_event_new(Point_t_ptr site)
+/**
+ * The height of the sweep line at the site event of a site. A weighted site enters the beach line while the sweep line
+ * is still its weight above it, see voronoi_breakpoint_x
+ */
+#ifdef VORONOI_WEIGHTED
+#define VORONOI_SITE_EVENT_Y(site) ((double) (site)->y + (site)->weight)
+// The margin by which rates of unit vectors have to differ to count as different
+#define VORONOI_WEIGHTED_EPSILON 1e-9
+#else
+#define VORONOI_SITE_EVENT_Y(site) ((double) (site)->y)
+#endif
+
+/**
+ * A chunk of consecutive records that a pool hands out one after the other
+ */
+typedef struct Voronoi_Pool_Chunk {
+    struct Voronoi_Pool_Chunk *next;
+    size_t used; // The number of records handed out from the chunk
+    size_t capacity; // The number of records the chunk can hold
+    double records[]; // Declared as double to align the records properly
+} Voronoi_Pool_Chunk_t;
+
+/**
+ * A pool of records of one size, like the circle events of the sweep.
+ * Released records are reused last in, first out, and the whole pool is recycled at the end of a sweep, so the chunks
+ * are only allocated by the first sweeps that need them.
+ */
+typedef struct {
+    size_t record_size; // The number of bytes per record, a multiple of the size of a double
+    Voronoi_Pool_Chunk_t *chunks; // The chunks in the order in which they are used
+    Voronoi_Pool_Chunk_t *chunk; // The chunk that new records are taken from, NULL before the first one
+    void *free_records; // The released records, each holding the address of the next one
+} Voronoi_Pool_t;
+
+/**
+ * The state of Fortune's sweep.
+ * The sweep line moves downwards, from the highest site to the lowest one. The beach line is a leaf-oriented tree:
+ * the leaves hold the arcs from left to right and every inner node holds the breakpoint between its two subtrees.
+ * Built with VORONOI_WEIGHTED, the directrix of the parabola of a site lies the weight of the site below the sweep
+ * line, which yields the additively weighted diagram with the same events and the same beach line.
+ */
+typedef struct {
+    Voronoi_Sites_t sites; // The distinct sites in the order of their site events
+    size_t next_site; // The position in sites of the next site event
+    PQueue_t *queue; // The circle events ordered by their y coordinate
+    Radix_Queue_t *radix_queue; // Replaces queue if the options ask for the radix heap, NULL until then
+    uint8_t is_radix; // Whether the current sweep uses radix_queue
+    uint8_t is_failed; // Whether radix_queue ran out of memory during the current sweep
+    size_t queue_size; // The maximum size of the queues
+    AVLTree_ptr_t beach_line; // The arcs and breakpoints of the beach line
+    Voronoi_Pool_t events; // The circle events
+    Voronoi_Pool_t arcs; // The arcs of the beach line
+    Voronoi_Pool_t breakpoints; // The breakpoints of the beach line
+    DCEL_t *dcel; // The diagram under construction
+    Delaunay_t *delaunay; // The dual triangulation under construction, NULL if it is not requested
+    double sweep; // The y coordinate of the sweep line
+#ifdef VORONOI_STATS
+    Voronoi_Stats_t stats; // The counters of the current sweep
+    uint64_t rotations; // The rotations of the beach line before the current sweep
+#endif
+} Voronoi_Sweep_t;
+
+static void voronoi_pool_init(Voronoi_Pool_t *self, size_t record_size)
 {
-    Voronoi_SiteEvent_ptr_t event = malloc(sizeof(Voronoi_SiteEvent_t));
-    event->site = site;
-    return event;
+    record_size = record_size > sizeof(void *) ? record_size : sizeof(void *);
+    self->record_size = (record_size + sizeof(double) - 1) & ~(sizeof(double) - 1);
+    self->chunks = self->chunk = NULL;
+    self->free_records = NULL;
+}
+
+/**
+ * Hands out a record of the pool, the last released one if there is any
+ *
+ * @param self the pool handle
+ * @return the uninitialized record, NULL if the memory could not be allocated
+ */
+static void *voronoi_pool_alloc(Voronoi_Pool_t *self)
+{
+    void *record = self->free_records;
+    if (record)
+    {
+        memcpy(&self->free_records, record, sizeof(void *));
+        return record;
+    }
+    if (! self->chunk || self->chunk->used == self->chunk->capacity)
+    {
+        Voronoi_Pool_Chunk_t *next = self->chunk ? self->chunk->next : self->chunks;
+        if (! next)
+        {
+            // Grow geometrically like the node pool of the beach line
+            size_t capacity = self->chunk ? 2 * self->chunk->capacity : 256;
+            capacity = capacity < 65536 ? capacity : 65536;
+            next = malloc(sizeof(Voronoi_Pool_Chunk_t) + capacity * self->record_size);
+            if (NULL == next) return NULL;
+            next->next = NULL;
+            next->capacity = capacity;
+            if (self->chunk)
+            {
+                self->chunk->next = next;
+            }
+            else
+            {
+                self->chunks = next;
+            }
+        }
+        next->used = 0;
+        self->chunk = next;
+    }
+    return (char *) self->chunk->records + self->record_size * self->chunk->used++;
+}
+
+static void voronoi_pool_release(Voronoi_Pool_t *self, void *record)
+{
+    if (record)
+    {
+        memcpy(record, &self->free_records, sizeof(void *));
+        self->free_records = record;
+    }
+}
+
+/**
+ * Takes back every record of the pool at once. The records handed out before become invalid
+ *
+ * @param self the pool handle
+ */
+static void voronoi_pool_clear(Voronoi_Pool_t *self)
+{
+    self->chunk = NULL;
+    self->free_records = NULL;
+}
+
+static void voronoi_pool_destroy(Voronoi_Pool_t *self)
+{
+    while (self->chunks)
+    {
+        Voronoi_Pool_Chunk_t *next = self->chunks->next;
+        free(self->chunks);
+        self->chunks = next;
+    }
+    voronoi_pool_clear(self);
 }
 
-static Voronoi_CircleEvent_ptr_t voronoi_circle_event_new(Point_t_ptr circle_point)
+static Voronoi_CircleEvent_ptr_t voronoi_circle_event_new(Voronoi_Sweep_t *sweep, Point_Real_t circle_point,
+                                                          Point_Real_t center, Voronoi_Arc_ptr_t arc)
 {
-    Voronoi_CircleEvent_ptr_t event = malloc(sizeof(Voronoi_CircleEvent_t));
+    Voronoi_CircleEvent_ptr_t event = voronoi_pool_alloc(&sweep->events);
     event->circle_point = circle_point;
-    event->arc = NULL;
+    event->center = center;
+    event->arc = arc;
     return event;
 }
 
-static Voronoi_Event_ptr_t voronoi_event_new(Point_t_ptr point, uint8_t is_circle_event)
+static int8_t voronoi_event_queue_comparator(void *first, void *second)
 {
-    Voronoi_Event_ptr_t event = malloc(sizeof(Voronoi_Event_t));
-    event->is_circle_event = is_circle_event;
-    if (is_circle_event)
+    Point_Real_t first_priority = ((Voronoi_CircleEvent_ptr_t) first)->circle_point;
+    Point_Real_t second_priority = ((Voronoi_CircleEvent_ptr_t) second)->circle_point;
+    if (first_priority.y > second_priority.y) return 1;
+    if (first_priority.y < second_priority.y) return -1;
+    // Events on the same height are handled from left to right, which keeps the arcs of a horizontal row of sites in order
+    if (first_priority.x < second_priority.x) return 1;
+    if (first_priority.x > second_priority.x) return -1;
+    return 0;
+}
+
+// The heap operations for circle events, with voronoi_event_queue_comparator inlined into the sift loops
+#define PQUEUE_PREFIX voronoi_event_heap
+#define PQUEUE_LINKAGE static inline
+#define PQUEUE_COMPARE(self, first, second) voronoi_event_queue_comparator(first, second)
+#include "PQueueTemplate.h"
+
+/**
+ * Maps the height of an event onto a key of the radix heap. The keys preserve the order of the doubles, reversed
+ * such that the highest event has the smallest key
+ */
+static uint64_t voronoi_event_radix_key(double y)
+{
+    // Both zeros get the same key
+    if (0 == y) y = 0;
+    uint64_t bits;
+    memcpy(&bits, &y, sizeof(bits));
+    bits = (bits >> 63) ? ~bits : bits | (1ULL << 63);
+    return ~bits;
+}
+
+/**
+ * Adds the circle event to the queue of the sweep, marks the sweep as failed if the radix queue cannot take it
+ *
+ * @param sweep the sweep state
+ * @param event the event
+ */
+static void voronoi_event_enqueue(Voronoi_Sweep_t *sweep, Voronoi_CircleEvent_ptr_t event)
+{
+    // The height of the event is its key, so the queues only call the comparator on equal heights
+    double y = event->circle_point.y;
+    if (sweep->is_radix)
     {
-        Voronoi_CircleEvent_ptr_t circle_event = voronoi_circle_event_new(point);
-        event->circle_event = circle_event;
-        event->site_event = NULL;
+        if (! radix_queue_enqueue(sweep->radix_queue, (void *) event, voronoi_event_radix_key(y))) sweep->is_failed = 1;
     }
-    else
+    else voronoi_event_heap_enqueue_keyed(sweep->queue, (void *) event, y);
+}
+
+static Voronoi_CircleEvent_ptr_t voronoi_event_dequeue(Voronoi_Sweep_t *sweep)
+{
+    if (sweep->is_radix) return (Voronoi_CircleEvent_ptr_t) radix_queue_dequeue(sweep->radix_queue);
+    return (Voronoi_CircleEvent_ptr_t) voronoi_event_heap_dequeue(sweep->queue);
+}
+
+/**
+ * Returns the next circle event of the sweep, marks the sweep as failed if the radix queue cannot produce it
+ *
+ * @param sweep the sweep state
+ * @return the event, NULL if there is none
+ */
+static Voronoi_CircleEvent_ptr_t voronoi_event_peek(Voronoi_Sweep_t *sweep)
+{
+    if (sweep->is_radix)
     {
-        Voronoi_SiteEvent_ptr_t site_event = voronoi_site_event_new(point);
-        event->site_event = site_event;
-        event->circle_event = NULL;
+        void *event = radix_queue_peek(sweep->radix_queue);
+        if (NULL == event && ! radix_queue_is_empty(sweep->radix_queue)) sweep->is_failed = 1;
+        return (Voronoi_CircleEvent_ptr_t) event;
     }
-    return event;
+    return (Voronoi_CircleEvent_ptr_t) priority_queue_peek(sweep->queue);
+}
+
+static Voronoi_Arc_ptr_t voronoi_arc_new(Voronoi_Sweep_t *sweep, Point_t_ptr site, size_t index)
+{
+    Voronoi_Arc_ptr_t arc = voronoi_pool_alloc(&sweep->arcs);
+    memset(arc, 0, sizeof(Voronoi_Arc_t));
+    arc->site = site;
+    arc->index = index;
+    return arc;
+}
+
+static Voronoi_Breakpoint_ptr_t voronoi_breakpoint_new(Voronoi_Sweep_t *sweep, Point_t_ptr left_site,
+                                                       Point_t_ptr right_site, DCEL_HalfEdge_ptr_t half_edge)
+{
+    Voronoi_Breakpoint_ptr_t breakpoint = voronoi_pool_alloc(&sweep->breakpoints);
+    breakpoint->left_site = left_site;
+    breakpoint->right_site = right_site;
+    breakpoint->half_edge = half_edge;
+    breakpoint->triangle = DELAUNAY_NONE;
+    breakpoint->partner = NULL;
+    return breakpoint;
+}
+
+/**
+ * Orders the arcs of the beach line by the x coordinate of their sites.
+ * Only used to insert the very first arc, afterwards the beach line is restructured leaf by leaf.
+ */
+static int8_t voronoi_beach_line_comparator(void *first, void *second)
+{
+    Voronoi_Arc_ptr_t first_arc = (Voronoi_Arc_ptr_t) first;
+    Voronoi_Arc_ptr_t second_arc = (Voronoi_Arc_ptr_t) second;
+    if (first_arc->site->x > second_arc->site->x) return 1;
+    if (first_arc->site->x < second_arc->site->x) return -1;
+    return 0;
+}
+
+/**
+ * Computes the x coordinate of the breakpoint, that is, the intersection of the parabolas of its two sites
+ * when the sweep line is at the given position
+ *
+ * @param breakpoint the breakpoint
+ * @param sweep the y coordinate of the sweep line
+ * @return the x coordinate
+ */
+static double voronoi_breakpoint_x(Voronoi_Breakpoint_ptr_t breakpoint, double sweep)
+{
+    // Work relative to the left site like voronoi_check_circle_event, the squares of large absolute coordinates
+    // would cancel each other out
+    double origin_x = (double) breakpoint->left_site->x;
+    double origin_y = (double) breakpoint->left_site->y;
+    double right_x = (double) breakpoint->right_site->x - origin_x;
+    double right_y = (double) breakpoint->right_site->y - origin_y;
+    sweep -= origin_y;
+#ifdef VORONOI_WEIGHTED
+    // The distance between the focus and the directrix of a parabola is the height of its site event above the sweep
+    double left_width = breakpoint->left_site->weight - sweep;
+    double right_width = right_y + breakpoint->right_site->weight - sweep;
+    if (0 == left_width && 0 == right_width) return origin_x + right_x / 2;
+    if (0 == left_width) return origin_x;
+    if (0 == right_width) return origin_x + right_x;
+
+    // As below, but the vertices of the parabolas lie halfway between their foci and their own directrices
+    double left_d = 1 / (2 * left_width);
+    double right_d = 1 / (2 * right_width);
+    double a = left_d - right_d;
+    double b = 2 * right_d * right_x;
+    double c = -right_d * right_x * right_x +
+               (-breakpoint->left_site->weight - right_y + breakpoint->right_site->weight) / 2;
+    // Parabolas of the same width meet once
+    if (left_width == right_width) return origin_x + (b != 0 ? -c / b : right_x / 2);
+#else
+    // Parabolas of the same width meet once, halfway between their foci
+    if (0 == right_y) return origin_x + right_x / 2;
+    // A site on the sweep line degenerates into a vertical ray below its focus
+    if (0 == sweep) return origin_x;
+    if (right_y == sweep) return origin_x + right_x;
+
+    // Solve a x^2 + b x + c = 0 for the difference of the two parabolas, with the left site at the origin.
+    // The left site is lower on the left of the breakpoint, which always selects the root (-b + sqrt(D)) / 2a
+    double left_d = 1 / (2 * -sweep);
+    double right_d = 1 / (2 * (right_y - sweep));
+    double a = left_d - right_d;
+    double b = 2 * right_d * right_x;
+    double c = -right_d * right_x * right_x - right_y / 2;
+#endif
+    double discriminant = b * b - 4 * a * c;
+    double root = discriminant > 0 ? sqrt(discriminant) : 0;
+    // Avoid the cancellation between -b and the root
+    if (b < 0) return origin_x + (-b + root) / (2 * a);
+    if (b + root == 0) return origin_x;
+    return origin_x + 2 * c / (-b - root);
 }
 
-static uint64_t voronoi_event_get_priority(Voronoi_Event_ptr_t event)
+/**
+ * Finds the arc of the beach line that lies above the given x coordinate
+ *
+ * @param sweep the sweep state
+ * @param x the x coordinate
+ * @return the arc
+ */
+static Voronoi_Arc_ptr_t voronoi_beach_line_locate(Voronoi_Sweep_t *sweep, double x)
 {
-    uint64_t event_key;
-    if (event->is_circle_event)
+    AVLTree_Node_ptr_t node = avl_tree_root(sweep->beach_line);
+    while (! avl_tree_node_is_leaf(node))
     {
-        event_key = event->circle_event->circle_point->y;
+        Voronoi_Breakpoint_ptr_t breakpoint = (Voronoi_Breakpoint_ptr_t) avl_tree_node_data(node);
+        if (x < voronoi_breakpoint_x(breakpoint, sweep->sweep))
+        {
+            node = avl_tree_node_left(node);
+        }
+        else
+        {
+            node = avl_tree_node_right(node);
+        }
+    }
+    return (Voronoi_Arc_ptr_t) avl_tree_node_data(node);
+}
+
+/**
+ * Drops the pending circle event of the arc, if any. The event stays in the queue and is skipped once dequeued
+ *
+ * @param arc the arc
+ */
+static void voronoi_arc_invalidate_circle_event(Voronoi_Arc_ptr_t arc)
+{
+    if (arc->circle_event)
+    {
+        arc->circle_event->arc = NULL;
+        arc->circle_event = NULL;
+    }
+}
+
+#ifdef VORONOI_WEIGHTED
+/**
+ * Finds the edge that the sweep traces away from a vertex of the weighted diagram. Three edges meet in the vertex,
+ * one between every two of its sites, and the sweep reaches the vertex along two of them.
+ * A site right below the vertex has its event at the vertex, and then both of its edges run level with the sweep
+ * line. The tie goes to the edge that does not touch site 1, the arc that shrinks to nothing as the site arrives
+ *
+ * @param towards the unit vectors from the vertex towards its three sites
+ * @return the site that the edge does not touch: 0, 1 or 2
+ */
+static size_t voronoi_vertex_outgoing_edge(const Point_Real_t towards[3])
+{
+    size_t outgoing = 1;
+    double lowest = INFINITY;
+    for (size_t i = 0; i < 3; i++)
+    {
+        size_t k = (i + 1) % 3;
+        Point_Real_t first = towards[(k + 1) % 3];
+        Point_Real_t second = towards[(k + 2) % 3];
+        // The edge leaves the vertex perpendicular to the difference of the directions, away from the third site
+        double tangent_x = first.y - second.y;
+        double tangent_y = second.x - first.x;
+        double length = hypot(tangent_x, tangent_y);
+        if (0 == length) continue;
+        if (tangent_x * (first.x - towards[k].x) + tangent_y * (first.y - towards[k].y) < 0) length = -length;
+        // The rate at which the height of the sweep line that settles the points changes along the edge
+        double rate = (tangent_x * first.x + tangent_y * (first.y + 1)) / length;
+        if (rate < lowest - VORONOI_WEIGHTED_EPSILON)
+        {
+            lowest = rate;
+            outgoing = k;
+        }
+    }
+    return outgoing;
+}
+#endif
+
+/**
+ * Schedules the circle event in which the arc disappears, provided that its breakpoints converge
+ *
+ * @param sweep the sweep state
+ * @param arc the arc
+ */
+static void voronoi_check_circle_event(Voronoi_Sweep_t *sweep, Voronoi_Arc_ptr_t arc)
+{
+    Voronoi_Arc_ptr_t left = arc->prev;
+    Voronoi_Arc_ptr_t right = arc->next;
+    if (! left || ! right || left->index == right->index) return;
+
+    // Work relative to the site of the arc to keep the magnitudes small
+    double origin_x = (double) arc->site->x;
+    double origin_y = (double) arc->site->y;
+    double left_x = (double) left->site->x - origin_x;
+    double left_y = (double) left->site->y - origin_y;
+    double right_x = (double) right->site->x - origin_x;
+    double right_y = (double) right->site->y - origin_y;
+#ifdef VORONOI_WEIGHTED
+    // The center c of the circle, relative to the site of the arc, and its distance t from that site solve
+    // c . p + t s = (|p|^2 - s^2) / 2 for both neighbours, where p is the position of the neighbour and s its weight
+    // minus the weight of the arc, together with |c| = t. The two linear equations leave a line of solutions (c, t),
+    // which meets the cone |c| = t in up to two points
+    double left_s = left->site->weight - arc->site->weight;
+    double right_s = right->site->weight - arc->site->weight;
+    double left_k = (left_x * left_x + left_y * left_y - left_s * left_s) / 2;
+    double right_k = (right_x * right_x + right_y * right_y - right_s * right_s) / 2;
+    double normal_x = left_y * right_s - left_s * right_y;
+    double normal_y = left_s * right_x - left_x * right_s;
+    double normal_t = left_x * right_y - left_y * right_x;
+    double norm = normal_x * normal_x + normal_y * normal_y + normal_t * normal_t;
+    if (0 == norm) return;
+    double base_x = (left_k * (right_y * normal_t - right_s * normal_y) +
+                     right_k * (normal_y * left_s - normal_t * left_y)) / norm;
+    double base_y = (left_k * (right_s * normal_x - right_x * normal_t) +
+                     right_k * (normal_t * left_x - normal_x * left_s)) / norm;
+    double base_t = (left_k * (right_x * normal_y - right_y * normal_x) +
+                     right_k * (normal_x * left_y - normal_y * left_x)) / norm;
+    double a = normal_x * normal_x + normal_y * normal_y - normal_t * normal_t;
+    double b = 2 * (base_x * normal_x + base_y * normal_y - base_t * normal_t);
+    double c = base_x * base_x + base_y * base_y - base_t * base_t;
+    double roots[2];
+    size_t root_count = 0;
+    if (0 == a)
+    {
+        if (b != 0) roots[root_count++] = -c / b;
     }
     else
     {
-        event_key = event->site_event->site->y;
+        double discriminant = b * b - 4 * a * c;
+        if (discriminant < 0) return;
+        // Avoid the cancellation between -b and the root
+        double q = -(b + copysign(sqrt(discriminant), b)) / 2;
+        roots[root_count++] = q / a;
+        if (q != 0) roots[root_count++] = c / q;
+    }
+
+    // Of the circles touching the three sites, the arc disappears on the one that meets them in clockwise order,
+    // like the circumcircle of a clockwise turn without weights
+    uint8_t is_found = 0;
+    Point_Real_t center;
+    Point_Real_t circle_point;
+    for (size_t r = 0; r < root_count; r++)
+    {
+        double center_x = base_x + roots[r] * normal_x;
+        double center_y = base_y + roots[r] * normal_y;
+        double distance = base_t + roots[r] * normal_t;
+        double left_distance = distance + left_s;
+        double right_distance = distance + right_s;
+        if (distance <= 0 || left_distance <= 0 || right_distance <= 0) continue;
+        Point_Real_t towards[3] = {
+            {(left_x - center_x) / left_distance, (left_y - center_y) / left_distance},
+            {-center_x / distance, -center_y / distance},
+            {(right_x - center_x) / right_distance, (right_y - center_y) / right_distance}
+        };
+        double to_left_x = towards[0].x - towards[1].x;
+        double to_left_y = towards[0].y - towards[1].y;
+        double to_right_x = towards[2].x - towards[1].x;
+        double to_right_y = towards[2].y - towards[1].y;
+        if (to_left_x * to_right_y - to_left_y * to_right_x <= 0) continue;
+        // A site can have arcs on both sides of the other two, and then both arcs between them meet the same circle.
+        // The one that disappears is the one whose cell does not touch the edge that starts at the center
+        if (voronoi_vertex_outgoing_edge(towards) != 1) continue;
+        // The center is settled once the sweep line lies its weighted distance below it
+        double y = origin_y + center_y - distance + arc->site->weight;
+        if (is_found && y <= circle_point.y) continue;
+        is_found = 1;
+        center.x = origin_x + center_x;
+        center.y = origin_y + center_y;
+        circle_point.x = center.x;
+        circle_point.y = y;
     }
-    return event_key;
+    if (! is_found) return;
+#else
+    // The breakpoints converge only if the sites make a clockwise turn
+    double determinant = left_x * right_y - left_y * right_x;
+    if (determinant <= 0) return;
+
+    double left_norm = left_x * left_x + left_y * left_y;
+    double right_norm = right_x * right_x + right_y * right_y;
+    double center_x = (right_y * left_norm - left_y * right_norm) / (2 * determinant);
+    double center_y = (left_x * right_norm - right_x * left_norm) / (2 * determinant);
+    double radius = sqrt(center_x * center_x + center_y * center_y);
+
+    Point_Real_t center = {origin_x + center_x, origin_y + center_y};
+    Point_Real_t circle_point = {center.x, center.y - radius};
+#endif
+    arc->circle_event = voronoi_circle_event_new(sweep, circle_point, center, arc);
+    voronoi_event_enqueue(sweep, arc->circle_event);
+    VORONOI_STATS_ADD(sweep->stats.event_bytes, sizeof(Voronoi_CircleEvent_t));
 }
 
-static int8_t voronoi_event_queue_comparator(void *first, void *second)
+/**
+ * Creates the pair of half-edges separating the faces of two sites
+ *
+ * @param sweep the sweep state
+ * @param left the index of the site on the left of the edge
+ * @param right the index of the site on the right of the edge
+ * @return the half-edge on the face of the left site. Its twin lies on the face of the right site
+ */
+static DCEL_HalfEdge_ptr_t voronoi_edge_new(Voronoi_Sweep_t *sweep, size_t left, size_t right)
 {
-    uint64_t first_priority = voronoi_event_get_priority((Voronoi_Event_ptr_t) first);
-    uint64_t second_priority = voronoi_event_get_priority((Voronoi_Event_ptr_t) second);
-    if (first_priority > second_priority) return 1;
-    if (first_priority < second_priority) return -1;
-    return 0;
+    DCEL_Face_ptr_t left_face = sweep->dcel->faces[left];
+    DCEL_Face_ptr_t right_face = sweep->dcel->faces[right];
+    DCEL_HalfEdge_ptr_t half_edge = dcel_half_edge_new(sweep->dcel, left_face);
+    DCEL_HalfEdge_ptr_t twin = dcel_half_edge_new(sweep->dcel, right_face);
+    half_edge->twin = twin;
+    twin->twin = half_edge;
+    if (! left_face->inc_edge)
+    {
+        left_face->inc_edge = half_edge;
+    }
+    if (! right_face->inc_edge)
+    {
+        right_face->inc_edge = twin;
+    }
+    return half_edge;
+}
+
+/**
+ * Makes next follow prev along the boundary of their face
+ */
+static void voronoi_edge_link(DCEL_HalfEdge_ptr_t prev, DCEL_HalfEdge_ptr_t next)
+{
+    prev->next = next;
+    next->prev = prev;
 }
 
-static PQueue_t* voronoi_event_queue_init(Point_t_ptr *points, size_t count)
+/**
+ * Records that the edge traced by the breakpoint ends in the Delaunay triangle.
+ * The triangle becomes the neighbour of the one at the other end of the edge, once both are known.
+ *
+ * @param sweep the sweep state
+ * @param breakpoint the breakpoint that disappears
+ * @param triangle the triangle of the circle event, DELAUNAY_NONE if none is recorded
+ * @param a the index of the left site of the breakpoint
+ * @param b the index of the right site of the breakpoint
+ */
+static void voronoi_breakpoint_finish(Voronoi_Sweep_t *sweep, Voronoi_Breakpoint_ptr_t breakpoint, uint32_t triangle,
+                                      size_t a, size_t b)
 {
-    PQueue_t *queue = priority_queue_new(count, voronoi_event_queue_comparator);
-    for (int i = 0; i < count; i++)
+    if (breakpoint->partner)
     {
-        Voronoi_Event_ptr_t site_event = voronoi_event_new(points[i], 0);
-        priority_queue_enqueue(queue, (void *) site_event);
+        // The partner traces the other end of the same edge
+        breakpoint->partner->triangle = triangle;
+        breakpoint->partner->partner = NULL;
     }
-    return queue;
+    else if (breakpoint->triangle != DELAUNAY_NONE && triangle != DELAUNAY_NONE)
+    {
+        delaunay_link(sweep->delaunay, triangle, breakpoint->triangle, (uint32_t) a, (uint32_t) b);
+    }
+}
+
+#ifdef VORONOI_WEIGHTED
+/**
+ * Returns whether the beach line has already passed the site. The weighted distance to the site of the arc above it
+ * is then smaller everywhere, so the cell of the site is empty and it gets no arc
+ *
+ * @param sweep the sweep state, at the site event of the site
+ * @param arc the arc above the site
+ * @param site the site
+ * @return 1 if the site is hidden, 0 otherwise
+ */
+static uint8_t voronoi_site_is_hidden(Voronoi_Sweep_t *sweep, Voronoi_Arc_ptr_t arc, Point_t_ptr site)
+{
+    double width = VORONOI_SITE_EVENT_Y(arc->site) - sweep->sweep;
+    // A site of the same event height still has a vertical ray up from it, which only hides the sites on the ray.
+    // Of those, the heaviest comes first, see voronoi_sites_prepare. The ray lies left of the located arc at its x
+    Voronoi_Arc_ptr_t prev = arc->prev;
+    if (prev && prev->site->x == site->x && VORONOI_SITE_EVENT_Y(prev->site) == sweep->sweep) return 1;
+    if (0 == width) return arc->site->x == site->x;
+    double x = (double) site->x - (double) arc->site->x;
+    double height = x * x / (2 * width) + ((double) arc->site->y - arc->site->weight + sweep->sweep) / 2;
+    return (double) site->y >= height;
 }
+#endif
+
+/**
+ * Adds the arc of a new site to the beach line
+ *
+ * @param sweep the sweep state
+ * @param site the site
+ * @param index the index of the site
+ */
+static void voronoi_process_site_event(Voronoi_Sweep_t *sweep, Point_t_ptr site, size_t index)
+{
+    sweep->sweep = VORONOI_SITE_EVENT_Y(site);
+    if (! avl_tree_root(sweep->beach_line))
+    {
+        Voronoi_Arc_ptr_t arc = voronoi_arc_new(sweep, site, index);
+        avl_tree_insert(sweep->beach_line, arc);
+        arc->node = avl_tree_root(sweep->beach_line);
+        VORONOI_STATS_ADD(sweep->stats.beach_line_bytes, sizeof(Voronoi_Arc_t) + avl_tree_node_size());
+        return;
+    }
+
+    // The sites are distinct, see voronoi_sites_prepare
+    Voronoi_Arc_ptr_t arc = voronoi_beach_line_locate(sweep, (double) site->x);
+#ifdef VORONOI_WEIGHTED
+    if (voronoi_site_is_hidden(sweep, arc, site)) return;
+#endif
+    voronoi_arc_invalidate_circle_event(arc);
+    AVLTree_Node_ptr_t leaf = arc->node;
+    Voronoi_Arc_ptr_t middle = voronoi_arc_new(sweep, site, index);
+    middle->node = avl_tree_node_alloc(sweep->beach_line, middle);
 
-void voronoi_process_site_event(Point_t_ptr site);
+#ifdef VORONOI_WEIGHTED
+    if (VORONOI_SITE_EVENT_Y(arc->site) == sweep->sweep)
+#else
+    if (arc->site->y == site->y)
+#endif
+    {
+        // Both sites lie on the sweep line, which only happens for the highest row of sites.
+        // The arcs are vertical rays, so the new arc is placed to the right of the old one instead of splitting it.
+        DCEL_HalfEdge_ptr_t half_edge = voronoi_edge_new(sweep, arc->index, index);
+        Voronoi_Breakpoint_ptr_t breakpoint = voronoi_breakpoint_new(sweep, arc->site, site, half_edge);
+        arc->node = avl_tree_node_alloc(sweep->beach_line, arc);
+        avl_tree_replace_leaf_node(sweep->beach_line, leaf,
+                                   avl_tree_node_join(sweep->beach_line, breakpoint, arc->node, middle->node));
+        avl_tree_node_release(sweep->beach_line, leaf);
+
+        middle->next = arc->next;
+        middle->right_breakpoint = arc->right_breakpoint;
+        if (middle->next)
+        {
+            middle->next->prev = middle;
+        }
+        middle->prev = arc;
+        middle->left_breakpoint = breakpoint;
+        arc->next = middle;
+        arc->right_breakpoint = breakpoint;
+        VORONOI_STATS_ADD(sweep->stats.beach_line_bytes,
+                          sizeof(Voronoi_Arc_t) + sizeof(Voronoi_Breakpoint_t) + 3 * avl_tree_node_size());
+        return;
+    }
 
-void voronoi_process_circle_event(Voronoi_Arc_ptr_t arc);
+    // Split the arc into a left and a right part with the new arc in between.
+    // Both new breakpoints trace the same edge, in opposite directions
+    Voronoi_Arc_ptr_t right = voronoi_arc_new(sweep, arc->site, arc->index);
+    right->node = avl_tree_node_alloc(sweep->beach_line, right);
+    arc->node = avl_tree_node_alloc(sweep->beach_line, arc);
+    DCEL_HalfEdge_ptr_t half_edge = voronoi_edge_new(sweep, arc->index, index);
+    Voronoi_Breakpoint_ptr_t left_breakpoint = voronoi_breakpoint_new(sweep, arc->site, site, half_edge);
+    Voronoi_Breakpoint_ptr_t right_breakpoint = voronoi_breakpoint_new(sweep, site, arc->site, half_edge->twin);
+    left_breakpoint->partner = right_breakpoint;
+    right_breakpoint->partner = left_breakpoint;
+    avl_tree_replace_leaf_node(sweep->beach_line, leaf,
+                               avl_tree_node_join(sweep->beach_line, left_breakpoint, arc->node,
+                                                  avl_tree_node_join(sweep->beach_line, right_breakpoint,
+                                                                     middle->node, right->node)));
+    avl_tree_node_release(sweep->beach_line, leaf);
+
+    right->next = arc->next;
+    right->right_breakpoint = arc->right_breakpoint;
+    if (right->next)
+    {
+        right->next->prev = right;
+    }
+    right->prev = middle;
+    right->left_breakpoint = right_breakpoint;
+    middle->prev = arc;
+    middle->next = right;
+    middle->left_breakpoint = left_breakpoint;
+    middle->right_breakpoint = right_breakpoint;
+    arc->next = middle;
+    arc->right_breakpoint = left_breakpoint;
+    VORONOI_STATS_ADD(sweep->stats.beach_line_bytes,
+                      2 * sizeof(Voronoi_Arc_t) + 2 * sizeof(Voronoi_Breakpoint_t) + 5 * avl_tree_node_size());
+
+    voronoi_check_circle_event(sweep, arc);
+    voronoi_check_circle_event(sweep, right);
+}
+
+/**
+ * Removes the arc that shrinks to a point and adds the center of the circle as a vertex of the diagram.
+ * The three sites of the circle form a triangle of the Delaunay triangulation.
+ *
+ * @param sweep the sweep state
+ * @param event the circle event
+ */
+static void voronoi_process_circle_event(Voronoi_Sweep_t *sweep, Voronoi_CircleEvent_ptr_t event)
+{
+    Voronoi_Arc_ptr_t arc = event->arc;
+    Voronoi_Arc_ptr_t left = arc->prev;
+    Voronoi_Arc_ptr_t right = arc->next;
+    Voronoi_Breakpoint_ptr_t left_breakpoint = arc->left_breakpoint;
+    Voronoi_Breakpoint_ptr_t right_breakpoint = arc->right_breakpoint;
+    sweep->sweep = event->circle_point.y;
+    arc->circle_event = NULL;
+    voronoi_arc_invalidate_circle_event(left);
+    voronoi_arc_invalidate_circle_event(right);
+
+    // Both edges end in the new vertex, where a new edge between the left and the right site starts
+    DCEL_Vertex_ptr_t vertex = dcel_vertex_new(sweep->dcel, event->center);
+    left_breakpoint->half_edge->origin = vertex;
+    right_breakpoint->half_edge->origin = vertex;
+    vertex->inc_edge = left_breakpoint->half_edge;
+    DCEL_HalfEdge_ptr_t half_edge = voronoi_edge_new(sweep, left->index, right->index);
+    half_edge->twin->origin = vertex;
+    voronoi_edge_link(half_edge, left_breakpoint->half_edge);
+    voronoi_edge_link(left_breakpoint->half_edge->twin, right_breakpoint->half_edge);
+    voronoi_edge_link(right_breakpoint->half_edge->twin, half_edge->twin);
+
+    uint32_t triangle = DELAUNAY_NONE;
+    if (sweep->delaunay)
+    {
+        // The sites turn clockwise from left to right, so the counter-clockwise order puts the arc last
+        triangle = delaunay_add_triangle(sweep->delaunay, (uint32_t) left->index, (uint32_t) right->index,
+                                         (uint32_t) arc->index);
+    }
+    voronoi_breakpoint_finish(sweep, left_breakpoint, triangle, left->index, arc->index);
+    voronoi_breakpoint_finish(sweep, right_breakpoint, triangle, arc->index, right->index);
+
+    // The leaf goes away together with one of the two breakpoints. The other one now separates left and right
+    Voronoi_Breakpoint_ptr_t removed = avl_tree_remove_leaf_node(sweep->beach_line, arc->node);
+    Voronoi_Breakpoint_ptr_t kept = removed == left_breakpoint ? right_breakpoint : left_breakpoint;
+    kept->left_site = left->site;
+    kept->right_site = right->site;
+    kept->half_edge = half_edge;
+    kept->triangle = triangle;
+    kept->partner = NULL;
+    voronoi_pool_release(&sweep->breakpoints, removed);
+
+    left->next = right;
+    right->prev = left;
+    left->right_breakpoint = right->left_breakpoint = kept;
+    voronoi_pool_release(&sweep->arcs, arc);
+
+    voronoi_check_circle_event(sweep, left);
+    voronoi_check_circle_event(sweep, right);
+}
+
+/**
+ * Releases the arcs and breakpoints that are left on the beach line and points every unbounded face
+ * to the first half-edge of its chain
+ *
+ * @param sweep the sweep state
+ */
+static void voronoi_sweep_finalise(Voronoi_Sweep_t *sweep)
+{
+    AVLTree_Node_ptr_t node = avl_tree_root(sweep->beach_line);
+    while (node && ! avl_tree_node_is_leaf(node))
+    {
+        node = avl_tree_node_left(node);
+    }
+    Voronoi_Arc_ptr_t arc = node ? (Voronoi_Arc_ptr_t) avl_tree_node_data(node) : NULL;
+    while (arc)
+    {
+        Voronoi_Arc_ptr_t next = arc->next;
+        voronoi_arc_invalidate_circle_event(arc);
+        voronoi_pool_release(&sweep->breakpoints, arc->right_breakpoint);
+        voronoi_pool_release(&sweep->arcs, arc);
+        arc = next;
+    }
+
+    for (size_t i = 0; i < sweep->dcel->face_count; i++)
+    {
+        DCEL_Face_ptr_t face = sweep->dcel->faces[i];
+        if (! face->inc_edge) continue;
+        DCEL_HalfEdge_ptr_t half_edge = face->inc_edge;
+        while (half_edge->prev && half_edge->prev != face->inc_edge)
+        {
+            half_edge = half_edge->prev;
+        }
+        if (! half_edge->prev)
+        {
+            face->inc_edge = half_edge;
+        }
+    }
+}
+
+/**
+ * Makes sure that the queues of the sweep have room for a sweep over up to capacity sites.
+ * The queues are replaced by larger ones if necessary, otherwise they are kept
+ *
+ * @param sweep the sweep state
+ * @param capacity the largest number of sites
+ */
+static void voronoi_sweep_reserve(Voronoi_Sweep_t *sweep, size_t capacity)
+{
+    // Besides the site events, every event schedules at most two circle events.
+    // Invalidated circle events stay in the queue until they are dequeued, so all of them need room.
+    uint64_t queue_size = 7 * capacity + 1;
+    if (sweep->queue && queue_size <= sweep->queue_size) return;
+    priority_queue_destroy(sweep->queue);
+    radix_queue_destroy(sweep->radix_queue);
+    sweep->queue_size = queue_size;
+    sweep->queue = priority_queue_new(sweep->queue_size, voronoi_event_queue_comparator);
+    // The radix heap is created by the first sweep that asks for it
+    sweep->radix_queue = NULL;
+}
+
+/**
+ * Prepares the queue and the beach line of a sweep over up to capacity sites
+ *
+ * @param sweep the sweep state
+ * @param capacity the largest number of sites
+ */
+static void voronoi_sweep_init(Voronoi_Sweep_t *sweep, size_t capacity)
+{
+    sweep->queue = NULL;
+    sweep->radix_queue = NULL;
+    voronoi_sweep_reserve(sweep, capacity);
+    sweep->is_radix = 0;
+    sweep->is_failed = 0;
+    voronoi_sites_init(&sweep->sites);
+    sweep->next_site = 0;
+    sweep->beach_line = avl_tree_new_pooled(voronoi_beach_line_comparator);
+    voronoi_pool_init(&sweep->events, sizeof(Voronoi_CircleEvent_t));
+    voronoi_pool_init(&sweep->arcs, sizeof(Voronoi_Arc_t));
+    voronoi_pool_init(&sweep->breakpoints, sizeof(Voronoi_Breakpoint_t));
+    sweep->dcel = NULL;
+    sweep->delaunay = NULL;
+    sweep->sweep = 0;
+#ifdef VORONOI_STATS
+    sweep->rotations = 0;
+#endif
+}
+
+/**
+ * Creates the faces of the points and sorts the sites into the order of their events
+ *
+ * @param sweep the sweep state
+ * @param points the points array
+ * @param count the number of points inside the array
+ * @param dcel the edge list that receives the diagram
+ * @param options the options of the sweep, can be NULL
+ * @return 1 on success, 0 if the memory could not be allocated
+ */
+static uint8_t voronoi_sweep_begin(Voronoi_Sweep_t *sweep, Point_t_ptr *points, size_t count, DCEL_t *dcel,
+                                   const Voronoi_Options_t *options)
+{
+    if (NULL == sweep->queue) return 0;
+    // A diagram of n sites has at most 2n vertices and 3n edges
+    if (! dcel_reserve(dcel, 2 * count, 6 * count, count)) return 0;
+    for (size_t i = 0; i < count; i++)
+    {
+        if (NULL == dcel_face_new(dcel, *points[i], i)) return 0;
+    }
+    sweep->dcel = dcel;
+    sweep->delaunay = options ? options->delaunay : NULL;
+    sweep->is_radix = options && VORONOI_QUEUE_RADIX == options->queue;
+    if (sweep->is_radix && NULL == sweep->radix_queue)
+    {
+        sweep->radix_queue = radix_queue_new(sweep->queue_size, voronoi_event_queue_comparator);
+        if (NULL == sweep->radix_queue) return 0;
+    }
+    sweep->is_failed = 0;
+    if (sweep->delaunay)
+    {
+        // Every circle event yields one triangle and there are at most 2n of them
+        if (! delaunay_reserve(sweep->delaunay, 2 * count)) return 0;
+    }
+#ifdef VORONOI_STATS
+    memset(&sweep->stats, 0, sizeof(Voronoi_Stats_t));
+    sweep->queue->comparisons = 0;
+    sweep->rotations = avl_tree_rotations(sweep->beach_line);
+    sweep->stats.queue_bytes = sizeof(PQueue_t) + sweep->queue->size * (sizeof(void *) + sizeof(double));
+    if (sweep->is_radix)
+    {
+        sweep->radix_queue->ties->comparisons = 0;
+        // The buckets grow during the sweep and are added at its end
+        sweep->stats.queue_bytes += sizeof(Radix_Queue_t) + sizeof(PQueue_t) +
+                                    sweep->radix_queue->ties->size * (sizeof(void *) + sizeof(double));
+    }
+#endif
+    voronoi_trace_begin("sites");
+    uint8_t is_prepared = voronoi_sites_prepare(&sweep->sites, points, count);
+    sweep->next_site = 0;
+    voronoi_trace_end("sites");
+    return is_prepared;
+}
+
+/**
+ * Returns whether the site event comes before the circle event. A site at the very point of a circle event comes first
+ *
+ * @param site the site of the next site event
+ * @param event the next circle event, can be NULL
+ * @return 1 if the site event is next, 0 otherwise
+ */
+static uint8_t voronoi_site_precedes(Point_t_ptr site, Voronoi_CircleEvent_ptr_t event)
+{
+    if (NULL == event) return 1;
+    double y = VORONOI_SITE_EVENT_Y(site);
+    return y > event->circle_point.y || (y == event->circle_point.y && (double) site->x <= event->circle_point.x);
+}
+
+/**
+ * Processes the events until there are neither sites nor circle events left.
+ * The site events are read off the sorted sites and merged with the circle events from the queue
+ *
+ * @param sweep the sweep state
+ */
+static void voronoi_sweep_events(Voronoi_Sweep_t *sweep)
+{
+    voronoi_trace_begin("sweep");
+    Voronoi_Sites_t *sites = &sweep->sites;
+    while(1)
+    {
+        VORONOI_STATS_MAX(sweep->stats.queue_high_water,
+                          sweep->is_radix ? sweep->radix_queue->count : sweep->queue->next - 1);
+        VORONOI_STATS_MAX(sweep->stats.tree_max_height, avl_tree_node_height(avl_tree_root(sweep->beach_line)) + 1);
+        Voronoi_CircleEvent_ptr_t event = voronoi_event_peek(sweep);
+        if (sweep->is_failed) break;
+        if (sweep->next_site < sites->count && voronoi_site_precedes(sites->sites[sweep->next_site], event))
+        {
+            voronoi_process_site_event(sweep, sites->sites[sweep->next_site], sites->indices[sweep->next_site]);
+            sweep->next_site++;
+            VORONOI_STATS_ADD(sweep->stats.site_events, 1);
+            continue;
+        }
+        if (NULL == event) break;
+        voronoi_event_dequeue(sweep);
+        if (event->arc)
+        {
+            voronoi_process_circle_event(sweep, event);
+            VORONOI_STATS_ADD(sweep->stats.circle_events, 1);
+        }
+        else
+        {
+            VORONOI_STATS_ADD(sweep->stats.false_alarms, 1);
+        }
+        voronoi_pool_release(&sweep->events, event);
+    }
+    voronoi_trace_end("sweep");
+}
+
+/**
+ * Completes the edge list after the last event and clips it if requested
+ *
+ * @param sweep the sweep state
+ * @param options the options of the sweep, can be NULL
+ */
+static void voronoi_sweep_end(Voronoi_Sweep_t *sweep, const Voronoi_Options_t *options)
+{
+    voronoi_trace_begin("finalise");
+    voronoi_sweep_finalise(sweep);
+    avl_tree_clear(sweep->beach_line);
+    voronoi_pool_clear(&sweep->events);
+    voronoi_pool_clear(&sweep->arcs);
+    voronoi_pool_clear(&sweep->breakpoints);
+    voronoi_trace_end("finalise");
+    if (options && options->clip)
+    {
+        voronoi_trace_begin("clip");
+        voronoi_clip(sweep->dcel, options->clip);
+        voronoi_trace_end("clip");
+    }
+    if (options && options->stats)
+    {
+#ifdef VORONOI_STATS
+        DCEL_t *dcel = sweep->dcel;
+        sweep->stats.event_comparisons = sweep->queue->comparisons;
+        if (sweep->is_radix)
+        {
+            sweep->stats.event_comparisons += sweep->radix_queue->ties->comparisons;
+            for (size_t b = 0; b < RADIX_QUEUE_BUCKETS; b++)
+            {
+                sweep->stats.queue_bytes += sweep->radix_queue->buckets[b].capacity * sizeof(Radix_Queue_Entry_t);
+            }
+        }
+        sweep->stats.tree_rotations = avl_tree_rotations(sweep->beach_line) - sweep->rotations;
+        sweep->stats.dcel_bytes = dcel->vertex_capacity * (sizeof(DCEL_Vertex_t) + sizeof(DCEL_Vertex_ptr_t)) +
+                                  dcel->half_edge_capacity * (sizeof(DCEL_HalfEdge_t) + sizeof(DCEL_HalfEdge_ptr_t)) +
+                                  dcel->face_capacity * (sizeof(DCEL_Face_t) + sizeof(DCEL_Face_ptr_t));
+        *options->stats = sweep->stats;
+#else
+        memset(options->stats, 0, sizeof(Voronoi_Stats_t));
+#endif
+    }
+}
+
+/**
+ * Sweeps over the points and adds their diagram to the edge list.
+ * The queue, the beach line and the pools are empty again afterwards, so the state can be reused for the next sweep
+ * over at most as many points as it was prepared for.
+ *
+ * @param sweep the sweep state
+ * @param points the points array
+ * @param count the number of points inside the array
+ * @param dcel the edge list that receives the diagram
+ * @param options the options of the sweep, can be NULL
+ * @return 1 on success, 0 if the memory could not be allocated, in which case the edge list is cleared
+ */
+static uint8_t voronoi_sweep_run(Voronoi_Sweep_t *sweep, Point_t_ptr *points, size_t count, DCEL_t *dcel,
+                                 const Voronoi_Options_t *options)
+{
+    if (! voronoi_sweep_begin(sweep, points, count, dcel, options))
+    {
+        dcel_clear(dcel);
+        return 0;
+    }
+    voronoi_sweep_events(sweep);
+    voronoi_sweep_end(sweep, options);
+    if (sweep->is_failed)
+    {
+        // The radix queue still holds events of the released pool, the next sweep starts with a new one
+        radix_queue_destroy(sweep->radix_queue);
+        sweep->radix_queue = NULL;
+        dcel_clear(dcel);
+        return 0;
+    }
+    return 1;
+}
+
+/**
+ * Frees the memory chunks used by the sweep state
+ *
+ * @param sweep the sweep state
+ */
+static void voronoi_sweep_destroy(Voronoi_Sweep_t *sweep)
+{
+    avl_tree_destroy(sweep->beach_line);
+    priority_queue_destroy(sweep->queue);
+    radix_queue_destroy(sweep->radix_queue);
+    voronoi_sites_destroy(&sweep->sites);
+    voronoi_pool_destroy(&sweep->events);
+    voronoi_pool_destroy(&sweep->arcs);
+    voronoi_pool_destroy(&sweep->breakpoints);
+}
+
+/**
+ * The memory of the sweep and of the diagram, kept from one diagram to the next
+ */
+struct Voronoi_Workspace {
+    Voronoi_Sweep_t sweep;
+    DCEL_t dcel; // The diagram of the last call
+};
+
+/**
+ * Creates a workspace for diagrams of up to capacity points. Larger inputs are accepted as well,
+ * the workspace grows to fit them
+ *
+ * @param capacity the expected largest number of points
+ * @return a handle to the workspace, NULL if the memory could not be allocated
+ */
+Voronoi_Workspace_t *voronoi_workspace_new(size_t capacity)
+{
+    Voronoi_Workspace_t *workspace = malloc(sizeof(Voronoi_Workspace_t));
+    if (NULL == workspace) return NULL;
+    voronoi_sweep_init(&workspace->sweep, capacity);
+    dcel_init(&workspace->dcel);
+    return workspace;
+}
+
+/**
+ * Computes the Voronoi diagram for a set of points with the memory of the workspace, like
+ * voronoi_diagram_with_options. The diagram of the previous call is cleared and its memory reused.
+ * Once the workspace has seen its largest input, no further heap allocations are made, except for the clipping.
+ * A Delaunay triangulation requested through the options is appended to, the caller clears it with delaunay_clear.
+ *
+ * @param self the workspace handle
+ * @param points the points array
+ * @param count the number of points inside the array
+ * @param options the options of the sweep, can be NULL
+ * @return the diagram, empty if the memory could not be allocated. It belongs to the workspace and stays valid
+ * until the next call on it
+ */
+DCEL_t *voronoi_workspace_diagram(Voronoi_Workspace_t *self, Point_t_ptr *points, size_t count,
+                                  Voronoi_Options_t *options)
+{
+    voronoi_sweep_reserve(&self->sweep, count);
+    dcel_clear(&self->dcel);
+    voronoi_sweep_run(&self->sweep, points, count, &self->dcel, options);
+    return &self->dcel;
+}
+
+/**
+ * Frees the workspace together with its last diagram
+ *
+ * @param self the workspace handle
+ */
+void voronoi_workspace_destroy(Voronoi_Workspace_t *self)
+{
+    if (self)
+    {
+        voronoi_sweep_destroy(&self->sweep);
+        dcel_destroy(&self->dcel);
+        free(self);
+    }
+}
 
 /**
  * Computes the Voronoi diagram for a set of points
@@ -87,20 +1115,93 @@ void voronoi_process_circle_event(Voronoi_Arc_ptr_t arc);
  */
 DCEL_t voronoi_diagram(Point_t_ptr *points, size_t count)
 {
-    PQueue_t *event_queue = voronoi_event_queue_init(points, count);
-    while(! priority_queue_is_empty(event_queue))
+    return voronoi_diagram_with_options(points, count, NULL);
+}
+
+/**
+ * Computes the Voronoi diagram for a set of points
+ * There is one face per point, in the order of the points. The index of each face is the index of its point.
+ *
+ * @param points the points array
+ * @param count the number of points inside the array
+ * @param options the options of the sweep, can be NULL
+ * @return a doubly-connected edge list representing the diagram, empty if the memory could not be allocated
+ */
+DCEL_t voronoi_diagram_with_options(Point_t_ptr *points, size_t count, Voronoi_Options_t *options)
+{
+    DCEL_t dcel;
+    dcel_init(&dcel);
+    Voronoi_Sweep_t sweep;
+    voronoi_sweep_init(&sweep, count);
+    if (! voronoi_sweep_run(&sweep, points, count, &dcel, options))
+    {
+        dcel_destroy(&dcel);
+        dcel_init(&dcel);
+    }
+    voronoi_sweep_destroy(&sweep);
+    return dcel;
+}
+
+/**
+ * Moves every point to the centroid of its cell within the bounding polygon, which is known as Lloyd's relaxation.
+ * The iteration stops after the given number of rounds or as soon as no point moves farther than the tolerance.
+ *
+ * The rounds share one workspace, so the sweep state and the memory of the diagram are reused from one round to the
+ * next. The centroids are rounded to the nearest integer coordinates, so the points settle on the grid instead of
+ * converging exactly.
+ * Points outside the polygon and duplicates of other points do not move.
+ *
+ * @param points the points array, updated in place
+ * @param count the number of points inside the array
+ * @param iterations the largest number of rounds
+ * @param bbox the convex polygon that bounds the cells
+ * @param tolerance the distance below which a point counts as settled
+ * @return the number of rounds performed
+ */
+size_t voronoi_lloyd(Point_t_ptr *points, size_t count, size_t iterations, const Voronoi_Clip_t *bbox,
+                     double tolerance)
+{
+    Voronoi_Workspace_t *workspace = voronoi_workspace_new(count);
+    if (NULL == workspace) return 0;
+    Voronoi_Options_t options = {.delaunay = NULL, .clip = bbox};
+
+    size_t iteration = 0;
+    while (iteration < iterations)
     {
-        Voronoi_Event_ptr_t event = (Voronoi_Event_ptr_t) priority_queue_dequeue(event_queue);
-        if (! event->is_circle_event)
+        voronoi_trace_begin("lloyd_round");
+        DCEL_t *dcel = voronoi_workspace_diagram(workspace, points, count, &options);
+        if (dcel->face_count != count)
         {
-            voronoi_process_site_event(event->site_event->site);
+            voronoi_trace_end("lloyd_round");
+            break;
         }
-        else
+        iteration++;
+
+        double max_shift = 0;
+        #pragma omp parallel default(none) shared(dcel, points, count) reduction(max:max_shift)
         {
-            voronoi_process_circle_event(event->circle_event->arc);
+            voronoi_trace_begin("lloyd_centroids");
+            #pragma omp for schedule(static) nowait
+            for (size_t i = 0; i < count; i++)
+            {
+                Point_Real_t centroid;
+                if (! voronoi_face_centroid(dcel->faces[i], &centroid)) continue;
+                uint64_t x = centroid.x > 0 ? (uint64_t) floor(centroid.x + 0.5) : 0;
+                uint64_t y = centroid.y > 0 ? (uint64_t) floor(centroid.y + 0.5) : 0;
+                double shift = hypot((double) x - (double) points[i]->x, (double) y - (double) points[i]->y);
+                if (shift > max_shift)
+                {
+                    max_shift = shift;
+                }
+                points[i]->x = x;
+                points[i]->y = y;
+            }
+            voronoi_trace_end("lloyd_centroids");
         }
+        voronoi_trace_end("lloyd_round");
+        if (max_shift <= tolerance) break;
     }
 
-    priority_queue_destroy(event_queue);
-
-}
\ No newline at end of file
+    voronoi_workspace_destroy(workspace);
+    return iteration;
+}
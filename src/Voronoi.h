@@ -8,12 +8,23 @@
 #include <stddef.h>
 #include "Point.h"
 #include "DCEL.h"
+#include "Delaunay.h"
+#include "VoronoiClip.h"
+#include "AVLTree.h"
+#include "VoronoiStats.h"
 
-typedef struct CircleEvent;
+struct CircleEvent;
+struct Breakpoint;
 
 typedef struct Arc {
     Point_t_ptr site;
+    size_t index; // The index of the site
     struct CircleEvent *circle_event; // This is where the arc will disappear. The lowest point of the circle
+    struct Arc *prev; // The neighbouring arc on the left
+    struct Arc *next; // The neighbouring arc on the right
+    struct Breakpoint *left_breakpoint; // The breakpoint shared with prev
+    struct Breakpoint *right_breakpoint; // The breakpoint shared with next
+    AVLTree_Node_ptr_t node; // The leaf of the beach line that holds the arc
 } Voronoi_Arc_t;
 
 typedef Voronoi_Arc_t* Voronoi_Arc_ptr_t;
@@ -21,33 +32,46 @@ typedef Voronoi_Arc_t* Voronoi_Arc_ptr_t;
 typedef struct Breakpoint {
     Point_t_ptr left_site;
     Point_t_ptr right_site;
-    DCEL_HalfEdge_ptr_t half_edge;
+    DCEL_HalfEdge_ptr_t half_edge; // The half-edge traced out by the breakpoint on the face of the left site
+    uint32_t triangle; // The Delaunay triangle at the start of the traced edge, DELAUNAY_NONE if there is none
+    struct Breakpoint *partner; // The breakpoint tracing the same edge in the opposite direction, if any
 } Voronoi_Breakpoint_t;
 
 typedef Voronoi_Breakpoint_t* Voronoi_Breakpoint_ptr_t;
 
-typedef struct SiteEvent {
-    Point_t_ptr site;
-} Voronoi_SiteEvent_t;
-
-typedef Voronoi_SiteEvent_t* Voronoi_SiteEvent_ptr_t;
-
 typedef struct CircleEvent {
-    Point_t_ptr circle_point; // The lowest point of the circle
-    Voronoi_Arc_ptr_t arc; // The arc that will dissapear in this event
+    Point_Real_t circle_point; // The lowest point of the circle
+    Point_Real_t center; // The center of the circle, which becomes a vertex of the diagram
+    Voronoi_Arc_ptr_t arc; // The arc that will dissapear in this event, NULL if the event was invalidated
 } Voronoi_CircleEvent_t;
 
 typedef Voronoi_CircleEvent_t* Voronoi_CircleEvent_ptr_t;
 
-typedef struct Event {
-    uint8_t is_circle_event;
-    union {
-        Voronoi_CircleEvent_ptr_t circle_event;
-        Voronoi_SiteEvent_ptr_t site_event;
-    };
-} Voronoi_Event_t;
+/**
+ * The event queues the sweep can use
+ */
+typedef enum {
+    VORONOI_QUEUE_HEAP = 0, // The heap of PQueue_t, which suits any input
+    // The radix heap of Radix_Queue_t over the heights of the events. It exploits that the sweep only moves downwards
+    // and pays off on inputs with many sites on the same rows, like snapped grids
+    VORONOI_QUEUE_RADIX
+} Voronoi_Queue_t;
 
-typedef Voronoi_Event_t* Voronoi_Event_ptr_t;
+/**
+ * Optional inputs and outputs of the sweep
+ */
+typedef struct {
+    // Receives the Delaunay triangulation of the sites if not NULL. It must be initialized.
+    // The triangles are recorded as the circle events fire, so the dual comes out of the same sweep.
+    Delaunay_t *delaunay;
+    // Clips the diagram to a convex polygon if not NULL, such that every face is closed and finite.
+    // The Delaunay triangulation is not clipped.
+    const Voronoi_Clip_t *clip;
+    // Receives the counters of the sweep if not NULL. They are zero unless compiled with VORONOI_STATS.
+    Voronoi_Stats_t *stats;
+    // The event queue, the heap by default
+    Voronoi_Queue_t queue;
+} Voronoi_Options_t;
 
 /**
  * Computes the Voronoi diagram for a set of points
@@ -58,6 +82,72 @@ typedef Voronoi_Event_t* Voronoi_Event_ptr_t;
  */
 DCEL_t voronoi_diagram(Point_t_ptr *points, size_t count);
 
+/**
+ * Computes the Voronoi diagram for a set of points
+ * There is one face per point, in the order of the points. The index of each face is the index of its point.
+ *
+ * @param points the points array
+ * @param count the number of points inside the array
+ * @param options the options of the sweep, can be NULL
+ * @return a doubly-connected edge list representing the diagram, empty if the memory could not be allocated
+ */
+DCEL_t voronoi_diagram_with_options(Point_t_ptr *points, size_t count, Voronoi_Options_t *options);
+
+/**
+ * The memory of the sweep and of the diagram, kept from one diagram to the next.
+ * Serves repeated computations, which then no longer pay for the allocator on every call
+ */
+typedef struct Voronoi_Workspace Voronoi_Workspace_t;
 
+/**
+ * Creates a workspace for diagrams of up to capacity points. Larger inputs are accepted as well,
+ * the workspace grows to fit them
+ *
+ * @param capacity the expected largest number of points
+ * @return a handle to the workspace, NULL if the memory could not be allocated
+ */
+Voronoi_Workspace_t *voronoi_workspace_new(size_t capacity);
+
+/**
+ * Computes the Voronoi diagram for a set of points with the memory of the workspace, like
+ * voronoi_diagram_with_options. The diagram of the previous call is cleared and its memory reused.
+ * Once the workspace has seen its largest input, no further heap allocations are made, except for the clipping.
+ * A Delaunay triangulation requested through the options is appended to, the caller clears it with delaunay_clear.
+ *
+ * @param self the workspace handle
+ * @param points the points array
+ * @param count the number of points inside the array
+ * @param options the options of the sweep, can be NULL
+ * @return the diagram, empty if the memory could not be allocated. It belongs to the workspace and stays valid
+ * until the next call on it
+ */
+DCEL_t *voronoi_workspace_diagram(Voronoi_Workspace_t *self, Point_t_ptr *points, size_t count,
+                                  Voronoi_Options_t *options);
+
+/**
+ * Frees the workspace together with its last diagram
+ *
+ * @param self the workspace handle
+ */
+void voronoi_workspace_destroy(Voronoi_Workspace_t *self);
+
+/**
+ * Moves every point to the centroid of its cell within the bounding polygon, which is known as Lloyd's relaxation.
+ * The iteration stops after the given number of rounds or as soon as no point moves farther than the tolerance.
+ *
+ * The rounds share one workspace, so the sweep state and the memory of the diagram are reused from one round to the
+ * next. The centroids are rounded to the nearest integer coordinates, so the points settle on the grid instead of
+ * converging exactly.
+ * Points outside the polygon and duplicates of other points do not move.
+ *
+ * @param points the points array, updated in place
+ * @param count the number of points inside the array
+ * @param iterations the largest number of rounds
+ * @param bbox the convex polygon that bounds the cells
+ * @param tolerance the distance below which a point counts as settled
+ * @return the number of rounds performed
+ */
+size_t voronoi_lloyd(Point_t_ptr *points, size_t count, size_t iterations, const Voronoi_Clip_t *bbox,
+                     double tolerance);
 
 #endif //VORONOI_VORONOI_H
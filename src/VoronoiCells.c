@@ -0,0 +1,218 @@
+//
+// Per-cell measures of a Voronoi diagram
+//
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include "VoronoiCells.h"
+#include "VoronoiTrace.h"
+
+/**
+ * The measures of a single face, accumulated during one walk around its boundary
+ */
+typedef struct {
+    double area;
+    double centroid_x;
+    double centroid_y;
+    double perimeter;
+    size_t degree; // The number of neighbours
+} Voronoi_Cell_t;
+
+/**
+ * Initializes an empty set of cell measures
+ *
+ * @param self the cells handle
+ */
+void voronoi_cells_init(Voronoi_Cells_t *self)
+{
+    memset(self, 0, sizeof(Voronoi_Cells_t));
+}
+
+/**
+ * Walks once around the boundary of the face. The neighbours are written out if an array is given
+ *
+ * @param face the face
+ * @param cell receives the measures
+ * @param neighbours receives the indices of the neighbouring faces, can be NULL
+ */
+static void voronoi_cell_walk(DCEL_Face_ptr_t face, Voronoi_Cell_t *cell, uint32_t *neighbours)
+{
+    cell->area = cell->perimeter = 0;
+    cell->centroid_x = cell->centroid_y = NAN;
+    cell->degree = 0;
+    DCEL_HalfEdge_ptr_t start = face->inc_edge;
+    if (! start) return;
+
+    // Measure relative to the first vertex to keep the products small. Only closed faces need it
+    Point_Real_t origin = {0, 0};
+    if (start->origin) origin = start->origin->position;
+    double area = 0;
+    double x = 0;
+    double y = 0;
+    double perimeter = 0;
+    DCEL_HalfEdge_ptr_t half_edge = start;
+    do
+    {
+        DCEL_Face_ptr_t neighbour = half_edge->twin->inc_face;
+        if (neighbour)
+        {
+            if (neighbours) neighbours[cell->degree] = (uint32_t) neighbour->index;
+            cell->degree++;
+        }
+        if (half_edge->origin && half_edge->twin->origin)
+        {
+            double from_x = half_edge->origin->position.x - origin.x;
+            double from_y = half_edge->origin->position.y - origin.y;
+            double to_x = half_edge->twin->origin->position.x - origin.x;
+            double to_y = half_edge->twin->origin->position.y - origin.y;
+            double cross = from_x * to_y - to_x * from_y;
+            area += cross;
+            x += (from_x + to_x) * cross;
+            y += (from_y + to_y) * cross;
+            perimeter += hypot(to_x - from_x, to_y - from_y);
+        }
+        half_edge = half_edge->next;
+    } while (half_edge && half_edge != start);
+
+    if (! half_edge)
+    {
+        cell->area = cell->perimeter = INFINITY;
+        return;
+    }
+    cell->area = area / 2;
+    cell->perimeter = perimeter;
+    if (area > 0)
+    {
+        cell->centroid_x = origin.x + x / (3 * area);
+        cell->centroid_y = origin.y + y / (3 * area);
+    }
+}
+
+/**
+ * Grows the arrays of self to hold the given number of faces and neighbours
+ *
+ * @param self the cells handle
+ * @param count the number of faces
+ * @param neighbour_count the number of neighbours
+ * @return 1 on success, 0 if the memory could not be allocated
+ */
+static uint8_t voronoi_cells_reserve(Voronoi_Cells_t *self, size_t count, size_t neighbour_count)
+{
+    if (count > self->capacity || NULL == self->neighbour_offsets)
+    {
+        double **arrays[4] = {&self->area, &self->centroid_x, &self->centroid_y, &self->perimeter};
+        for (size_t i = 0; i < 4; i++)
+        {
+            double *array = realloc(*arrays[i], count * sizeof(double));
+            if (NULL == array) return 0;
+            *arrays[i] = array;
+        }
+        size_t *offsets = realloc(self->neighbour_offsets, (count + 1) * sizeof(size_t));
+        if (NULL == offsets) return 0;
+        self->neighbour_offsets = offsets;
+        self->capacity = count;
+    }
+    if (neighbour_count > self->neighbour_capacity)
+    {
+        uint32_t *neighbours = realloc(self->neighbours, neighbour_count * sizeof(uint32_t));
+        if (NULL == neighbours) return 0;
+        self->neighbours = neighbours;
+        self->neighbour_capacity = neighbour_count;
+    }
+    return 1;
+}
+
+/**
+ * Measures every face of the diagram. The faces are processed in parallel and the memory of self is reused,
+ * so the same handle can be passed for one diagram after another
+ *
+ * The first pass computes the measures and the number of neighbours of each face, which gives the offsets
+ * of the neighbour lists. The second pass walks the faces again to fill in the lists.
+ *
+ * @param self the cells handle
+ * @param dcel the diagram
+ * @return 1 on success, 0 if the memory could not be allocated
+ */
+uint8_t voronoi_cells_compute(Voronoi_Cells_t *self, const DCEL_t *dcel)
+{
+    size_t count = dcel->face_count;
+    // Every half-edge contributes at most one neighbour
+    if (! voronoi_cells_reserve(self, count, dcel->half_edge_count)) return 0;
+    self->count = count;
+    DCEL_Face_ptr_t *faces = dcel->faces;
+    size_t *offsets = self->neighbour_offsets;
+
+    #pragma omp parallel default(none) shared(self, faces, offsets, count)
+    {
+        voronoi_trace_begin("cells_measure");
+        #pragma omp for schedule(static) nowait
+        for (size_t i = 0; i < count; i++)
+        {
+            Voronoi_Cell_t cell;
+            voronoi_cell_walk(faces[i], &cell, NULL);
+            self->area[i] = cell.area;
+            self->centroid_x[i] = cell.centroid_x;
+            self->centroid_y[i] = cell.centroid_y;
+            self->perimeter[i] = cell.perimeter;
+            offsets[i + 1] = cell.degree;
+        }
+        voronoi_trace_end("cells_measure");
+    }
+
+    offsets[0] = 0;
+    for (size_t i = 0; i < count; i++)
+    {
+        offsets[i + 1] += offsets[i];
+    }
+
+    uint32_t *neighbours = self->neighbours;
+    #pragma omp parallel default(none) shared(faces, offsets, neighbours, count)
+    {
+        voronoi_trace_begin("cells_neighbours");
+        #pragma omp for schedule(static) nowait
+        for (size_t i = 0; i < count; i++)
+        {
+            Voronoi_Cell_t cell;
+            voronoi_cell_walk(faces[i], &cell, &neighbours[offsets[i]]);
+        }
+        voronoi_trace_end("cells_neighbours");
+    }
+    return 1;
+}
+
+/**
+ * Computes the centroid of a single closed face
+ *
+ * @param face the face
+ * @param centroid receives the centroid
+ * @return 1 if the face encloses an area, 0 otherwise
+ */
+uint8_t voronoi_face_centroid(DCEL_Face_ptr_t face, Point_Real_t *centroid)
+{
+    Voronoi_Cell_t cell;
+    voronoi_cell_walk(face, &cell, NULL);
+    if (isinf(cell.area) || isnan(cell.centroid_x)) return 0;
+    centroid->x = cell.centroid_x;
+    centroid->y = cell.centroid_y;
+    return 1;
+}
+
+/**
+ * Frees the arrays of self. The cells are empty afterwards
+ *
+ * @param self the cells handle
+ */
+void voronoi_cells_destroy(Voronoi_Cells_t *self)
+{
+    if (self)
+    {
+        free(self->area);
+        free(self->centroid_x);
+        free(self->centroid_y);
+        free(self->perimeter);
+        free(self->neighbour_offsets);
+        free(self->neighbours);
+        voronoi_cells_init(self);
+    }
+}
@@ -0,0 +1,66 @@
+//
+// Per-cell measures of a Voronoi diagram
+//
+
+#ifndef VORONOI_VORONOICELLS_H
+#define VORONOI_VORONOICELLS_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "Point.h"
+#include "DCEL.h"
+
+/**
+ * The area, centroid, perimeter and neighbours of every face of a diagram, stored as flat arrays indexed by face.
+ *
+ * The neighbours of face i are neighbours[neighbour_offsets[i]] up to, but excluding,
+ * neighbours[neighbour_offsets[i + 1]], in counter-clockwise order. Sides along a clip polygon have no neighbour.
+ * An unbounded face has an infinite area and perimeter, a face without edges has neither area nor perimeter.
+ * The centroid of both is NAN.
+ */
+typedef struct {
+    double *area;
+    double *centroid_x;
+    double *centroid_y;
+    double *perimeter;
+    size_t *neighbour_offsets; // count + 1 entries
+    uint32_t *neighbours;
+    size_t count; // The number of faces
+    size_t capacity; // The number of faces that fit into the arrays
+    size_t neighbour_capacity; // The number of neighbours that fit into the neighbour array
+} Voronoi_Cells_t;
+
+/**
+ * Initializes an empty set of cell measures
+ *
+ * @param self the cells handle
+ */
+void voronoi_cells_init(Voronoi_Cells_t *self);
+
+/**
+ * Measures every face of the diagram. The faces are processed in parallel and the memory of self is reused,
+ * so the same handle can be passed for one diagram after another
+ *
+ * @param self the cells handle
+ * @param dcel the diagram
+ * @return 1 on success, 0 if the memory could not be allocated
+ */
+uint8_t voronoi_cells_compute(Voronoi_Cells_t *self, const DCEL_t *dcel);
+
+/**
+ * Computes the centroid of a single closed face
+ *
+ * @param face the face
+ * @param centroid receives the centroid
+ * @return 1 if the face encloses an area, 0 otherwise
+ */
+uint8_t voronoi_face_centroid(DCEL_Face_ptr_t face, Point_Real_t *centroid);
+
+/**
+ * Frees the arrays of self. The cells are empty afterwards
+ *
+ * @param self the cells handle
+ */
+void voronoi_cells_destroy(Voronoi_Cells_t *self);
+
+#endif //VORONOI_VORONOICELLS_H
@@ -0,0 +1,577 @@
+//
+// Clipping of a Voronoi diagram to a convex region
+//
+
+#include <math.h>
+#include <stdlib.h>
+#include "VoronoiClip.h"
+
+// A chain of half-edges of one face that enters and leaves the clip polygon
+typedef struct {
+    DCEL_Face_ptr_t face;
+    DCEL_HalfEdge_ptr_t first; // The half-edge that starts on the boundary of the polygon
+    DCEL_HalfEdge_ptr_t last; // The half-edge that ends on the boundary of the polygon
+    double entry; // The position of the start of first along the boundary of the polygon
+    double exit; // The position of the end of last along the boundary of the polygon
+} Voronoi_Clip_Chain_t;
+
+/**
+ * Describes the axis-aligned rectangle [min_x, max_x] x [min_y, max_y] as a clip polygon
+ *
+ * @param corners receives the four corners of the rectangle, must outlive the clip polygon
+ * @param min_x the left side of the rectangle
+ * @param min_y the bottom side of the rectangle
+ * @param max_x the right side of the rectangle
+ * @param max_y the top side of the rectangle
+ * @return the clip polygon
+ */
+Voronoi_Clip_t voronoi_clip_rectangle(Point_Real_t corners[4], double min_x, double min_y, double max_x, double max_y)
+{
+    corners[0].x = min_x;
+    corners[0].y = min_y;
+    corners[1].x = max_x;
+    corners[1].y = min_y;
+    corners[2].x = max_x;
+    corners[2].y = max_y;
+    corners[3].x = min_x;
+    corners[3].y = max_y;
+    Voronoi_Clip_t clip = {corners, 4};
+    return clip;
+}
+
+/**
+ * Restricts the line start + t * direction, t in [t0, t1], to the polygon (Cyrus-Beck)
+ *
+ * @param clip the polygon
+ * @param start a point on the line
+ * @param direction the direction of the line
+ * @param t0 the lower bound of the parameter, updated in place
+ * @param t1 the upper bound of the parameter, updated in place
+ * @return 1 if a part of positive length is inside the polygon, 0 otherwise
+ */
+static uint8_t voronoi_clip_line(const Voronoi_Clip_t *clip, Point_Real_t start, Point_Real_t direction,
+                                 double *t0, double *t1)
+{
+    for (size_t i = 0; i < clip->count; i++)
+    {
+        Point_Real_t corner = clip->vertices[i];
+        Point_Real_t following = clip->vertices[(i + 1) % clip->count];
+        // The inside is on the left of every side
+        double normal_x = corner.y - following.y;
+        double normal_y = following.x - corner.x;
+        double distance = normal_x * (start.x - corner.x) + normal_y * (start.y - corner.y);
+        double speed = normal_x * direction.x + normal_y * direction.y;
+        if (speed == 0)
+        {
+            if (distance < 0) return 0;
+            continue;
+        }
+        double t = -distance / speed;
+        if (speed > 0 && t > *t0)
+        {
+            *t0 = t;
+        }
+        else if (speed < 0 && t < *t1)
+        {
+            *t1 = t;
+        }
+    }
+    return *t0 < *t1;
+}
+
+/**
+ * Yields the position of a point on the boundary of the polygon.
+ * The position is i + f for the point at fraction f of the side from corner i to corner i + 1.
+ *
+ * @param clip the polygon
+ * @param point the point, which is snapped to the nearest side
+ * @return the position
+ */
+static double voronoi_clip_position(const Voronoi_Clip_t *clip, Point_Real_t point)
+{
+    double best_distance = INFINITY;
+    double best_position = 0;
+    for (size_t i = 0; i < clip->count; i++)
+    {
+        Point_Real_t corner = clip->vertices[i];
+        Point_Real_t following = clip->vertices[(i + 1) % clip->count];
+        double side_x = following.x - corner.x;
+        double side_y = following.y - corner.y;
+        double length = side_x * side_x + side_y * side_y;
+        double fraction = length > 0 ? ((point.x - corner.x) * side_x + (point.y - corner.y) * side_y) / length : 0;
+        fraction = fraction < 0 ? 0 : (fraction > 1 ? 1 : fraction);
+        double offset_x = corner.x + fraction * side_x - point.x;
+        double offset_y = corner.y + fraction * side_y - point.y;
+        double distance = offset_x * offset_x + offset_y * offset_y;
+        if (distance < best_distance)
+        {
+            best_distance = distance;
+            best_position = (double) i + fraction;
+        }
+    }
+    return best_position >= (double) clip->count ? 0 : best_position;
+}
+
+/**
+ * Cuts the links between the half-edge and its neighbours at its origin
+ */
+static void voronoi_clip_detach_origin(DCEL_HalfEdge_ptr_t half_edge)
+{
+    if (half_edge->prev)
+    {
+        half_edge->prev->next = NULL;
+        half_edge->prev = NULL;
+    }
+    if (half_edge->twin->next)
+    {
+        half_edge->twin->next->prev = NULL;
+        half_edge->twin->next = NULL;
+    }
+}
+
+/**
+ * Removes the edge of the half-edge and its twin from the diagram. The half-edges are marked by unlinking the twins
+ */
+static void voronoi_clip_remove_edge(DCEL_HalfEdge_ptr_t half_edge)
+{
+    DCEL_HalfEdge_ptr_t twin = half_edge->twin;
+    voronoi_clip_detach_origin(half_edge);
+    voronoi_clip_detach_origin(twin);
+    half_edge->twin = twin->twin = NULL;
+}
+
+/**
+ * Checks whether all edges of the chain that starts with the half-edge are shorter than the tolerance
+ */
+static uint8_t voronoi_clip_is_point(DCEL_HalfEdge_ptr_t half_edge, double tolerance)
+{
+    for (; half_edge; half_edge = half_edge->next)
+    {
+        Point_Real_t from = half_edge->origin->position;
+        Point_Real_t to = half_edge->twin->origin->position;
+        if (hypot(to.x - from.x, to.y - from.y) > tolerance) return 0;
+    }
+    return 1;
+}
+
+#ifdef VORONOI_WEIGHTED
+/**
+ * Computes the direction in which the bisector of two weighted sites runs off to infinity. The bisector is a branch
+ * of a hyperbola, whose asymptotes replace the perpendicular bisector of the unweighted sites
+ *
+ * @param left the site on the left of the bisector
+ * @param right the site on the right of the bisector
+ * @param is_end 1 for the end of the half-edge with the left face, 0 for its start
+ * @return the direction in which the half-edge runs at that end
+ */
+static Point_Real_t voronoi_clip_asymptote(Point_t left, Point_t right, uint8_t is_end)
+{
+    double dx = (double) right.x - (double) left.x;
+    double dy = (double) right.y - (double) left.y;
+    double distance = sqrt(dx * dx + dy * dy);
+    // Far out in a direction u, the distances to the sites differ by u . (right - left), which matches the weights
+    double cosine = (left.weight - right.weight) / distance;
+    if (cosine > 1) cosine = 1;
+    if (cosine < -1) cosine = -1;
+    double sine = sqrt(1 - cosine * cosine);
+    if (! is_end) cosine = -cosine;
+    Point_Real_t direction = {(cosine * dx - sine * dy) / distance, (cosine * dy + sine * dx) / distance};
+    return direction;
+}
+#endif
+
+/**
+ * Clips the edge of the half-edge and its twin. An edge that lies outside is marked by unlinking the twins
+ *
+ * @param dcel the diagram
+ * @param clip the polygon
+ * @param half_edge the half-edge
+ * @param tolerance the length below which a clipped edge is dropped
+ * @return 1 on success, 0 if the memory could not be allocated
+ */
+static uint8_t voronoi_clip_edge(DCEL_t *dcel, const Voronoi_Clip_t *clip, DCEL_HalfEdge_ptr_t half_edge,
+                                 double tolerance)
+{
+    DCEL_HalfEdge_ptr_t twin = half_edge->twin;
+    DCEL_Vertex_ptr_t origin = half_edge->origin;
+    DCEL_Vertex_ptr_t target = twin->origin;
+    Point_t left = half_edge->inc_face->site;
+    Point_t right = twin->inc_face->site;
+
+    // The edge runs along the bisector of the two sites, with the face of the half-edge on its left
+    Point_Real_t start;
+    Point_Real_t direction = {(double) left.y - (double) right.y, (double) right.x - (double) left.x};
+    double t0 = -INFINITY;
+    double t1 = INFINITY;
+    if (origin && target)
+    {
+        start = origin->position;
+        direction.x = target->position.x - start.x;
+        direction.y = target->position.y - start.y;
+        t0 = 0;
+        t1 = 1;
+    }
+    else if (origin)
+    {
+        start = origin->position;
+        t0 = 0;
+#ifdef VORONOI_WEIGHTED
+        direction = voronoi_clip_asymptote(left, right, 1);
+#endif
+    }
+    else if (target)
+    {
+        start = target->position;
+        t1 = 0;
+#ifdef VORONOI_WEIGHTED
+        direction = voronoi_clip_asymptote(left, right, 0);
+#endif
+    }
+    else
+    {
+        start.x = ((double) left.x + (double) right.x) / 2;
+        start.y = ((double) left.y + (double) right.y) / 2;
+#ifdef VORONOI_WEIGHTED
+        // The line through the vertex of the hyperbola, which is closer to the lighter site
+        double shift = (left.weight - right.weight) / 2 / hypot(direction.x, direction.y);
+        start.x += shift * direction.y;
+        start.y -= shift * direction.x;
+#endif
+    }
+    double start_t = t0;
+    double end_t = t1;
+
+    uint8_t is_inside = voronoi_clip_line(clip, start, direction, &t0, &t1);
+    // An edge that merely touches the polygon, e.g. at a corner, would leave a cell without area behind
+    if (is_inside && (t0 != start_t || t1 != end_t))
+    {
+        is_inside = (t1 - t0) * sqrt(direction.x * direction.x + direction.y * direction.y) > tolerance;
+    }
+    if (! is_inside)
+    {
+        voronoi_clip_remove_edge(half_edge);
+        return 1;
+    }
+    if (t0 != start_t)
+    {
+        Point_Real_t position = {start.x + t0 * direction.x, start.y + t0 * direction.y};
+        voronoi_clip_detach_origin(half_edge);
+        half_edge->origin = dcel_vertex_new(dcel, position);
+        if (NULL == half_edge->origin) return 0;
+    }
+    if (t1 != end_t)
+    {
+        Point_Real_t position = {start.x + t1 * direction.x, start.y + t1 * direction.y};
+        voronoi_clip_detach_origin(twin);
+        twin->origin = dcel_vertex_new(dcel, position);
+        if (NULL == twin->origin) return 0;
+    }
+    return 1;
+}
+
+/**
+ * Creates a half-edge from one vertex to another on the boundary of the polygon, inside the face.
+ * Its twin lies outside of the polygon and has no face
+ */
+static DCEL_HalfEdge_ptr_t voronoi_clip_boundary_edge(DCEL_t *dcel, DCEL_Face_ptr_t face,
+                                                      DCEL_Vertex_ptr_t from, DCEL_Vertex_ptr_t to)
+{
+    DCEL_HalfEdge_ptr_t half_edge = dcel_half_edge_new(dcel, face);
+    if (NULL == half_edge) return NULL;
+    DCEL_HalfEdge_ptr_t twin = dcel_half_edge_new(dcel, NULL);
+    if (NULL == twin) return NULL;
+    half_edge->twin = twin;
+    twin->twin = half_edge;
+    half_edge->origin = from;
+    twin->origin = to;
+    return half_edge;
+}
+
+/**
+ * Yields the vertex at a corner of the polygon, creating it on first use
+ */
+static DCEL_Vertex_ptr_t voronoi_clip_corner(DCEL_t *dcel, const Voronoi_Clip_t *clip, DCEL_Vertex_ptr_t *corners,
+                                             size_t i)
+{
+    if (! corners[i])
+    {
+        corners[i] = dcel_vertex_new(dcel, clip->vertices[i]);
+    }
+    return corners[i];
+}
+
+/**
+ * Walks along the boundary of the polygon from the end of one chain to the start of another, counter-clockwise,
+ * and links both chains with half-edges along the way
+ *
+ * @param dcel the diagram
+ * @param clip the polygon
+ * @param corners the vertices created for the corners of the polygon so far
+ * @param from the chain to continue
+ * @param to the chain to continue with
+ * @param distance the distance between both chains along the boundary, measured in sides of the polygon
+ *
+ * @return 1 on success, 0 if the memory could not be allocated
+ */
+static uint8_t voronoi_clip_close(DCEL_t *dcel, const Voronoi_Clip_t *clip, DCEL_Vertex_ptr_t *corners,
+                                  Voronoi_Clip_Chain_t *from, Voronoi_Clip_Chain_t *to, double distance)
+{
+    DCEL_HalfEdge_ptr_t last = from->last;
+    DCEL_Vertex_ptr_t vertex = last->twin->origin;
+    // Pass every corner that lies strictly between both ends
+    for (size_t k = (size_t) floor(from->exit) + 1; (double) k - from->exit < distance; k++)
+    {
+        DCEL_Vertex_ptr_t corner = voronoi_clip_corner(dcel, clip, corners, k % clip->count);
+        DCEL_HalfEdge_ptr_t half_edge = voronoi_clip_boundary_edge(dcel, from->face, vertex, corner);
+        if (NULL == corner || NULL == half_edge) return 0;
+        last->next = half_edge;
+        half_edge->prev = last;
+        last = half_edge;
+        vertex = corner;
+    }
+    DCEL_HalfEdge_ptr_t half_edge = voronoi_clip_boundary_edge(dcel, from->face, vertex, to->first->origin);
+    if (NULL == half_edge) return 0;
+    last->next = half_edge;
+    half_edge->prev = last;
+    half_edge->next = to->first;
+    to->first->prev = half_edge;
+    return 1;
+}
+
+/**
+ * Orders chains by face and then by their entry position
+ */
+static int voronoi_clip_chain_compare(const void *first, const void *second)
+{
+    const Voronoi_Clip_Chain_t *first_chain = (const Voronoi_Clip_Chain_t *) first;
+    const Voronoi_Clip_Chain_t *second_chain = (const Voronoi_Clip_Chain_t *) second;
+    if (first_chain->face->index != second_chain->face->index)
+    {
+        return first_chain->face->index < second_chain->face->index ? -1 : 1;
+    }
+    if (first_chain->entry != second_chain->entry)
+    {
+        return first_chain->entry < second_chain->entry ? -1 : 1;
+    }
+    return 0;
+}
+
+/**
+ * Drops the removed half-edges and the vertices that are no longer used from the arrays of the diagram
+ * and points every face and vertex to one of the remaining half-edges.
+ * The records themselves stay in the blocks of the diagram until it is destroyed.
+ */
+static void voronoi_clip_compact(DCEL_t *dcel)
+{
+    size_t count = 0;
+    for (size_t i = 0; i < dcel->half_edge_count; i++)
+    {
+        if (dcel->half_edges[i]->twin)
+        {
+            dcel->half_edges[count++] = dcel->half_edges[i];
+        }
+    }
+    dcel->half_edge_count = count;
+    for (size_t i = 0; i < dcel->vertex_count; i++)
+    {
+        dcel->vertices[i]->inc_edge = NULL;
+    }
+    for (size_t i = 0; i < dcel->face_count; i++)
+    {
+        dcel->faces[i]->inc_edge = NULL;
+    }
+    for (size_t i = 0; i < dcel->half_edge_count; i++)
+    {
+        DCEL_HalfEdge_ptr_t half_edge = dcel->half_edges[i];
+        if (half_edge->origin)
+        {
+            half_edge->origin->inc_edge = half_edge;
+        }
+        if (half_edge->inc_face)
+        {
+            half_edge->inc_face->inc_edge = half_edge;
+        }
+    }
+    count = 0;
+    for (size_t i = 0; i < dcel->vertex_count; i++)
+    {
+        if (dcel->vertices[i]->inc_edge)
+        {
+            dcel->vertices[count++] = dcel->vertices[i];
+        }
+    }
+    dcel->vertex_count = count;
+}
+
+/**
+ * Clips the diagram to the polygon and closes the boundary of every face.
+ *
+ * Afterwards every face that overlaps the polygon is bounded by a cycle of half-edges that can be walked with next,
+ * and faces outside the polygon have no incident edge. The half-edges along the polygon have a twin without
+ * incident face. The faces of the diagram must carry their sites, which give the directions of unbounded edges.
+ *
+ * @param dcel the diagram
+ * @param clip the convex polygon
+ * @return 1 on success, 0 if the memory could not be allocated
+ */
+uint8_t voronoi_clip(DCEL_t *dcel, const Voronoi_Clip_t *clip)
+{
+    if (clip->count < 3) return 1;
+    double min_x = INFINITY, min_y = INFINITY, max_x = -INFINITY, max_y = -INFINITY;
+    for (size_t i = 0; i < clip->count; i++)
+    {
+        min_x = fmin(min_x, clip->vertices[i].x);
+        min_y = fmin(min_y, clip->vertices[i].y);
+        max_x = fmax(max_x, clip->vertices[i].x);
+        max_y = fmax(max_y, clip->vertices[i].y);
+    }
+    double tolerance = 1e-9 * (max_x - min_x + max_y - min_y);
+
+    size_t half_edge_count = dcel->half_edge_count;
+    for (size_t i = 0; i < half_edge_count; i++)
+    {
+        DCEL_HalfEdge_ptr_t half_edge = dcel->half_edges[i];
+        // Handle every edge once, through the first of its half-edges in memory
+        if (! half_edge->twin || (uintptr_t) half_edge > (uintptr_t) half_edge->twin) continue;
+        if (! voronoi_clip_edge(dcel, clip, half_edge, tolerance)) return 0;
+    }
+
+    // A chain that collapses to a single point on the boundary cannot tell whether its face covers
+    // the whole polygon or nothing, so drop it. Such chains stem from vertices that lie on the boundary
+    for (size_t i = 0; i < dcel->half_edge_count; i++)
+    {
+        DCEL_HalfEdge_ptr_t half_edge = dcel->half_edges[i];
+        if (! half_edge->twin || half_edge->prev || ! voronoi_clip_is_point(half_edge, tolerance)) continue;
+        while (half_edge)
+        {
+            DCEL_HalfEdge_ptr_t next = half_edge->next;
+            voronoi_clip_remove_edge(half_edge);
+            half_edge = next;
+        }
+    }
+
+    // The surviving half-edges form closed cycles around the cells inside the polygon
+    // and chains that start and end on its boundary
+    size_t chain_count = 0;
+    size_t inner_count = 0;
+    for (size_t i = 0; i < dcel->half_edge_count; i++)
+    {
+        DCEL_HalfEdge_ptr_t half_edge = dcel->half_edges[i];
+        if (! half_edge->twin) continue;
+        inner_count++;
+        chain_count += half_edge->prev == NULL;
+    }
+    Voronoi_Clip_Chain_t *chains = malloc((chain_count ? chain_count : 1) * sizeof(Voronoi_Clip_Chain_t));
+    DCEL_Vertex_ptr_t *corners = calloc(clip->count, sizeof(DCEL_Vertex_ptr_t));
+    if (NULL == chains || NULL == corners)
+    {
+        free(chains);
+        free(corners);
+        return 0;
+    }
+    chain_count = 0;
+    for (size_t i = 0; i < dcel->half_edge_count; i++)
+    {
+        DCEL_HalfEdge_ptr_t half_edge = dcel->half_edges[i];
+        if (! half_edge->twin || half_edge->prev) continue;
+        Voronoi_Clip_Chain_t *chain = &chains[chain_count++];
+        chain->face = half_edge->inc_face;
+        chain->first = chain->last = half_edge;
+        while (chain->last->next)
+        {
+            chain->last = chain->last->next;
+        }
+        chain->entry = voronoi_clip_position(clip, chain->first->origin->position);
+        chain->exit = voronoi_clip_position(clip, chain->last->twin->origin->position);
+    }
+
+    uint8_t result = 1;
+    if (0 == inner_count && dcel->face_count > 0)
+    {
+        // No edge crosses the polygon, so it lies within a single cell: the one whose site is closest to it
+        Point_Real_t corner = clip->vertices[0];
+        DCEL_Face_ptr_t closest = dcel->faces[0];
+        double closest_distance = INFINITY;
+        for (size_t i = 0; i < dcel->face_count; i++)
+        {
+            double offset_x = (double) dcel->faces[i]->site.x - corner.x;
+            double offset_y = (double) dcel->faces[i]->site.y - corner.y;
+#ifdef VORONOI_WEIGHTED
+            double distance = sqrt(offset_x * offset_x + offset_y * offset_y) - dcel->faces[i]->site.weight;
+#else
+            double distance = offset_x * offset_x + offset_y * offset_y;
+#endif
+            if (distance < closest_distance)
+            {
+                closest_distance = distance;
+                closest = dcel->faces[i];
+            }
+        }
+        DCEL_HalfEdge_ptr_t first = NULL;
+        DCEL_HalfEdge_ptr_t last = NULL;
+        for (size_t i = 0; i < clip->count && result; i++)
+        {
+            DCEL_Vertex_ptr_t from = voronoi_clip_corner(dcel, clip, corners, i);
+            DCEL_Vertex_ptr_t to = voronoi_clip_corner(dcel, clip, corners, (i + 1) % clip->count);
+            DCEL_HalfEdge_ptr_t half_edge = from && to ? voronoi_clip_boundary_edge(dcel, closest, from, to) : NULL;
+            if (NULL == half_edge)
+            {
+                result = 0;
+                break;
+            }
+            if (last)
+            {
+                last->next = half_edge;
+                half_edge->prev = last;
+            }
+            else
+            {
+                first = half_edge;
+            }
+            last = half_edge;
+        }
+        if (result)
+        {
+            last->next = first;
+            first->prev = last;
+        }
+    }
+
+    // Close every chain with the next chain of the same face, counter-clockwise along the boundary
+    qsort(chains, chain_count, sizeof(Voronoi_Clip_Chain_t), voronoi_clip_chain_compare);
+    for (size_t begin = 0, end; begin < chain_count && result; begin = end)
+    {
+        end = begin + 1;
+        while (end < chain_count && chains[end].face == chains[begin].face)
+        {
+            end++;
+        }
+        for (size_t i = begin; i < end && result; i++)
+        {
+            double count = (double) clip->count;
+            size_t next = begin;
+            double next_distance = INFINITY;
+            for (size_t k = begin; k < end; k++)
+            {
+                double distance = fmod(chains[k].entry - chains[i].exit + count, count);
+                // A chain that ends where it starts touches the boundary in a single vertex and closes right there
+                if (k == i && distance > count - 1e-9)
+                {
+                    distance = 0;
+                }
+                if (distance < next_distance)
+                {
+                    next_distance = distance;
+                    next = k;
+                }
+            }
+            result = voronoi_clip_close(dcel, clip, corners, &chains[i], &chains[next], next_distance);
+        }
+    }
+
+    free(chains);
+    free(corners);
+    // Pick up the boundary half-edges and corners
+    voronoi_clip_compact(dcel);
+    return result;
+}
@@ -0,0 +1,51 @@
+//
+// Clipping of a Voronoi diagram to a convex region
+//
+
+#ifndef VORONOI_VORONOICLIP_H
+#define VORONOI_VORONOICLIP_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "Point.h"
+#include "DCEL.h"
+
+/**
+ * A convex polygon that bounds the diagram, given by its corners in counter-clockwise order.
+ * The corners are owned by the caller.
+ */
+typedef struct {
+    const Point_Real_t *vertices;
+    size_t count;
+} Voronoi_Clip_t;
+
+/**
+ * Describes the axis-aligned rectangle [min_x, max_x] x [min_y, max_y] as a clip polygon
+ *
+ * @param corners receives the four corners of the rectangle, must outlive the clip polygon
+ * @param min_x the left side of the rectangle
+ * @param min_y the bottom side of the rectangle
+ * @param max_x the right side of the rectangle
+ * @param max_y the top side of the rectangle
+ * @return the clip polygon
+ */
+Voronoi_Clip_t voronoi_clip_rectangle(Point_Real_t corners[4], double min_x, double min_y, double max_x, double max_y);
+
+/**
+ * Clips the diagram to the polygon and closes the boundary of every face.
+ *
+ * Afterwards every face that overlaps the polygon is bounded by a cycle of half-edges that can be walked with next,
+ * and faces outside the polygon have no incident edge. The half-edges along the polygon have a twin without
+ * incident face. The faces of the diagram must carry their sites, which give the directions of unbounded edges.
+ *
+ * Built with VORONOI_WEIGHTED, the curved edges are clipped as the segments between their vertices and unbounded
+ * edges as rays along their asymptotes. This is exact enough while the weights stay below the spacing of the sites,
+ * but cells that curve around much heavier neighbours may cross the straightened edges of other cells.
+ *
+ * @param dcel the diagram
+ * @param clip the convex polygon
+ * @return 1 on success, 0 if the memory could not be allocated
+ */
+uint8_t voronoi_clip(DCEL_t *dcel, const Voronoi_Clip_t *clip);
+
+#endif //VORONOI_VORONOICLIP_H
@@ -0,0 +1,957 @@
+//
+// Incremental maintenance of a Voronoi diagram under site insertions and removals
+//
+
+#include <stdlib.h>
+#include <string.h>
+#include "VoronoiIncremental.h"
+
+// The vertex at infinity. Every edge of the convex hull forms a ghost triangle with it,
+// which lets us treat sites outside of the hull just like the ones inside of it.
+#define GHOST ((size_t) -2)
+#define NONE VORONOI_INCREMENTAL_NONE
+
+typedef enum {
+    SITE_REMOVED,
+    SITE_PENDING, // The site waits for enough sites to span a triangle
+    SITE_TRIANGULATED
+} Voronoi_Incremental_State_t;
+
+typedef struct {
+    size_t vertices[3]; // The site indices in counter-clockwise order, GHOST for the vertex at infinity
+    size_t neighbours[3]; // neighbours[i] is the triangle across the edge opposite of vertices[i]
+    size_t mark; // The update during which the triangle was last visited
+} Voronoi_Incremental_Triangle_t;
+
+typedef Voronoi_Incremental_Triangle_t* Voronoi_Incremental_Triangle_ptr_t;
+
+struct Voronoi_Incremental {
+    Point_t *sites;
+    uint8_t *states;
+    size_t *incident; // A triangle that is incident to each triangulated site
+    size_t *links; // Scratch space: the triangle created around a new site that starts at a given site
+    size_t *stamps; // Scratch space: the update during which a site was last reported as changed
+    size_t site_count;
+    size_t site_capacity;
+
+    Voronoi_Incremental_Triangle_t *triangles;
+    size_t triangle_count; // The number of triangle slots in use, including the freed ones
+    size_t triangle_capacity;
+    size_t free_triangle; // The head of the list of freed slots
+    size_t finite_count; // The number of live triangles that do not touch infinity
+    size_t last; // A recently created finite triangle, where the point location starts
+
+    size_t *pending;
+    size_t pending_count;
+    size_t pending_capacity;
+
+    size_t *changed;
+    size_t changed_count;
+    size_t changed_capacity;
+
+    size_t *scratch; // Holds the cavity of an insertion or the ring of a removal
+    size_t scratch_capacity;
+
+    size_t update; // Counts the updates. Used to mark triangles and sites without clearing the marks
+};
+
+/**
+ * Makes sure that the array can hold at least count elements
+ *
+ * @param array the address of the array
+ * @param capacity the address of the current capacity of the array
+ * @param count the requested number of elements
+ * @param size the size of an element
+ * @return 1 on success, 0 if the memory could not be allocated
+ */
+static uint8_t voronoi_incremental_grow(void **array, size_t *capacity, size_t count, size_t size)
+{
+    if (count <= *capacity) return 1;
+    size_t new_capacity = *capacity ? *capacity : 16;
+    while (new_capacity < count)
+    {
+        new_capacity *= 2;
+    }
+    void *grown = realloc(*array, new_capacity * size);
+    if (NULL == grown) return 0;
+    *array = grown;
+    *capacity = new_capacity;
+    return 1;
+}
+
+/**
+ * Yields the position of a site in real coordinates
+ */
+static Point_Real_t voronoi_incremental_position(Voronoi_Incremental_ptr_t self, size_t site)
+{
+    Point_Real_t position = { (double) self->sites[site].x, (double) self->sites[site].y };
+    return position;
+}
+
+/**
+ * Computes twice the signed area of the triangle abc
+ *
+ * @return a positive value if abc is counter-clockwise, a negative value if it is clockwise and 0 if it is degenerate
+ */
+static double voronoi_incremental_orient(Point_Real_t a, Point_Real_t b, Point_Real_t c)
+{
+    return (b.x - a.x) * (c.y - a.y) - (b.y - a.y) * (c.x - a.x);
+}
+
+/**
+ * Tests whether d lies inside the circumcircle of the counter-clockwise triangle abc
+ *
+ * @return a positive value if it does, a negative value if it does not and 0 if d is on the circle
+ */
+static double voronoi_incremental_in_circle(Point_Real_t a, Point_Real_t b, Point_Real_t c, Point_Real_t d)
+{
+    double adx = a.x - d.x, ady = a.y - d.y;
+    double bdx = b.x - d.x, bdy = b.y - d.y;
+    double cdx = c.x - d.x, cdy = c.y - d.y;
+    return (adx * adx + ady * ady) * (bdx * cdy - cdx * bdy)
+         + (bdx * bdx + bdy * bdy) * (cdx * ady - adx * cdy)
+         + (cdx * cdx + cdy * cdy) * (adx * bdy - bdx * ady);
+}
+
+/**
+ * Computes the center of the circumcircle of the triangle abc, that is, the Voronoi vertex dual to the triangle
+ */
+static Point_Real_t voronoi_incremental_circumcenter(Point_Real_t a, Point_Real_t b, Point_Real_t c)
+{
+    double bx = b.x - a.x, by = b.y - a.y;
+    double cx = c.x - a.x, cy = c.y - a.y;
+    double d = 2 * (bx * cy - by * cx);
+    double b_squared = bx * bx + by * by;
+    double c_squared = cx * cx + cy * cy;
+    Point_Real_t center = {
+        a.x + (cy * b_squared - by * c_squared) / d,
+        a.y + (bx * c_squared - cx * b_squared) / d
+    };
+    return center;
+}
+
+/**
+ * Yields the position of vertex inside the triangle, 3 if the triangle does not contain it
+ */
+static size_t voronoi_incremental_slot(Voronoi_Incremental_Triangle_ptr_t triangle, size_t vertex)
+{
+    if (triangle->vertices[0] == vertex) return 0;
+    if (triangle->vertices[1] == vertex) return 1;
+    if (triangle->vertices[2] == vertex) return 2;
+    return 3;
+}
+
+/**
+ * Yields the position of the vertex opposite of the edge ab inside the triangle, 3 if the triangle has no such edge
+ */
+static size_t voronoi_incremental_edge_slot(Voronoi_Incremental_Triangle_ptr_t triangle, size_t a, size_t b)
+{
+    for (size_t i = 0; i < 3; i++)
+    {
+        size_t u = triangle->vertices[(i + 1) % 3];
+        size_t w = triangle->vertices[(i + 2) % 3];
+        if ((u == a && w == b) || (u == b && w == a)) return i;
+    }
+    return 3;
+}
+
+/**
+ * Tests whether the point p conflicts with the triangle, that is, whether p lies inside its circumcircle.
+ * The circumcircle of a ghost triangle degenerates to the open half-plane beyond its hull edge,
+ * together with the interior of the hull edge itself.
+ */
+static uint8_t voronoi_incremental_conflicts(Voronoi_Incremental_ptr_t self, size_t t, Point_Real_t p)
+{
+    Voronoi_Incremental_Triangle_ptr_t triangle = &self->triangles[t];
+    size_t ghost = voronoi_incremental_slot(triangle, GHOST);
+    if (ghost == 3)
+    {
+        return voronoi_incremental_in_circle(voronoi_incremental_position(self, triangle->vertices[0]),
+                                             voronoi_incremental_position(self, triangle->vertices[1]),
+                                             voronoi_incremental_position(self, triangle->vertices[2]), p) > 0;
+    }
+    Point_Real_t u = voronoi_incremental_position(self, triangle->vertices[(ghost + 1) % 3]);
+    Point_Real_t w = voronoi_incremental_position(self, triangle->vertices[(ghost + 2) % 3]);
+    double orientation = voronoi_incremental_orient(u, w, p);
+    if (orientation > 0) return 1;
+    if (orientation < 0) return 0;
+    // p is on the line through the hull edge. It conflicts only if it lies strictly between the endpoints.
+    double dot_u = (p.x - u.x) * (w.x - u.x) + (p.y - u.y) * (w.y - u.y);
+    double dot_w = (p.x - w.x) * (u.x - w.x) + (p.y - w.y) * (u.y - w.y);
+    return dot_u > 0 && dot_w > 0;
+}
+
+/**
+ * Takes a triangle slot from the free list or from the end of the array.
+ * The caller has to make sure that there is enough capacity.
+ */
+static size_t voronoi_incremental_triangle_alloc(Voronoi_Incremental_ptr_t self)
+{
+    size_t t;
+    if (self->free_triangle != NONE)
+    {
+        t = self->free_triangle;
+        self->free_triangle = self->triangles[t].neighbours[0];
+    }
+    else
+    {
+        t = self->triangle_count++;
+    }
+    self->triangles[t].mark = 0;
+    return t;
+}
+
+/**
+ * Returns a triangle slot to the free list
+ */
+static void voronoi_incremental_triangle_free(Voronoi_Incremental_ptr_t self, size_t t)
+{
+    Voronoi_Incremental_Triangle_ptr_t triangle = &self->triangles[t];
+    if (voronoi_incremental_slot(triangle, GHOST) == 3)
+    {
+        self->finite_count--;
+    }
+    triangle->vertices[0] = triangle->vertices[1] = triangle->vertices[2] = NONE;
+    triangle->neighbours[0] = self->free_triangle;
+    self->free_triangle = t;
+}
+
+/**
+ * Makes sure that count more triangles can be allocated without growing the array
+ */
+static uint8_t voronoi_incremental_reserve_triangles(Voronoi_Incremental_ptr_t self, size_t count)
+{
+    return voronoi_incremental_grow((void **) &self->triangles, &self->triangle_capacity,
+                                    self->triangle_count + count, sizeof(Voronoi_Incremental_Triangle_t));
+}
+
+/**
+ * Creates the counter-clockwise triangle abc and links it to the given neighbours.
+ * The neighbours are linked back to the new triangle. NONE leaves a neighbour to be linked later.
+ *
+ * @param na the neighbour across the edge opposite of a
+ * @param nb the neighbour across the edge opposite of b
+ * @param nc the neighbour across the edge opposite of c
+ * @return the new triangle
+ */
+static size_t voronoi_incremental_triangle_new(Voronoi_Incremental_ptr_t self, size_t a, size_t b, size_t c,
+                                               size_t na, size_t nb, size_t nc)
+{
+    size_t t = voronoi_incremental_triangle_alloc(self);
+    Voronoi_Incremental_Triangle_ptr_t triangle = &self->triangles[t];
+    triangle->vertices[0] = a;
+    triangle->vertices[1] = b;
+    triangle->vertices[2] = c;
+    triangle->neighbours[0] = na;
+    triangle->neighbours[1] = nb;
+    triangle->neighbours[2] = nc;
+    for (size_t i = 0; i < 3; i++)
+    {
+        size_t neighbour = triangle->neighbours[i];
+        if (neighbour != NONE)
+        {
+            Voronoi_Incremental_Triangle_ptr_t other = &self->triangles[neighbour];
+            size_t slot = voronoi_incremental_edge_slot(other, triangle->vertices[(i + 1) % 3],
+                                                        triangle->vertices[(i + 2) % 3]);
+            other->neighbours[slot] = t;
+        }
+        if (triangle->vertices[i] != GHOST)
+        {
+            self->incident[triangle->vertices[i]] = t;
+        }
+    }
+    if (a != GHOST && b != GHOST && c != GHOST)
+    {
+        self->finite_count++;
+        self->last = t;
+    }
+    return t;
+}
+
+/**
+ * Reports a site as changed by the current update, unless it has been reported already
+ */
+static uint8_t voronoi_incremental_report(Voronoi_Incremental_ptr_t self, size_t site)
+{
+    if (site == GHOST || self->stamps[site] == self->update) return 1;
+    if (! voronoi_incremental_grow((void **) &self->changed, &self->changed_capacity,
+                                   self->changed_count + 1, sizeof(size_t))) return 0;
+    self->stamps[site] = self->update;
+    self->changed[self->changed_count++] = site;
+    return 1;
+}
+
+/**
+ * Walks from the last created triangle towards the point p.
+ *
+ * @return the finite triangle that contains p, or a ghost triangle whose hull edge sees p if p is outside of the hull
+ */
+static size_t voronoi_incremental_locate(Voronoi_Incremental_ptr_t self, Point_Real_t p)
+{
+    size_t t = self->last;
+    if (t >= self->triangle_count || self->triangles[t].vertices[0] == NONE)
+    {
+        // The hint went stale, so start from any live triangle
+        for (t = 0; self->triangles[t].vertices[0] == NONE; t++);
+    }
+    size_t ghost = voronoi_incremental_slot(&self->triangles[t], GHOST);
+    if (ghost != 3)
+    {
+        t = self->triangles[t].neighbours[ghost];
+    }
+
+    // Rotate the first edge that is tested, otherwise the walk can cycle on degenerate inputs
+    size_t rotation = self->update;
+    while (1)
+    {
+        Voronoi_Incremental_Triangle_ptr_t triangle = &self->triangles[t];
+        if (voronoi_incremental_slot(triangle, GHOST) != 3) return t;
+        size_t i;
+        for (i = 0; i < 3; i++)
+        {
+            size_t edge = (i + rotation) % 3;
+            Point_Real_t u = voronoi_incremental_position(self, triangle->vertices[(edge + 1) % 3]);
+            Point_Real_t w = voronoi_incremental_position(self, triangle->vertices[(edge + 2) % 3]);
+            if (voronoi_incremental_orient(u, w, p) < 0)
+            {
+                t = triangle->neighbours[edge];
+                break;
+            }
+        }
+        if (i == 3) return t;
+        rotation++;
+    }
+}
+
+/**
+ * Adds the site into the triangulation with the Bowyer-Watson algorithm.
+ * The triangles whose circumcircles contain the site form a star-shaped cavity around it.
+ * The cavity is removed and its boundary is connected to the site.
+ *
+ * @param site the index of the site
+ * @param start a triangle that conflicts with the site
+ * @return 1 on success, 0 if the memory could not be allocated. The triangulation is unchanged in that case
+ */
+static uint8_t voronoi_incremental_triangulate(Voronoi_Incremental_ptr_t self, size_t site, size_t start)
+{
+    Point_Real_t p = voronoi_incremental_position(self, site);
+
+    // Collect the cavity by a breadth-first search from the start triangle.
+    // The scratch array holds the cavity triangles first and the boundary edges as (u, w, outside) triples after that.
+    size_t cavity_count = 0;
+    size_t boundary_count = 0;
+    if (! voronoi_incremental_grow((void **) &self->scratch, &self->scratch_capacity, 1, sizeof(size_t))) return 0;
+    self->scratch[cavity_count++] = start;
+    self->triangles[start].mark = self->update;
+    for (size_t cursor = 0; cursor < cavity_count; cursor++)
+    {
+        size_t t = self->scratch[cursor];
+        for (size_t i = 0; i < 3; i++)
+        {
+            size_t neighbour = self->triangles[t].neighbours[i];
+            if (self->triangles[neighbour].mark == self->update) continue;
+            if (voronoi_incremental_conflicts(self, neighbour, p))
+            {
+                if (! voronoi_incremental_grow((void **) &self->scratch, &self->scratch_capacity,
+                                               cavity_count + 1, sizeof(size_t))) return 0;
+                self->triangles[neighbour].mark = self->update;
+                self->scratch[cavity_count++] = neighbour;
+            }
+        }
+    }
+    for (size_t c = 0; c < cavity_count; c++)
+    {
+        size_t t = self->scratch[c];
+        for (size_t i = 0; i < 3; i++)
+        {
+            size_t neighbour = self->triangles[t].neighbours[i];
+            if (self->triangles[neighbour].mark == self->update) continue;
+            if (! voronoi_incremental_grow((void **) &self->scratch, &self->scratch_capacity,
+                                           cavity_count + 3 * (boundary_count + 1), sizeof(size_t))) return 0;
+            size_t *edge = self->scratch + cavity_count + 3 * boundary_count++;
+            edge[0] = self->triangles[t].vertices[(i + 1) % 3];
+            edge[1] = self->triangles[t].vertices[(i + 2) % 3];
+            edge[2] = neighbour;
+        }
+    }
+    if (! voronoi_incremental_reserve_triangles(self, boundary_count)) return 0;
+    for (size_t c = 0; c < cavity_count; c++)
+    {
+        Voronoi_Incremental_Triangle_ptr_t triangle = &self->triangles[self->scratch[c]];
+        for (size_t i = 0; i < 3; i++)
+        {
+            if (! voronoi_incremental_report(self, triangle->vertices[i])) return 0;
+        }
+    }
+    if (! voronoi_incremental_report(self, site)) return 0;
+
+    // From here on nothing can fail anymore
+    for (size_t c = 0; c < cavity_count; c++)
+    {
+        voronoi_incremental_triangle_free(self, self->scratch[c]);
+    }
+    size_t *boundary = self->scratch + cavity_count;
+    size_t ghost_link = NONE;
+    for (size_t b = 0; b < boundary_count; b++)
+    {
+        size_t u = boundary[3 * b], w = boundary[3 * b + 1], outside = boundary[3 * b + 2];
+        size_t t = voronoi_incremental_triangle_new(self, u, w, site, NONE, NONE, outside);
+        // Remember the triangle by the first vertex of its boundary edge, so the fan can be closed below
+        if (u == GHOST) ghost_link = t;
+        else self->links[u] = t;
+        boundary[3 * b + 2] = t;
+    }
+    // The triangle (u, w, site) shares the edge (w, site) with the triangle that starts at w
+    for (size_t b = 0; b < boundary_count; b++)
+    {
+        size_t t = boundary[3 * b + 2];
+        size_t w = self->triangles[t].vertices[1];
+        size_t following = w == GHOST ? ghost_link : self->links[w];
+        self->triangles[t].neighbours[0] = following;
+        self->triangles[following].neighbours[1] = t;
+    }
+    self->states[site] = SITE_TRIANGULATED;
+    return 1;
+}
+
+/**
+ * Creates the first finite triangle out of three sites that are not collinear, together with its three ghost triangles
+ */
+static void voronoi_incremental_seed(Voronoi_Incremental_ptr_t self, size_t a, size_t b, size_t c)
+{
+    if (voronoi_incremental_orient(voronoi_incremental_position(self, a), voronoi_incremental_position(self, b),
+                                   voronoi_incremental_position(self, c)) < 0)
+    {
+        size_t tmp = b;
+        b = c;
+        c = tmp;
+    }
+    size_t t = voronoi_incremental_triangle_new(self, a, b, c, NONE, NONE, NONE);
+    size_t ghost_a = voronoi_incremental_triangle_new(self, c, b, GHOST, NONE, NONE, t);
+    size_t ghost_b = voronoi_incremental_triangle_new(self, a, c, GHOST, ghost_a, NONE, t);
+    voronoi_incremental_triangle_new(self, b, a, GHOST, ghost_b, ghost_a, t);
+    self->states[a] = self->states[b] = self->states[c] = SITE_TRIANGULATED;
+}
+
+/**
+ * Triangulates the pending sites as soon as three of them are not collinear.
+ * All pending sites are collinear, so it suffices to compare the sites starting at from against the first two.
+ *
+ * @return 1 on success, 0 if the memory could not be allocated
+ */
+static uint8_t voronoi_incremental_bootstrap(Voronoi_Incremental_ptr_t self, size_t from)
+{
+    if (self->pending_count < 3) return 1;
+    if (from < 2) from = 2;
+    Point_Real_t a = voronoi_incremental_position(self, self->pending[0]);
+    Point_Real_t b = voronoi_incremental_position(self, self->pending[1]);
+    size_t apex;
+    for (apex = from; apex < self->pending_count; apex++)
+    {
+        if (voronoi_incremental_orient(a, b, voronoi_incremental_position(self, self->pending[apex])) != 0) break;
+    }
+    if (apex == self->pending_count) return 1;
+
+    if (! voronoi_incremental_reserve_triangles(self, 4)) return 0;
+    voronoi_incremental_seed(self, self->pending[0], self->pending[1], self->pending[apex]);
+    for (size_t i = 0; i < self->pending_count; i++)
+    {
+        size_t site = self->pending[i];
+        if (self->states[site] == SITE_TRIANGULATED) continue;
+        if (! voronoi_incremental_triangulate(self, site, voronoi_incremental_locate(self,
+                                                  voronoi_incremental_position(self, site)))) return 0;
+    }
+    self->pending_count = 0;
+    // Every site of the seed is new to the diagram
+    self->update++;
+    self->changed_count = 0;
+    for (size_t site = 0; site < self->site_count; site++)
+    {
+        if (self->states[site] == SITE_TRIANGULATED && ! voronoi_incremental_report(self, site)) return 0;
+    }
+    return 1;
+}
+
+/**
+ * Allocates memory for an empty incremental diagram
+ *
+ * @return a handle to the diagram, NULL if the memory could not be allocated
+ */
+Voronoi_Incremental_ptr_t voronoi_incremental_new(void)
+{
+    Voronoi_Incremental_ptr_t self = calloc(1, sizeof(Voronoi_Incremental_t));
+    if (NULL == self) return NULL;
+    self->free_triangle = NONE;
+    self->last = NONE;
+    return self;
+}
+
+/**
+ * Inserts a site into the diagram
+ * Inserting a site that is already present does not change the diagram and yields the index of the present site.
+ *
+ * @param self the diagram handle
+ * @param site the site to insert
+ * @return the index of the site, VORONOI_INCREMENTAL_NONE if the memory could not be allocated
+ */
+size_t voronoi_insert_site(Voronoi_Incremental_ptr_t self, Point_t_ptr site)
+{
+    if (! self || ! site) return NONE;
+    self->update++;
+    self->changed_count = 0;
+
+    // Look for a duplicate before the site gets an index
+    size_t start = NONE;
+    if (self->finite_count > 0)
+    {
+        Point_Real_t p = { (double) site->x, (double) site->y };
+        start = voronoi_incremental_locate(self, p);
+        for (size_t i = 0; i < 3; i++)
+        {
+            size_t vertex = self->triangles[start].vertices[i];
+            if (vertex != GHOST && self->sites[vertex].x == site->x && self->sites[vertex].y == site->y) return vertex;
+        }
+    }
+    else
+    {
+        for (size_t i = 0; i < self->pending_count; i++)
+        {
+            Point_t_ptr other = &self->sites[self->pending[i]];
+            if (other->x == site->x && other->y == site->y) return self->pending[i];
+        }
+    }
+
+    size_t index = self->site_count;
+    size_t capacity = self->site_capacity;
+    if (! voronoi_incremental_grow((void **) &self->sites, &capacity, index + 1, sizeof(Point_t))) return NONE;
+    capacity = self->site_capacity;
+    if (! voronoi_incremental_grow((void **) &self->states, &capacity, index + 1, sizeof(uint8_t))) return NONE;
+    capacity = self->site_capacity;
+    if (! voronoi_incremental_grow((void **) &self->incident, &capacity, index + 1, sizeof(size_t))) return NONE;
+    capacity = self->site_capacity;
+    if (! voronoi_incremental_grow((void **) &self->links, &capacity, index + 1, sizeof(size_t))) return NONE;
+    capacity = self->site_capacity;
+    if (! voronoi_incremental_grow((void **) &self->stamps, &capacity, index + 1, sizeof(size_t))) return NONE;
+    self->site_capacity = capacity;
+    self->sites[index] = *site;
+    self->states[index] = SITE_PENDING;
+    self->incident[index] = NONE;
+    self->stamps[index] = 0;
+
+    if (self->finite_count > 0)
+    {
+        if (! voronoi_incremental_triangulate(self, index, start)) return NONE;
+        self->site_count++;
+        return index;
+    }
+
+    // There is no triangle yet, so the site has to wait until it can span one with the other pending sites
+    if (! voronoi_incremental_grow((void **) &self->pending, &self->pending_capacity,
+                                   self->pending_count + 1, sizeof(size_t))) return NONE;
+    self->pending[self->pending_count++] = index;
+    self->site_count++;
+    if (! voronoi_incremental_report(self, index)) return NONE;
+    if (! voronoi_incremental_bootstrap(self, self->pending_count - 1)) return NONE;
+    return index;
+}
+
+/**
+ * Moves every triangulated site back to the pending state and throws the triangles away.
+ * Used when a removal leaves too few sites to span a triangle.
+ */
+static uint8_t voronoi_incremental_reset(Voronoi_Incremental_ptr_t self)
+{
+    self->triangle_count = 0;
+    self->free_triangle = NONE;
+    self->finite_count = 0;
+    self->last = NONE;
+    for (size_t site = 0; site < self->site_count; site++)
+    {
+        if (self->states[site] != SITE_TRIANGULATED) continue;
+        if (! voronoi_incremental_grow((void **) &self->pending, &self->pending_capacity,
+                                       self->pending_count + 1, sizeof(size_t))) return 0;
+        self->states[site] = SITE_PENDING;
+        self->incident[site] = NONE;
+        self->pending[self->pending_count++] = site;
+    }
+    return voronoi_incremental_bootstrap(self, 2);
+}
+
+/**
+ * Tests whether the ear abc of the hole can become a Delaunay triangle.
+ * It has to be counter-clockwise and none of the other vertices of the hole may lie inside of its circumcircle.
+ *
+ * @param ring the vertices of the hole
+ * @param count the number of vertices of the hole
+ */
+static uint8_t voronoi_incremental_is_ear(Voronoi_Incremental_ptr_t self, size_t a, size_t b, size_t c,
+                                          const size_t *ring, size_t count)
+{
+    Point_Real_t pa = voronoi_incremental_position(self, a);
+    Point_Real_t pb = voronoi_incremental_position(self, b);
+    Point_Real_t pc = voronoi_incremental_position(self, c);
+    if (voronoi_incremental_orient(pa, pb, pc) <= 0) return 0;
+    for (size_t i = 0; i < count; i++)
+    {
+        size_t other = ring[i];
+        if (other == GHOST || other == a || other == b || other == c) continue;
+        if (voronoi_incremental_in_circle(pa, pb, pc, voronoi_incremental_position(self, other)) > 0) return 0;
+    }
+    return 1;
+}
+
+/**
+ * Re-triangulates the hole left behind by a removed site by cutting off Delaunay ears.
+ *
+ * The hole is given by its vertices in counter-clockwise order. outer[i] is the triangle across the edge
+ * from vertex i to vertex i + 1. If the removed site was on the convex hull, the ring starts with the ghost vertex.
+ * Ears are then only cut from the finite chain that follows it, and the part of the chain that remains
+ * once no ear is left becomes the new convex hull.
+ *
+ * @param ring the vertices of the hole, modified in place
+ * @param outer the triangles around the hole, modified in place
+ * @param count the number of vertices of the hole
+ */
+static void voronoi_incremental_fill(Voronoi_Incremental_ptr_t self, size_t *ring, size_t *outer, size_t count)
+{
+    const size_t original_count = count;
+    size_t *original = ring + count;
+    memcpy(original, ring, count * sizeof(size_t));
+    uint8_t is_open = ring[0] == GHOST;
+
+    while (count > 3 || (is_open && count > 2))
+    {
+        // Ear tips of an open chain exclude the ghost vertex and its two neighbours
+        size_t first = is_open ? 2 : 0;
+        size_t last = is_open ? count - 1 : count;
+        size_t tip = count;
+        size_t fallback = count;
+        for (size_t i = first; i < last; i++)
+        {
+            size_t a = ring[(i + count - 1) % count], b = ring[i], c = ring[(i + 1) % count];
+            if (voronoi_incremental_is_ear(self, a, b, c, original, original_count))
+            {
+                tip = i;
+                break;
+            }
+            if (fallback == count && voronoi_incremental_orient(voronoi_incremental_position(self, a),
+                                                                voronoi_incremental_position(self, b),
+                                                                voronoi_incremental_position(self, c)) > 0)
+            {
+                fallback = i;
+            }
+        }
+        if (tip == count)
+        {
+            // A closed hole always has a Delaunay ear. Rounding errors can hide it though, in which case
+            // any convex ear keeps the triangulation valid.
+            if (is_open) break;
+            tip = fallback != count ? fallback : first;
+        }
+        size_t previous = (tip + count - 1) % count;
+        size_t a = ring[previous], b = ring[tip], c = ring[(tip + 1) % count];
+        size_t t = voronoi_incremental_triangle_new(self, a, b, c, outer[tip], NONE, outer[previous]);
+        outer[previous] = t;
+        memmove(ring + tip, ring + tip + 1, (count - tip - 1) * sizeof(size_t));
+        memmove(outer + tip, outer + tip + 1, (count - tip - 1) * sizeof(size_t));
+        count--;
+    }
+
+    if (! is_open)
+    {
+        voronoi_incremental_triangle_new(self, ring[0], ring[1], ring[2], outer[1], outer[2], outer[0]);
+        return;
+    }
+    // What is left of the chain is convex and becomes part of the hull. outer[0] is across the edge from
+    // the ghost vertex to the chain, outer[count - 1] across the edge from the chain back to the ghost vertex.
+    size_t previous = outer[0];
+    for (size_t i = 1; i + 1 < count; i++)
+    {
+        size_t following = i + 2 == count ? outer[count - 1] : NONE;
+        previous = voronoi_incremental_triangle_new(self, ring[i], ring[i + 1], GHOST, following, previous, outer[i]);
+    }
+}
+
+/**
+ * Removes a site from the diagram
+ * The index of a removed site is never handed out again.
+ *
+ * @param self the diagram handle
+ * @param index the index of the site
+ * @return 1 if the site was removed, 0 if there is no such site
+ */
+uint8_t voronoi_remove_site(Voronoi_Incremental_ptr_t self, size_t index)
+{
+    if (! self || index >= self->site_count || self->states[index] == SITE_REMOVED) return 0;
+    self->update++;
+    self->changed_count = 0;
+
+    if (self->states[index] == SITE_PENDING)
+    {
+        for (size_t i = 0; i < self->pending_count; i++)
+        {
+            if (self->pending[i] == index)
+            {
+                memmove(self->pending + i, self->pending + i + 1, (self->pending_count - i - 1) * sizeof(size_t));
+                self->pending_count--;
+                break;
+            }
+        }
+        self->states[index] = SITE_REMOVED;
+        return 1;
+    }
+
+    // Walk around the site and collect the ring of its neighbours together with the triangles beyond the ring.
+    // The scratch array holds the ring, the outer triangles and a copy of the ring, so it needs three slots per triangle.
+    size_t count = 0;
+    size_t start = self->incident[index];
+    size_t t = start;
+    do
+    {
+        if (! voronoi_incremental_grow((void **) &self->scratch, &self->scratch_capacity,
+                                       3 * (count + 1), sizeof(size_t))) return 0;
+        size_t i = voronoi_incremental_slot(&self->triangles[t], index);
+        self->scratch[count++] = t;
+        t = self->triangles[t].neighbours[(i + 1) % 3];
+    } while (t != start);
+    if (! voronoi_incremental_reserve_triangles(self, count)) return 0;
+    size_t *ring = self->scratch + count;
+    size_t *outer = self->scratch + 2 * count;
+    // Lay out the ring such that the ghost vertex comes first
+    size_t offset = 0;
+    for (size_t k = 0; k < count; k++)
+    {
+        Voronoi_Incremental_Triangle_ptr_t triangle = &self->triangles[self->scratch[k]];
+        size_t i = voronoi_incremental_slot(triangle, index);
+        if (triangle->vertices[(i + 1) % 3] == GHOST) offset = k;
+    }
+    for (size_t k = 0; k < count; k++)
+    {
+        Voronoi_Incremental_Triangle_ptr_t triangle = &self->triangles[self->scratch[(k + offset) % count]];
+        size_t i = voronoi_incremental_slot(triangle, index);
+        ring[k] = triangle->vertices[(i + 1) % 3];
+        outer[k] = triangle->neighbours[i];
+        if (! voronoi_incremental_report(self, ring[k])) return 0;
+    }
+
+    for (size_t k = 0; k < count; k++)
+    {
+        voronoi_incremental_triangle_free(self, self->scratch[k]);
+    }
+    self->states[index] = SITE_REMOVED;
+    self->incident[index] = NONE;
+    // The ring is moved to the front, since the fill needs room behind it for its copy
+    memmove(self->scratch, ring, count * sizeof(size_t));
+    memmove(self->scratch + 2 * count, outer, count * sizeof(size_t));
+    voronoi_incremental_fill(self, self->scratch, self->scratch + 2 * count, count);
+
+    if (self->finite_count == 0)
+    {
+        // The remaining sites are collinear, so there is no triangle left to hold them
+        if (! voronoi_incremental_reset(self)) return 0;
+    }
+    return 1;
+}
+
+/**
+ * Yields the indices of the sites whose cells were changed by the last insertion or removal.
+ * The inserted site is part of the list, the removed site is not.
+ * The array is owned by self and is valid until the next update.
+ *
+ * @param self the diagram handle
+ * @param count receives the number of sites
+ * @return the array of site indices
+ */
+const size_t *voronoi_incremental_changed_sites(Voronoi_Incremental_ptr_t self, size_t *count)
+{
+    *count = self->changed_count;
+    return self->changed;
+}
+
+/**
+ * Finds the triangle around the site at which a counter-clockwise walk should start.
+ * That is the triangle following the ghost triangle for sites on the hull, any triangle otherwise.
+ */
+static size_t voronoi_incremental_cell_start(Voronoi_Incremental_ptr_t self, size_t site, uint8_t *is_bounded)
+{
+    size_t start = self->incident[site];
+    size_t t = start;
+    *is_bounded = 1;
+    do
+    {
+        Voronoi_Incremental_Triangle_ptr_t triangle = &self->triangles[t];
+        size_t i = voronoi_incremental_slot(triangle, site);
+        if (triangle->vertices[(i + 1) % 3] == GHOST)
+        {
+            *is_bounded = 0;
+            return triangle->neighbours[(i + 1) % 3];
+        }
+        t = triangle->neighbours[(i + 1) % 3];
+    } while (t != start);
+    return start;
+}
+
+/**
+ * Yields the vertices of the cell of a site in counter-clockwise order.
+ * If the cell is unbounded, the vertices form an open chain that starts and ends on the two unbounded edges.
+ *
+ * @param self the diagram handle
+ * @param index the index of the site
+ * @param vertices receives up to capacity vertices
+ * @param capacity the number of vertices that fit into vertices
+ * @param is_bounded receives 1 if the cell is bounded, 0 otherwise. Can be NULL
+ * @return the number of vertices of the cell, which can be larger than capacity
+ */
+size_t voronoi_incremental_cell(Voronoi_Incremental_ptr_t self, size_t index,
+                                Point_Real_t *vertices, size_t capacity, uint8_t *is_bounded)
+{
+    uint8_t bounded = 0;
+    size_t count = 0;
+    if (self && index < self->site_count && self->states[index] == SITE_TRIANGULATED)
+    {
+        size_t start = voronoi_incremental_cell_start(self, index, &bounded);
+        size_t t = start;
+        do
+        {
+            Voronoi_Incremental_Triangle_ptr_t triangle = &self->triangles[t];
+            if (voronoi_incremental_slot(triangle, GHOST) != 3) break;
+            if (count < capacity)
+            {
+                vertices[count] = voronoi_incremental_circumcenter(voronoi_incremental_position(self, triangle->vertices[0]),
+                                                                   voronoi_incremental_position(self, triangle->vertices[1]),
+                                                                   voronoi_incremental_position(self, triangle->vertices[2]));
+            }
+            count++;
+            t = triangle->neighbours[(voronoi_incremental_slot(triangle, index) + 1) % 3];
+        } while (t != start);
+    }
+    if (is_bounded) *is_bounded = bounded;
+    return count;
+}
+
+/**
+ * Builds the doubly-connected edge list of the whole diagram.
+ * There is one face per site, ordered by site index. The index of each face is the index of its site.
+ *
+ * @param self the diagram handle
+ * @return a doubly-connected edge list representing the diagram
+ */
+DCEL_t voronoi_incremental_dcel(Voronoi_Incremental_ptr_t self)
+{
+    DCEL_t dcel;
+    dcel_init(&dcel);
+    if (! self) return dcel;
+
+    size_t face_count = 0;
+    for (size_t site = 0; site < self->site_count; site++)
+    {
+        face_count += self->states[site] != SITE_REMOVED;
+    }
+    // Each finite triangle yields a vertex and each triangle edge between two sites yields a half-edge
+    DCEL_Face_ptr_t *faces = malloc((self->site_count + 1) * sizeof(DCEL_Face_ptr_t));
+    DCEL_Vertex_ptr_t *vertices = malloc((self->triangle_count + 1) * sizeof(DCEL_Vertex_ptr_t));
+    DCEL_HalfEdge_ptr_t *half_edges = calloc(3 * self->triangle_count + 1, sizeof(DCEL_HalfEdge_ptr_t));
+    if (! faces || ! vertices || ! half_edges ||
+        ! dcel_reserve(&dcel, self->finite_count, 3 * self->triangle_count, face_count))
+    {
+        free(faces);
+        free(vertices);
+        free(half_edges);
+        dcel_destroy(&dcel);
+        return dcel;
+    }
+
+    for (size_t site = 0; site < self->site_count; site++)
+    {
+        faces[site] = self->states[site] == SITE_REMOVED ? NULL : dcel_face_new(&dcel, self->sites[site], site);
+    }
+    for (size_t t = 0; t < self->triangle_count; t++)
+    {
+        Voronoi_Incremental_Triangle_ptr_t triangle = &self->triangles[t];
+        vertices[t] = NULL;
+        if (triangle->vertices[0] == NONE || voronoi_incremental_slot(triangle, GHOST) != 3) continue;
+        vertices[t] = dcel_vertex_new(&dcel, voronoi_incremental_circumcenter(
+                voronoi_incremental_position(self, triangle->vertices[0]),
+                voronoi_incremental_position(self, triangle->vertices[1]),
+                voronoi_incremental_position(self, triangle->vertices[2])));
+    }
+
+    // The directed triangle edge u -> w belongs to exactly one triangle, the one on its left.
+    // Its dual half-edge bounds the cell of u and runs from the vertex of the neighbour across the edge to the vertex of the triangle.
+    for (size_t t = 0; t < self->triangle_count; t++)
+    {
+        Voronoi_Incremental_Triangle_ptr_t triangle = &self->triangles[t];
+        if (triangle->vertices[0] == NONE) continue;
+        for (size_t i = 0; i < 3; i++)
+        {
+            size_t u = triangle->vertices[(i + 1) % 3];
+            size_t w = triangle->vertices[(i + 2) % 3];
+            if (u == GHOST || w == GHOST) continue;
+            DCEL_HalfEdge_ptr_t half_edge = dcel_half_edge_new(&dcel, faces[u]);
+            half_edge->origin = vertices[triangle->neighbours[i]];
+            half_edges[3 * t + i] = half_edge;
+        }
+    }
+    for (size_t t = 0; t < self->triangle_count; t++)
+    {
+        Voronoi_Incremental_Triangle_ptr_t triangle = &self->triangles[t];
+        for (size_t i = 0; i < 3; i++)
+        {
+            DCEL_HalfEdge_ptr_t half_edge = half_edges[3 * t + i];
+            if (! half_edge) continue;
+            size_t u = triangle->vertices[(i + 1) % 3];
+            size_t w = triangle->vertices[(i + 2) % 3];
+            size_t neighbour = triangle->neighbours[i];
+            half_edge->twin = half_edges[3 * neighbour + voronoi_incremental_edge_slot(&self->triangles[neighbour], u, w)];
+            if (half_edge->origin)
+            {
+                half_edge->origin->inc_edge = half_edge;
+            }
+            if (triangle->vertices[i] != GHOST)
+            {
+                // The cell of u continues across the edge from the apex back to u
+                size_t following = triangle->neighbours[(i + 2) % 3];
+                size_t slot = voronoi_incremental_edge_slot(&self->triangles[following], u, triangle->vertices[i]);
+                half_edge->next = half_edges[3 * following + slot];
+                half_edge->next->prev = half_edge;
+            }
+        }
+    }
+    for (size_t site = 0; site < self->site_count; site++)
+    {
+        if (! faces[site] || self->states[site] != SITE_TRIANGULATED) continue;
+        uint8_t is_bounded;
+        size_t start = voronoi_incremental_cell_start(self, site, &is_bounded);
+        Voronoi_Incremental_Triangle_ptr_t triangle = &self->triangles[start];
+        // The first half-edge of the cell ends at the vertex of the start triangle
+        size_t i = voronoi_incremental_slot(triangle, site);
+        faces[site]->inc_edge = half_edges[3 * start + (i + 2) % 3];
+    }
+
+    free(faces);
+    free(vertices);
+    free(half_edges);
+    return dcel;
+}
+
+/**
+ * Frees the memory chunks used by self
+ *
+ * @param self the diagram handle
+ */
+void voronoi_incremental_destroy(Voronoi_Incremental_ptr_t self)
+{
+    if (self)
+    {
+        free(self->sites);
+        free(self->states);
+        free(self->incident);
+        free(self->links);
+        free(self->stamps);
+        free(self->triangles);
+        free(self->pending);
+        free(self->changed);
+        free(self->scratch);
+        free(self);
+    }
+}
@@ -0,0 +1,103 @@
+//
+// Incremental maintenance of a Voronoi diagram under site insertions and removals
+//
+
+#ifndef VORONOI_VORONOIINCREMENTAL_H
+#define VORONOI_VORONOIINCREMENTAL_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "Point.h"
+#include "DCEL.h"
+
+// Returned in place of a site index if there is no such site
+#define VORONOI_INCREMENTAL_NONE ((size_t) -1)
+
+/**
+ * A Voronoi diagram that is kept up to date while sites are added and removed one at a time.
+ *
+ * The diagram is stored as its dual, the Delaunay triangulation. Inserting a site replaces the triangles whose
+ * circumcircles contain it (Bowyer-Watson), removing a site re-triangulates the hole left behind by its triangles.
+ * An update therefore only touches the cells around the site and costs time proportional to the size of the change,
+ * not to the number of sites. The point location that precedes an insertion walks from the last update,
+ * so it is cheap when consecutive updates are close to each other.
+ *
+ * After every update the sites whose cells changed are reported, such that a copy of the diagram can be patched
+ * cell by cell using voronoi_incremental_cell instead of being recomputed.
+ *
+ * NOTE: The geometric predicates are evaluated in double precision. They are exact as long as the coordinates
+ * fit in 26 bits, which covers snapped sensor grids but not the whole range of Point_t.
+ */
+typedef struct Voronoi_Incremental Voronoi_Incremental_t;
+
+typedef Voronoi_Incremental_t* Voronoi_Incremental_ptr_t;
+
+/**
+ * Allocates memory for an empty incremental diagram
+ *
+ * @return a handle to the diagram, NULL if the memory could not be allocated
+ */
+Voronoi_Incremental_ptr_t voronoi_incremental_new(void);
+
+/**
+ * Inserts a site into the diagram
+ * Inserting a site that is already present does not change the diagram and yields the index of the present site.
+ *
+ * @param self the diagram handle
+ * @param site the site to insert
+ * @return the index of the site, VORONOI_INCREMENTAL_NONE if the memory could not be allocated
+ */
+size_t voronoi_insert_site(Voronoi_Incremental_ptr_t self, Point_t_ptr site);
+
+/**
+ * Removes a site from the diagram
+ * The index of a removed site is never handed out again.
+ *
+ * @param self the diagram handle
+ * @param index the index of the site
+ * @return 1 if the site was removed, 0 if there is no such site
+ */
+uint8_t voronoi_remove_site(Voronoi_Incremental_ptr_t self, size_t index);
+
+/**
+ * Yields the indices of the sites whose cells were changed by the last insertion or removal.
+ * The inserted site is part of the list, the removed site is not.
+ * The array is owned by self and is valid until the next update.
+ *
+ * @param self the diagram handle
+ * @param count receives the number of sites
+ * @return the array of site indices
+ */
+const size_t *voronoi_incremental_changed_sites(Voronoi_Incremental_ptr_t self, size_t *count);
+
+/**
+ * Yields the vertices of the cell of a site in counter-clockwise order.
+ * If the cell is unbounded, the vertices form an open chain that starts and ends on the two unbounded edges.
+ *
+ * @param self the diagram handle
+ * @param index the index of the site
+ * @param vertices receives up to capacity vertices
+ * @param capacity the number of vertices that fit into vertices
+ * @param is_bounded receives 1 if the cell is bounded, 0 otherwise. Can be NULL
+ * @return the number of vertices of the cell, which can be larger than capacity
+ */
+size_t voronoi_incremental_cell(Voronoi_Incremental_ptr_t self, size_t index,
+                                Point_Real_t *vertices, size_t capacity, uint8_t *is_bounded);
+
+/**
+ * Builds the doubly-connected edge list of the whole diagram.
+ * There is one face per site, ordered by site index. The index of each face is the index of its site.
+ *
+ * @param self the diagram handle
+ * @return a doubly-connected edge list representing the diagram
+ */
+DCEL_t voronoi_incremental_dcel(Voronoi_Incremental_ptr_t self);
+
+/**
+ * Frees the memory chunks used by self
+ *
+ * @param self the diagram handle
+ */
+void voronoi_incremental_destroy(Voronoi_Incremental_ptr_t self);
+
+#endif //VORONOI_VORONOIINCREMENTAL_H
@@ -0,0 +1,188 @@
+//
+// Tests for the incremental Voronoi diagram
+//
+
+#include <assert.h>
+#include <stdio.h>
+#include "DCEL.c"
+#include "VoronoiTrace.c"
+#include "VoronoiIncremental.c"
+
+static uint64_t random_state = 42;
+
+static uint64_t random_next(uint64_t bound)
+{
+    random_state = random_state * 6364136223846793005ULL + 1442695040888963407ULL;
+    return (random_state >> 33) % bound;
+}
+
+/**
+ * Checks the links of the triangulation and the empty circumcircle property of every finite triangle
+ */
+static void assert_delaunay(Voronoi_Incremental_ptr_t diagram)
+{
+    size_t finite_count = 0;
+    for (size_t t = 0; t < diagram->triangle_count; t++)
+    {
+        Voronoi_Incremental_Triangle_ptr_t triangle = &diagram->triangles[t];
+        if (triangle->vertices[0] == NONE) continue;
+        for (size_t i = 0; i < 3; i++)
+        {
+            // The neighbour has to share the edge and point back
+            Voronoi_Incremental_Triangle_ptr_t neighbour = &diagram->triangles[triangle->neighbours[i]];
+            size_t slot = voronoi_incremental_edge_slot(neighbour, triangle->vertices[(i + 1) % 3],
+                                                        triangle->vertices[(i + 2) % 3]);
+            assert(slot != 3);
+            assert(neighbour->neighbours[slot] == t);
+        }
+        if (voronoi_incremental_slot(triangle, GHOST) != 3) continue;
+        finite_count++;
+        Point_Real_t a = voronoi_incremental_position(diagram, triangle->vertices[0]);
+        Point_Real_t b = voronoi_incremental_position(diagram, triangle->vertices[1]);
+        Point_Real_t c = voronoi_incremental_position(diagram, triangle->vertices[2]);
+        assert(voronoi_incremental_orient(a, b, c) > 0);
+        for (size_t site = 0; site < diagram->site_count; site++)
+        {
+            if (diagram->states[site] != SITE_TRIANGULATED) continue;
+            assert(voronoi_incremental_in_circle(a, b, c, voronoi_incremental_position(diagram, site)) <= 0);
+        }
+    }
+    assert(finite_count == diagram->finite_count);
+}
+
+/**
+ * Checks the links of the edge list
+ */
+static void assert_dcel(DCEL_t *dcel)
+{
+    for (size_t i = 0; i < dcel->half_edge_count; i++)
+    {
+        DCEL_HalfEdge_ptr_t half_edge = dcel->half_edges[i];
+        assert(half_edge->twin != NULL);
+        assert(half_edge->twin->twin == half_edge);
+        assert(half_edge->twin->inc_face != half_edge->inc_face);
+        if (half_edge->next)
+        {
+            assert(half_edge->next->prev == half_edge);
+            assert(half_edge->next->inc_face == half_edge->inc_face);
+            assert(half_edge->next->origin == half_edge->twin->origin);
+        }
+    }
+}
+
+void test_incremental_square()
+{
+    Voronoi_Incremental_ptr_t diagram = voronoi_incremental_new();
+    Point_t points[5] = {{0, 0}, {10, 0}, {10, 10}, {0, 10}, {5, 5}};
+    for (size_t i = 0; i < 4; i++)
+    {
+        size_t index = voronoi_insert_site(diagram, &points[i]);
+        assert(index == i);
+    }
+    assert_delaunay(diagram);
+    assert(diagram->finite_count == 2);
+
+    // The center splits the square into four triangles and changes every cell
+    size_t index = voronoi_insert_site(diagram, &points[4]);
+    assert(index == 4);
+    assert_delaunay(diagram);
+    size_t count;
+    voronoi_incremental_changed_sites(diagram, &count);
+    assert(count == 5);
+
+    // The cell of the center is the diamond spanned by the midpoints of the sides
+    Point_Real_t cell[8];
+    uint8_t is_bounded;
+    size_t vertex_count = voronoi_incremental_cell(diagram, 4, cell, 8, &is_bounded);
+    assert(vertex_count == 4);
+    assert(is_bounded);
+    for (size_t i = 0; i < 4; i++)
+    {
+        assert(cell[i].x == 5 || cell[i].y == 5);
+    }
+    vertex_count = voronoi_incremental_cell(diagram, 0, cell, 8, &is_bounded);
+    assert(vertex_count == 2);
+    assert(! is_bounded);
+
+    // Duplicates are not inserted twice
+    index = voronoi_insert_site(diagram, &points[2]);
+    assert(index == 2);
+    voronoi_incremental_destroy(diagram);
+}
+
+void test_incremental_collinear()
+{
+    Voronoi_Incremental_ptr_t diagram = voronoi_incremental_new();
+    Point_t points[4] = {{0, 0}, {5, 0}, {10, 0}, {5, 5}};
+    for (size_t i = 0; i < 3; i++)
+    {
+        voronoi_insert_site(diagram, &points[i]);
+    }
+    assert(diagram->finite_count == 0);
+    assert(diagram->pending_count == 3);
+
+    voronoi_insert_site(diagram, &points[3]);
+    assert(diagram->finite_count == 2);
+    assert_delaunay(diagram);
+
+    // Removing the apex leaves a line again
+    uint8_t is_removed = voronoi_remove_site(diagram, 3);
+    assert(is_removed);
+    assert(diagram->finite_count == 0);
+    assert(diagram->pending_count == 3);
+    is_removed = voronoi_remove_site(diagram, 3);
+    assert(! is_removed);
+    voronoi_incremental_destroy(diagram);
+}
+
+void test_incremental_random()
+{
+    Voronoi_Incremental_ptr_t diagram = voronoi_incremental_new();
+    size_t count = 300;
+    for (size_t i = 0; i < count; i++)
+    {
+        Point_t point = {random_next(1000), random_next(1000)};
+        voronoi_insert_site(diagram, &point);
+    }
+    assert_delaunay(diagram);
+
+    DCEL_t dcel = voronoi_incremental_dcel(diagram);
+    assert(dcel.face_count == diagram->site_count);
+    assert(dcel.vertex_count == diagram->finite_count);
+    assert_dcel(&dcel);
+    dcel_destroy(&dcel);
+
+    // Remove every other site, interior and hull sites alike
+    for (size_t i = 0; i < diagram->site_count; i += 2)
+    {
+        uint8_t is_removed = voronoi_remove_site(diagram, i);
+        assert(is_removed);
+        size_t changed_count;
+        const size_t *changed = voronoi_incremental_changed_sites(diagram, &changed_count);
+        for (size_t k = 0; k < changed_count; k++)
+        {
+            assert(changed[k] != i);
+        }
+    }
+    assert_delaunay(diagram);
+
+    // Insert again next to the remaining sites
+    for (size_t i = 0; i < count / 2; i++)
+    {
+        Point_t point = {random_next(1200), random_next(1200)};
+        voronoi_insert_site(diagram, &point);
+    }
+    assert_delaunay(diagram);
+
+    dcel = voronoi_incremental_dcel(diagram);
+    assert_dcel(&dcel);
+    dcel_destroy(&dcel);
+    voronoi_incremental_destroy(diagram);
+}
+
+int main(int argc, char *argv[])
+{
+    test_incremental_square();
+    test_incremental_collinear();
+    test_incremental_random();
+}
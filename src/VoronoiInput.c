@@ -0,0 +1,375 @@
+//
+// Reading of the sites from files
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+#include "VoronoiInput.h"
+#include "VoronoiTrace.h"
+
+// The number of chunks per thread that a text file is split into. Smaller chunks balance the threads better
+#define VORONOI_INPUT_CHUNKS_PER_THREAD 4
+// Files and arrays below this size are handled by a single thread
+#define VORONOI_INPUT_PARALLEL_SIZE (1 << 20)
+
+/**
+ * Guesses the format of a file from its extension: .csv is CSV, .bin is binary and anything else is text
+ *
+ * @param path the path of the file
+ * @return the format
+ */
+Voronoi_Input_Format_t voronoi_input_format(const char *path)
+{
+    const char *extension = strrchr(path, '.');
+    if (extension && 0 == strcmp(extension, ".csv")) return VORONOI_INPUT_CSV;
+    if (extension && 0 == strcmp(extension, ".bin")) return VORONOI_INPUT_BINARY;
+    return VORONOI_INPUT_TEXT;
+}
+
+static const char *voronoi_input_skip_blanks(const char *cursor, const char *end)
+{
+    while (cursor < end && (' ' == *cursor || '\t' == *cursor || '\r' == *cursor)) cursor++;
+    return cursor;
+}
+
+/**
+ * Parses the unsigned integer at the cursor and moves the cursor behind it
+ *
+ * @param cursor the address of the cursor
+ * @param end the end of the text
+ * @param value receives the integer
+ * @return 1 on success, 0 if there is no integer at the cursor or it does not fit into 64 bits
+ */
+static uint8_t voronoi_input_parse_integer(const char **cursor, const char *end, uint64_t *value)
+{
+    const char *digit = *cursor;
+    // Up to 19 digits fit into 64 bits in any case, only a 20th one needs to be checked for overflow
+    const char *safe_end = end - digit > 19 ? digit + 19 : end;
+    uint64_t result = 0;
+    while (digit < safe_end && (unsigned) (*digit - '0') < 10)
+    {
+        result = result * 10 + (uint64_t) (*digit - '0');
+        digit++;
+    }
+    if (digit == *cursor) return 0;
+    if (digit < end && (unsigned) (*digit - '0') < 10)
+    {
+        if (result > (UINT64_MAX - (uint64_t) (*digit - '0')) / 10) return 0;
+        result = result * 10 + (uint64_t) (*digit - '0');
+        digit++;
+        if (digit < end && (unsigned) (*digit - '0') < 10) return 0;
+    }
+    *cursor = digit;
+    *value = result;
+    return 1;
+}
+
+/**
+ * Parses one site and moves the cursor behind it and the blanks that follow. Built with VORONOI_WEIGHTED, an
+ * integer in a third column is the weight of the site
+ *
+ * @param cursor the address of the cursor, at the first character of the site
+ * @param end the end of the text
+ * @param separator the character between the coordinates, 0 for whitespace
+ * @param point receives the site
+ * @return 1 on success, 0 if there is no site at the cursor
+ */
+static uint8_t voronoi_input_parse_site(const char **cursor, const char *end, char separator, Point_t *point)
+{
+    if (! voronoi_input_parse_integer(cursor, end, &point->x)) return 0;
+    *cursor = voronoi_input_skip_blanks(*cursor, end);
+    if (separator)
+    {
+        if (*cursor == end || **cursor != separator) return 0;
+        *cursor = voronoi_input_skip_blanks(*cursor + 1, end);
+    }
+    if (! voronoi_input_parse_integer(cursor, end, &point->y)) return 0;
+    *cursor = voronoi_input_skip_blanks(*cursor, end);
+#ifdef VORONOI_WEIGHTED
+    // The weight is an optional third column
+    point->weight = 0;
+    const char *weight = *cursor;
+    if (separator && weight < end && *weight == separator) weight = voronoi_input_skip_blanks(weight + 1, end);
+    uint64_t value;
+    if ((! separator || weight > *cursor) && voronoi_input_parse_integer(&weight, end, &value))
+    {
+        point->weight = (double) value;
+        *cursor = voronoi_input_skip_blanks(weight, end);
+    }
+#endif
+    return 1;
+}
+
+/**
+ * Tells whether a line that is not a site names the columns of a CSV file: it either holds no digit at all or
+ * starts with a letter or a quote, like x,y or "x1","y1". A line such as 1,2, or -1,2 is a malformed site instead
+ *
+ * @param cursor the first non-blank character of the line
+ * @param end the end of the line
+ * @return 1 if the line is a header, 0 otherwise
+ */
+static uint8_t voronoi_input_is_header(const char *cursor, const char *end)
+{
+    char first = (char) (*cursor | 0x20);
+    if (('a' <= first && first <= 'z') || '"' == *cursor || '_' == *cursor) return 1;
+    for (; cursor < end; cursor++)
+    {
+        if ((unsigned) (*cursor - '0') < 10) return 0;
+    }
+    return 1;
+}
+
+/**
+ * A newline-aligned piece of a text file that one thread parses
+ */
+typedef struct {
+    const char *begin;
+    const char *end;
+    size_t lines; // The number of line breaks inside the chunk
+    size_t first_line; // The number of lines before the chunk
+    size_t first_point; // The position in points from which the sites of the chunk are stored
+    size_t count; // The number of sites of the chunk
+    size_t error_line; // The line of the first malformed record of the chunk, 0 if there is none
+} Voronoi_Input_Chunk_t;
+
+/**
+ * Parses the sites of a chunk into the points from its first point on. A line that holds a site is parsed in
+ * a single pass, only the others are searched for their end
+ *
+ * @param chunk the chunk
+ * @param format the format of the file
+ * @param points the points array
+ */
+static void voronoi_input_parse_chunk(Voronoi_Input_Chunk_t *chunk, Voronoi_Input_Format_t format, Point_t *points)
+{
+    char separator = VORONOI_INPUT_CSV == format ? ',' : 0;
+    Point_t *point = &points[chunk->first_point];
+    size_t line = chunk->first_line;
+    const char *end = chunk->end;
+    const char *cursor = chunk->begin;
+    while (cursor < end)
+    {
+        line++;
+        cursor = voronoi_input_skip_blanks(cursor, end);
+        if (cursor == end) break;
+        if ('\n' == *cursor)
+        {
+            cursor++;
+            continue;
+        }
+        const char *site_end = cursor;
+        if ((VORONOI_INPUT_TEXT != format || *cursor != '#') &&
+            voronoi_input_parse_site(&site_end, end, separator, point) && (site_end == end || '\n' == *site_end))
+        {
+            point++;
+            cursor = site_end < end ? site_end + 1 : end;
+            continue;
+        }
+        const char *line_end = memchr(cursor, '\n', (size_t) (end - cursor));
+        // Comments are skipped, and the first record of a CSV file may name the columns
+        if ((VORONOI_INPUT_TEXT == format && '#' == *cursor) ||
+            (VORONOI_INPUT_CSV == format && 1 == line && voronoi_input_is_header(cursor, line_end ? line_end : end)))
+        {
+            cursor = line_end ? line_end + 1 : end;
+            continue;
+        }
+        chunk->error_line = line;
+        break;
+    }
+    chunk->count = (size_t) (point - &points[chunk->first_point]);
+}
+
+/**
+ * Parses the sites of a text or CSV file. Large files are split into one chunk per thread and a few more,
+ * each ending at a line break. The line breaks of every chunk are counted first, which bounds the number of its
+ * sites and thus tells where in the points array they go. Then every chunk is parsed straight into the array
+ * and the gaps left by blank lines and comments are closed at the end
+ *
+ * @param self the input handle
+ * @param text the contents of the file
+ * @param size the number of bytes of the file
+ * @param format the format of the file
+ * @return 1 on success, 0 if the file is malformed or does not fit into memory
+ */
+static uint8_t voronoi_input_parse(Voronoi_Input_t *self, const char *text, size_t size, Voronoi_Input_Format_t format)
+{
+    size_t chunk_count = 1;
+#ifdef _OPENMP
+    if (size >= VORONOI_INPUT_PARALLEL_SIZE)
+    {
+        chunk_count = (size_t) omp_get_max_threads() * VORONOI_INPUT_CHUNKS_PER_THREAD;
+    }
+#endif
+    Voronoi_Input_Chunk_t *chunks = calloc(chunk_count, sizeof(Voronoi_Input_Chunk_t));
+    if (NULL == chunks) return 0;
+    const char *end = text + size;
+    const char *begin = text;
+    for (size_t c = 0; c < chunk_count; c++)
+    {
+        const char *chunk_end = c + 1 == chunk_count ? end : text + size / chunk_count * (c + 1);
+        if (chunk_end < begin) chunk_end = begin;
+        const char *line_end = chunk_end < end ? memchr(chunk_end, '\n', (size_t) (end - chunk_end)) : NULL;
+        chunks[c].begin = begin;
+        chunks[c].end = line_end ? line_end + 1 : end;
+        begin = chunks[c].end;
+    }
+
+    #pragma omp parallel for schedule(dynamic) if (chunk_count > 1) default(none) shared(chunks, chunk_count)
+    for (size_t c = 0; c < chunk_count; c++)
+    {
+        voronoi_trace_begin("input_lines");
+        const char *cursor = chunks[c].begin;
+        while (cursor < chunks[c].end && (cursor = memchr(cursor, '\n', (size_t) (chunks[c].end - cursor))))
+        {
+            chunks[c].lines++;
+            cursor++;
+        }
+        voronoi_trace_end("input_lines");
+    }
+    // Every line holds at most one site, and the last one may lack its line break
+    size_t lines = 0;
+    for (size_t c = 0; c < chunk_count; c++)
+    {
+        chunks[c].first_line = lines;
+        chunks[c].first_point = lines + c;
+        lines += chunks[c].lines;
+    }
+    self->points = malloc((lines + chunk_count) * sizeof(Point_t));
+    if (NULL == self->points)
+    {
+        free(chunks);
+        return 0;
+    }
+
+    Point_t *points = self->points;
+    #pragma omp parallel for schedule(dynamic) if (chunk_count > 1) default(none) \
+        shared(chunks, chunk_count, format, points)
+    for (size_t c = 0; c < chunk_count; c++)
+    {
+        voronoi_trace_begin("input_parse");
+        voronoi_input_parse_chunk(&chunks[c], format, points);
+        voronoi_trace_end("input_parse");
+    }
+    uint8_t success = 1;
+    for (size_t c = 0; success && c < chunk_count; c++)
+    {
+        if (chunks[c].error_line)
+        {
+            self->line = chunks[c].error_line;
+            success = 0;
+            break;
+        }
+        memmove(&points[self->count], &points[chunks[c].first_point], chunks[c].count * sizeof(Point_t));
+        self->count += chunks[c].count;
+    }
+    free(chunks);
+    return success;
+}
+
+/**
+ * Maps a file into memory
+ *
+ * @param path the path of the file
+ * @param size receives the number of bytes of the file
+ * @return the mapping, NULL if the file is empty or could not be mapped, in which case size is (size_t) -1
+ */
+static void *voronoi_input_map(const char *path, size_t *size)
+{
+    *size = (size_t) -1;
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return NULL;
+    struct stat status;
+    void *mapping = NULL;
+    if (0 == fstat(fd, &status))
+    {
+        *size = (size_t) status.st_size;
+        if (*size > 0)
+        {
+            mapping = mmap(NULL, *size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (MAP_FAILED == mapping)
+            {
+                mapping = NULL;
+                *size = (size_t) -1;
+            }
+        }
+    }
+    close(fd);
+    return mapping;
+}
+
+/**
+ * Reads the sites of a file. The coordinates of text files must be unsigned integers. Built with VORONOI_WEIGHTED,
+ * an unsigned integer after them is the weight of the site, which is 0 without it
+ *
+ * @param self the input handle
+ * @param path the path of the file
+ * @param format the format of the file
+ * @return 1 on success, 0 if the file could not be read, is malformed or does not fit into memory
+ */
+uint8_t voronoi_input_read(Voronoi_Input_t *self, const char *path, Voronoi_Input_Format_t format)
+{
+    memset(self, 0, sizeof(Voronoi_Input_t));
+    size_t size;
+    void *mapping = voronoi_input_map(path, &size);
+    uint8_t success = size != (size_t) -1;
+    if (success && VORONOI_INPUT_BINARY == format)
+    {
+        // The sites stay in the mapping
+        success = 0 == size % sizeof(Point_t);
+        self->mapping = mapping;
+        self->mapping_size = size;
+        self->points = (Point_t *) mapping;
+        self->count = success ? size / sizeof(Point_t) : 0;
+    }
+    else if (success)
+    {
+        voronoi_trace_begin("input_text");
+        success = voronoi_input_parse(self, (const char *) mapping, size, format);
+        voronoi_trace_end("input_text");
+        if (mapping) munmap(mapping, size);
+    }
+    if (success)
+    {
+        self->sites = malloc((self->count + 1) * sizeof(Point_t_ptr));
+        success = self->sites != NULL;
+        Point_t *points = self->points;
+        Point_t_ptr *sites = self->sites;
+        size_t count = success ? self->count : 0;
+        #pragma omp parallel for if (count >= VORONOI_INPUT_PARALLEL_SIZE) default(none) shared(points, sites, count)
+        for (size_t i = 0; i < count; i++)
+        {
+            sites[i] = &points[i];
+        }
+    }
+    if (! success)
+    {
+        size_t line = self->line;
+        voronoi_input_destroy(self);
+        self->line = line;
+    }
+    return success;
+}
+
+/**
+ * Frees the sites of self or unmaps them. The input is empty afterwards
+ *
+ * @param self the input handle
+ */
+void voronoi_input_destroy(Voronoi_Input_t *self)
+{
+    if (self)
+    {
+        if (self->mapping) munmap(self->mapping, self->mapping_size);
+        else free(self->points);
+        free(self->sites);
+        memset(self, 0, sizeof(Voronoi_Input_t));
+    }
+}
@@ -0,0 +1,62 @@
+//
+// Reading of the sites from files
+//
+
+#ifndef VORONOI_VORONOIINPUT_H
+#define VORONOI_VORONOIINPUT_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "Point.h"
+
+/**
+ * The formats of a file of sites
+ */
+typedef enum {
+    VORONOI_INPUT_TEXT, // One site per line, x and y separated by whitespace. Blank lines and lines starting with # are skipped
+    VORONOI_INPUT_CSV, // One site per line, x and y separated by a comma. A first line without digits or starting with a letter or a quote is a header
+    // The points as they lie in memory: pairs of 64-bit unsigned integers x, y in the byte order of the machine,
+    // each followed by its weight as a double in a build with VORONOI_WEIGHTED.
+    // The file is mapped instead of being read, so the sites point straight into the page cache
+    VORONOI_INPUT_BINARY
+} Voronoi_Input_Format_t;
+
+/**
+ * The sites of a file
+ */
+typedef struct {
+    Point_t *points; // The coordinates, either parsed into memory or mapped from the file
+    Point_t_ptr *sites; // A handle to each point, as voronoi_diagram takes them
+    size_t count; // The number of sites
+    size_t line; // The line of the first malformed record of a text file, 0 if there is none
+    void *mapping; // The mapped file, NULL if the points were parsed
+    size_t mapping_size; // The number of bytes mapped
+} Voronoi_Input_t;
+
+/**
+ * Guesses the format of a file from its extension: .csv is CSV, .bin is binary and anything else is text
+ *
+ * @param path the path of the file
+ * @return the format
+ */
+Voronoi_Input_Format_t voronoi_input_format(const char *path);
+
+/**
+ * Reads the sites of a file. The coordinates of text files must be unsigned integers. Built with VORONOI_WEIGHTED,
+ * an unsigned integer after them is the weight of the site, which is 0 without it
+ *
+ * @param self the input handle
+ * @param path the path of the file
+ * @param format the format of the file
+ * @return 1 on success, 0 if the file could not be read, is malformed or does not fit into memory
+ */
+uint8_t voronoi_input_read(Voronoi_Input_t *self, const char *path, Voronoi_Input_Format_t format);
+
+/**
+ * Frees the sites of self or unmaps them. The input is empty afterwards
+ *
+ * @param self the input handle
+ */
+void voronoi_input_destroy(Voronoi_Input_t *self);
+
+#endif //VORONOI_VORONOIINPUT_H
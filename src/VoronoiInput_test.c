@@ -0,0 +1,175 @@
+//
+// Tests for the reading of sites from files
+//
+
+#include <assert.h>
+#include <stdio.h>
+#include "VoronoiTrace.c"
+#include "VoronoiInput.c"
+
+static const char *path = "voronoi_input_test.txt";
+
+static void write_file(const void *contents, size_t size)
+{
+    FILE *file = fopen(path, "wb");
+    assert(file);
+    size_t written = fwrite(contents, 1, size, file);
+    assert(written == size);
+    fclose(file);
+}
+
+static void write_text(const char *text)
+{
+    write_file(text, strlen(text));
+}
+
+void test_voronoi_input_format()
+{
+    assert(voronoi_input_format("sites.csv") == VORONOI_INPUT_CSV);
+    assert(voronoi_input_format("dir.v2/sites.bin") == VORONOI_INPUT_BINARY);
+    assert(voronoi_input_format("sites.txt") == VORONOI_INPUT_TEXT);
+    assert(voronoi_input_format("sites") == VORONOI_INPUT_TEXT);
+}
+
+void test_voronoi_input_text()
+{
+    write_text("# a comment\n1 2\n\n  30\t40  \r\n18446744073709551615 0");
+    Voronoi_Input_t input;
+    uint8_t is_read = voronoi_input_read(&input, path, VORONOI_INPUT_TEXT);
+    assert(is_read);
+    assert(input.count == 3);
+    assert(input.points[0].x == 1 && input.points[0].y == 2);
+    assert(input.points[1].x == 30 && input.points[1].y == 40);
+    assert(input.points[2].x == UINT64_MAX && input.points[2].y == 0);
+    for (size_t i = 0; i < input.count; i++)
+    {
+        assert(input.sites[i] == &input.points[i]);
+    }
+    voronoi_input_destroy(&input);
+
+    // The line of the first malformed record is reported
+    const char *malformed[4] = {"1 2\n3\n", "1 2\n3 4 5\n", "1 2\n-3 4\n", "1 2\n18446744073709551616 4\n"};
+    for (size_t i = 0; i < 4; i++)
+    {
+        write_text(malformed[i]);
+        is_read = voronoi_input_read(&input, path, VORONOI_INPUT_TEXT);
+        assert(! is_read);
+        assert(input.line == 2);
+        assert(input.sites == NULL && input.count == 0);
+    }
+    remove(path);
+}
+
+void test_voronoi_input_csv()
+{
+    write_text("x,y\n1,2\n3 , 4\n");
+    Voronoi_Input_t input;
+    uint8_t is_read = voronoi_input_read(&input, path, VORONOI_INPUT_CSV);
+    assert(is_read);
+    assert(input.count == 2);
+    assert(input.points[1].x == 3 && input.points[1].y == 4);
+    voronoi_input_destroy(&input);
+
+    // Only the first line can be a header
+    write_text("1,2\nx,y\n");
+    is_read = voronoi_input_read(&input, path, VORONOI_INPUT_CSV);
+    assert(! is_read);
+    assert(input.line == 2);
+    write_text("x,y\n1 2\n");
+    is_read = voronoi_input_read(&input, path, VORONOI_INPUT_CSV);
+    assert(! is_read);
+    assert(input.line == 2);
+
+    // A first line with numbers is a malformed site rather than a header
+    const char *malformed[2] = {"1,2,\n3,4\n", "-1,2\n3,4\n"};
+    for (size_t i = 0; i < 2; i++)
+    {
+        write_text(malformed[i]);
+        is_read = voronoi_input_read(&input, path, VORONOI_INPUT_CSV);
+        assert(! is_read);
+        assert(input.line == 1);
+        assert(input.sites == NULL && input.count == 0);
+    }
+    write_text("\"x1\",\"y1\"\n3,4\n");
+    is_read = voronoi_input_read(&input, path, VORONOI_INPUT_CSV);
+    assert(is_read);
+    assert(input.count == 1);
+    voronoi_input_destroy(&input);
+    remove(path);
+}
+
+void test_voronoi_input_chunks()
+{
+    // Large enough to be split into chunks, with lines that hold no site here and there
+    size_t count = 200000;
+    FILE *file = fopen(path, "w");
+    assert(file);
+    fprintf(file, "x,y\n");
+    for (size_t i = 0; i < count; i++)
+    {
+        fprintf(file, "%zu,%zu\n", i, 3 * i + 1);
+        if (i % 1000 == 0) fprintf(file, "\n  \r\n");
+    }
+    fclose(file);
+    Voronoi_Input_t input;
+    uint8_t is_read = voronoi_input_read(&input, path, VORONOI_INPUT_CSV);
+    assert(is_read);
+    assert(input.count == count);
+    for (size_t i = 0; i < count; i++)
+    {
+        assert(input.points[i].x == i && input.points[i].y == 3 * i + 1);
+        assert(input.sites[i] == &input.points[i]);
+    }
+    voronoi_input_destroy(&input);
+
+    // The first malformed line is found wherever it is
+    file = fopen(path, "w");
+    for (size_t i = 0; i < count; i++)
+    {
+        fprintf(file, i == count / 2 || i == count - 1 ? "%zu;%zu\n" : "%zu %zu\n", i, i);
+    }
+    fclose(file);
+    is_read = voronoi_input_read(&input, path, VORONOI_INPUT_TEXT);
+    assert(! is_read);
+    assert(input.line == count / 2 + 1);
+    remove(path);
+}
+
+void test_voronoi_input_binary()
+{
+    Point_t points[3] = {{1, 2}, {3, 4}, {UINT64_MAX, 5}};
+    write_file(points, sizeof(points));
+    Voronoi_Input_t input;
+    uint8_t is_read = voronoi_input_read(&input, path, VORONOI_INPUT_BINARY);
+    assert(is_read);
+    assert(input.count == 3);
+    assert(input.mapping != NULL);
+    assert(0 == memcmp(input.points, points, sizeof(points)));
+    voronoi_input_destroy(&input);
+
+    // A truncated point is an error
+    write_file(points, sizeof(points) - 1);
+    is_read = voronoi_input_read(&input, path, VORONOI_INPUT_BINARY);
+    assert(! is_read);
+
+    write_file(points, 0);
+    is_read = voronoi_input_read(&input, path, VORONOI_INPUT_BINARY);
+    assert(is_read);
+    assert(input.count == 0);
+    voronoi_input_destroy(&input);
+    remove(path);
+
+    is_read = voronoi_input_read(&input, path, VORONOI_INPUT_BINARY);
+    assert(! is_read);
+    is_read = voronoi_input_read(&input, path, VORONOI_INPUT_TEXT);
+    assert(! is_read);
+}
+
+int main(int argc, char *argv[])
+{
+    test_voronoi_input_format();
+    test_voronoi_input_text();
+    test_voronoi_input_csv();
+    test_voronoi_input_chunks();
+    test_voronoi_input_binary();
+}
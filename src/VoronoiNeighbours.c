@@ -0,0 +1,215 @@
+//
+// Nearest neighbours of the sites of a Voronoi diagram
+//
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include "VoronoiNeighbours.h"
+#include "VoronoiTrace.h"
+
+// The number of neighbours whose distances are evaluated together. Most faces have fewer than eight neighbours
+#define VORONOI_NEIGHBOURS_BLOCK 8
+
+/**
+ * Initializes an empty set of neighbours
+ *
+ * @param self the neighbours handle
+ */
+void voronoi_neighbours_init(Voronoi_Neighbours_t *self)
+{
+    memset(self, 0, sizeof(Voronoi_Neighbours_t));
+}
+
+/**
+ * Finds the closest of a block of neighbouring faces. The squared distances are evaluated side by side,
+ * relative to the site of the face to keep the products small
+ *
+ * @param face the face
+ * @param block the neighbouring faces
+ * @param count the number of faces in the block, at most VORONOI_NEIGHBOURS_BLOCK
+ * @param closest the closest face so far, updated if one of the block is closer
+ * @param closest_distance the squared distance of the closest face so far
+ */
+static void voronoi_neighbours_closest(DCEL_Face_ptr_t face, DCEL_Face_ptr_t *block, size_t count,
+                                       DCEL_Face_ptr_t *closest, double *closest_distance)
+{
+    double offset_x[VORONOI_NEIGHBOURS_BLOCK];
+    double offset_y[VORONOI_NEIGHBOURS_BLOCK];
+    double distance[VORONOI_NEIGHBOURS_BLOCK];
+    double x = (double) face->site.x;
+    double y = (double) face->site.y;
+    for (size_t i = 0; i < count; i++)
+    {
+        offset_x[i] = (double) block[i]->site.x;
+        offset_y[i] = (double) block[i]->site.y;
+    }
+    #pragma omp simd
+    for (size_t i = 0; i < count; i++)
+    {
+        double dx = offset_x[i] - x;
+        double dy = offset_y[i] - y;
+        distance[i] = dx * dx + dy * dy;
+    }
+    // Ties go to the lower index, so the result does not depend on where the walk starts
+    for (size_t i = 0; i < count; i++)
+    {
+        if (distance[i] < *closest_distance ||
+            (distance[i] == *closest_distance && block[i]->index < (*closest)->index))
+        {
+            *closest_distance = distance[i];
+            *closest = block[i];
+        }
+    }
+}
+
+/**
+ * Walks once around the boundary of the face and counts its neighbours. The neighbours are written out and the
+ * closest one is picked if the arrays are given
+ *
+ * @param face the face
+ * @param neighbours receives the indices of the neighbouring faces, can be NULL
+ * @param closest receives the closest neighbouring face, NULL if there is none. Only set if neighbours is given
+ * @return the number of neighbours
+ */
+static size_t voronoi_neighbours_walk(DCEL_Face_ptr_t face, uint32_t *neighbours, DCEL_Face_ptr_t *closest)
+{
+    size_t degree = 0;
+    DCEL_HalfEdge_ptr_t start = face->inc_edge;
+    if (closest) *closest = NULL;
+    if (! start) return 0;
+
+    DCEL_Face_ptr_t block[VORONOI_NEIGHBOURS_BLOCK];
+    size_t filled = 0;
+    double closest_distance = INFINITY;
+    DCEL_HalfEdge_ptr_t half_edge = start;
+    do
+    {
+        DCEL_Face_ptr_t neighbour = half_edge->twin->inc_face;
+        if (neighbour)
+        {
+            if (neighbours)
+            {
+                neighbours[degree] = (uint32_t) neighbour->index;
+                block[filled++] = neighbour;
+                if (VORONOI_NEIGHBOURS_BLOCK == filled)
+                {
+                    voronoi_neighbours_closest(face, block, filled, closest, &closest_distance);
+                    filled = 0;
+                }
+            }
+            degree++;
+        }
+        half_edge = half_edge->next;
+    } while (half_edge && half_edge != start);
+
+    if (filled) voronoi_neighbours_closest(face, block, filled, closest, &closest_distance);
+    return degree;
+}
+
+/**
+ * Grows the arrays of self to hold the given number of faces and neighbours
+ *
+ * @param self the neighbours handle
+ * @param count the number of faces
+ * @param neighbour_count the number of neighbours
+ * @return 1 on success, 0 if the memory could not be allocated
+ */
+static uint8_t voronoi_neighbours_reserve(Voronoi_Neighbours_t *self, size_t count, size_t neighbour_count)
+{
+    if (count > self->capacity || NULL == self->offsets)
+    {
+        size_t *offsets = realloc(self->offsets, (count + 1) * sizeof(size_t));
+        if (NULL == offsets) return 0;
+        self->offsets = offsets;
+        uint32_t *nearest = realloc(self->nearest, count * sizeof(uint32_t));
+        if (NULL == nearest) return 0;
+        self->nearest = nearest;
+        double *nearest_distance = realloc(self->nearest_distance, count * sizeof(double));
+        if (NULL == nearest_distance) return 0;
+        self->nearest_distance = nearest_distance;
+        self->capacity = count;
+    }
+    if (neighbour_count > self->neighbour_capacity)
+    {
+        uint32_t *neighbours = realloc(self->neighbours, neighbour_count * sizeof(uint32_t));
+        if (NULL == neighbours) return 0;
+        self->neighbours = neighbours;
+        self->neighbour_capacity = neighbour_count;
+    }
+    return 1;
+}
+
+/**
+ * Collects the neighbours of every face of the diagram and picks the nearest one. The faces are processed in parallel
+ * and the memory of self is reused, so the same handle can be passed for one diagram after another
+ *
+ * The first pass counts the neighbours of each face, which gives the offsets of the neighbour lists. The second pass
+ * walks the faces again to fill in the lists and compares the distances to the neighbours on the way.
+ * Only the nearest distance of each face is taken as a square root, see point_euclidean_distance
+ *
+ * @param self the neighbours handle
+ * @param dcel the diagram
+ * @return 1 on success, 0 if the memory could not be allocated
+ */
+uint8_t voronoi_neighbours_compute(Voronoi_Neighbours_t *self, const DCEL_t *dcel)
+{
+    size_t count = dcel->face_count;
+    // Every half-edge contributes at most one neighbour
+    if (! voronoi_neighbours_reserve(self, count, dcel->half_edge_count)) return 0;
+    self->count = count;
+    DCEL_Face_ptr_t *faces = dcel->faces;
+    size_t *offsets = self->offsets;
+
+    #pragma omp parallel default(none) shared(faces, offsets, count)
+    {
+        voronoi_trace_begin("neighbours_count");
+        #pragma omp for schedule(static) nowait
+        for (size_t i = 0; i < count; i++)
+        {
+            offsets[i + 1] = voronoi_neighbours_walk(faces[i], NULL, NULL);
+        }
+        voronoi_trace_end("neighbours_count");
+    }
+
+    offsets[0] = 0;
+    for (size_t i = 0; i < count; i++)
+    {
+        offsets[i + 1] += offsets[i];
+    }
+
+    uint32_t *neighbours = self->neighbours;
+    uint32_t *nearest = self->nearest;
+    double *nearest_distance = self->nearest_distance;
+    #pragma omp parallel default(none) shared(faces, offsets, neighbours, nearest, nearest_distance, count)
+    {
+        voronoi_trace_begin("neighbours_nearest");
+        #pragma omp for schedule(static) nowait
+        for (size_t i = 0; i < count; i++)
+        {
+            DCEL_Face_ptr_t closest;
+            voronoi_neighbours_walk(faces[i], &neighbours[offsets[i]], &closest);
+            nearest[i] = closest ? (uint32_t) closest->index : VORONOI_NEIGHBOURS_NONE;
+            nearest_distance[i] = closest ? point_euclidean_distance(&faces[i]->site, &closest->site) : INFINITY;
+        }
+        voronoi_trace_end("neighbours_nearest");
+    }
+    return 1;
+}
+
+/**
+ * Frees the arrays of self. The neighbours are empty afterwards
+ *
+ * @param self the neighbours handle
+ */
+void voronoi_neighbours_destroy(Voronoi_Neighbours_t *self)
+{
+    if (self)
+    {
+        free(self->offsets);
+        free(self->neighbours);
+        free(self->nearest);
+        free(self->nearest_distance);
+        voronoi_neighbours_init(self);
+    }
+}
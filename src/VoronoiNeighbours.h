@@ -0,0 +1,60 @@
+//
+// Nearest neighbours of the sites of a Voronoi diagram
+//
+
+#ifndef VORONOI_VORONOINEIGHBOURS_H
+#define VORONOI_VORONOINEIGHBOURS_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "Point.h"
+#include "DCEL.h"
+
+// The nearest neighbour of a site without neighbours
+#define VORONOI_NEIGHBOURS_NONE UINT32_MAX
+
+/**
+ * The Voronoi neighbours and the nearest neighbour of every face of a diagram, stored as flat arrays indexed by face.
+ *
+ * The neighbours of face i are neighbours[offsets[i]] up to, but excluding, neighbours[offsets[i + 1]],
+ * in counter-clockwise order. The nearest site is always a Voronoi neighbour, so nearest[i] is exact as long as
+ * the edge between the two cells survives, which holds without clipping and for clip polygons around all sites.
+ * Weights are ignored, so in a build with VORONOI_WEIGHTED the nearest neighbour is only the nearest of the cells.
+ * A face without neighbours, e.g. the empty face of a duplicate site, has VORONOI_NEIGHBOURS_NONE as its nearest
+ * neighbour at an infinite distance.
+ */
+typedef struct {
+    size_t *offsets; // count + 1 entries
+    uint32_t *neighbours;
+    uint32_t *nearest;
+    double *nearest_distance;
+    size_t count; // The number of faces
+    size_t capacity; // The number of faces that fit into the arrays
+    size_t neighbour_capacity; // The number of neighbours that fit into the neighbour array
+} Voronoi_Neighbours_t;
+
+/**
+ * Initializes an empty set of neighbours
+ *
+ * @param self the neighbours handle
+ */
+void voronoi_neighbours_init(Voronoi_Neighbours_t *self);
+
+/**
+ * Collects the neighbours of every face of the diagram and picks the nearest one. The faces are processed in parallel
+ * and the memory of self is reused, so the same handle can be passed for one diagram after another
+ *
+ * @param self the neighbours handle
+ * @param dcel the diagram
+ * @return 1 on success, 0 if the memory could not be allocated
+ */
+uint8_t voronoi_neighbours_compute(Voronoi_Neighbours_t *self, const DCEL_t *dcel);
+
+/**
+ * Frees the arrays of self. The neighbours are empty afterwards
+ *
+ * @param self the neighbours handle
+ */
+void voronoi_neighbours_destroy(Voronoi_Neighbours_t *self);
+
+#endif //VORONOI_VORONOINEIGHBOURS_H
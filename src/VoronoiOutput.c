@@ -0,0 +1,873 @@
+//
+// Writing of diagrams and triangulations to files
+//
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+#include "VoronoiOutput.h"
+#include "VoronoiTrace.h"
+
+// The number of records that are formatted into one buffer
+#define VORONOI_OUTPUT_CHUNK 4096
+// The number of buffers per thread that are formatted before they are written together. Memory stays bounded by
+// the number of buffers, however large the diagram is
+#define VORONOI_OUTPUT_CHUNKS_PER_THREAD 4
+// The largest number of buffers written at once, the IOV_MAX of Linux
+#define VORONOI_OUTPUT_MAX_CHUNKS 1024
+// The longest text of a double, e.g. -1.2345678901234567e-308 or -0.0000012345678901234567
+#define VORONOI_OUTPUT_DOUBLE_SIZE 32
+
+/**
+ * A growing piece of text
+ */
+typedef struct {
+    char *data;
+    size_t size;
+    size_t capacity;
+    uint8_t failed; // Whether some of the text was dropped because the memory could not be allocated
+} Voronoi_Output_Buffer_t;
+
+/**
+ * Formats the records [begin, end) of source into the buffer
+ */
+typedef void (*voronoi_output_formatter)(const void *source, size_t begin, size_t end, Voronoi_Output_Buffer_t *buffer);
+
+/**
+ * A floating point number f * 2^e with a 64-bit significand, as used by Grisu
+ */
+typedef struct {
+    uint64_t f;
+    int e;
+} Voronoi_Output_Float_t;
+
+// The normalized powers 10^-348, 10^-340, ..., 10^340, rounded to 64 bits
+static const Voronoi_Output_Float_t voronoi_output_powers[87] = {
+    {0xfa8fd5a0081c0288ULL, -1220}, {0xbaaee17fa23ebf76ULL, -1193}, {0x8b16fb203055ac76ULL, -1166},
+    {0xcf42894a5dce35eaULL, -1140}, {0x9a6bb0aa55653b2dULL, -1113}, {0xe61acf033d1a45dfULL, -1087},
+    {0xab70fe17c79ac6caULL, -1060}, {0xff77b1fcbebcdc4fULL, -1034}, {0xbe5691ef416bd60cULL, -1007},
+    {0x8dd01fad907ffc3cULL, -980}, {0xd3515c2831559a83ULL, -954}, {0x9d71ac8fada6c9b5ULL, -927},
+    {0xea9c227723ee8bcbULL, -901}, {0xaecc49914078536dULL, -874}, {0x823c12795db6ce57ULL, -847},
+    {0xc21094364dfb5637ULL, -821}, {0x9096ea6f3848984fULL, -794}, {0xd77485cb25823ac7ULL, -768},
+    {0xa086cfcd97bf97f4ULL, -741}, {0xef340a98172aace5ULL, -715}, {0xb23867fb2a35b28eULL, -688},
+    {0x84c8d4dfd2c63f3bULL, -661}, {0xc5dd44271ad3cdbaULL, -635}, {0x936b9fcebb25c996ULL, -608},
+    {0xdbac6c247d62a584ULL, -582}, {0xa3ab66580d5fdaf6ULL, -555}, {0xf3e2f893dec3f126ULL, -529},
+    {0xb5b5ada8aaff80b8ULL, -502}, {0x87625f056c7c4a8bULL, -475}, {0xc9bcff6034c13053ULL, -449},
+    {0x964e858c91ba2655ULL, -422}, {0xdff9772470297ebdULL, -396}, {0xa6dfbd9fb8e5b88fULL, -369},
+    {0xf8a95fcf88747d94ULL, -343}, {0xb94470938fa89bcfULL, -316}, {0x8a08f0f8bf0f156bULL, -289},
+    {0xcdb02555653131b6ULL, -263}, {0x993fe2c6d07b7facULL, -236}, {0xe45c10c42a2b3b06ULL, -210},
+    {0xaa242499697392d3ULL, -183}, {0xfd87b5f28300ca0eULL, -157}, {0xbce5086492111aebULL, -130},
+    {0x8cbccc096f5088ccULL, -103}, {0xd1b71758e219652cULL, -77}, {0x9c40000000000000ULL, -50},
+    {0xe8d4a51000000000ULL, -24}, {0xad78ebc5ac620000ULL, 3}, {0x813f3978f8940984ULL, 30},
+    {0xc097ce7bc90715b3ULL, 56}, {0x8f7e32ce7bea5c70ULL, 83}, {0xd5d238a4abe98068ULL, 109},
+    {0x9f4f2726179a2245ULL, 136}, {0xed63a231d4c4fb27ULL, 162}, {0xb0de65388cc8ada8ULL, 189},
+    {0x83c7088e1aab65dbULL, 216}, {0xc45d1df942711d9aULL, 242}, {0x924d692ca61be758ULL, 269},
+    {0xda01ee641a708deaULL, 295}, {0xa26da3999aef774aULL, 322}, {0xf209787bb47d6b85ULL, 348},
+    {0xb454e4a179dd1877ULL, 375}, {0x865b86925b9bc5c2ULL, 402}, {0xc83553c5c8965d3dULL, 428},
+    {0x952ab45cfa97a0b3ULL, 455}, {0xde469fbd99a05fe3ULL, 481}, {0xa59bc234db398c25ULL, 508},
+    {0xf6c69a72a3989f5cULL, 534}, {0xb7dcbf5354e9beceULL, 561}, {0x88fcf317f22241e2ULL, 588},
+    {0xcc20ce9bd35c78a5ULL, 614}, {0x98165af37b2153dfULL, 641}, {0xe2a0b5dc971f303aULL, 667},
+    {0xa8d9d1535ce3b396ULL, 694}, {0xfb9b7cd9a4a7443cULL, 720}, {0xbb764c4ca7a44410ULL, 747},
+    {0x8bab8eefb6409c1aULL, 774}, {0xd01fef10a657842cULL, 800}, {0x9b10a4e5e9913129ULL, 827},
+    {0xe7109bfba19c0c9dULL, 853}, {0xac2820d9623bf429ULL, 880}, {0x80444b5e7aa7cf85ULL, 907},
+    {0xbf21e44003acdd2dULL, 933}, {0x8e679c2f5e44ff8fULL, 960}, {0xd433179d9c8cb841ULL, 986},
+    {0x9e19db92b4e31ba9ULL, 1013}, {0xeb96bf6ebadf77d9ULL, 1039}, {0xaf87023b9bf0ee6bULL, 1066}
+};
+
+static const uint32_t voronoi_output_powers_of_ten[10] = {
+    1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000, 1000000000
+};
+
+/**
+ * Multiplies two numbers and rounds the product to a 64-bit significand
+ */
+static Voronoi_Output_Float_t voronoi_output_multiply(Voronoi_Output_Float_t a, Voronoi_Output_Float_t b)
+{
+    unsigned __int128 product = (unsigned __int128) a.f * b.f;
+    Voronoi_Output_Float_t result;
+    result.f = (uint64_t) (product >> 64) + ((uint64_t) (product >> 63) & 1);
+    result.e = a.e + b.e + 64;
+    return result;
+}
+
+/**
+ * Moves the last digit towards the exact value as long as the digits stay inside the rounding interval
+ */
+static void voronoi_output_grisu_round(char *digits, int length, uint64_t delta, uint64_t rest, uint64_t ten_kappa,
+                                       uint64_t distance)
+{
+    while (rest < distance && delta - rest >= ten_kappa &&
+           (rest + ten_kappa < distance || distance - rest > rest + ten_kappa - distance))
+    {
+        digits[length - 1]--;
+        rest += ten_kappa;
+    }
+}
+
+/**
+ * Yields the decimal digits of a positive finite double with Grisu2 by F. Loitsch, "Printing Floating-Point Numbers
+ * Quickly and Accurately with Integers". The digits read back as the same double, and they are the shortest such
+ * digits for almost all doubles.
+ *
+ * @param value the double
+ * @param digits receives up to 17 digits
+ * @param exponent receives the exponent e such that value is digits * 10^e
+ * @return the number of digits
+ */
+static int voronoi_output_grisu(double value, char *digits, int *exponent)
+{
+    uint64_t bits;
+    memcpy(&bits, &value, sizeof(double));
+    int biased = (int) (bits >> 52 & 0x7FF);
+    Voronoi_Output_Float_t v;
+    v.f = bits & ((1ULL << 52) - 1);
+    v.e = biased ? biased - 1075 : -1074;
+    if (biased) v.f |= 1ULL << 52;
+
+    // The boundaries halfway to the neighbouring doubles, on the scale of the upper one
+    Voronoi_Output_Float_t plus = {(v.f << 1) + 1, v.e - 1};
+    while (! (plus.f & (1ULL << 53)))
+    {
+        plus.f <<= 1;
+        plus.e--;
+    }
+    plus.f <<= 10;
+    plus.e -= 10;
+    Voronoi_Output_Float_t minus = {(v.f << 1) - 1, v.e - 1};
+    if (v.f == 1ULL << 52)
+    {
+        // The gap to the next lower double is half as large at a power of two
+        minus.f = (v.f << 2) - 1;
+        minus.e = v.e - 2;
+    }
+    minus.f <<= minus.e - plus.e;
+    minus.e = plus.e;
+    int shift = __builtin_clzll(v.f);
+    v.f <<= shift;
+    v.e -= shift;
+
+    // Scale by a cached power of ten, such that the integral part of the upper boundary fits into 32 bits
+    double estimate = (-61 - plus.e) * 0.30102999566398114 + 347;
+    int k = (int) estimate;
+    if (estimate - k > 0.0) k++;
+    size_t index = (size_t) ((k >> 3) + 1);
+    int decimal_exponent = 348 - (int) index * 8;
+    Voronoi_Output_Float_t power = voronoi_output_powers[index];
+    Voronoi_Output_Float_t scaled = voronoi_output_multiply(v, power);
+    Voronoi_Output_Float_t upper = voronoi_output_multiply(plus, power);
+    Voronoi_Output_Float_t lower = voronoi_output_multiply(minus, power);
+    upper.f--;
+    lower.f++;
+
+    // Generate the digits of the upper boundary until they are inside the interval
+    int one_exponent = -upper.e;
+    uint64_t one = 1ULL << one_exponent;
+    uint64_t delta = upper.f - lower.f;
+    uint64_t distance = upper.f - scaled.f;
+    uint32_t integral = (uint32_t) (upper.f >> one_exponent);
+    uint64_t fraction = upper.f & (one - 1);
+    int kappa = 1;
+    while (kappa < 10 && integral >= voronoi_output_powers_of_ten[kappa]) kappa++;
+    int length = 0;
+    while (kappa > 0)
+    {
+        uint32_t power_of_ten = voronoi_output_powers_of_ten[kappa - 1];
+        uint32_t digit = integral / power_of_ten;
+        integral %= power_of_ten;
+        if (digit || length) digits[length++] = (char) ('0' + digit);
+        kappa--;
+        uint64_t rest = ((uint64_t) integral << one_exponent) + fraction;
+        if (rest <= delta)
+        {
+            *exponent = decimal_exponent + kappa;
+            voronoi_output_grisu_round(digits, length, delta, rest,
+                                       (uint64_t) voronoi_output_powers_of_ten[kappa] << one_exponent, distance);
+            return length;
+        }
+    }
+    while (1)
+    {
+        fraction *= 10;
+        delta *= 10;
+        char digit = (char) (fraction >> one_exponent);
+        if (digit || length) digits[length++] = (char) ('0' + digit);
+        fraction &= one - 1;
+        kappa--;
+        if (fraction < delta)
+        {
+            *exponent = decimal_exponent + kappa;
+            distance *= -kappa < 10 ? voronoi_output_powers_of_ten[-kappa] : 0;
+            voronoi_output_grisu_round(digits, length, delta, fraction, one, distance);
+            return length;
+        }
+    }
+}
+
+/**
+ * Writes the text of a double that reads back as the same double: plain digits like 1234.5 or 0.000125,
+ * and an exponent like 1.5e-7 for very small and very large values
+ *
+ * @param value the double
+ * @param text receives up to VORONOI_OUTPUT_DOUBLE_SIZE characters, not terminated
+ * @return the number of characters
+ */
+static size_t voronoi_output_format_double(double value, char *text)
+{
+    char *cursor = text;
+    if (value != value)
+    {
+        memcpy(cursor, "nan", 3);
+        return 3;
+    }
+    if (value < 0)
+    {
+        *cursor++ = '-';
+        value = -value;
+    }
+    if (0 == value)
+    {
+        *cursor++ = '0';
+        return (size_t) (cursor - text);
+    }
+    if (value > 1.7976931348623157e308)
+    {
+        memcpy(cursor, "inf", 3);
+        return (size_t) (cursor - text) + 3;
+    }
+    char digits[20];
+    int exponent;
+    int length = voronoi_output_grisu(value, digits, &exponent);
+    // The decimal point follows the first point digits
+    int point = length + exponent;
+    if (exponent >= 0 && point <= 21)
+    {
+        memcpy(cursor, digits, (size_t) length);
+        memset(cursor + length, '0', (size_t) exponent);
+        cursor += point;
+    }
+    else if (0 < point && point <= 21)
+    {
+        memcpy(cursor, digits, (size_t) point);
+        cursor[point] = '.';
+        memcpy(cursor + point + 1, digits + point, (size_t) (length - point));
+        cursor += length + 1;
+    }
+    else if (-6 < point && point <= 0)
+    {
+        cursor[0] = '0';
+        cursor[1] = '.';
+        memset(cursor + 2, '0', (size_t) -point);
+        memcpy(cursor + 2 - point, digits, (size_t) length);
+        cursor += 2 - point + length;
+    }
+    else
+    {
+        *cursor++ = digits[0];
+        if (length > 1)
+        {
+            *cursor++ = '.';
+            memcpy(cursor, digits + 1, (size_t) (length - 1));
+            cursor += length - 1;
+        }
+        *cursor++ = 'e';
+        int scientific = point - 1;
+        if (scientific < 0)
+        {
+            *cursor++ = '-';
+            scientific = -scientific;
+        }
+        if (scientific >= 100) *cursor++ = (char) ('0' + scientific / 100);
+        if (scientific >= 10) *cursor++ = (char) ('0' + scientific / 10 % 10);
+        *cursor++ = (char) ('0' + scientific % 10);
+    }
+    return (size_t) (cursor - text);
+}
+
+/**
+ * Makes room for the given number of characters at the end of the buffer
+ *
+ * @param buffer the buffer
+ * @param size the number of characters
+ * @return where to write them, NULL if the memory could not be allocated
+ */
+static char *voronoi_output_reserve(Voronoi_Output_Buffer_t *buffer, size_t size)
+{
+    if (buffer->size + size > buffer->capacity)
+    {
+        size_t capacity = buffer->capacity ? 2 * buffer->capacity : 65536;
+        while (capacity < buffer->size + size) capacity *= 2;
+        char *data = realloc(buffer->data, capacity);
+        if (NULL == data)
+        {
+            buffer->failed = 1;
+            return NULL;
+        }
+        buffer->data = data;
+        buffer->capacity = capacity;
+    }
+    return buffer->data + buffer->size;
+}
+
+static void voronoi_output_text(Voronoi_Output_Buffer_t *buffer, const char *text)
+{
+    size_t length = strlen(text);
+    char *target = voronoi_output_reserve(buffer, length);
+    if (NULL == target) return;
+    memcpy(target, text, length);
+    buffer->size += length;
+}
+
+static void voronoi_output_unsigned(Voronoi_Output_Buffer_t *buffer, uint64_t value)
+{
+    char digits[20];
+    size_t length = 0;
+    do
+    {
+        digits[length++] = (char) ('0' + value % 10);
+        value /= 10;
+    } while (value);
+    char *target = voronoi_output_reserve(buffer, length);
+    if (NULL == target) return;
+    for (size_t i = 0; i < length; i++) target[i] = digits[length - 1 - i];
+    buffer->size += length;
+}
+
+/**
+ * Writes the position of a record, -1 if there is none
+ */
+static void voronoi_output_position_text(Voronoi_Output_Buffer_t *buffer, long long position)
+{
+    if (position < 0) voronoi_output_text(buffer, "-1");
+    else voronoi_output_unsigned(buffer, (uint64_t) position);
+}
+
+static void voronoi_output_double(Voronoi_Output_Buffer_t *buffer, double value)
+{
+    char *target = voronoi_output_reserve(buffer, VORONOI_OUTPUT_DOUBLE_SIZE);
+    if (NULL == target) return;
+    buffer->size += voronoi_output_format_double(value, target);
+}
+
+/**
+ * Writes all bytes of the vectors, resuming after partial writes
+ *
+ * @param fd the file descriptor
+ * @param vectors the vectors, modified as they are written
+ * @param count the number of vectors
+ * @return 1 on success, 0 if the file could not be written
+ */
+static uint8_t voronoi_output_writev(int fd, struct iovec *vectors, size_t count)
+{
+    while (count > 0)
+    {
+        ssize_t written = writev(fd, vectors, (int) count);
+        if (written < 0)
+        {
+            if (EINTR == errno) continue;
+            return 0;
+        }
+        while (count > 0 && (size_t) written >= vectors->iov_len)
+        {
+            written -= (ssize_t) vectors->iov_len;
+            vectors++;
+            count--;
+        }
+        if (count > 0)
+        {
+            vectors->iov_base = (char *) vectors->iov_base + written;
+            vectors->iov_len -= (size_t) written;
+        }
+    }
+    return 1;
+}
+
+static uint8_t voronoi_output_write_text(int fd, const char *text)
+{
+    struct iovec vector = {(void *) text, strlen(text)};
+    return voronoi_output_writev(fd, &vector, 1);
+}
+
+/**
+ * Formats count records in parallel and writes them in order. The records are split into chunks of
+ * VORONOI_OUTPUT_CHUNK, every thread formats a few chunks into buffers of their own and then all the buffers
+ * are written with a single writev, round after round
+ *
+ * @param fd the file descriptor
+ * @param source the records
+ * @param count the number of records
+ * @param format formats a chunk of records
+ * @return 1 on success, 0 if the file could not be written or the memory could not be allocated
+ */
+static uint8_t voronoi_output_parallel(int fd, const void *source, size_t count, voronoi_output_formatter format)
+{
+#ifdef _OPENMP
+    size_t chunks = (size_t) omp_get_max_threads() * VORONOI_OUTPUT_CHUNKS_PER_THREAD;
+#else
+    size_t chunks = VORONOI_OUTPUT_CHUNKS_PER_THREAD;
+#endif
+    if (chunks > VORONOI_OUTPUT_MAX_CHUNKS) chunks = VORONOI_OUTPUT_MAX_CHUNKS;
+    Voronoi_Output_Buffer_t *buffers = calloc(chunks, sizeof(Voronoi_Output_Buffer_t));
+    struct iovec *vectors = malloc(chunks * sizeof(struct iovec));
+    uint8_t success = buffers && vectors;
+    for (size_t round = 0; success && round < count; round += chunks * VORONOI_OUTPUT_CHUNK)
+    {
+        size_t round_chunks = (count - round + VORONOI_OUTPUT_CHUNK - 1) / VORONOI_OUTPUT_CHUNK;
+        if (round_chunks > chunks) round_chunks = chunks;
+        #pragma omp parallel if (round_chunks > 1) default(none) shared(source, count, format, buffers, round, round_chunks)
+        {
+            voronoi_trace_begin("output_format");
+            #pragma omp for schedule(dynamic)
+            for (size_t chunk = 0; chunk < round_chunks; chunk++)
+            {
+                size_t begin = round + chunk * VORONOI_OUTPUT_CHUNK;
+                size_t end = begin + VORONOI_OUTPUT_CHUNK < count ? begin + VORONOI_OUTPUT_CHUNK : count;
+                buffers[chunk].size = 0;
+                format(source, begin, end, &buffers[chunk]);
+            }
+            voronoi_trace_end("output_format");
+        }
+        for (size_t chunk = 0; chunk < round_chunks; chunk++)
+        {
+            success &= ! buffers[chunk].failed;
+            vectors[chunk].iov_base = buffers[chunk].data;
+            vectors[chunk].iov_len = buffers[chunk].size;
+        }
+        voronoi_trace_begin("output_write");
+        success = success && voronoi_output_writev(fd, vectors, round_chunks);
+        voronoi_trace_end("output_write");
+    }
+    for (size_t chunk = 0; buffers && chunk < chunks; chunk++)
+    {
+        free(buffers[chunk].data);
+    }
+    free(buffers);
+    free(vectors);
+    return success;
+}
+
+/**
+ * Hands the file over to the writers, which bypass its buffer
+ *
+ * @param file the file
+ * @return the file descriptor, -1 if the buffered text could not be written
+ */
+static int voronoi_output_descriptor(FILE *file)
+{
+    return 0 == fflush(file) ? fileno(file) : -1;
+}
+
+/**
+ * A slot of the hash table from the addresses of records to their positions
+ */
+typedef struct {
+    uintptr_t address; // 0 if the slot is empty
+    size_t position;
+} Voronoi_Output_Record_t;
+
+/**
+ * Maps the records of one array of an edge list to their positions in the array, by open addressing.
+ * A lookup costs about one cache miss, where a binary search over the sorted addresses costs one per step
+ */
+typedef struct {
+    Voronoi_Output_Record_t *slots;
+    size_t mask; // The number of slots minus one
+} Voronoi_Output_Records_t;
+
+static size_t voronoi_output_slot(const Voronoi_Output_Records_t *self, uintptr_t address)
+{
+    uint64_t hash = (uint64_t) address * 0x9E3779B97F4A7C15ULL;
+    return (size_t) (hash ^ hash >> 32) & self->mask;
+}
+
+/**
+ * Fills the table with the positions of the records of an array
+ *
+ * @param self the table
+ * @param records the array of records
+ * @param count the number of records
+ * @return 1 on success, 0 if the memory could not be allocated
+ */
+static uint8_t voronoi_output_records_init(Voronoi_Output_Records_t *self, void *const *records, size_t count)
+{
+    // Keep the table at most half full, such that the probe sequences stay short
+    size_t slots = 2;
+    while (slots < 2 * count) slots *= 2;
+    self->slots = calloc(slots, sizeof(Voronoi_Output_Record_t));
+    self->mask = slots - 1;
+    if (NULL == self->slots) return 0;
+    for (size_t i = 0; i < count; i++)
+    {
+        uintptr_t address = (uintptr_t) records[i];
+        size_t slot = voronoi_output_slot(self, address);
+        while (self->slots[slot].address) slot = (slot + 1) & self->mask;
+        self->slots[slot].address = address;
+        self->slots[slot].position = i;
+    }
+    return 1;
+}
+
+/**
+ * Looks up the position of a record
+ *
+ * @param self the table
+ * @param record the record, can be NULL
+ * @return the position of the record, -1 if it is NULL or not in the table
+ */
+static long long voronoi_output_position(const Voronoi_Output_Records_t *self, const void *record)
+{
+    if (NULL == record) return -1;
+    uintptr_t address = (uintptr_t) record;
+    size_t slot = voronoi_output_slot(self, address);
+    while (self->slots[slot].address)
+    {
+        if (self->slots[slot].address == address) return (long long) self->slots[slot].position;
+        slot = (slot + 1) & self->mask;
+    }
+    return -1;
+}
+
+/**
+ * An edge list together with the positions of its records
+ */
+typedef struct {
+    const DCEL_t *dcel;
+    Voronoi_Output_Records_t vertices;
+    Voronoi_Output_Records_t half_edges;
+    Voronoi_Output_Records_t faces;
+} Voronoi_Output_Tables_t;
+
+/**
+ * Writes the end of an edge, nothing if it is at infinity
+ */
+static void voronoi_output_edge_end(Voronoi_Output_Buffer_t *buffer, DCEL_Vertex_ptr_t vertex)
+{
+    voronoi_output_text(buffer, ",");
+    if (vertex) voronoi_output_double(buffer, vertex->position.x);
+    voronoi_output_text(buffer, ",");
+    if (vertex) voronoi_output_double(buffer, vertex->position.y);
+}
+
+static void voronoi_output_edges_chunk(const void *source, size_t begin, size_t end, Voronoi_Output_Buffer_t *buffer)
+{
+    const DCEL_t *dcel = source;
+    for (size_t i = begin; i < end; i++)
+    {
+        DCEL_HalfEdge_ptr_t half_edge = dcel->half_edges[i];
+        DCEL_HalfEdge_ptr_t twin = half_edge->twin;
+        if (NULL == half_edge->inc_face) continue;
+        DCEL_Face_ptr_t neighbour = twin ? twin->inc_face : NULL;
+        if (neighbour && neighbour->index < half_edge->inc_face->index) continue;
+        voronoi_output_unsigned(buffer, half_edge->inc_face->index);
+        voronoi_output_text(buffer, ",");
+        if (neighbour) voronoi_output_unsigned(buffer, neighbour->index);
+        voronoi_output_edge_end(buffer, half_edge->origin);
+        voronoi_output_edge_end(buffer, twin ? twin->origin : NULL);
+        voronoi_output_text(buffer, "\n");
+    }
+}
+
+/**
+ * Writes the edges of the diagram as CSV with the columns site,neighbour,x1,y1,x2,y2.
+ * Every edge is written once, from the face of the lower site index. It separates the cells of the sites site and
+ * neighbour and runs from (x1, y1) to (x2, y2). The neighbour is empty on the boundary of a clip polygon,
+ * the coordinates of an end are empty if the edge runs off to infinity there.
+ *
+ * @param file the file
+ * @param dcel the diagram
+ * @return 1 on success, 0 if the file could not be written or the memory could not be allocated
+ */
+uint8_t voronoi_output_edges(FILE *file, const DCEL_t *dcel)
+{
+    int fd = voronoi_output_descriptor(file);
+    return fd >= 0 && voronoi_output_write_text(fd, "site,neighbour,x1,y1,x2,y2\n") &&
+           voronoi_output_parallel(fd, dcel, dcel->half_edge_count, voronoi_output_edges_chunk);
+}
+
+static void voronoi_output_vertices_chunk(const void *source, size_t begin, size_t end,
+                                          Voronoi_Output_Buffer_t *buffer)
+{
+    const Voronoi_Output_Tables_t *tables = source;
+    const DCEL_t *dcel = tables->dcel;
+    for (size_t i = begin; i < end; i++)
+    {
+        DCEL_Vertex_ptr_t vertex = dcel->vertices[i];
+        voronoi_output_text(buffer, "v ");
+        voronoi_output_double(buffer, vertex->position.x);
+        voronoi_output_text(buffer, " ");
+        voronoi_output_double(buffer, vertex->position.y);
+        voronoi_output_text(buffer, " ");
+        voronoi_output_position_text(buffer, voronoi_output_position(&tables->half_edges, vertex->inc_edge));
+        voronoi_output_text(buffer, "\n");
+    }
+}
+
+static void voronoi_output_half_edges_chunk(const void *source, size_t begin, size_t end,
+                                            Voronoi_Output_Buffer_t *buffer)
+{
+    const Voronoi_Output_Tables_t *tables = source;
+    const DCEL_t *dcel = tables->dcel;
+    for (size_t i = begin; i < end; i++)
+    {
+        DCEL_HalfEdge_ptr_t half_edge = dcel->half_edges[i];
+        const DCEL_HalfEdge_t *links[3] = {half_edge->twin, half_edge->next, half_edge->prev};
+        voronoi_output_text(buffer, "h ");
+        voronoi_output_position_text(buffer, voronoi_output_position(&tables->vertices, half_edge->origin));
+        for (size_t link = 0; link < 3; link++)
+        {
+            voronoi_output_text(buffer, " ");
+            voronoi_output_position_text(buffer, voronoi_output_position(&tables->half_edges, links[link]));
+        }
+        voronoi_output_text(buffer, " ");
+        voronoi_output_position_text(buffer, voronoi_output_position(&tables->faces, half_edge->inc_face));
+        voronoi_output_text(buffer, "\n");
+    }
+}
+
+static void voronoi_output_faces_chunk(const void *source, size_t begin, size_t end, Voronoi_Output_Buffer_t *buffer)
+{
+    const Voronoi_Output_Tables_t *tables = source;
+    const DCEL_t *dcel = tables->dcel;
+    for (size_t i = begin; i < end; i++)
+    {
+        DCEL_Face_ptr_t face = dcel->faces[i];
+        voronoi_output_text(buffer, "f ");
+        voronoi_output_unsigned(buffer, face->site.x);
+        voronoi_output_text(buffer, " ");
+        voronoi_output_unsigned(buffer, face->site.y);
+        voronoi_output_text(buffer, " ");
+        voronoi_output_unsigned(buffer, face->index);
+        voronoi_output_text(buffer, " ");
+        voronoi_output_position_text(buffer, voronoi_output_position(&tables->half_edges, face->inc_edge));
+        voronoi_output_text(buffer, "\n");
+    }
+}
+
+/**
+ * Writes every record of the edge list, with the links given as positions in the arrays of the edge list.
+ * A missing link is written as -1. The file starts with the line "dcel <vertices> <half-edges> <faces>",
+ * followed by one line per record:
+ *   v <x> <y> <inc_edge>
+ *   h <origin> <twin> <next> <prev> <inc_face>
+ *   f <site x> <site y> <site index> <inc_edge>
+ *
+ * @param file the file
+ * @param dcel the edge list
+ * @return 1 on success, 0 if the file could not be written or the memory could not be allocated
+ */
+uint8_t voronoi_output_dcel(FILE *file, const DCEL_t *dcel)
+{
+    Voronoi_Output_Tables_t tables;
+    tables.dcel = dcel;
+    uint8_t success = voronoi_output_records_init(&tables.vertices, (void *const *) dcel->vertices,
+                                                  dcel->vertex_count);
+    success &= voronoi_output_records_init(&tables.half_edges, (void *const *) dcel->half_edges,
+                                           dcel->half_edge_count);
+    success &= voronoi_output_records_init(&tables.faces, (void *const *) dcel->faces, dcel->face_count);
+    int fd = voronoi_output_descriptor(file);
+    success &= fd >= 0;
+    if (success)
+    {
+        char header[96];
+        snprintf(header, sizeof(header), "dcel %zu %zu %zu\n", dcel->vertex_count, dcel->half_edge_count,
+                 dcel->face_count);
+        success = voronoi_output_write_text(fd, header) &&
+                  voronoi_output_parallel(fd, &tables, dcel->vertex_count, voronoi_output_vertices_chunk) &&
+                  voronoi_output_parallel(fd, &tables, dcel->half_edge_count, voronoi_output_half_edges_chunk) &&
+                  voronoi_output_parallel(fd, &tables, dcel->face_count, voronoi_output_faces_chunk);
+    }
+    free(tables.vertices.slots);
+    free(tables.half_edges.slots);
+    free(tables.faces.slots);
+    return success;
+}
+
+/**
+ * Counts the vertices on the boundary of a face
+ *
+ * @param face the face
+ * @param closed receives whether the boundary is a cycle
+ * @return the number of vertices
+ */
+static size_t voronoi_output_boundary(DCEL_Face_ptr_t face, uint8_t *closed)
+{
+    size_t count = 0;
+    DCEL_HalfEdge_ptr_t half_edge = face->inc_edge;
+    *closed = 0;
+    while (half_edge)
+    {
+        if (half_edge->origin) count++;
+        half_edge = half_edge->next;
+        if (half_edge == face->inc_edge)
+        {
+            *closed = 1;
+            break;
+        }
+    }
+    return count;
+}
+
+/**
+ * Writes the vertices on the boundary of a face, the first one again at the end if the boundary is closed
+ *
+ * @param buffer the buffer
+ * @param face the face
+ * @param closed whether the boundary is a cycle
+ * @param json whether to write [x,y],[x,y] for GeoJSON rather than x y, x y for WKT
+ */
+static void voronoi_output_boundary_text(Voronoi_Output_Buffer_t *buffer, DCEL_Face_ptr_t face, uint8_t closed,
+                                         uint8_t json)
+{
+    const char *separator = "";
+    DCEL_HalfEdge_ptr_t half_edge = face->inc_edge;
+    while (half_edge)
+    {
+        if (half_edge->origin)
+        {
+            voronoi_output_text(buffer, separator);
+            voronoi_output_text(buffer, json ? "[" : "");
+            voronoi_output_double(buffer, half_edge->origin->position.x);
+            voronoi_output_text(buffer, json ? "," : " ");
+            voronoi_output_double(buffer, half_edge->origin->position.y);
+            voronoi_output_text(buffer, json ? "]" : "");
+            separator = json ? "," : ", ";
+        }
+        half_edge = half_edge->next;
+        if (half_edge == face->inc_edge) break;
+    }
+    if (closed)
+    {
+        DCEL_Vertex_ptr_t first = face->inc_edge->origin;
+        voronoi_output_text(buffer, json ? ",[" : ", ");
+        voronoi_output_double(buffer, first->position.x);
+        voronoi_output_text(buffer, json ? "," : " ");
+        voronoi_output_double(buffer, first->position.y);
+        voronoi_output_text(buffer, json ? "]" : "");
+    }
+}
+
+static void voronoi_output_wkt_chunk(const void *source, size_t begin, size_t end, Voronoi_Output_Buffer_t *buffer)
+{
+    const DCEL_t *dcel = source;
+    for (size_t i = begin; i < end; i++)
+    {
+        DCEL_Face_ptr_t face = dcel->faces[i];
+        uint8_t closed;
+        size_t count = voronoi_output_boundary(face, &closed);
+        voronoi_output_unsigned(buffer, face->index);
+        if (closed)
+        {
+            voronoi_output_text(buffer, ",\"POLYGON ((");
+            voronoi_output_boundary_text(buffer, face, closed, 0);
+            voronoi_output_text(buffer, "))\"\n");
+        }
+        else if (count >= 2)
+        {
+            voronoi_output_text(buffer, ",\"LINESTRING (");
+            voronoi_output_boundary_text(buffer, face, closed, 0);
+            voronoi_output_text(buffer, ")\"\n");
+        }
+        else
+        {
+            voronoi_output_text(buffer, ",\"POLYGON EMPTY\"\n");
+        }
+    }
+}
+
+/**
+ * Writes the cells of the diagram as CSV with the columns site,wkt, one line per face in the order of the faces.
+ * A closed cell is a POLYGON. An unbounded cell is the LINESTRING through its vertices, and a cell without
+ * two vertices, e.g. one that was clipped away, is POLYGON EMPTY
+ *
+ * @param file the file
+ * @param dcel the diagram
+ * @return 1 on success, 0 if the file could not be written or the memory could not be allocated
+ */
+uint8_t voronoi_output_wkt(FILE *file, const DCEL_t *dcel)
+{
+    int fd = voronoi_output_descriptor(file);
+    return fd >= 0 && voronoi_output_write_text(fd, "site,wkt\n") &&
+           voronoi_output_parallel(fd, dcel, dcel->face_count, voronoi_output_wkt_chunk);
+}
+
+static void voronoi_output_geojson_chunk(const void *source, size_t begin, size_t end,
+                                         Voronoi_Output_Buffer_t *buffer)
+{
+    const DCEL_t *dcel = source;
+    for (size_t i = begin; i < end; i++)
+    {
+        DCEL_Face_ptr_t face = dcel->faces[i];
+        uint8_t closed;
+        size_t count = voronoi_output_boundary(face, &closed);
+        voronoi_output_text(buffer, i ? ",\n{\"type\":\"Feature\",\"properties\":{\"site\":" :
+                                        "{\"type\":\"Feature\",\"properties\":{\"site\":");
+        voronoi_output_unsigned(buffer, face->index);
+        if (closed)
+        {
+            voronoi_output_text(buffer, "},\"geometry\":{\"type\":\"Polygon\",\"coordinates\":[[");
+            voronoi_output_boundary_text(buffer, face, closed, 1);
+            voronoi_output_text(buffer, "]]}}");
+        }
+        else if (count >= 2)
+        {
+            voronoi_output_text(buffer, "},\"geometry\":{\"type\":\"LineString\",\"coordinates\":[");
+            voronoi_output_boundary_text(buffer, face, closed, 1);
+            voronoi_output_text(buffer, "]}}");
+        }
+        else
+        {
+            voronoi_output_text(buffer, "},\"geometry\":null}");
+        }
+    }
+}
+
+/**
+ * Writes the cells of the diagram as a GeoJSON FeatureCollection with one Feature per face in the order of
+ * the faces. The property site holds the index of the site. The geometry of a closed cell is a Polygon, that of
+ * an unbounded cell the LineString through its vertices, and a cell without two vertices has none
+ *
+ * @param file the file
+ * @param dcel the diagram
+ * @return 1 on success, 0 if the file could not be written or the memory could not be allocated
+ */
+uint8_t voronoi_output_geojson(FILE *file, const DCEL_t *dcel)
+{
+    int fd = voronoi_output_descriptor(file);
+    return fd >= 0 && voronoi_output_write_text(fd, "{\"type\":\"FeatureCollection\",\"features\":[\n") &&
+           voronoi_output_parallel(fd, dcel, dcel->face_count, voronoi_output_geojson_chunk) &&
+           voronoi_output_write_text(fd, "\n]}\n");
+}
+
+static void voronoi_output_delaunay_chunk(const void *source, size_t begin, size_t end,
+                                          Voronoi_Output_Buffer_t *buffer)
+{
+    const Delaunay_t *delaunay = source;
+    for (size_t t = begin; t < end; t++)
+    {
+        const uint32_t *triangle = &delaunay->triangles[3 * t];
+        voronoi_output_unsigned(buffer, triangle[0]);
+        voronoi_output_text(buffer, ",");
+        voronoi_output_unsigned(buffer, triangle[1]);
+        voronoi_output_text(buffer, ",");
+        voronoi_output_unsigned(buffer, triangle[2]);
+        voronoi_output_text(buffer, "\n");
+    }
+}
+
+/**
+ * Writes the triangles as CSV with the columns a,b,c, the site indices in counter-clockwise order
+ *
+ * @param file the file
+ * @param delaunay the triangulation
+ * @return 1 on success, 0 if the file could not be written or the memory could not be allocated
+ */
+uint8_t voronoi_output_delaunay(FILE *file, const Delaunay_t *delaunay)
+{
+    int fd = voronoi_output_descriptor(file);
+    return fd >= 0 && voronoi_output_write_text(fd, "a,b,c\n") &&
+           voronoi_output_parallel(fd, delaunay, delaunay->count, voronoi_output_delaunay_chunk);
+}
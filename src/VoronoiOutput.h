@@ -0,0 +1,73 @@
+//
+// Writing of diagrams and triangulations to files
+//
+// The writers format the records in parallel chunks and write them with writev, bypassing the buffer of the file.
+// Coordinates are written with at most 17 digits, which read back as the same double.
+//
+
+#ifndef VORONOI_VORONOIOUTPUT_H
+#define VORONOI_VORONOIOUTPUT_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include "DCEL.h"
+#include "Delaunay.h"
+
+/**
+ * Writes the edges of the diagram as CSV with the columns site,neighbour,x1,y1,x2,y2.
+ * Every edge is written once, from the face of the lower site index. It separates the cells of the sites site and
+ * neighbour and runs from (x1, y1) to (x2, y2). The neighbour is empty on the boundary of a clip polygon,
+ * the coordinates of an end are empty if the edge runs off to infinity there.
+ *
+ * @param file the file
+ * @param dcel the diagram
+ * @return 1 on success, 0 if the file could not be written or the memory could not be allocated
+ */
+uint8_t voronoi_output_edges(FILE *file, const DCEL_t *dcel);
+
+/**
+ * Writes every record of the edge list, with the links given as positions in the arrays of the edge list.
+ * A missing link is written as -1. The file starts with the line "dcel <vertices> <half-edges> <faces>",
+ * followed by one line per record:
+ *   v <x> <y> <inc_edge>
+ *   h <origin> <twin> <next> <prev> <inc_face>
+ *   f <site x> <site y> <site index> <inc_edge>
+ *
+ * @param file the file
+ * @param dcel the edge list
+ * @return 1 on success, 0 if the file could not be written or the memory could not be allocated
+ */
+uint8_t voronoi_output_dcel(FILE *file, const DCEL_t *dcel);
+
+/**
+ * Writes the cells of the diagram as CSV with the columns site,wkt, one line per face in the order of the faces.
+ * A closed cell is a POLYGON. An unbounded cell is the LINESTRING through its vertices, and a cell without
+ * two vertices, e.g. one that was clipped away, is POLYGON EMPTY
+ *
+ * @param file the file
+ * @param dcel the diagram
+ * @return 1 on success, 0 if the file could not be written or the memory could not be allocated
+ */
+uint8_t voronoi_output_wkt(FILE *file, const DCEL_t *dcel);
+
+/**
+ * Writes the cells of the diagram as a GeoJSON FeatureCollection with one Feature per face in the order of
+ * the faces. The property site holds the index of the site. The geometry of a closed cell is a Polygon, that of
+ * an unbounded cell the LineString through its vertices, and a cell without two vertices has none
+ *
+ * @param file the file
+ * @param dcel the diagram
+ * @return 1 on success, 0 if the file could not be written or the memory could not be allocated
+ */
+uint8_t voronoi_output_geojson(FILE *file, const DCEL_t *dcel);
+
+/**
+ * Writes the triangles as CSV with the columns a,b,c, the site indices in counter-clockwise order
+ *
+ * @param file the file
+ * @param delaunay the triangulation
+ * @return 1 on success, 0 if the file could not be written or the memory could not be allocated
+ */
+uint8_t voronoi_output_delaunay(FILE *file, const Delaunay_t *delaunay);
+
+#endif //VORONOI_VORONOIOUTPUT_H
@@ -0,0 +1,328 @@
+//
+// Tests for the writing of diagrams and triangulations to files
+//
+
+#include <assert.h>
+#include <stdio.h>
+#include "Point.c"
+#include "DCEL.c"
+#include "Delaunay.c"
+#include "PQueue.c"
+#include "RadixQueue.c"
+#include "AVLTree.c"
+#include "VoronoiClip.c"
+#include "VoronoiCells.c"
+#include "VoronoiSites.c"
+#include "VoronoiTrace.c"
+#include "Voronoi.c"
+#include "VoronoiOutput.c"
+
+/**
+ * Computes the diagram of four corners of a square around an inner site, see test_voronoi_square
+ */
+static DCEL_t square_diagram(Delaunay_t *delaunay, const Voronoi_Clip_t *clip)
+{
+    static Point_t points[5] = {{0, 0}, {10, 0}, {10, 10}, {0, 10}, {5, 4}};
+    Point_t_ptr sites[5];
+    for (size_t i = 0; i < 5; i++)
+    {
+        sites[i] = &points[i];
+    }
+    Voronoi_Options_t options = {delaunay, clip};
+    return voronoi_diagram_with_options(sites, 5, &options);
+}
+
+/**
+ * Looks up a link written by voronoi_output_dcel
+ */
+static void *record_at(void **records, long long position)
+{
+    return position < 0 ? NULL : records[position];
+}
+
+/**
+ * Reads back the lines that a writer wrote to a temporary file and closes the file
+ */
+static size_t read_lines(FILE *file, char lines[][128], size_t capacity)
+{
+    rewind(file);
+    size_t count = 0;
+    while (count < capacity && fgets(lines[count], 128, file)) count++;
+    fclose(file);
+    return count;
+}
+
+static uint64_t random_state = 11;
+
+static uint64_t random_next()
+{
+    random_state = random_state * 6364136223846793005ULL + 1442695040888963407ULL;
+    return random_state;
+}
+
+static void assert_double_text(double value, const char *expected)
+{
+    char text[VORONOI_OUTPUT_DOUBLE_SIZE + 1];
+    text[voronoi_output_format_double(value, text)] = '\0';
+    assert(0 == strcmp(text, expected));
+}
+
+void test_voronoi_output_double()
+{
+    assert_double_text(0, "0");
+    assert_double_text(1, "1");
+    assert_double_text(-2.5, "-2.5");
+    assert_double_text(0.1, "0.1");
+    assert_double_text(123.456, "123.456");
+    assert_double_text(1073741824, "1073741824");
+    assert_double_text(0.000001, "0.000001");
+    assert_double_text(1e-7, "1e-7");
+    assert_double_text(1e21, "1e21");
+    assert_double_text(6.02214076e23, "6.02214076e23");
+    assert_double_text(5e-324, "5e-324");
+    assert_double_text(1.7976931348623157e308, "1.7976931348623157e308");
+    assert_double_text(-2.2250738585072014e-308, "-2.2250738585072014e-308");
+
+    // Every double reads back as itself, random bit patterns cover all exponents
+    char text[VORONOI_OUTPUT_DOUBLE_SIZE + 1];
+    for (size_t i = 0; i < 1000000; i++)
+    {
+        uint64_t bits = random_next() ^ (random_next() >> 32);
+        double value;
+        memcpy(&value, &bits, sizeof(double));
+        if (value != value || value > 1.7976931348623157e308 || value < -1.7976931348623157e308) continue;
+        size_t length = voronoi_output_format_double(value, text);
+        assert(length <= 25);
+        text[length] = '\0';
+        assert(strtod(text, NULL) == value);
+    }
+}
+
+void test_voronoi_output_edges()
+{
+    DCEL_t dcel = square_diagram(NULL, NULL);
+    FILE *file = tmpfile();
+    uint8_t is_written = voronoi_output_edges(file, &dcel);
+    assert(is_written);
+    char lines[32][128];
+    size_t count = read_lines(file, lines, 32);
+    // The header, the four edges around the inner cell and the four rays between the corner cells
+    assert(count == 1 + 8);
+    size_t rays = 0;
+    assert(0 == strcmp(lines[0], "site,neighbour,x1,y1,x2,y2\n"));
+    for (size_t i = 1; i < count; i++)
+    {
+        size_t site, neighbour;
+        int scanned = sscanf(lines[i], "%zu,%zu,", &site, &neighbour);
+        assert(2 == scanned);
+        assert(site < neighbour);
+        rays += NULL != strstr(lines[i], ",,");
+    }
+    assert(rays == 4);
+    dcel_destroy(&dcel);
+
+    // Clipped edges have both ends, the sides of the rectangle have no neighbour
+    Point_Real_t corners[4];
+    Voronoi_Clip_t clip = voronoi_clip_rectangle(corners, -5, -5, 15, 15);
+    dcel = square_diagram(NULL, &clip);
+    file = tmpfile();
+    is_written = voronoi_output_edges(file, &dcel);
+    assert(is_written);
+    count = read_lines(file, lines, 32);
+    assert(count == 1 + 8 + 8);
+    size_t sides = 0;
+    for (size_t i = 1; i < count; i++)
+    {
+        assert(NULL == strstr(lines[i], ",,\n") && NULL == strstr(lines[i], ",,,"));
+        size_t site;
+        char comma;
+        int scanned = sscanf(lines[i], "%zu,%c", &site, &comma);
+        assert(2 == scanned);
+        sides += ',' == comma;
+    }
+    assert(sides == 8);
+    dcel_destroy(&dcel);
+}
+
+void test_voronoi_output_dcel()
+{
+    Point_Real_t corners[4];
+    Voronoi_Clip_t clip = voronoi_clip_rectangle(corners, -5, -5, 15, 15);
+    DCEL_t dcel = square_diagram(NULL, &clip);
+    FILE *file = tmpfile();
+    uint8_t is_written = voronoi_output_dcel(file, &dcel);
+    assert(is_written);
+    rewind(file);
+
+    // Every link refers to the record at the same position in the edge list
+    size_t vertex_count, half_edge_count, face_count;
+    int scanned = fscanf(file, "dcel %zu %zu %zu\n", &vertex_count, &half_edge_count, &face_count);
+    assert(3 == scanned);
+    assert(vertex_count == dcel.vertex_count && half_edge_count == dcel.half_edge_count && face_count == 5);
+    for (size_t i = 0; i < vertex_count; i++)
+    {
+        double x, y;
+        long long inc_edge;
+        scanned = fscanf(file, "v %lf %lf %lld\n", &x, &y, &inc_edge);
+        assert(3 == scanned);
+        assert(x == dcel.vertices[i]->position.x && y == dcel.vertices[i]->position.y);
+        assert(record_at((void **) dcel.half_edges, inc_edge) == dcel.vertices[i]->inc_edge);
+    }
+    for (size_t i = 0; i < half_edge_count; i++)
+    {
+        long long origin, twin, next, prev, face;
+        scanned = fscanf(file, "h %lld %lld %lld %lld %lld\n", &origin, &twin, &next, &prev, &face);
+        assert(5 == scanned);
+        DCEL_HalfEdge_ptr_t half_edge = dcel.half_edges[i];
+        assert(record_at((void **) dcel.vertices, origin) == half_edge->origin);
+        assert(record_at((void **) dcel.half_edges, twin) == half_edge->twin);
+        assert(record_at((void **) dcel.half_edges, next) == half_edge->next);
+        assert(record_at((void **) dcel.half_edges, prev) == half_edge->prev);
+        assert(record_at((void **) dcel.faces, face) == half_edge->inc_face);
+    }
+    for (size_t i = 0; i < face_count; i++)
+    {
+        unsigned long long x, y;
+        size_t index;
+        long long inc_edge;
+        scanned = fscanf(file, "f %llu %llu %zu %lld\n", &x, &y, &index, &inc_edge);
+        assert(4 == scanned);
+        assert(x == dcel.faces[i]->site.x && y == dcel.faces[i]->site.y && index == i);
+        assert(record_at((void **) dcel.half_edges, inc_edge) == dcel.faces[i]->inc_edge);
+    }
+    int last = fgetc(file);
+    assert(EOF == last);
+    fclose(file);
+    dcel_destroy(&dcel);
+}
+
+void test_voronoi_output_cells()
+{
+    DCEL_t dcel = square_diagram(NULL, NULL);
+    FILE *file = tmpfile();
+    uint8_t is_written = voronoi_output_wkt(file, &dcel);
+    assert(is_written);
+    char lines[32][128];
+    size_t count = read_lines(file, lines, 32);
+    // Only the cell of the inner site is closed
+    assert(count == 1 + 5);
+    assert(0 == strcmp(lines[0], "site,wkt\n"));
+    for (size_t i = 1; i < 5; i++)
+    {
+        assert(NULL != strstr(lines[i], "\"LINESTRING ("));
+    }
+    assert(0 == strncmp(lines[5], "4,\"POLYGON ((", 13));
+    dcel_destroy(&dcel);
+
+    // A clipped cell is a polygon that starts and ends at the same vertex
+    Point_Real_t corners[4];
+    Voronoi_Clip_t clip = voronoi_clip_rectangle(corners, -5, -5, 15, 15);
+    dcel = square_diagram(NULL, &clip);
+    file = tmpfile();
+    is_written = voronoi_output_geojson(file, &dcel);
+    assert(is_written);
+    char text[4096];
+    rewind(file);
+    size_t length = fread(text, 1, sizeof(text) - 1, file);
+    text[length] = '\0';
+    fclose(file);
+    assert(0 == strncmp(text, "{\"type\":\"FeatureCollection\",\"features\":[\n", 40));
+    assert(0 == strcmp(text + length - 4, "\n]}\n"));
+    const char *cursor = text;
+    for (size_t i = 0; i < 5; i++)
+    {
+        char expected[64];
+        snprintf(expected, sizeof(expected), "\"properties\":{\"site\":%zu}", i);
+        cursor = strstr(cursor, expected);
+        assert(cursor);
+        const char *coordinates = strstr(cursor, "\"coordinates\":[[[");
+        assert(coordinates);
+        const char *first = coordinates + 17;
+        const char *end = strstr(first, "]]]");
+        const char *last = end;
+        while (last[-1] != '[') last--;
+        assert(0 == strncmp(first, last, (size_t) (strchr(first, ']') - first)));
+    }
+    assert(NULL == strstr(cursor + 1, "\"properties\""));
+    dcel_destroy(&dcel);
+}
+
+void test_voronoi_output_chunks()
+{
+    // Enough records for several rounds of chunks
+    size_t count = 20000;
+    Point_t *points = malloc(count * sizeof(Point_t));
+    Point_t_ptr *sites = malloc(count * sizeof(Point_t_ptr));
+    for (size_t i = 0; i < count; i++)
+    {
+        point_init(&points[i], random_next() >> 44, random_next() >> 44);
+        sites[i] = &points[i];
+    }
+    DCEL_t dcel = voronoi_diagram(sites, count);
+    size_t edges = 0;
+    for (size_t i = 0; i < dcel.half_edge_count; i++)
+    {
+        DCEL_HalfEdge_ptr_t half_edge = dcel.half_edges[i];
+        edges += half_edge->inc_face->index < half_edge->twin->inc_face->index;
+    }
+
+    // The lines come out in the order of the half-edges
+    FILE *file = tmpfile();
+    uint8_t is_written = voronoi_output_edges(file, &dcel);
+    assert(is_written);
+    rewind(file);
+    char line[256];
+    char *header = fgets(line, sizeof(line), file);
+    assert(header);
+    size_t lines = 0;
+    size_t i = 0;
+    while (fgets(line, sizeof(line), file))
+    {
+        size_t site, neighbour;
+        int scanned = sscanf(line, "%zu,%zu,", &site, &neighbour);
+        assert(2 == scanned);
+        while (dcel.half_edges[i]->inc_face->index > dcel.half_edges[i]->twin->inc_face->index) i++;
+        assert(site == dcel.half_edges[i]->inc_face->index);
+        assert(neighbour == dcel.half_edges[i]->twin->inc_face->index);
+        i++;
+        lines++;
+    }
+    fclose(file);
+    assert(lines == edges);
+    dcel_destroy(&dcel);
+    free(sites);
+    free(points);
+}
+
+void test_voronoi_output_delaunay()
+{
+    Delaunay_t delaunay;
+    delaunay_init(&delaunay);
+    DCEL_t dcel = square_diagram(&delaunay, NULL);
+    FILE *file = tmpfile();
+    uint8_t is_written = voronoi_output_delaunay(file, &delaunay);
+    assert(is_written);
+    char lines[32][128];
+    size_t count = read_lines(file, lines, 32);
+    assert(count == 1 + delaunay.count);
+    for (size_t t = 0; t < delaunay.count; t++)
+    {
+        unsigned a, b, c;
+        int scanned = sscanf(lines[1 + t], "%u,%u,%u", &a, &b, &c);
+        assert(3 == scanned);
+        assert(a == delaunay.triangles[3 * t] && b == delaunay.triangles[3 * t + 1] &&
+               c == delaunay.triangles[3 * t + 2]);
+    }
+    delaunay_destroy(&delaunay);
+    dcel_destroy(&dcel);
+}
+
+int main(int argc, char *argv[])
+{
+    test_voronoi_output_double();
+    test_voronoi_output_edges();
+    test_voronoi_output_dcel();
+    test_voronoi_output_cells();
+    test_voronoi_output_chunks();
+    test_voronoi_output_delaunay();
+}
@@ -0,0 +1,206 @@
+//
+// Sorting and deduplication of the sites before the sweep
+//
+
+#include <stdlib.h>
+#include <string.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+#include "VoronoiSites.h"
+#include "VoronoiTrace.h"
+
+// The number of sites in a run that one thread sorts on its own before the runs are merged
+#define VORONOI_SITES_RUN 4096
+
+/**
+ * Initializes an empty set of sites
+ *
+ * @param self the sites handle
+ */
+void voronoi_sites_init(Voronoi_Sites_t *self)
+{
+    memset(self, 0, sizeof(Voronoi_Sites_t));
+}
+
+/**
+ * Orders two sort keys: the higher site first, then the one to the left, then the heavier one if the sites are weighted,
+ * then the one of the lower input index
+ */
+static int voronoi_site_key_compare(const void *first, const void *second)
+{
+    const Voronoi_Site_Key_t *a = (const Voronoi_Site_Key_t *) first;
+    const Voronoi_Site_Key_t *b = (const Voronoi_Site_Key_t *) second;
+    if (a->y != b->y) return a->y > b->y ? -1 : 1;
+    if (a->x != b->x) return a->x < b->x ? -1 : 1;
+#ifdef VORONOI_WEIGHTED
+    if (a->weight != b->weight) return a->weight > b->weight ? -1 : 1;
+#endif
+    if (a->index != b->index) return a->index < b->index ? -1 : 1;
+    return 0;
+}
+
+/**
+ * Merges the sorted ranges [begin, middle) and [middle, end) of source into the same range of target
+ */
+static void voronoi_sites_merge(const Voronoi_Site_Key_t *source, size_t begin, size_t middle, size_t end,
+                                Voronoi_Site_Key_t *target)
+{
+    size_t left = begin;
+    size_t right = middle;
+    for (size_t i = begin; i < end; i++)
+    {
+        if (right == end || (left < middle && voronoi_site_key_compare(&source[left], &source[right]) <= 0))
+        {
+            target[i] = source[left++];
+        }
+        else
+        {
+            target[i] = source[right++];
+        }
+    }
+}
+
+/**
+ * Grows the arrays of self to hold the given number of points
+ *
+ * @param self the sites handle
+ * @param count the number of points
+ * @return 1 on success, 0 if the memory could not be allocated
+ */
+static uint8_t voronoi_sites_reserve(Voronoi_Sites_t *self, size_t count)
+{
+    if (count <= self->capacity && self->sites) return 1;
+    Point_t_ptr *sites = realloc(self->sites, (count + 1) * sizeof(Point_t_ptr));
+    if (NULL == sites) return 0;
+    self->sites = sites;
+    size_t **indices[2] = {&self->indices, &self->unique};
+    for (size_t i = 0; i < 2; i++)
+    {
+        size_t *array = realloc(*indices[i], (count + 1) * sizeof(size_t));
+        if (NULL == array) return 0;
+        *indices[i] = array;
+    }
+    Voronoi_Site_Key_t **keys[2] = {&self->keys, &self->scratch};
+    for (size_t i = 0; i < 2; i++)
+    {
+        Voronoi_Site_Key_t *array = realloc(*keys[i], (count + 1) * sizeof(Voronoi_Site_Key_t));
+        if (NULL == array) return 0;
+        *keys[i] = array;
+    }
+    self->capacity = count;
+    return 1;
+}
+
+/**
+ * Sorts the points into sweep order and drops the duplicates. Large inputs are sorted in parallel, unless the caller
+ * already runs in a parallel region, such as the tiled engine with one sweep per thread.
+ * The memory of self is reused, so the same handle can be passed for one input after another
+ *
+ * Every thread sorts runs of VORONOI_SITES_RUN sites, then the runs are merged pairwise, all pairs of one pass
+ * in parallel. The duplicates are next to each other afterwards and a single pass drops them.
+ *
+ * @param self the sites handle
+ * @param points the points array
+ * @param count the number of points inside the array
+ * @return 1 on success, 0 if the memory could not be allocated
+ */
+uint8_t voronoi_sites_prepare(Voronoi_Sites_t *self, Point_t_ptr *points, size_t count)
+{
+    if (! voronoi_sites_reserve(self, count)) return 0;
+    self->input_count = count;
+    Voronoi_Site_Key_t *keys = self->keys;
+    Voronoi_Site_Key_t *scratch = self->scratch;
+    size_t runs = (count + VORONOI_SITES_RUN - 1) / VORONOI_SITES_RUN;
+#ifdef _OPENMP
+    uint8_t is_parallel = runs > 1 && ! omp_in_parallel();
+#else
+    uint8_t is_parallel = 0;
+#endif
+
+    #pragma omp parallel if (is_parallel) default(none) shared(points, count, runs, keys, scratch)
+    {
+        voronoi_trace_begin("sites_sort");
+        #pragma omp for schedule(static)
+        for (size_t run = 0; run < runs; run++)
+        {
+            size_t begin = run * VORONOI_SITES_RUN;
+            size_t end = begin + VORONOI_SITES_RUN < count ? begin + VORONOI_SITES_RUN : count;
+            for (size_t i = begin; i < end; i++)
+            {
+#ifdef VORONOI_WEIGHTED
+                keys[i].y = (double) points[i]->y + points[i]->weight;
+                keys[i].weight = points[i]->weight;
+#else
+                keys[i].y = points[i]->y;
+#endif
+                keys[i].x = points[i]->x;
+                keys[i].index = i;
+            }
+            qsort(&keys[begin], end - begin, sizeof(Voronoi_Site_Key_t), voronoi_site_key_compare);
+        }
+        // Every thread swaps its copies of the buffers after each pass, so they agree on the source of the next one
+        Voronoi_Site_Key_t *source = keys;
+        Voronoi_Site_Key_t *target = scratch;
+        for (size_t width = VORONOI_SITES_RUN; width < count; width *= 2)
+        {
+            size_t pairs = (count + 2 * width - 1) / (2 * width);
+            #pragma omp for schedule(static)
+            for (size_t pair = 0; pair < pairs; pair++)
+            {
+                size_t begin = 2 * width * pair;
+                size_t middle = begin + width < count ? begin + width : count;
+                size_t end = middle + width < count ? middle + width : count;
+                voronoi_sites_merge(source, begin, middle, end, target);
+            }
+            Voronoi_Site_Key_t *swap = source;
+            source = target;
+            target = swap;
+        }
+        voronoi_trace_end("sites_sort");
+    }
+
+    // An odd number of merge passes leaves the result in the scratch space
+    size_t passes = 0;
+    for (size_t width = VORONOI_SITES_RUN; width < count; width *= 2) passes++;
+    const Voronoi_Site_Key_t *sorted = passes % 2 ? scratch : keys;
+
+    size_t distinct = 0;
+    for (size_t k = 0; k < count; k++)
+    {
+#ifdef VORONOI_WEIGHTED
+        // Equal points of different weights stay apart, the sweep hides all but the heaviest one
+        uint8_t is_distinct = 0 == k || sorted[k].x != sorted[k - 1].x || sorted[k].weight != sorted[k - 1].weight ||
+                              points[sorted[k].index]->y != points[sorted[k - 1].index]->y;
+#else
+        uint8_t is_distinct = 0 == k || sorted[k].x != sorted[k - 1].x || sorted[k].y != sorted[k - 1].y;
+#endif
+        if (is_distinct)
+        {
+            self->sites[distinct] = points[sorted[k].index];
+            self->indices[distinct] = sorted[k].index;
+            distinct++;
+        }
+        self->unique[sorted[k].index] = distinct - 1;
+    }
+    self->count = distinct;
+    return 1;
+}
+
+/**
+ * Frees the arrays of self. The sites are empty afterwards
+ *
+ * @param self the sites handle
+ */
+void voronoi_sites_destroy(Voronoi_Sites_t *self)
+{
+    if (self)
+    {
+        free(self->sites);
+        free(self->indices);
+        free(self->unique);
+        free(self->keys);
+        free(self->scratch);
+        voronoi_sites_init(self);
+    }
+}
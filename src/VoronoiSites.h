@@ -0,0 +1,71 @@
+//
+// Sorting and deduplication of the sites before the sweep
+//
+
+#ifndef VORONOI_VORONOISITES_H
+#define VORONOI_VORONOISITES_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "Point.h"
+
+/**
+ * The sort key of a site: the sweep visits the higher sites first and the sites of one row from left to right.
+ * Equal points are ordered by their input index, so the order is the same on every run and any number of threads.
+ * Weighted sites are visited at the height of their site event, their y coordinate plus their weight, and the
+ * heaviest of the sites at the same point comes first.
+ */
+typedef struct {
+#ifdef VORONOI_WEIGHTED
+    double y; // The height of the site event
+    double weight;
+#else
+    uint64_t y;
+#endif
+    uint64_t x;
+    size_t index; // The input index of the site
+} Voronoi_Site_Key_t;
+
+/**
+ * The distinct sites of an input in the order of the sweep.
+ *
+ * The first occurrence of a point represents all of its duplicates: sites[j] is the input point indices[j],
+ * and unique[i] is the position j of the representative of input point i. The duplicates get empty cells.
+ */
+typedef struct {
+    Point_t_ptr *sites; // The distinct sites in sweep order
+    size_t *indices; // The input index of each distinct site
+    size_t *unique; // The position in sites of each input point
+    size_t count; // The number of distinct sites
+    size_t input_count; // The number of input points
+    size_t capacity; // The number of input points that fit into the arrays
+    Voronoi_Site_Key_t *keys; // Scratch space of the sort
+    Voronoi_Site_Key_t *scratch; // Scratch space of the sort
+} Voronoi_Sites_t;
+
+/**
+ * Initializes an empty set of sites
+ *
+ * @param self the sites handle
+ */
+void voronoi_sites_init(Voronoi_Sites_t *self);
+
+/**
+ * Sorts the points into sweep order and drops the duplicates. Large inputs are sorted in parallel.
+ * The memory of self is reused, so the same handle can be passed for one input after another
+ *
+ * @param self the sites handle
+ * @param points the points array
+ * @param count the number of points inside the array
+ * @return 1 on success, 0 if the memory could not be allocated
+ */
+uint8_t voronoi_sites_prepare(Voronoi_Sites_t *self, Point_t_ptr *points, size_t count);
+
+/**
+ * Frees the arrays of self. The sites are empty afterwards
+ *
+ * @param self the sites handle
+ */
+void voronoi_sites_destroy(Voronoi_Sites_t *self);
+
+#endif //VORONOI_VORONOISITES_H
@@ -0,0 +1,36 @@
+//
+// Counters of the work done by the sweep
+//
+
+#ifndef VORONOI_VORONOISTATS_H
+#define VORONOI_VORONOISTATS_H
+
+#include <stdint.h>
+
+/**
+ * The counters of one sweep. They are only maintained if the library is compiled with VORONOI_STATS defined,
+ * otherwise the counting compiles to nothing and the counters stay zero.
+ */
+typedef struct {
+    uint64_t site_events; // The number of site events processed
+    uint64_t circle_events; // The number of circle events processed
+    uint64_t false_alarms; // The number of circle events that were invalidated before they fired
+    uint64_t queue_high_water; // The largest number of events in the queue at once
+    uint64_t event_comparisons; // The number of calls of the event comparator, which breaks ties in height
+    uint64_t tree_max_height; // The largest height of the beach line tree
+    uint64_t tree_rotations; // The number of rotations performed to balance the beach line tree
+    uint64_t queue_bytes; // The bytes allocated for the heap of the queue
+    uint64_t event_bytes; // The bytes allocated for events
+    uint64_t beach_line_bytes; // The bytes allocated for arcs, breakpoints and tree nodes
+    uint64_t dcel_bytes; // The bytes reserved for the records of the edge list
+} Voronoi_Stats_t;
+
+#ifdef VORONOI_STATS
+#define VORONOI_STATS_ADD(counter, amount) ((counter) += (amount))
+#define VORONOI_STATS_MAX(counter, value) do { if ((uint64_t) (value) > (counter)) (counter) = (uint64_t) (value); } while (0)
+#else
+#define VORONOI_STATS_ADD(counter, amount)
+#define VORONOI_STATS_MAX(counter, value)
+#endif
+
+#endif //VORONOI_VORONOISTATS_H
@@ -0,0 +1,673 @@
+//
+// Tiled construction of large Voronoi diagrams
+//
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include "VoronoiTiles.h"
+#include "VoronoiTrace.h"
+
+// The width of the first halo around a tile, in multiples of the average distance between the points
+#define VORONOI_TILES_HALO 4
+// The number of points per bucket of the grid that locates the points
+#define VORONOI_TILES_BUCKET 32
+// A halo may take in up to 1 / VORONOI_TILES_SHARE of the points beyond its box before the tiles give up
+#define VORONOI_TILES_SHARE 4
+// The relative error allowed for the circle around a vertex, which is computed in floating point
+#define VORONOI_TILES_TOLERANCE 1e-9
+
+/**
+ * An axis-aligned rectangle
+ */
+typedef struct {
+    double min_x;
+    double min_y;
+    double max_x;
+    double max_y;
+} Voronoi_Tiles_Box_t;
+
+/**
+ * The points sorted into a grid of buckets, and the tiles as blocks of tile_span x tile_span buckets
+ */
+typedef struct {
+    Point_t_ptr *points;
+    size_t count;
+    Voronoi_Tiles_Box_t bounds; // The bounding box of the points
+    size_t columns; // The number of columns of buckets
+    size_t rows;
+    size_t *offsets; // The points of bucket b are indices[offsets[b]] up to, but excluding, indices[offsets[b + 1]]
+    size_t *indices;
+    Voronoi_Tiles_Box_t *extents; // The bounding box of the points of every bucket
+    size_t tile_span; // The number of buckets along the sides of a tile
+    size_t tile_columns;
+    size_t tile_rows;
+    size_t *owners; // The tile of every point
+    double margin; // The width of the first halo
+    Voronoi_Queue_t queue;
+} Voronoi_Tiles_t;
+
+/**
+ * A growable list of point indices
+ */
+typedef struct {
+    size_t *items;
+    size_t count;
+    size_t capacity;
+    uint8_t is_broken; // Set once an item could not be added
+} Voronoi_Tiles_List_t;
+
+/**
+ * The points that are swept together with a tile: the points in a box around the tile, and the points outside
+ * the box that turned out to reach into the cells of the tile
+ */
+typedef struct {
+    Voronoi_Tiles_Box_t box;
+    Voronoi_Tiles_List_t extras; // The points outside the box that belong to the halo
+    Voronoi_Tiles_List_t found; // The points found since the last sweep
+    uint8_t *marks; // A bit per point, set for the points of extras and found
+} Voronoi_Tiles_Halo_t;
+
+/**
+ * A circle or a half-plane that must not hold a point outside the halo, see voronoi_tiles_scan
+ */
+typedef struct {
+    uint8_t is_circle;
+    Point_Real_t center; // The center of the circle or a point on the border of the half-plane
+    double radius;
+    Point_Real_t normal; // The direction into the half-plane
+} Voronoi_Tiles_Region_t;
+
+/**
+ * Finds the column or row of the grid that holds a coordinate
+ *
+ * @param value the coordinate
+ * @param min the smallest coordinate of the points
+ * @param max the largest coordinate of the points
+ * @param count the number of columns or rows
+ * @return the column or row
+ */
+static size_t voronoi_tiles_slot(double value, double min, double max, size_t count)
+{
+    if (max <= min || value <= min) return 0;
+    if (value >= max) return count - 1;
+    size_t slot = (size_t) ((value - min) / (max - min) * (double) count);
+    return slot < count ? slot : count - 1;
+}
+
+/**
+ * Splits a rectangle into about count squares
+ *
+ * @param width the width of the rectangle
+ * @param height the height of the rectangle
+ * @param count the number of squares
+ * @param columns receives the number of columns
+ * @param rows receives the number of rows
+ */
+static void voronoi_tiles_shape(double width, double height, double count, size_t *columns, size_t *rows)
+{
+    double side = sqrt(width * height / count);
+    double column_count = side > 0 ? ceil(width / side) : width > 0 ? ceil(count) : 1;
+    double row_count = side > 0 ? ceil(height / side) : height > 0 ? ceil(count) : 1;
+    *columns = column_count < 1 ? 1 : (size_t) column_count;
+    *rows = row_count < 1 ? 1 : (size_t) row_count;
+}
+
+static void voronoi_tiles_box_add(Voronoi_Tiles_Box_t *box, double x, double y)
+{
+    if (x < box->min_x) box->min_x = x;
+    if (y < box->min_y) box->min_y = y;
+    if (x > box->max_x) box->max_x = x;
+    if (y > box->max_y) box->max_y = y;
+}
+
+static uint8_t voronoi_tiles_box_covers(const Voronoi_Tiles_Box_t *box, const Voronoi_Tiles_Box_t *other)
+{
+    return box->min_x <= other->min_x && box->min_y <= other->min_y &&
+           box->max_x >= other->max_x && box->max_y >= other->max_y;
+}
+
+static uint8_t voronoi_tiles_box_holds(const Voronoi_Tiles_Box_t *box, double x, double y)
+{
+    return x >= box->min_x && y >= box->min_y && x <= box->max_x && y <= box->max_y;
+}
+
+static void voronoi_tiles_list_add(Voronoi_Tiles_List_t *list, size_t item)
+{
+    if (list->count == list->capacity)
+    {
+        size_t capacity = list->capacity ? 2 * list->capacity : 64;
+        size_t *items = realloc(list->items, capacity * sizeof(size_t));
+        if (NULL == items)
+        {
+            list->is_broken = 1;
+            return;
+        }
+        list->items = items;
+        list->capacity = capacity;
+    }
+    list->items[list->count++] = item;
+}
+
+/**
+ * Makes the points that were found since the last sweep part of the halo
+ *
+ * @param halo the halo
+ */
+static void voronoi_tiles_halo_extend(Voronoi_Tiles_Halo_t *halo)
+{
+    for (size_t i = 0; i < halo->found.count; i++)
+    {
+        voronoi_tiles_list_add(&halo->extras, halo->found.items[i]);
+    }
+    halo->found.count = 0;
+}
+
+static uint8_t voronoi_tiles_region_holds(const Voronoi_Tiles_Region_t *region, double x, double y)
+{
+    double dx = x - region->center.x;
+    double dy = y - region->center.y;
+    if (region->is_circle) return dx * dx + dy * dy < region->radius * region->radius;
+    return dx * region->normal.x + dy * region->normal.y > 0;
+}
+
+/**
+ * Returns whether the region can hold a point of the box
+ */
+static uint8_t voronoi_tiles_region_meets(const Voronoi_Tiles_Region_t *region, const Voronoi_Tiles_Box_t *box)
+{
+    if (region->is_circle)
+    {
+        double x = fmin(fmax(region->center.x, box->min_x), box->max_x);
+        double y = fmin(fmax(region->center.y, box->min_y), box->max_y);
+        return voronoi_tiles_region_holds(region, x, y);
+    }
+    // A half-plane meets the box in the corner farthest along its normal, if at all
+    double x = region->normal.x > 0 ? box->max_x : box->min_x;
+    double y = region->normal.y > 0 ? box->max_y : box->min_y;
+    return voronoi_tiles_region_holds(region, x, y);
+}
+
+/**
+ * Finds the horizontal extent of the region within a row of the grid
+ *
+ * @param region the region
+ * @param min_y the bottom of the row
+ * @param max_y the top of the row
+ * @param min_x receives the left end of the extent
+ * @param max_x receives the right end of the extent
+ * @return 1 if the region reaches into the row, 0 otherwise
+ */
+static uint8_t voronoi_tiles_region_span(const Voronoi_Tiles_Region_t *region, double min_y, double max_y,
+                                         double *min_x, double *max_x)
+{
+    *min_x = -INFINITY;
+    *max_x = INFINITY;
+    if (region->is_circle)
+    {
+        double dy = fmax(0, fmax(min_y - region->center.y, region->center.y - max_y));
+        if (dy >= region->radius) return 0;
+        double half_width = sqrt(region->radius * region->radius - dy * dy);
+        *min_x = region->center.x - half_width;
+        *max_x = region->center.x + half_width;
+        return 1;
+    }
+    // The half-plane holds x with (x - c.x) * n.x > -(y - c.y) * n.y, which is loosest at one of the ends of the row
+    double rise = fmax((min_y - region->center.y) * region->normal.y, (max_y - region->center.y) * region->normal.y);
+    if (0 == region->normal.x) return rise > 0;
+    double border = region->center.x - rise / region->normal.x;
+    if (region->normal.x > 0) *min_x = border;
+    else *max_x = border;
+    return 1;
+}
+
+/**
+ * Looks for points outside the halo that lie in the region. Only the buckets in the given box are visited,
+ * and of those only the ones whose points are not all in the box of the halo and can meet the region. The points
+ * are added to the found points of the halo
+ *
+ * @param tiles the grid
+ * @param halo the halo
+ * @param region the region
+ * @param box a box around the part of the region among the points
+ * @return 1 if there are none, 0 otherwise
+ */
+static void voronoi_tiles_scan(const Voronoi_Tiles_t *tiles, Voronoi_Tiles_Halo_t *halo,
+                                  const Voronoi_Tiles_Region_t *region, const Voronoi_Tiles_Box_t *box)
+{
+    const Voronoi_Tiles_Box_t *bounds = &tiles->bounds;
+    if (box->max_x < bounds->min_x || box->max_y < bounds->min_y || box->min_x > bounds->max_x ||
+        box->min_y > bounds->max_y) return;
+    double height = (bounds->max_y - bounds->min_y) / (double) tiles->rows;
+    size_t first_row = voronoi_tiles_slot(box->min_y, bounds->min_y, bounds->max_y, tiles->rows);
+    size_t last_row = voronoi_tiles_slot(box->max_y, bounds->min_y, bounds->max_y, tiles->rows);
+    for (size_t row = first_row; row <= last_row; row++)
+    {
+        double min_x, max_x;
+        double min_y = bounds->min_y + (double) row * height;
+        if (! voronoi_tiles_region_span(region, min_y, min_y + height, &min_x, &max_x)) continue;
+        min_x = fmax(min_x, box->min_x);
+        max_x = fmin(max_x, box->max_x);
+        if (min_x > max_x) continue;
+        size_t first_column = voronoi_tiles_slot(min_x, bounds->min_x, bounds->max_x, tiles->columns);
+        size_t last_column = voronoi_tiles_slot(max_x, bounds->min_x, bounds->max_x, tiles->columns);
+        for (size_t column = first_column; column <= last_column; column++)
+        {
+            size_t bucket = row * tiles->columns + column;
+            const Voronoi_Tiles_Box_t *extent = &tiles->extents[bucket];
+            if (tiles->offsets[bucket] == tiles->offsets[bucket + 1] || voronoi_tiles_box_covers(&halo->box, extent) ||
+                ! voronoi_tiles_region_meets(region, extent)) continue;
+            for (size_t k = tiles->offsets[bucket]; k < tiles->offsets[bucket + 1]; k++)
+            {
+                size_t index = tiles->indices[k];
+                double x = (double) tiles->points[index]->x;
+                double y = (double) tiles->points[index]->y;
+                if (voronoi_tiles_box_holds(&halo->box, x, y)) continue;
+                if (halo->marks[index >> 3] & (1 << (index & 7))) continue;
+                if (! voronoi_tiles_region_holds(region, x, y)) continue;
+                voronoi_tiles_list_add(&halo->found, index);
+                if (! halo->found.is_broken) halo->marks[index >> 3] |= (uint8_t) (1 << (index & 7));
+            }
+        }
+    }
+}
+
+/**
+ * Looks for points outside the halo inside the circle around a vertex
+ *
+ * @param tiles the grid
+ * @param halo the halo
+ * @param center the vertex
+ * @param radius the distance of the vertex from its sites
+ */
+static void voronoi_tiles_check_circle(const Voronoi_Tiles_t *tiles, Voronoi_Tiles_Halo_t *halo,
+                                       Point_Real_t center, double radius)
+{
+    Voronoi_Tiles_Region_t region;
+    memset(&region, 0, sizeof(Voronoi_Tiles_Region_t));
+    region.is_circle = 1;
+    region.center = center;
+    region.radius = radius * (1 + VORONOI_TILES_TOLERANCE);
+    Voronoi_Tiles_Box_t box = {
+        center.x - region.radius, center.y - region.radius, center.x + region.radius, center.y + region.radius
+    };
+    if (voronoi_tiles_box_covers(&halo->box, &box)) return;
+    voronoi_tiles_scan(tiles, halo, &region, &box);
+}
+
+/**
+ * Looks for points outside the halo in a half-plane. Only the part of the half-plane that overlaps the bounding box
+ * of the points is searched
+ *
+ * @param tiles the grid
+ * @param halo the halo
+ * @param anchor a point on the border of the half-plane
+ * @param normal the direction into the half-plane
+ */
+static void voronoi_tiles_check_half_plane(const Voronoi_Tiles_t *tiles, Voronoi_Tiles_Halo_t *halo,
+                                           Point_Real_t anchor, Point_Real_t normal)
+{
+    const Voronoi_Tiles_Box_t *bounds = &tiles->bounds;
+    Point_Real_t corners[4] = {
+        {bounds->min_x, bounds->min_y}, {bounds->max_x, bounds->min_y},
+        {bounds->max_x, bounds->max_y}, {bounds->min_x, bounds->max_y}
+    };
+    // Walk the sides of the bounding box and keep the corners and crossings on the inner side of the border
+    Voronoi_Tiles_Box_t box = {INFINITY, INFINITY, -INFINITY, -INFINITY};
+    for (size_t i = 0; i < 4; i++)
+    {
+        Point_Real_t from = corners[i];
+        Point_Real_t to = corners[(i + 1) % 4];
+        double from_side = (from.x - anchor.x) * normal.x + (from.y - anchor.y) * normal.y;
+        double to_side = (to.x - anchor.x) * normal.x + (to.y - anchor.y) * normal.y;
+        if (from_side >= 0) voronoi_tiles_box_add(&box, from.x, from.y);
+        if ((from_side < 0) != (to_side < 0))
+        {
+            double t = from_side / (from_side - to_side);
+            voronoi_tiles_box_add(&box, from.x + t * (to.x - from.x), from.y + t * (to.y - from.y));
+        }
+    }
+    if (box.min_x > box.max_x || voronoi_tiles_box_covers(&halo->box, &box)) return;
+    Voronoi_Tiles_Region_t region;
+    memset(&region, 0, sizeof(Voronoi_Tiles_Region_t));
+    region.center = anchor;
+    region.normal = normal;
+    voronoi_tiles_scan(tiles, halo, &region, &box);
+}
+
+/**
+ * Looks for points outside the halo that can change the cell of a face. A vertex is final if its empty circle holds
+ * no such point. Points beyond an unbounded edge would cut it off, so the half-plane that the circles along the edge
+ * sweep out must not hold one either. The cell is final if no point is found
+ *
+ * @param tiles the grid
+ * @param halo the halo that the diagram of the face was computed with
+ * @param face the face
+ */
+static void voronoi_tiles_check_cell(const Voronoi_Tiles_t *tiles, Voronoi_Tiles_Halo_t *halo, DCEL_Face_ptr_t face)
+{
+    DCEL_HalfEdge_ptr_t start = face->inc_edge;
+    if (! start) return;
+    Point_Real_t site = {(double) face->site.x, (double) face->site.y};
+    DCEL_HalfEdge_ptr_t half_edge = start;
+    do
+    {
+        DCEL_Vertex_ptr_t origin = half_edge->origin;
+        DCEL_Vertex_ptr_t target = half_edge->twin->origin;
+        if (origin)
+        {
+            double radius = hypot(origin->position.x - site.x, origin->position.y - site.y);
+            voronoi_tiles_check_circle(tiles, halo, origin->position, radius);
+        }
+        if (! origin || ! target)
+        {
+            // The face lies to the left of the half-edge, which thus runs along (-v.y, v.x) for the offset v
+            // to the neighbour. An edge without vertices extends to both sides
+            Point_t neighbour = half_edge->twin->inc_face->site;
+            double offset_x = (double) neighbour.x - site.x;
+            double offset_y = (double) neighbour.y - site.y;
+            Point_Real_t ahead = {-offset_y, offset_x};
+            Point_Real_t behind = {offset_y, -offset_x};
+            if (! target) voronoi_tiles_check_half_plane(tiles, halo, site, ahead);
+            if (! origin) voronoi_tiles_check_half_plane(tiles, halo, site, behind);
+        }
+        half_edge = half_edge->next;
+    } while (half_edge && half_edge != start);
+}
+
+/**
+ * Adds the points of a bucket that lie in a box to the sites
+ *
+ * @return the number of sites afterwards
+ */
+static size_t voronoi_tiles_gather(const Voronoi_Tiles_t *tiles, const Voronoi_Tiles_Box_t *box, size_t bucket,
+                                   Point_t_ptr *sites, size_t *indices, size_t count)
+{
+    uint8_t is_inside = voronoi_tiles_box_covers(box, &tiles->extents[bucket]);
+    for (size_t k = tiles->offsets[bucket]; k < tiles->offsets[bucket + 1]; k++)
+    {
+        Point_t_ptr point = tiles->points[tiles->indices[k]];
+        double x = (double) point->x;
+        double y = (double) point->y;
+        if (! is_inside && ! voronoi_tiles_box_holds(box, x, y)) continue;
+        sites[count] = point;
+        indices[count++] = tiles->indices[k];
+    }
+    return count;
+}
+
+/**
+ * Sweeps the points in a halo. The faces get the indices of their points in the whole input
+ *
+ * @param tiles the grid
+ * @param halo the halo
+ * @param sites receives the points of the halo, room for all points
+ * @param indices receives their indices, room for all points
+ * @return the diagram of the points in the halo
+ */
+static DCEL_t voronoi_tiles_sweep(const Voronoi_Tiles_t *tiles, const Voronoi_Tiles_Halo_t *halo, Point_t_ptr *sites,
+                                  size_t *indices)
+{
+    const Voronoi_Tiles_Box_t *bounds = &tiles->bounds;
+    const Voronoi_Tiles_Box_t *box = &halo->box;
+    size_t first_column = voronoi_tiles_slot(box->min_x, bounds->min_x, bounds->max_x, tiles->columns);
+    size_t last_column = voronoi_tiles_slot(box->max_x, bounds->min_x, bounds->max_x, tiles->columns);
+    size_t first_row = voronoi_tiles_slot(box->min_y, bounds->min_y, bounds->max_y, tiles->rows);
+    size_t last_row = voronoi_tiles_slot(box->max_y, bounds->min_y, bounds->max_y, tiles->rows);
+    size_t count = 0;
+    for (size_t row = first_row; row <= last_row; row++)
+    {
+        for (size_t column = first_column; column <= last_column; column++)
+        {
+            count = voronoi_tiles_gather(tiles, box, row * tiles->columns + column, sites, indices, count);
+        }
+    }
+    for (size_t i = 0; i < halo->extras.count; i++)
+    {
+        sites[count] = tiles->points[halo->extras.items[i]];
+        indices[count++] = halo->extras.items[i];
+    }
+    Voronoi_Options_t options;
+    memset(&options, 0, sizeof(Voronoi_Options_t));
+    options.queue = tiles->queue;
+    DCEL_t piece = voronoi_diagram_with_options(sites, count, &options);
+    for (size_t i = 0; i < piece.face_count; i++)
+    {
+        piece.faces[i]->index = indices[piece.faces[i]->index];
+    }
+    return piece;
+}
+
+/**
+ * Computes the final cells of the points of a tile. The tile is swept with the points in a box around it, and again
+ * with the points that reached into its cells added, until none do. Most cells are final after the
+ * first sweep; the cells along the border of the input can reach far, but only the points near the border
+ * change them. Cells that face an empty region, e.g. between clusters, can take in whole clusters though,
+ * so a tile gives up once its halo outgrows VORONOI_TILES_SHARE
+ *
+ * @param tiles the grid
+ * @param tile the tile
+ * @param marks scratch room for a cleared bit per point, left cleared
+ * @param sites scratch room for all points
+ * @param indices scratch room for all indices
+ * @param piece receives a diagram that holds the final cells of the points of the tile
+ * @return 1 on success, 0 if the tile gives up or the memory could not be allocated
+ */
+static uint8_t voronoi_tiles_build(const Voronoi_Tiles_t *tiles, size_t tile, uint8_t *marks, Point_t_ptr *sites,
+                                   size_t *indices, DCEL_t *piece)
+{
+    const Voronoi_Tiles_Box_t *bounds = &tiles->bounds;
+    double width = (bounds->max_x - bounds->min_x) / (double) tiles->columns;
+    double height = (bounds->max_y - bounds->min_y) / (double) tiles->rows;
+    size_t first_column = tile % tiles->tile_columns * tiles->tile_span;
+    size_t first_row = tile / tiles->tile_columns * tiles->tile_span;
+    size_t end_column = first_column + tiles->tile_span < tiles->columns ? first_column + tiles->tile_span
+                                                                        : tiles->columns;
+    size_t end_row = first_row + tiles->tile_span < tiles->rows ? first_row + tiles->tile_span : tiles->rows;
+    Voronoi_Tiles_Halo_t halo;
+    memset(&halo, 0, sizeof(Voronoi_Tiles_Halo_t));
+    halo.box.min_x = bounds->min_x + (double) first_column * width - tiles->margin;
+    halo.box.min_y = bounds->min_y + (double) first_row * height - tiles->margin;
+    halo.box.max_x = bounds->min_x + (double) end_column * width + tiles->margin;
+    halo.box.max_y = bounds->min_y + (double) end_row * height + tiles->margin;
+    halo.marks = marks;
+    size_t limit = tiles->count / VORONOI_TILES_SHARE;
+    uint8_t success = 1;
+    while (1)
+    {
+        voronoi_trace_begin("tiles_sweep");
+        *piece = voronoi_tiles_sweep(tiles, &halo, sites, indices);
+        voronoi_trace_end("tiles_sweep");
+        if (voronoi_tiles_box_covers(&halo.box, bounds)) break;
+
+        voronoi_trace_begin("tiles_check");
+        for (size_t i = 0; i < piece->face_count; i++)
+        {
+            DCEL_Face_ptr_t face = piece->faces[i];
+            if (tiles->owners[face->index] == tile) voronoi_tiles_check_cell(tiles, &halo, face);
+        }
+        voronoi_trace_end("tiles_check");
+        if (0 == halo.found.count && ! halo.found.is_broken) break;
+        dcel_destroy(piece);
+        voronoi_tiles_halo_extend(&halo);
+        if (halo.found.is_broken || halo.extras.is_broken || halo.extras.count > limit)
+        {
+            success = 0;
+            break;
+        }
+    }
+    for (size_t i = 0; i < halo.extras.count; i++)
+    {
+        marks[halo.extras.items[i] >> 3] = 0;
+    }
+    for (size_t i = 0; i < halo.found.count; i++)
+    {
+        marks[halo.found.items[i] >> 3] = 0;
+    }
+    free(halo.found.items);
+    free(halo.extras.items);
+    return success;
+}
+
+/**
+ * Sorts the points into the buckets and finds the tile of every point
+ *
+ * @param tiles the grid, with its points and its shape
+ * @param count the number of points
+ * @return 1 on success, 0 if the memory could not be allocated
+ */
+static uint8_t voronoi_tiles_sort(Voronoi_Tiles_t *tiles, size_t count)
+{
+    size_t bucket_count = tiles->columns * tiles->rows;
+    tiles->offsets = calloc(bucket_count + 1, sizeof(size_t));
+    tiles->indices = malloc(count * sizeof(size_t));
+    tiles->owners = malloc(count * sizeof(size_t));
+    tiles->extents = malloc(bucket_count * sizeof(Voronoi_Tiles_Box_t));
+    if (! tiles->offsets || ! tiles->indices || ! tiles->owners || ! tiles->extents) return 0;
+    // The owners hold the buckets of the points until the points are sorted
+    Voronoi_Tiles_t *grid = tiles;
+    #pragma omp parallel for schedule(static) default(none) shared(grid, count)
+    for (size_t i = 0; i < count; i++)
+    {
+        size_t column = voronoi_tiles_slot((double) grid->points[i]->x, grid->bounds.min_x, grid->bounds.max_x,
+                                           grid->columns);
+        size_t row = voronoi_tiles_slot((double) grid->points[i]->y, grid->bounds.min_y, grid->bounds.max_y,
+                                        grid->rows);
+        grid->owners[i] = row * grid->columns + column;
+    }
+    // Count the points of every bucket, sum the counts up to the ends of the buckets and fill every bucket from its
+    // end, which leaves the offsets at the starts
+    for (size_t i = 0; i < count; i++)
+    {
+        tiles->offsets[tiles->owners[i]]++;
+    }
+    for (size_t b = 1; b < bucket_count; b++)
+    {
+        tiles->offsets[b] += tiles->offsets[b - 1];
+    }
+    tiles->offsets[bucket_count] = count;
+    for (size_t i = count; i-- > 0;)
+    {
+        tiles->indices[--tiles->offsets[tiles->owners[i]]] = i;
+    }
+
+    #pragma omp parallel for schedule(static) default(none) shared(grid, bucket_count)
+    for (size_t b = 0; b < bucket_count; b++)
+    {
+        Voronoi_Tiles_Box_t extent = {INFINITY, INFINITY, -INFINITY, -INFINITY};
+        size_t tile = b / grid->columns / grid->tile_span * grid->tile_columns + b % grid->columns / grid->tile_span;
+        for (size_t k = grid->offsets[b]; k < grid->offsets[b + 1]; k++)
+        {
+            size_t i = grid->indices[k];
+            voronoi_tiles_box_add(&extent, (double) grid->points[i]->x, (double) grid->points[i]->y);
+            grid->owners[i] = tile;
+        }
+        grid->extents[b] = extent;
+    }
+    return 1;
+}
+
+/**
+ * Computes the Voronoi diagram for a set of points tile by tile, such that the tiles are swept in parallel.
+ *
+ * The tiles are squares of about tile_sites points on average. Their sweeps run in parallel and every thread reuses
+ * its scratch arrays, while the diagrams of the tiles are only kept until they are merged.
+ *
+ * @param points the points array
+ * @param count the number of points inside the array
+ * @param tile_sites the number of points per tile to aim for, 0 for VORONOI_TILES_SITES
+ * @param options the options of the sweeps, can be NULL. The clip polygon is applied to the merged diagram,
+ *                no Delaunay triangulation is produced and no counters are collected
+ * @return a doubly-connected edge list representing the diagram
+ */
+DCEL_t voronoi_diagram_tiled(Point_t_ptr *points, size_t count, size_t tile_sites, Voronoi_Options_t *options)
+{
+    Voronoi_Options_t sweep_options;
+    memset(&sweep_options, 0, sizeof(Voronoi_Options_t));
+    if (options)
+    {
+        sweep_options.clip = options->clip;
+        sweep_options.queue = options->queue;
+    }
+    if (0 == tile_sites) tile_sites = VORONOI_TILES_SITES;
+#ifdef VORONOI_WEIGHTED
+    // The circles of weighted vertices do not bound the sites that can change them, so there are no tiles
+    tile_sites = count;
+#endif
+    if (count <= tile_sites) return voronoi_diagram_with_options(points, count, &sweep_options);
+
+    Voronoi_Tiles_t tiles;
+    memset(&tiles, 0, sizeof(Voronoi_Tiles_t));
+    tiles.points = points;
+    tiles.count = count;
+    tiles.queue = sweep_options.queue;
+    tiles.bounds.min_x = tiles.bounds.min_y = INFINITY;
+    tiles.bounds.max_x = tiles.bounds.max_y = -INFINITY;
+    for (size_t i = 0; i < count; i++)
+    {
+        voronoi_tiles_box_add(&tiles.bounds, (double) points[i]->x, (double) points[i]->y);
+    }
+    double width = tiles.bounds.max_x - tiles.bounds.min_x;
+    double height = tiles.bounds.max_y - tiles.bounds.min_y;
+    voronoi_tiles_shape(width, height, (double) count / VORONOI_TILES_BUCKET, &tiles.columns, &tiles.rows);
+    tiles.tile_span = (size_t) round(sqrt((double) tile_sites / VORONOI_TILES_BUCKET));
+    if (0 == tiles.tile_span) tiles.tile_span = 1;
+    tiles.tile_columns = (tiles.columns + tiles.tile_span - 1) / tiles.tile_span;
+    tiles.tile_rows = (tiles.rows + tiles.tile_span - 1) / tiles.tile_span;
+    double spacing = width * height > 0 ? sqrt(width * height / (double) count) : fmax(width, height) / (double) count;
+    tiles.margin = VORONOI_TILES_HALO * spacing + 1;
+
+    size_t tile_total = tiles.tile_columns * tiles.tile_rows;
+    DCEL_t merged;
+    dcel_init(&merged);
+    DCEL_t *pieces = calloc(tile_total, sizeof(DCEL_t));
+    uint8_t success = pieces && count < UINT32_MAX && voronoi_tiles_sort(&tiles, count);
+    if (success)
+    {
+        #pragma omp parallel default(none) shared(tiles, pieces, tile_total, count, success)
+        {
+            uint8_t *marks = calloc((count + 7) / 8, sizeof(uint8_t));
+            Point_t_ptr *sites = malloc(count * sizeof(Point_t_ptr));
+            size_t *indices = malloc(count * sizeof(size_t));
+            if (! marks || ! sites || ! indices)
+            {
+                #pragma omp atomic write
+                success = 0;
+            }
+            #pragma omp for schedule(dynamic)
+            for (size_t t = 0; t < tile_total; t++)
+            {
+                uint8_t is_going;
+                #pragma omp atomic read
+                is_going = success;
+                if (is_going && marks && sites && indices &&
+                    ! voronoi_tiles_build(&tiles, t, marks, sites, indices, &pieces[t]))
+                {
+                    #pragma omp atomic write
+                    success = 0;
+                }
+            }
+            free(marks);
+            free(sites);
+            free(indices);
+        }
+        success = success && dcel_merge(&merged, pieces, tile_total, tiles.owners, count);
+    }
+    for (size_t t = 0; pieces && t < tile_total; t++)
+    {
+        dcel_destroy(&pieces[t]);
+    }
+    free(pieces);
+    free(tiles.offsets);
+    free(tiles.indices);
+    free(tiles.extents);
+    free(tiles.owners);
+    if (! success)
+    {
+        // A tile gave up, the tiles disagree on a seam or the memory ran out, all of which a single sweep avoids
+        dcel_destroy(&merged);
+        return voronoi_diagram_with_options(points, count, &sweep_options);
+    }
+    if (sweep_options.clip) voronoi_clip(&merged, sweep_options.clip);
+    return merged;
+}
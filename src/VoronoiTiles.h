@@ -0,0 +1,42 @@
+//
+// Tiled construction of large Voronoi diagrams
+//
+
+#ifndef VORONOI_VORONOITILES_H
+#define VORONOI_VORONOITILES_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "Point.h"
+#include "DCEL.h"
+#include "Voronoi.h"
+
+// The number of sites per tile if none is given
+#define VORONOI_TILES_SITES 65536
+
+/**
+ * Computes the Voronoi diagram for a set of points tile by tile, such that the tiles are swept in parallel.
+ *
+ * The bounding box of the points is split into a grid of tiles with about tile_sites points each. Every tile is swept
+ * together with the points in a halo around it, and a cell of one of its own points is final once the circles around
+ * its vertices, and the half-planes behind its unbounded edges, hold no point outside the halo. A tile with a cell
+ * that is not final is swept again with the points that were found added to its halo. The final cells of all tiles
+ * are merged into one edge list with dcel_merge, so a sweep only ever holds the points of one tile and its halo.
+ *
+ * The result is the diagram of voronoi_diagram_with_options: one face per point in the order of the points,
+ * and the index of each face is the index of its point. Only the vertices on the seams between tiles can differ
+ * in the last bits, where two tiles computed them. The whole diagram is swept at once instead if the tiles disagree
+ * on a seam, which takes several points on a circle that two tiles resolve differently, or if a halo has to take in
+ * a large share of the points, as happens around the empty space between clusters. Built with VORONOI_WEIGHTED,
+ * the diagram is always swept at once.
+ *
+ * @param points the points array
+ * @param count the number of points inside the array
+ * @param tile_sites the number of points per tile to aim for, 0 for VORONOI_TILES_SITES
+ * @param options the options of the sweeps, can be NULL. The clip polygon is applied to the merged diagram,
+ *                no Delaunay triangulation is produced and no counters are collected
+ * @return a doubly-connected edge list representing the diagram
+ */
+DCEL_t voronoi_diagram_tiled(Point_t_ptr *points, size_t count, size_t tile_sites, Voronoi_Options_t *options);
+
+#endif //VORONOI_VORONOITILES_H
@@ -0,0 +1,265 @@
+//
+// Tracing of the phases of the construction in the Chrome trace event format
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+#include "VoronoiTrace.h"
+
+typedef struct {
+    const char *name;
+    double timestamp; // Microseconds since the start of the trace
+    char phase; // 'B' for the begin of a span, 'E' for its end
+} Voronoi_TraceEvent_t;
+
+/**
+ * The events of one thread. Buffers are padded to a cache line, so that threads do not share lines
+ */
+typedef struct {
+    Voronoi_TraceEvent_t *events;
+    size_t count;
+    size_t capacity;
+    char padding[64 - sizeof(Voronoi_TraceEvent_t *) - 2 * sizeof(size_t)];
+} Voronoi_TraceBuffer_t;
+
+// The buffers of all threads that recorded, the one of the thread that started the trace comes first
+static Voronoi_TraceBuffer_t **trace_buffers = NULL;
+static size_t trace_thread_count = 0;
+static size_t trace_thread_capacity = 0;
+static double trace_start = 0;
+// Only changes outside of parallel regions, unlike trace_buffers, which grows while threads register
+static uint8_t trace_is_on = 0;
+// Counts the traces, such that a thread can tell a buffer of an earlier trace from one of the current trace
+static size_t trace_generation = 0;
+
+// The buffer of the calling thread. OpenMP thread numbers repeat across the teams of nested regions, so every
+// thread keeps a pointer to its own buffer instead
+static Voronoi_TraceBuffer_t *trace_local = NULL;
+static size_t trace_local_generation = 0;
+#ifdef _OPENMP
+#pragma omp threadprivate(trace_local, trace_local_generation)
+#endif
+
+static double voronoi_trace_now()
+{
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return (double) time.tv_sec * 1e6 + (double) time.tv_nsec / 1e3;
+}
+
+/**
+ * Allocates a buffer for the calling thread and appends it to the buffers of the trace
+ *
+ * @return the buffer, or NULL if the memory could not be allocated
+ */
+static Voronoi_TraceBuffer_t *voronoi_trace_register()
+{
+    Voronoi_TraceBuffer_t *buffer = calloc(1, sizeof(Voronoi_TraceBuffer_t));
+    if (NULL == buffer) return NULL;
+    uint8_t is_added = 0;
+#ifdef _OPENMP
+#pragma omp critical(voronoi_trace)
+#endif
+    {
+        if (trace_thread_count == trace_thread_capacity)
+        {
+            size_t capacity = trace_thread_capacity ? 2 * trace_thread_capacity : 16;
+            Voronoi_TraceBuffer_t **buffers = realloc(trace_buffers, capacity * sizeof(Voronoi_TraceBuffer_t *));
+            if (buffers)
+            {
+                trace_buffers = buffers;
+                trace_thread_capacity = capacity;
+            }
+        }
+        if (trace_thread_count < trace_thread_capacity)
+        {
+            trace_buffers[trace_thread_count++] = buffer;
+            is_added = 1;
+        }
+    }
+    if (! is_added)
+    {
+        free(buffer);
+        return NULL;
+    }
+    trace_local = buffer;
+    trace_local_generation = trace_generation;
+    return buffer;
+}
+
+/**
+ * Starts recording. Every thread records into its own buffer, which it registers under a lock on its first event,
+ * so recording takes no locks afterwards. While tracing is off, voronoi_trace_begin and voronoi_trace_end return
+ * right away.
+ *
+ * @return 1 on success, 0 if the memory could not be allocated
+ */
+uint8_t voronoi_trace_start()
+{
+    if (trace_buffers) return 1;
+    trace_generation++;
+    trace_start = voronoi_trace_now();
+    // The starting thread registers first, such that its buffer is the one the summary reads
+    if (NULL == voronoi_trace_register())
+    {
+        free(trace_buffers);
+        trace_buffers = NULL;
+        trace_thread_count = 0;
+        trace_thread_capacity = 0;
+        return 0;
+    }
+    trace_is_on = 1;
+    return 1;
+}
+
+/**
+ * Appends an event to the buffer of the calling thread. Events that do not fit into memory anymore are dropped
+ *
+ * @param name the name of the span
+ * @param phase the phase of the event
+ */
+static void voronoi_trace_record(const char *name, char phase)
+{
+    if (! trace_is_on) return;
+    double timestamp = voronoi_trace_now() - trace_start;
+    Voronoi_TraceBuffer_t *buffer = trace_local;
+    if (NULL == buffer || trace_local_generation != trace_generation) buffer = voronoi_trace_register();
+    if (NULL == buffer) return;
+    if (buffer->count == buffer->capacity)
+    {
+        size_t capacity = buffer->capacity ? 2 * buffer->capacity : 256;
+        Voronoi_TraceEvent_t *events = realloc(buffer->events, capacity * sizeof(Voronoi_TraceEvent_t));
+        if (NULL == events) return;
+        buffer->events = events;
+        buffer->capacity = capacity;
+    }
+    Voronoi_TraceEvent_t *event = &buffer->events[buffer->count++];
+    event->name = name;
+    event->timestamp = timestamp;
+    event->phase = phase;
+}
+
+/**
+ * Marks the start of a span on the calling thread
+ *
+ * @param name the name of the span, must outlive the trace, e.g. a string literal
+ */
+void voronoi_trace_begin(const char *name)
+{
+    voronoi_trace_record(name, 'B');
+}
+
+/**
+ * Marks the end of the span on the calling thread that was begun last
+ *
+ * @param name the name of the span
+ */
+void voronoi_trace_end(const char *name)
+{
+    voronoi_trace_record(name, 'E');
+}
+
+/**
+ * Prints the total time spent in each span of the first thread, in the order in which the spans first began.
+ * Recording goes on
+ *
+ * @param file the file
+ */
+void voronoi_trace_summary(FILE *file)
+{
+    if (NULL == trace_buffers) return;
+    Voronoi_TraceBuffer_t *buffer = trace_buffers[0];
+    // The distinct names with their totals, and the spans that are open at the current event
+    const char **names = malloc((buffer->count + 1) * sizeof(const char *));
+    double *totals = malloc((buffer->count + 1) * sizeof(double));
+    double *open = malloc((buffer->count + 1) * sizeof(double));
+    size_t name_count = 0;
+    size_t depth = 0;
+    for (size_t i = 0; names && totals && open && i < buffer->count; i++)
+    {
+        Voronoi_TraceEvent_t *event = &buffer->events[i];
+        if ('B' == event->phase)
+        {
+            open[depth++] = event->timestamp;
+            continue;
+        }
+        if (0 == depth) continue;
+        double duration = event->timestamp - open[--depth];
+        size_t name = 0;
+        while (name < name_count && strcmp(names[name], event->name) != 0) name++;
+        if (name == name_count)
+        {
+            names[name_count] = event->name;
+            totals[name_count++] = 0;
+        }
+        totals[name] += duration;
+    }
+    // The spans end before the ones that enclose them, so order them by their first begin instead
+    for (size_t i = 0; names && totals && open && i < buffer->count; i++)
+    {
+        Voronoi_TraceEvent_t *event = &buffer->events[i];
+        if (event->phase != 'B') continue;
+        for (size_t name = 0; name < name_count; name++)
+        {
+            if (names[name] && 0 == strcmp(names[name], event->name))
+            {
+                fprintf(file, "%-16s %12.3f ms\n", names[name], totals[name] / 1e3);
+                names[name] = NULL;
+                break;
+            }
+        }
+    }
+    free(names);
+    free(totals);
+    free(open);
+}
+
+/**
+ * Stops recording and writes the spans as a JSON trace that can be opened in chrome://tracing or Perfetto.
+ * The buffers are released afterwards
+ *
+ * @param path the path of the trace file
+ * @return 1 on success, 0 if the file could not be written
+ */
+uint8_t voronoi_trace_write(const char *path)
+{
+    if (NULL == trace_buffers) return 0;
+    FILE *file = fopen(path, "w");
+    uint8_t success = file != NULL;
+    if (file)
+    {
+        fprintf(file, "{\"displayTimeUnit\": \"ns\", \"traceEvents\": [\n");
+        const char *separator = "";
+        for (size_t thread = 0; thread < trace_thread_count; thread++)
+        {
+            Voronoi_TraceBuffer_t *buffer = trace_buffers[thread];
+            for (size_t i = 0; i < buffer->count; i++)
+            {
+                Voronoi_TraceEvent_t *event = &buffer->events[i];
+                fprintf(file, "%s{\"name\": \"%s\", \"ph\": \"%c\", \"ts\": %.3f, \"pid\": 1, \"tid\": %zu}",
+                        separator, event->name, event->phase, event->timestamp, thread);
+                separator = ",\n";
+            }
+        }
+        fprintf(file, "\n]}\n");
+        success = 0 == ferror(file);
+        success &= 0 == fclose(file);
+    }
+
+    for (size_t thread = 0; thread < trace_thread_count; thread++)
+    {
+        free(trace_buffers[thread]->events);
+        free(trace_buffers[thread]);
+    }
+    free(trace_buffers);
+    trace_buffers = NULL;
+    trace_thread_count = 0;
+    trace_thread_capacity = 0;
+    trace_is_on = 0;
+    return success;
+}
@@ -0,0 +1,51 @@
+//
+// Tracing of the phases of the construction in the Chrome trace event format
+//
+
+#ifndef VORONOI_VORONOITRACE_H
+#define VORONOI_VORONOITRACE_H
+
+#include <stdio.h>
+#include <stdint.h>
+
+/**
+ * Starts recording. Every thread records into its own buffer, which it registers under a lock on its first event,
+ * so recording takes no locks afterwards. While tracing is off, voronoi_trace_begin and voronoi_trace_end return
+ * right away.
+ *
+ * @return 1 on success, 0 if the memory could not be allocated
+ */
+uint8_t voronoi_trace_start();
+
+/**
+ * Marks the start of a span on the calling thread
+ *
+ * @param name the name of the span, must outlive the trace, e.g. a string literal
+ */
+void voronoi_trace_begin(const char *name);
+
+/**
+ * Marks the end of the span on the calling thread that was begun last
+ *
+ * @param name the name of the span
+ */
+void voronoi_trace_end(const char *name);
+
+/**
+ * Prints the total time spent in each span of the first thread, in the order in which the spans first began.
+ * Recording goes on
+ *
+ * @param file the file
+ */
+void voronoi_trace_summary(FILE *file);
+
+/**
+ * Stops recording and writes the spans as a JSON trace that can be opened in chrome://tracing or Perfetto.
+ * The buffers are released afterwards
+ *
+ * @param path the path of the trace file
+ * @return 1 on success, 0 if the file could not be written
+ */
+uint8_t voronoi_trace_write(const char *path);
+
+#endif //VORONOI_VORONOITRACE_H
@@ -0,0 +1,378 @@
+//
+// Benchmarks for the sweep line construction of the Voronoi diagram
+//
+// Usage: voronoi_bench [--distribution uniform|gaussian|grid|cocircular|all] [--min sites] [--max sites] [--seed seed]
+//                      [--queue heap|radix] [--repeat runs] [--trace path] [--sites path]
+//
+// Runs the sweep for every distribution and every power of ten between min and max sites, 10^3 to 10^6 by default,
+// and prints one JSON record per run. With --trace the phases are also written to a Chrome trace file.
+// With --repeat every input is computed that many times through one workspace instead, and the record holds the
+// percentiles of the latency and the allocations of the last run.
+// With --sites the generated sites are appended to a text file that the voronoi tool reads, and nothing is computed.
+// The training run of a VORONOI_PGO=generate build feeds the tool these files.
+// Build with optimizations, e.g. CMAKE_BUILD_TYPE=Release, for meaningful numbers.
+//
+
+#define _GNU_SOURCE
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static size_t bench_allocations = 0;
+
+static void *voronoi_bench_malloc(size_t size)
+{
+    #pragma omp atomic
+    bench_allocations++;
+    return malloc(size);
+}
+
+static void *voronoi_bench_calloc(size_t count, size_t size)
+{
+    #pragma omp atomic
+    bench_allocations++;
+    return calloc(count, size);
+}
+
+static void *voronoi_bench_realloc(void *block, size_t size)
+{
+    #pragma omp atomic
+    bench_allocations++;
+    return realloc(block, size);
+}
+
+// Count the allocations of the engine, whose sources are compiled into this file
+#define malloc(size) voronoi_bench_malloc(size)
+#define calloc(count, size) voronoi_bench_calloc(count, size)
+#define realloc(block, size) voronoi_bench_realloc(block, size)
+
+#include "Point.c"
+#include "DCEL.c"
+#include "Delaunay.c"
+#include "PQueue.c"
+#include "RadixQueue.c"
+#include "AVLTree.c"
+#include "VoronoiClip.c"
+#include "VoronoiCells.c"
+#include "VoronoiSites.c"
+#include "Voronoi.c"
+#include "Bench.c"
+
+#undef malloc
+#undef calloc
+#undef realloc
+
+// The buffers of the trace do not count as allocations of the engine
+#include "VoronoiTrace.c"
+
+// The sites are placed within [0, BENCH_SPAN) x [0, BENCH_SPAN)
+#define BENCH_SPAN (1ULL << 30)
+
+static uint64_t random_state;
+
+static uint64_t random_next(uint64_t bound)
+{
+    random_state = random_state * 6364136223846793005ULL + 1442695040888963407ULL;
+    return (random_state >> 33) % bound;
+}
+
+static double random_unit(void)
+{
+    return ((double) random_next(1ULL << 30) + 0.5) / (double) (1ULL << 30);
+}
+
+static uint64_t bench_clamp(double coordinate)
+{
+    if (coordinate < 0) return 0;
+    if (coordinate >= (double) (BENCH_SPAN - 1)) return BENCH_SPAN - 1;
+    return (uint64_t) coordinate;
+}
+
+static void generate_uniform(Point_t *points, size_t count)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        point_init(&points[i], random_next(BENCH_SPAN), random_next(BENCH_SPAN));
+    }
+}
+
+/**
+ * Draws the points from normal distributions around sqrt(count) / 4 + 1 random centers, so every cluster holds
+ * about 4 sqrt(count) points
+ */
+static void generate_gaussian(Point_t *points, size_t count)
+{
+    size_t clusters = (size_t) sqrt((double) count) / 4 + 1;
+    double deviation = (double) BENCH_SPAN / (8 * sqrt((double) clusters));
+    Point_Real_t *centers = malloc(clusters * sizeof(Point_Real_t));
+    for (size_t i = 0; i < clusters; i++)
+    {
+        centers[i].x = (double) random_next(BENCH_SPAN);
+        centers[i].y = (double) random_next(BENCH_SPAN);
+    }
+    for (size_t i = 0; i < count; i++)
+    {
+        // Box-Muller transform
+        Point_Real_t center = centers[random_next(clusters)];
+        double radius = deviation * sqrt(-2 * log(random_unit()));
+        double angle = 2 * M_PI * random_unit();
+        point_init(&points[i], bench_clamp(center.x + radius * cos(angle)),
+                   bench_clamp(center.y + radius * sin(angle)));
+    }
+    free(centers);
+}
+
+/**
+ * Places the points on a square grid in random order, which makes four sites co-circular around every vertex
+ */
+static void generate_grid(Point_t *points, size_t count)
+{
+    size_t side = (size_t) ceil(sqrt((double) count));
+    uint64_t spacing = BENCH_SPAN / side;
+    for (size_t i = 0; i < count; i++)
+    {
+        point_init(&points[i], (i % side) * spacing, (i / side) * spacing);
+    }
+    for (size_t i = count; i > 1; i--)
+    {
+        size_t j = random_next(i);
+        Point_t point = points[i - 1];
+        points[i - 1] = points[j];
+        points[j] = point;
+    }
+}
+
+/**
+ * Places the points on concentric circles of 1000 points each. Their coordinates are rounded to integers,
+ * so the sites are co-circular up to rounding, which is the hardest case for the circle events
+ */
+static void generate_cocircular(Point_t *points, size_t count)
+{
+    size_t per_circle = 1000;
+    size_t circles = (count + per_circle - 1) / per_circle;
+    double center = (double) BENCH_SPAN / 2;
+    double offset = 2 * M_PI * random_unit();
+    for (size_t i = 0; i < count; i++)
+    {
+        double radius = center * (double) (i / per_circle + 1) / (double) (circles + 1);
+        double angle = offset + 2 * M_PI * (double) (i % per_circle) / (double) per_circle;
+        point_init(&points[i], bench_clamp(center + radius * cos(angle)), bench_clamp(center + radius * sin(angle)));
+    }
+}
+
+typedef struct {
+    const char *name;
+    void (*generate)(Point_t *points, size_t count);
+} Bench_Distribution_t;
+
+static const Bench_Distribution_t distributions[4] = {
+        {"uniform", generate_uniform},
+        {"gaussian", generate_gaussian},
+        {"grid", generate_grid},
+        {"cocircular", generate_cocircular}
+};
+
+/**
+ * Runs the sweep once over freshly generated points and prints its JSON record
+ */
+static void bench_run(const Bench_Distribution_t *distribution, size_t count, uint64_t seed, Voronoi_Queue_t queue)
+{
+    Point_t *points = malloc(count * sizeof(Point_t));
+    Point_t_ptr *sites = malloc(count * sizeof(Point_t_ptr));
+    if (NULL == points || NULL == sites)
+    {
+        fprintf(stderr, "voronoi_bench: not enough memory for %zu sites\n", count);
+        exit(EXIT_FAILURE);
+    }
+    random_state = seed;
+    distribution->generate(points, count);
+    for (size_t i = 0; i < count; i++)
+    {
+        sites[i] = &points[i];
+    }
+
+    Voronoi_Stats_t stats;
+    Voronoi_Options_t options = {NULL, NULL, &stats, queue};
+    bench_allocations = 0;
+    voronoi_trace_begin(distribution->name);
+    double start = bench_now();
+    DCEL_t dcel;
+    dcel_init(&dcel);
+    Voronoi_Sweep_t sweep;
+    voronoi_sweep_init(&sweep, count);
+    voronoi_sweep_begin(&sweep, sites, count, &dcel, &options);
+    double queue_built = bench_now();
+    voronoi_sweep_events(&sweep);
+    double swept = bench_now();
+    voronoi_sweep_end(&sweep, &options);
+    double finalised = bench_now();
+    voronoi_trace_end(distribution->name);
+    size_t allocations = bench_allocations;
+
+    printf("{\"distribution\": \"%s\", \"queue\": \"%s\", \"sites\": %zu, \"seed\": %llu, "
+           "\"queue_build_ns\": %.0f, \"sweep_ns\": %.0f, \"finalise_ns\": %.0f, \"ns_per_site\": %.2f, "
+           "\"vertices\": %zu, \"peak_rss_kb\": %ld, \"allocations_per_site\": %.2f",
+           distribution->name, VORONOI_QUEUE_RADIX == queue ? "radix" : "heap", count, (unsigned long long) seed,
+           queue_built - start, swept - queue_built, finalised - swept, (finalised - start) / (double) count,
+           dcel.vertex_count, bench_peak_rss(), (double) allocations / (double) count);
+#ifdef VORONOI_STATS
+    printf(", \"false_alarms\": %llu, \"queue_high_water\": %llu, \"event_comparisons\": %llu, "
+           "\"tree_max_height\": %llu, \"tree_rotations\": %llu",
+           (unsigned long long) stats.false_alarms, (unsigned long long) stats.queue_high_water,
+           (unsigned long long) stats.event_comparisons, (unsigned long long) stats.tree_max_height,
+           (unsigned long long) stats.tree_rotations);
+#endif
+    printf("}\n");
+    fflush(stdout);
+
+    voronoi_sweep_destroy(&sweep);
+    dcel_destroy(&dcel);
+    free(sites);
+    free(points);
+}
+
+/**
+ * Appends freshly generated points to a text file of sites, one site per line
+ */
+static void bench_write_sites(const Bench_Distribution_t *distribution, size_t count, uint64_t seed, FILE *file)
+{
+    Point_t *points = malloc(count * sizeof(Point_t));
+    if (NULL == points)
+    {
+        fprintf(stderr, "voronoi_bench: not enough memory for %zu sites\n", count);
+        exit(EXIT_FAILURE);
+    }
+    random_state = seed;
+    distribution->generate(points, count);
+    for (size_t i = 0; i < count; i++)
+    {
+        fprintf(file, "%llu %llu\n", (unsigned long long) points[i].x, (unsigned long long) points[i].y);
+    }
+    free(points);
+}
+
+static int bench_compare_doubles(const void *first, const void *second)
+{
+    double a = *(const double *) first;
+    double b = *(const double *) second;
+    return (a > b) - (a < b);
+}
+
+/**
+ * Computes the diagram of the same freshly generated points runs times through one workspace
+ * and prints the JSON record of the latencies
+ */
+static void bench_repeat(const Bench_Distribution_t *distribution, size_t count, uint64_t seed, Voronoi_Queue_t queue,
+                         size_t runs)
+{
+    Point_t *points = malloc(count * sizeof(Point_t));
+    Point_t_ptr *sites = malloc(count * sizeof(Point_t_ptr));
+    double *latencies = malloc(runs * sizeof(double));
+    Voronoi_Workspace_t *workspace = voronoi_workspace_new(count);
+    if (NULL == points || NULL == sites || NULL == latencies || NULL == workspace)
+    {
+        fprintf(stderr, "voronoi_bench: not enough memory for %zu sites\n", count);
+        exit(EXIT_FAILURE);
+    }
+    random_state = seed;
+    distribution->generate(points, count);
+    for (size_t i = 0; i < count; i++)
+    {
+        sites[i] = &points[i];
+    }
+
+    Voronoi_Options_t options = {NULL, NULL, NULL, queue};
+    size_t allocations = 0;
+    for (size_t run = 0; run < runs; run++)
+    {
+        bench_allocations = 0;
+        voronoi_trace_begin(distribution->name);
+        double start = bench_now();
+        voronoi_workspace_diagram(workspace, sites, count, &options);
+        latencies[run] = bench_now() - start;
+        voronoi_trace_end(distribution->name);
+        allocations = bench_allocations;
+    }
+    double first = latencies[0];
+    qsort(latencies, runs, sizeof(double), bench_compare_doubles);
+
+    printf("{\"distribution\": \"%s\", \"queue\": \"%s\", \"sites\": %zu, \"seed\": %llu, \"runs\": %zu, "
+           "\"first_ns\": %.0f, \"median_ns\": %.0f, \"p99_ns\": %.0f, \"max_ns\": %.0f, "
+           "\"steady_allocations\": %zu, \"peak_rss_kb\": %ld}\n",
+           distribution->name, VORONOI_QUEUE_RADIX == queue ? "radix" : "heap", count, (unsigned long long) seed,
+           runs, first, latencies[runs / 2], latencies[(runs * 99) / 100 < runs ? (runs * 99) / 100 : runs - 1],
+           latencies[runs - 1], allocations, bench_peak_rss());
+    fflush(stdout);
+
+    voronoi_workspace_destroy(workspace);
+    free(latencies);
+    free(sites);
+    free(points);
+}
+
+int main(int argc, char *argv[])
+{
+    const char *selected = "all";
+    size_t min = 1000;
+    size_t max = 1000000;
+    uint64_t seed = 1;
+    const char *trace = NULL;
+    const char *sites_path = NULL;
+    size_t runs = 0;
+    Voronoi_Queue_t queue = VORONOI_QUEUE_HEAP;
+    for (int i = 1; i + 1 < argc; i += 2)
+    {
+        if (0 == strcmp(argv[i], "--distribution")) selected = argv[i + 1];
+        else if (0 == strcmp(argv[i], "--min")) min = strtoull(argv[i + 1], NULL, 10);
+        else if (0 == strcmp(argv[i], "--max")) max = strtoull(argv[i + 1], NULL, 10);
+        else if (0 == strcmp(argv[i], "--seed")) seed = strtoull(argv[i + 1], NULL, 10);
+        else if (0 == strcmp(argv[i], "--trace")) trace = argv[i + 1];
+        else if (0 == strcmp(argv[i], "--repeat")) runs = strtoull(argv[i + 1], NULL, 10);
+        else if (0 == strcmp(argv[i], "--sites")) sites_path = argv[i + 1];
+        else if (0 == strcmp(argv[i], "--queue") && 0 == strcmp(argv[i + 1], "heap")) queue = VORONOI_QUEUE_HEAP;
+        else if (0 == strcmp(argv[i], "--queue") && 0 == strcmp(argv[i + 1], "radix")) queue = VORONOI_QUEUE_RADIX;
+        else
+        {
+            fprintf(stderr, "voronoi_bench: unknown option %s\n", argv[i]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    if (0 == min)
+    {
+        min = 1;
+    }
+    if (trace && ! voronoi_trace_start())
+    {
+        fprintf(stderr, "voronoi_bench: could not start the trace\n");
+        return EXIT_FAILURE;
+    }
+    FILE *sites_file = sites_path ? fopen(sites_path, "w") : NULL;
+    if (sites_path && NULL == sites_file)
+    {
+        fprintf(stderr, "voronoi_bench: could not open %s\n", sites_path);
+        return EXIT_FAILURE;
+    }
+    for (size_t d = 0; d < 4; d++)
+    {
+        if (strcmp(selected, "all") != 0 && strcmp(selected, distributions[d].name) != 0) continue;
+        for (size_t count = min; count <= max; count *= 10)
+        {
+            if (sites_file) bench_write_sites(&distributions[d], count, seed, sites_file);
+            else if (runs) bench_repeat(&distributions[d], count, seed, queue, runs);
+            else bench_run(&distributions[d], count, seed, queue);
+        }
+    }
+    if (sites_file && fclose(sites_file) != 0)
+    {
+        fprintf(stderr, "voronoi_bench: could not write %s\n", sites_path);
+        return EXIT_FAILURE;
+    }
+    if (trace && ! voronoi_trace_write(trace))
+    {
+        fprintf(stderr, "voronoi_bench: could not write the trace to %s\n", trace);
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,1317 @@
+//
+// Tests for the sweep line construction of the Voronoi diagram and its Delaunay dual
+//
+
+#include <assert.h>
+#include <stdio.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+#include "Point.c"
+#include "DCEL.c"
+#include "Delaunay.c"
+#include "PQueue.c"
+#include "RadixQueue.c"
+#include "AVLTree.c"
+#include "VoronoiClip.c"
+#include "VoronoiCells.c"
+#include "VoronoiNeighbours.c"
+#include "VoronoiSites.c"
+#include "VoronoiTrace.c"
+#include "Voronoi.c"
+#include "VoronoiIncremental.c"
+#include "VoronoiTiles.c"
+
+static uint64_t random_state = 7;
+
+static uint64_t random_next(uint64_t bound)
+{
+    random_state = random_state * 6364136223846793005ULL + 1442695040888963407ULL;
+    return (random_state >> 33) % bound;
+}
+
+static Point_Real_t position(Point_t *points, uint32_t index)
+{
+    Point_Real_t point = {(double) points[index].x, (double) points[index].y};
+    return point;
+}
+
+/**
+ * Checks the orientation, the adjacency and the empty circumcircle property of every triangle
+ */
+static void assert_delaunay(Delaunay_t *delaunay, Point_t *points, size_t count)
+{
+    for (size_t t = 0; t < delaunay->count; t++)
+    {
+        uint32_t *triangle = &delaunay->triangles[3 * t];
+        Point_Real_t a = position(points, triangle[0]);
+        Point_Real_t b = position(points, triangle[1]);
+        Point_Real_t c = position(points, triangle[2]);
+        assert(voronoi_incremental_orient(a, b, c) > 0);
+        for (size_t i = 0; i < 3; i++)
+        {
+            // The neighbour has to share the edge and point back
+            uint32_t neighbour = delaunay->adjacency[3 * t + i];
+            if (neighbour == DELAUNAY_NONE) continue;
+            size_t shared = 0;
+            for (size_t k = 0; k < 3; k++)
+            {
+                uint32_t vertex = delaunay->triangles[3 * neighbour + k];
+                if (vertex == triangle[(i + 1) % 3] || vertex == triangle[(i + 2) % 3]) shared++;
+                assert(vertex != triangle[i]);
+                if (delaunay->adjacency[3 * neighbour + k] == t)
+                {
+                    assert(vertex != triangle[(i + 1) % 3] && vertex != triangle[(i + 2) % 3]);
+                }
+            }
+            assert(shared == 2);
+        }
+        for (size_t site = 0; site < count; site++)
+        {
+            assert(voronoi_incremental_in_circle(a, b, c, position(points, (uint32_t) site)) <= 0);
+        }
+    }
+}
+
+/**
+ * Checks the links of the edge list, in any order of the records
+ */
+static void assert_dcel_links(DCEL_t *dcel)
+{
+    for (size_t i = 0; i < dcel->half_edge_count; i++)
+    {
+        DCEL_HalfEdge_ptr_t half_edge = dcel->half_edges[i];
+        assert(half_edge->twin != NULL);
+        assert(half_edge->twin->twin == half_edge);
+        assert(half_edge->twin->inc_face != half_edge->inc_face);
+        if (half_edge->next)
+        {
+            assert(half_edge->next->prev == half_edge);
+            assert(half_edge->next->inc_face == half_edge->inc_face);
+            assert(half_edge->next->origin == half_edge->twin->origin);
+        }
+    }
+    for (size_t i = 0; i < dcel->face_count; i++)
+    {
+        // Bounded faces are counter-clockwise, so their signed area is positive
+        DCEL_HalfEdge_ptr_t start = dcel->faces[i]->inc_edge;
+        if (! start || ! start->prev) continue;
+        double area = 0;
+        size_t edges = 0;
+        DCEL_HalfEdge_ptr_t half_edge = start;
+        do
+        {
+            Point_Real_t from = half_edge->origin->position;
+            Point_Real_t to = half_edge->twin->origin->position;
+            area += from.x * to.y - to.x * from.y;
+            half_edge = half_edge->next;
+            edges++;
+        } while (half_edge != start);
+#ifdef VORONOI_WEIGHTED
+        // The edges of weighted cells are curved, so a cell between two edges has no area as a polygon
+        assert(area > 0 || 2 == edges);
+#else
+        assert(area > 0);
+#endif
+    }
+}
+
+/**
+ * Checks the links of the edge list and that face i belongs to site i, as the sweep builds it
+ */
+static void assert_dcel(DCEL_t *dcel)
+{
+    assert_dcel_links(dcel);
+    for (size_t i = 0; i < dcel->face_count; i++)
+    {
+        assert(dcel->faces[i]->index == i);
+    }
+}
+
+void test_voronoi_square()
+{
+    Point_t points[5] = {{0, 0}, {10, 0}, {10, 10}, {0, 10}, {5, 4}};
+    Point_t_ptr sites[5];
+    for (size_t i = 0; i < 5; i++)
+    {
+        sites[i] = &points[i];
+    }
+    Delaunay_t delaunay;
+    delaunay_init(&delaunay);
+    Voronoi_Options_t options = {&delaunay, NULL};
+    DCEL_t dcel = voronoi_diagram_with_options(sites, 5, &options);
+
+    // The inner site is connected to every corner
+    assert(delaunay.count == 4);
+    for (size_t t = 0; t < delaunay.count; t++)
+    {
+        uint32_t *triangle = &delaunay.triangles[3 * t];
+        assert(triangle[0] == 4 || triangle[1] == 4 || triangle[2] == 4);
+    }
+    assert_delaunay(&delaunay, points, 5);
+    assert(dcel.face_count == 5);
+    assert(dcel.vertex_count == 4);
+    assert_dcel(&dcel);
+    // Only the cell of the inner site is bounded
+    assert(dcel.faces[4]->inc_edge->prev != NULL);
+    assert(dcel.faces[0]->inc_edge->prev == NULL);
+
+    delaunay_destroy(&delaunay);
+    dcel_destroy(&dcel);
+}
+
+void test_voronoi_random()
+{
+    size_t count = 500;
+    Point_t points[500];
+    Point_t_ptr sites[500];
+    Voronoi_Incremental_ptr_t incremental = voronoi_incremental_new();
+    for (size_t i = 0; i < count; i++)
+    {
+        point_init(&points[i], random_next(1000000), random_next(1000000));
+        sites[i] = &points[i];
+        voronoi_insert_site(incremental, &points[i]);
+    }
+    Delaunay_t delaunay;
+    delaunay_init(&delaunay);
+    Voronoi_Options_t options = {&delaunay, NULL};
+    DCEL_t dcel = voronoi_diagram_with_options(sites, count, &options);
+
+    // The sweep and the incremental construction agree on the triangulation
+    assert(delaunay.count == incremental->finite_count);
+    assert_delaunay(&delaunay, points, count);
+    size_t hull_edges = 0;
+    for (size_t i = 0; i < 3 * delaunay.count; i++)
+    {
+        hull_edges += delaunay.adjacency[i] == DELAUNAY_NONE;
+    }
+    // Euler's formula for a triangulation with h sites on the convex hull
+    assert(delaunay.count == 2 * count - 2 - hull_edges);
+
+    assert(dcel.face_count == count);
+    assert(dcel.vertex_count == delaunay.count);
+    assert_dcel(&dcel);
+
+    // Without options the same diagram is built
+    DCEL_t plain = voronoi_diagram(sites, count);
+    assert(plain.vertex_count == dcel.vertex_count);
+    assert(plain.half_edge_count == dcel.half_edge_count);
+
+    dcel_destroy(&plain);
+    delaunay_destroy(&delaunay);
+    dcel_destroy(&dcel);
+    voronoi_incremental_destroy(incremental);
+}
+
+void test_voronoi_duplicates()
+{
+    Point_t points[4] = {{3, 3}, {8, 1}, {3, 3}, {1, 7}};
+    Point_t_ptr sites[4];
+    for (size_t i = 0; i < 4; i++)
+    {
+        sites[i] = &points[i];
+    }
+    Delaunay_t delaunay;
+    delaunay_init(&delaunay);
+    Voronoi_Options_t options = {&delaunay, NULL};
+    DCEL_t dcel = voronoi_diagram_with_options(sites, 4, &options);
+
+    // One of the twins gets an empty cell
+    assert(delaunay.count == 1);
+    assert((dcel.faces[0]->inc_edge == NULL) != (dcel.faces[2]->inc_edge == NULL));
+    assert_dcel(&dcel);
+
+    delaunay_destroy(&delaunay);
+    dcel_destroy(&dcel);
+}
+
+/**
+ * Sums up the signed areas of the faces, all of which have to be closed
+ */
+static double closed_area(DCEL_t *dcel)
+{
+    double total = 0;
+    for (size_t i = 0; i < dcel->face_count; i++)
+    {
+        DCEL_HalfEdge_ptr_t start = dcel->faces[i]->inc_edge;
+        if (! start) continue;
+        double area = 0;
+        DCEL_HalfEdge_ptr_t half_edge = start;
+        do
+        {
+            assert(half_edge->next != NULL);
+            Point_Real_t from = half_edge->origin->position;
+            Point_Real_t to = half_edge->twin->origin->position;
+            area += from.x * to.y - to.x * from.y;
+            half_edge = half_edge->next;
+        } while (half_edge != start);
+        assert(area >= 0);
+        total += area / 2;
+    }
+    return total;
+}
+
+void test_voronoi_clip()
+{
+    size_t count = 300;
+    Point_t points[300];
+    Point_t_ptr sites[300];
+    for (size_t i = 0; i < count; i++)
+    {
+        point_init(&points[i], random_next(2000), random_next(2000));
+        sites[i] = &points[i];
+    }
+
+    // A rectangle that cuts through the diagram, so cells are clipped on every side and some disappear
+    Point_Real_t corners[4];
+    Voronoi_Clip_t clip = voronoi_clip_rectangle(corners, 500, 400, 1500, 1200);
+    Voronoi_Options_t options = {NULL, &clip};
+    DCEL_t dcel = voronoi_diagram_with_options(sites, count, &options);
+    assert_dcel(&dcel);
+    assert(fabs(closed_area(&dcel) - 1000 * 800) < 1e-6 * 1000 * 800);
+    for (size_t i = 0; i < dcel.vertex_count; i++)
+    {
+        Point_Real_t position = dcel.vertices[i]->position;
+        assert(position.x >= 500 - 1e-9 && position.x <= 1500 + 1e-9);
+        assert(position.y >= 400 - 1e-9 && position.y <= 1200 + 1e-9);
+    }
+    dcel_destroy(&dcel);
+
+    // A triangle
+    Point_Real_t triangle[3] = {{-100, -100}, {2100, 0}, {900, 2500}};
+    clip.vertices = triangle;
+    clip.count = 3;
+    dcel = voronoi_diagram_with_options(sites, count, &options);
+    assert_dcel(&dcel);
+    double area = ((triangle[1].x - triangle[0].x) * (triangle[2].y - triangle[0].y) -
+                   (triangle[2].x - triangle[0].x) * (triangle[1].y - triangle[0].y)) / 2;
+    assert(fabs(closed_area(&dcel) - area) < 1e-6 * area);
+    dcel_destroy(&dcel);
+
+    // A polygon within a single cell becomes that cell
+    clip = voronoi_clip_rectangle(corners, 0, 0, 0.5, 0.5);
+    dcel = voronoi_diagram_with_options(sites, 2, &options);
+    assert(fabs(closed_area(&dcel) - 0.25) < 1e-12);
+    dcel_destroy(&dcel);
+}
+
+void test_voronoi_lloyd()
+{
+    size_t count = 200;
+    Point_t points[200];
+    Point_t_ptr sites[200];
+    for (size_t i = 0; i < count; i++)
+    {
+        // Start from a clustered layout in one corner
+        point_init(&points[i], random_next(200000), random_next(200000));
+        sites[i] = &points[i];
+    }
+    Point_Real_t corners[4];
+    Voronoi_Clip_t bbox = voronoi_clip_rectangle(corners, 0, 0, 1000000, 1000000);
+
+    // The relaxation spreads the points over the box and settles before running out of rounds
+    size_t iterations = voronoi_lloyd(sites, count, 1000, &bbox, 250);
+    assert(iterations > 1 && iterations < 1000);
+    uint64_t max_x = 0;
+    uint64_t max_y = 0;
+    for (size_t i = 0; i < count; i++)
+    {
+        assert(points[i].x <= 1000000 && points[i].y <= 1000000);
+        max_x = points[i].x > max_x ? points[i].x : max_x;
+        max_y = points[i].y > max_y ? points[i].y : max_y;
+    }
+    assert(max_x > 900000 && max_y > 900000);
+
+    // Every point sits close to the centroid of its cell now
+    Voronoi_Options_t options = {NULL, &bbox};
+    DCEL_t dcel = voronoi_diagram_with_options(sites, count, &options);
+    for (size_t i = 0; i < count; i++)
+    {
+        Point_Real_t centroid;
+        uint8_t is_closed = voronoi_face_centroid(dcel.faces[i], &centroid);
+        assert(is_closed);
+        assert(hypot(centroid.x - (double) points[i].x, centroid.y - (double) points[i].y) <= 500);
+    }
+    dcel_destroy(&dcel);
+}
+
+/**
+ * Counts the chunks of a pool of the sweep
+ */
+static size_t pool_chunks(Voronoi_Pool_t *pool)
+{
+    size_t count = 0;
+    for (Voronoi_Pool_Chunk_t *chunk = pool->chunks; chunk; chunk = chunk->next) count++;
+    return count;
+}
+
+void test_voronoi_workspace()
+{
+    size_t sizes[5] = {50, 3000, 3000, 1000, 3000};
+    Point_t points[3000];
+    Point_t_ptr sites[3000];
+    Delaunay_t delaunay;
+    delaunay_init(&delaunay);
+    // Smaller than most inputs, so the workspace has to grow
+    Voronoi_Workspace_t *workspace = voronoi_workspace_new(100);
+    PQueue_t *queue = NULL;
+    DCEL_Vertex_ptr_t *vertices = NULL;
+    size_t chunks = 0;
+    for (size_t run = 0; run < 5; run++)
+    {
+        size_t count = sizes[run];
+        for (size_t i = 0; i < count; i++)
+        {
+            point_init(&points[i], random_next(1000000), random_next(1000000));
+            sites[i] = &points[i];
+        }
+        delaunay_clear(&delaunay);
+        Voronoi_Options_t options = {&delaunay, NULL, NULL, 3 == run ? VORONOI_QUEUE_RADIX : VORONOI_QUEUE_HEAP};
+        DCEL_t *dcel = voronoi_workspace_diagram(workspace, sites, count, &options);
+
+        // The diagram is the same as the one of a fresh sweep
+        DCEL_t fresh = voronoi_diagram(sites, count);
+        assert(dcel->face_count == count);
+        assert(dcel->vertex_count == fresh.vertex_count && dcel->half_edge_count == fresh.half_edge_count);
+        for (size_t i = 0; i < fresh.vertex_count; i++)
+        {
+            assert(dcel->vertices[i]->position.x == fresh.vertices[i]->position.x);
+            assert(dcel->vertices[i]->position.y == fresh.vertices[i]->position.y);
+        }
+        assert(delaunay.count == dcel->vertex_count);
+        assert_dcel(dcel);
+        dcel_destroy(&fresh);
+
+        // After the first input of the largest size, the memory stays in place
+        size_t run_chunks = pool_chunks(&workspace->sweep.events) + pool_chunks(&workspace->sweep.arcs) +
+                            pool_chunks(&workspace->sweep.breakpoints);
+        if (run > 1)
+        {
+            assert(workspace->sweep.queue == queue);
+            assert(dcel->vertices == vertices);
+            assert(run_chunks == chunks);
+        }
+        queue = workspace->sweep.queue;
+        vertices = dcel->vertices;
+        chunks = run_chunks;
+    }
+    voronoi_workspace_destroy(workspace);
+    delaunay_destroy(&delaunay);
+}
+
+void test_voronoi_cells()
+{
+    size_t count = 400;
+    Point_t points[400];
+    Point_t_ptr sites[400];
+    for (size_t i = 0; i < count; i++)
+    {
+        point_init(&points[i], random_next(5000), random_next(5000));
+        sites[i] = &points[i];
+    }
+    Voronoi_Cells_t cells;
+    voronoi_cells_init(&cells);
+
+    // The neighbours of the unclipped diagram are the edges of the triangulation, seen from both sides
+    Delaunay_t delaunay;
+    delaunay_init(&delaunay);
+    Voronoi_Options_t options = {&delaunay, NULL};
+    DCEL_t dcel = voronoi_diagram_with_options(sites, count, &options);
+    uint8_t is_computed = voronoi_cells_compute(&cells, &dcel);
+    assert(is_computed);
+    assert(cells.count == count);
+    size_t interior_edges = 0;
+    size_t hull_edges = 0;
+    for (size_t i = 0; i < 3 * delaunay.count; i++)
+    {
+        interior_edges += delaunay.adjacency[i] != DELAUNAY_NONE;
+        hull_edges += delaunay.adjacency[i] == DELAUNAY_NONE;
+    }
+    assert(cells.neighbour_offsets[count] == interior_edges + 2 * hull_edges);
+    for (size_t i = 0; i < count; i++)
+    {
+        for (size_t k = cells.neighbour_offsets[i]; k < cells.neighbour_offsets[i + 1]; k++)
+        {
+            uint32_t neighbour = cells.neighbours[k];
+            uint8_t found = 0;
+            for (size_t l = cells.neighbour_offsets[neighbour]; l < cells.neighbour_offsets[neighbour + 1]; l++)
+            {
+                found |= cells.neighbours[l] == i;
+            }
+            assert(found);
+        }
+        assert(isinf(cells.area[i]) == (dcel.faces[i]->inc_edge->prev == NULL));
+    }
+    dcel_destroy(&dcel);
+    delaunay_destroy(&delaunay);
+
+    // The clipped cells tile the rectangle, and the same handle is reused
+    Point_Real_t corners[4];
+    Voronoi_Clip_t clip = voronoi_clip_rectangle(corners, 1000, 1000, 4000, 3000);
+    options.delaunay = NULL;
+    options.clip = &clip;
+    dcel = voronoi_diagram_with_options(sites, count, &options);
+    is_computed = voronoi_cells_compute(&cells, &dcel);
+    assert(is_computed);
+    double area = 0;
+    for (size_t i = 0; i < count; i++)
+    {
+        area += cells.area[i];
+        Point_Real_t centroid;
+        if (voronoi_face_centroid(dcel.faces[i], &centroid))
+        {
+            assert(fabs(centroid.x - cells.centroid_x[i]) < 1e-9 && fabs(centroid.y - cells.centroid_y[i]) < 1e-9);
+            assert(cells.perimeter[i] > 0);
+        }
+        else
+        {
+            assert(cells.area[i] == 0 && isnan(cells.centroid_x[i]));
+            assert(cells.neighbour_offsets[i] == cells.neighbour_offsets[i + 1]);
+        }
+    }
+    assert(fabs(area - 3000 * 2000) < 1e-6 * 3000 * 2000);
+    dcel_destroy(&dcel);
+
+    // A single square cell
+    clip = voronoi_clip_rectangle(corners, 0, 0, 0.5, 0.5);
+    dcel = voronoi_diagram_with_options(sites, 2, &options);
+    is_computed = voronoi_cells_compute(&cells, &dcel);
+    assert(is_computed);
+    size_t inside = cells.area[0] > 0 ? 0 : 1;
+    assert(fabs(cells.area[inside] - 0.25) < 1e-12);
+    assert(fabs(cells.perimeter[inside] - 2) < 1e-12);
+    assert(fabs(cells.centroid_x[inside] - 0.25) < 1e-12 && fabs(cells.centroid_y[inside] - 0.25) < 1e-12);
+    assert(cells.neighbour_offsets[2] == 0);
+    dcel_destroy(&dcel);
+
+    voronoi_cells_destroy(&cells);
+}
+
+void test_voronoi_neighbours()
+{
+    size_t count = 2000;
+    Point_t *points = malloc(count * sizeof(Point_t));
+    Point_t_ptr *sites = malloc(count * sizeof(Point_t_ptr));
+    for (size_t i = 0; i < count; i++)
+    {
+        point_init(&points[i], random_next(20000), random_next(20000));
+        sites[i] = &points[i];
+    }
+    // The distance does not depend on the order of the points, although the coordinates are unsigned
+    assert(point_euclidean_distance(&points[0], &points[1]) == point_euclidean_distance(&points[1], &points[0]));
+
+    // The lists match those of the cells, and the nearest neighbour is the one found by brute force
+    Voronoi_Neighbours_t neighbours;
+    voronoi_neighbours_init(&neighbours);
+    Voronoi_Cells_t cells;
+    voronoi_cells_init(&cells);
+    Point_Real_t corners[4];
+    Voronoi_Clip_t clip = voronoi_clip_rectangle(corners, -1, -1, 20000, 20000);
+    Voronoi_Options_t options = {NULL, NULL};
+    for (size_t round = 0; round < 2; round++)
+    {
+        options.clip = round ? &clip : NULL;
+        DCEL_t dcel = voronoi_diagram_with_options(sites, count, &options);
+        uint8_t is_computed = voronoi_neighbours_compute(&neighbours, &dcel);
+        assert(is_computed);
+        is_computed = voronoi_cells_compute(&cells, &dcel);
+        assert(is_computed);
+        assert(neighbours.count == count);
+        assert(0 == memcmp(neighbours.offsets, cells.neighbour_offsets, (count + 1) * sizeof(size_t)));
+        assert(0 == memcmp(neighbours.neighbours, cells.neighbours, neighbours.offsets[count] * sizeof(uint32_t)));
+        for (size_t i = 0; i < count; i++)
+        {
+            double closest = INFINITY;
+            for (size_t j = 0; j < count; j++)
+            {
+                double distance = point_euclidean_distance(&points[i], &points[j]);
+                if (j != i && distance < closest) closest = distance;
+            }
+            assert(neighbours.nearest[i] != VORONOI_NEIGHBOURS_NONE);
+            assert(neighbours.nearest_distance[i] == closest);
+            assert(point_euclidean_distance(&points[i], &points[neighbours.nearest[i]]) == closest);
+        }
+        dcel_destroy(&dcel);
+    }
+
+    // The empty face of a duplicate has no nearest neighbour
+    point_init(&points[1], points[0].x, points[0].y);
+    options.clip = NULL;
+    DCEL_t dcel = voronoi_diagram_with_options(sites, 3, &options);
+    uint8_t is_computed = voronoi_neighbours_compute(&neighbours, &dcel);
+    assert(is_computed);
+    size_t empty = dcel.faces[0]->inc_edge ? 1 : 0;
+    assert(neighbours.nearest[empty] == VORONOI_NEIGHBOURS_NONE && isinf(neighbours.nearest_distance[empty]));
+    assert(neighbours.nearest[2] == 1 - empty);
+    dcel_destroy(&dcel);
+
+    voronoi_cells_destroy(&cells);
+    voronoi_neighbours_destroy(&neighbours);
+    free(sites);
+    free(points);
+}
+
+void test_voronoi_stats()
+{
+    size_t count = 1000;
+    Point_t points[1000];
+    Point_t_ptr sites[1000];
+    for (size_t i = 0; i < count; i++)
+    {
+        point_init(&points[i], random_next(100000), random_next(100000));
+        sites[i] = &points[i];
+    }
+    Voronoi_Stats_t stats;
+    memset(&stats, 0xff, sizeof(stats));
+    Voronoi_Options_t options = {NULL, NULL, &stats};
+    DCEL_t dcel = voronoi_diagram_with_options(sites, count, &options);
+#ifdef VORONOI_STATS
+    // Every circle event that fired made a vertex, the others were false alarms
+    assert(stats.site_events == count);
+    assert(stats.circle_events == dcel.vertex_count);
+    assert(stats.event_bytes == (stats.circle_events + stats.false_alarms) * sizeof(Voronoi_CircleEvent_t));
+    // The queue only holds circle events, the site events are read off the sorted sites
+    assert(stats.queue_high_water > 0 && stats.queue_high_water < 7 * count + 1);
+    // The inline keys order the events, the comparator only breaks the ties in height
+    assert(stats.event_comparisons < count);
+    assert(stats.tree_max_height > 1 && stats.tree_max_height < 2 * 1.45 * log2(2.0 * count));
+    assert(stats.tree_rotations > 0);
+    assert(stats.queue_bytes > 0 && stats.beach_line_bytes > 0 && stats.dcel_bytes > 0);
+#else
+    Voronoi_Stats_t zero;
+    memset(&zero, 0, sizeof(zero));
+    assert(0 == memcmp(&stats, &zero, sizeof(stats)));
+#endif
+    dcel_destroy(&dcel);
+}
+
+void test_voronoi_trace()
+{
+    size_t count = 300;
+    Point_t points[300];
+    Point_t_ptr sites[300];
+    for (size_t i = 0; i < count; i++)
+    {
+        point_init(&points[i], random_next(100000), random_next(100000));
+        sites[i] = &points[i];
+    }
+    Point_Real_t corners[4];
+    Voronoi_Clip_t bbox = voronoi_clip_rectangle(corners, 0, 0, 100000, 100000);
+    uint8_t is_traced = voronoi_trace_start();
+    assert(is_traced);
+    voronoi_lloyd(sites, count, 2, &bbox, 0);
+    const char *path = "voronoi_trace_test.json";
+    is_traced = voronoi_trace_write(path);
+    assert(is_traced);
+
+    // Every span that begins also ends
+    FILE *file = fopen(path, "r");
+    assert(file);
+    char line[256];
+    long balance = 0;
+    size_t rounds = 0;
+    while (fgets(line, sizeof(line), file))
+    {
+        balance += NULL != strstr(line, "\"ph\": \"B\"");
+        balance -= NULL != strstr(line, "\"ph\": \"E\"");
+        rounds += NULL != strstr(line, "\"lloyd_round\", \"ph\": \"B\"");
+        assert(NULL == strstr(line, "\"sweep\"") || NULL != strstr(line, "\"tid\": 0"));
+    }
+    fclose(file);
+    remove(path);
+    assert(balance == 0);
+    assert(rounds == 2);
+
+    // Thread numbers repeat across the teams of nested regions, yet every thread records into its own buffer
+    int max_levels = omp_get_max_active_levels();
+    omp_set_max_active_levels(2);
+    is_traced = voronoi_trace_start();
+    assert(is_traced);
+    size_t spans = 1000;
+#pragma omp parallel num_threads(2) default(none) shared(spans)
+    {
+#pragma omp parallel num_threads(2) default(none) shared(spans)
+        {
+            for (size_t i = 0; i < spans; i++)
+            {
+                voronoi_trace_begin("nested");
+                voronoi_trace_end("nested");
+            }
+        }
+    }
+    omp_set_max_active_levels(max_levels);
+    is_traced = voronoi_trace_write(path);
+    assert(is_traced);
+    file = fopen(path, "r");
+    assert(file);
+    long balances[8] = {0};
+    size_t begins = 0;
+    while (fgets(line, sizeof(line), file))
+    {
+        const char *tid = strstr(line, "\"tid\": ");
+        if (NULL == tid) continue;
+        size_t thread = strtoul(tid + 7, NULL, 10);
+        assert(thread < 8);
+        balances[thread] += NULL != strstr(line, "\"ph\": \"B\"");
+        balances[thread] -= NULL != strstr(line, "\"ph\": \"E\"");
+        begins += NULL != strstr(line, "\"ph\": \"B\"");
+    }
+    fclose(file);
+    remove(path);
+    for (size_t thread = 0; thread < 8; thread++) assert(0 == balances[thread]);
+    assert(begins == 4 * spans);
+
+    // Without a trace nothing is recorded
+    voronoi_trace_begin("ignored");
+    voronoi_trace_end("ignored");
+    is_traced = voronoi_trace_write(path);
+    assert(! is_traced);
+}
+
+void test_voronoi_sites()
+{
+    // Enough points for several runs of the parallel sort, on few rows and with many duplicates
+    size_t count = 3 * VORONOI_SITES_RUN + 17;
+    Point_t *points = malloc(count * sizeof(Point_t));
+    Point_t_ptr *sites = malloc(count * sizeof(Point_t_ptr));
+    for (size_t i = 0; i < count; i++)
+    {
+        point_init(&points[i], random_next(2000), random_next(20));
+        sites[i] = &points[i];
+    }
+    Voronoi_Sites_t prepared;
+    voronoi_sites_init(&prepared);
+    uint8_t is_prepared = voronoi_sites_prepare(&prepared, sites, count);
+    assert(is_prepared);
+    assert(prepared.input_count == count);
+    assert(prepared.count < count);
+    for (size_t j = 1; j < prepared.count; j++)
+    {
+        // Higher rows first, every row from left to right, no point twice
+        Point_t_ptr previous = prepared.sites[j - 1];
+        Point_t_ptr site = prepared.sites[j];
+        assert(previous->y > site->y || (previous->y == site->y && previous->x < site->x));
+    }
+    for (size_t i = 0; i < count; i++)
+    {
+        // Every point maps to the first occurrence of its coordinates
+        size_t j = prepared.unique[i];
+        assert(prepared.sites[j]->x == points[i].x && prepared.sites[j]->y == points[i].y);
+        assert(prepared.indices[j] <= i && prepared.sites[j] == sites[prepared.indices[j]]);
+    }
+
+    // The duplicates keep empty cells and the representatives get all the others
+    DCEL_t dcel = voronoi_diagram(sites, count);
+    for (size_t i = 0; i < count; i++)
+    {
+        assert((dcel.faces[i]->inc_edge != NULL) == (prepared.indices[prepared.unique[i]] == i));
+    }
+    assert_dcel(&dcel);
+
+    dcel_destroy(&dcel);
+    voronoi_sites_destroy(&prepared);
+    free(sites);
+    free(points);
+}
+
+void test_voronoi_radix_queue()
+{
+    size_t count = 900;
+    Point_t points[900];
+    Point_t_ptr sites[900];
+    for (size_t grid = 0; grid <= 1; grid++)
+    {
+        for (size_t i = 0; i < count; i++)
+        {
+            // A snapped grid has whole rows of sites at the same height
+            if (grid) point_init(&points[i], (i % 30) * 1000 + random_next(3), (i / 30) * 1000);
+            else point_init(&points[i], random_next(1000000), random_next(1000000));
+            sites[i] = &points[i];
+        }
+        Delaunay_t heap_delaunay, radix_delaunay;
+        delaunay_init(&heap_delaunay);
+        delaunay_init(&radix_delaunay);
+        Voronoi_Options_t heap_options = {&heap_delaunay, NULL, NULL, VORONOI_QUEUE_HEAP};
+        Voronoi_Options_t radix_options = {&radix_delaunay, NULL, NULL, VORONOI_QUEUE_RADIX};
+        DCEL_t heap = voronoi_diagram_with_options(sites, count, &heap_options);
+        DCEL_t radix = voronoi_diagram_with_options(sites, count, &radix_options);
+
+        // Both queues hand out the events in the same order, up to events at the very same point
+        assert_dcel(&radix);
+        assert_delaunay(&radix_delaunay, points, count);
+        assert(radix.vertex_count == heap.vertex_count);
+        assert(radix.half_edge_count == heap.half_edge_count);
+        assert(radix_delaunay.count == heap_delaunay.count);
+        for (size_t i = 0; ! grid && i < radix.vertex_count; i++)
+        {
+            assert(radix.vertices[i]->position.x == heap.vertices[i]->position.x);
+            assert(radix.vertices[i]->position.y == heap.vertices[i]->position.y);
+        }
+
+        delaunay_destroy(&heap_delaunay);
+        delaunay_destroy(&radix_delaunay);
+        dcel_destroy(&heap);
+        dcel_destroy(&radix);
+    }
+}
+
+void test_dcel_reorder()
+{
+    // Consecutive points of the Hilbert curve are neighbours on the grid
+    uint8_t seen[256] = {0};
+    uint32_t cells[256][2];
+    for (uint32_t x = 0; x < 16; x++)
+    {
+        for (uint32_t y = 0; y < 16; y++)
+        {
+            uint64_t key = dcel_hilbert_key(x, y);
+            assert(key < 256 && ! seen[key]);
+            seen[key] = 1;
+            cells[key][0] = x;
+            cells[key][1] = y;
+        }
+    }
+    for (size_t key = 1; key < 256; key++)
+    {
+        int64_t dx = (int64_t) cells[key][0] - (int64_t) cells[key - 1][0];
+        int64_t dy = (int64_t) cells[key][1] - (int64_t) cells[key - 1][1];
+        assert(dx * dx + dy * dy == 1);
+    }
+
+    size_t count = 400;
+    Point_t points[400];
+    Point_t_ptr sites[400];
+    for (size_t i = 0; i < count; i++)
+    {
+        point_init(&points[i], random_next(2000), random_next(2000));
+        sites[i] = &points[i];
+    }
+    Point_Real_t corners[4];
+    Voronoi_Clip_t clip = voronoi_clip_rectangle(corners, 500, 400, 1500, 1200);
+    const Voronoi_Clip_t *clips[2] = {NULL, &clip};
+    for (size_t c = 0; c < 2; c++)
+    {
+        for (DCEL_Curve_t curve = DCEL_CURVE_MORTON; curve <= DCEL_CURVE_HILBERT; curve++)
+        {
+            Voronoi_Options_t options = {NULL, clips[c]};
+            DCEL_t dcel = voronoi_diagram_with_options(sites, count, &options);
+            Voronoi_Cells_t before, after;
+            voronoi_cells_init(&before);
+            voronoi_cells_init(&after);
+            uint8_t is_computed = voronoi_cells_compute(&before, &dcel);
+            assert(is_computed);
+            size_t vertex_count = dcel.vertex_count;
+            size_t half_edge_count = dcel.half_edge_count;
+
+            uint8_t is_reordered = dcel_reorder(&dcel, curve);
+            assert(is_reordered);
+            assert_dcel_links(&dcel);
+            assert(dcel.vertex_count == vertex_count && dcel.half_edge_count == half_edge_count);
+            assert(dcel.face_count == count);
+            // Every face keeps its site and its cell, only the positions change
+            is_computed = voronoi_cells_compute(&after, &dcel);
+            assert(is_computed);
+            uint8_t moved = 0;
+            for (size_t i = 0; i < count; i++)
+            {
+                size_t site = dcel.faces[i]->index;
+                moved |= site != i;
+                assert(dcel.faces[i]->site.x == points[site].x && dcel.faces[i]->site.y == points[site].y);
+                assert(after.area[i] == before.area[site] || (isnan(after.area[i]) && isnan(before.area[site])));
+                assert(after.neighbour_offsets[i + 1] - after.neighbour_offsets[i] ==
+                       before.neighbour_offsets[site + 1] - before.neighbour_offsets[site]);
+            }
+            assert(moved);
+            // The boundary of each face is contiguous in memory
+            for (size_t i = 0; i < dcel.face_count; i++)
+            {
+                DCEL_HalfEdge_ptr_t half_edge = dcel.faces[i]->inc_edge;
+                while (half_edge && half_edge->next && half_edge->next != dcel.faces[i]->inc_edge)
+                {
+                    assert(half_edge->next == half_edge + 1);
+                    half_edge = half_edge->next;
+                }
+            }
+
+            voronoi_cells_destroy(&before);
+            voronoi_cells_destroy(&after);
+            dcel_destroy(&dcel);
+        }
+    }
+}
+
+/**
+ * Splits the sites into vertical strips and sweeps every strip on its own. The halo of a strip holds the Voronoi
+ * neighbours of its sites, which is all a cell depends on, so each piece holds the correct cells of its own sites
+ * even where they are unbounded. The faces of a piece take the indices of their sites in the full input
+ */
+static void merge_strips(DCEL_t *merged, Point_t_ptr *sites, size_t count, const Voronoi_Clip_t *clip,
+                         size_t piece_count)
+{
+    DCEL_t pieces[4];
+    size_t owners[2000];
+    uint8_t is_member[2000];
+    Point_t_ptr strip[2000];
+    size_t indices[2000];
+    for (size_t i = 0; i < count; i++)
+    {
+        owners[i] = (size_t) (sites[i]->x * piece_count / 1000000);
+    }
+    DCEL_t whole = voronoi_diagram(sites, count);
+    Voronoi_Neighbours_t neighbours;
+    voronoi_neighbours_init(&neighbours);
+    uint8_t is_computed = voronoi_neighbours_compute(&neighbours, &whole);
+    assert(is_computed);
+    for (size_t p = 0; p < piece_count; p++)
+    {
+        memset(is_member, 0, sizeof(is_member));
+        for (size_t i = 0; i < count; i++)
+        {
+            if (owners[i] != p) continue;
+            is_member[i] = 1;
+            for (size_t k = neighbours.offsets[i]; k < neighbours.offsets[i + 1]; k++)
+            {
+                is_member[neighbours.neighbours[k]] = 1;
+            }
+        }
+        size_t strip_count = 0;
+        for (size_t i = 0; i < count; i++)
+        {
+            if (! is_member[i]) continue;
+            strip[strip_count] = sites[i];
+            indices[strip_count++] = i;
+        }
+        // The strip and its halo are a fraction of the sites
+        assert(strip_count < count / 2);
+        Voronoi_Options_t options = {NULL, clip};
+        pieces[p] = voronoi_diagram_with_options(strip, strip_count, &options);
+        for (size_t i = 0; i < pieces[p].face_count; i++)
+        {
+            pieces[p].faces[i]->index = indices[pieces[p].faces[i]->index];
+        }
+    }
+    voronoi_neighbours_destroy(&neighbours);
+    dcel_destroy(&whole);
+    uint8_t is_merged = dcel_merge(merged, pieces, piece_count, owners, count);
+    assert(is_merged);
+    for (size_t p = 0; p < piece_count; p++)
+    {
+        dcel_destroy(&pieces[p]);
+    }
+}
+
+static size_t record_position(void *record, void *first, size_t size)
+{
+    return record ? (size_t) ((char *) record - (char *) first) / size : (size_t) -1;
+}
+
+void test_dcel_merge()
+{
+    size_t count = 2000;
+    Point_t points[2000];
+    Point_t_ptr sites[2000];
+    for (size_t i = 0; i < count; i++)
+    {
+        point_init(&points[i], random_next(1000000), random_next(1000000));
+        sites[i] = &points[i];
+    }
+    Point_Real_t corners[4];
+    Voronoi_Clip_t clip = voronoi_clip_rectangle(corners, 100000, 50000, 900000, 950000);
+    const Voronoi_Clip_t *clips[2] = {NULL, &clip};
+    for (size_t c = 0; c < 2; c++)
+    {
+        Voronoi_Options_t options = {NULL, clips[c]};
+        DCEL_t reference = voronoi_diagram_with_options(sites, count, &options);
+        DCEL_t merged;
+        dcel_init(&merged);
+        merge_strips(&merged, sites, count, clips[c], 4);
+        assert_dcel(&merged);
+        assert(merged.vertex_count == reference.vertex_count);
+        assert(merged.half_edge_count == reference.half_edge_count);
+        // Every face has the same boundary as in the diagram of a single sweep
+        for (size_t i = 0; i < count; i++)
+        {
+            DCEL_HalfEdge_ptr_t expected = reference.faces[i]->inc_edge;
+            DCEL_HalfEdge_ptr_t actual = merged.faces[i]->inc_edge;
+            assert((NULL == expected) == (NULL == actual));
+            while (expected)
+            {
+                assert((NULL == expected->origin) == (NULL == actual->origin));
+                if (expected->origin)
+                {
+                    assert(expected->origin->position.x == actual->origin->position.x);
+                    assert(expected->origin->position.y == actual->origin->position.y);
+                    assert(actual->origin->inc_edge->origin == actual->origin);
+                }
+                DCEL_Face_ptr_t neighbour = actual->twin->inc_face;
+                assert(neighbour ? neighbour->index == expected->twin->inc_face->index : ! expected->twin->inc_face);
+                expected = expected->next;
+                actual = actual->next;
+                assert((NULL == expected) == (NULL == actual));
+                if (expected == reference.faces[i]->inc_edge) break;
+            }
+        }
+
+#ifdef _OPENMP
+        // The same records at the same positions on any number of threads
+        int threads = omp_get_max_threads();
+        omp_set_num_threads(3);
+        DCEL_t parallel;
+        dcel_init(&parallel);
+        merge_strips(&parallel, sites, count, clips[c], 4);
+        omp_set_num_threads(threads);
+        assert(parallel.vertex_count == merged.vertex_count);
+        DCEL_HalfEdge_ptr_t first = merged.half_edges[0];
+        DCEL_HalfEdge_ptr_t parallel_first = parallel.half_edges[0];
+        for (size_t i = 0; i < merged.vertex_count; i++)
+        {
+            assert(merged.vertices[i]->position.x == parallel.vertices[i]->position.x);
+            assert(merged.vertices[i]->position.y == parallel.vertices[i]->position.y);
+        }
+        for (size_t i = 0; i < merged.half_edge_count; i++)
+        {
+            size_t size = sizeof(DCEL_HalfEdge_t);
+            assert(record_position(merged.half_edges[i]->twin, first, size) ==
+                   record_position(parallel.half_edges[i]->twin, parallel_first, size));
+            assert(record_position(merged.half_edges[i]->next, first, size) ==
+                   record_position(parallel.half_edges[i]->next, parallel_first, size));
+        }
+        dcel_destroy(&parallel);
+#endif
+        dcel_destroy(&merged);
+        dcel_destroy(&reference);
+    }
+
+    // A piece without the cells of its sites cannot be merged
+    DCEL_t pieces[2];
+    size_t owners[2000];
+    pieces[0] = voronoi_diagram(sites, count);
+    pieces[1] = voronoi_diagram(sites, count / 2);
+    for (size_t i = 0; i < count; i++)
+    {
+        owners[i] = i % 2;
+    }
+    DCEL_t merged;
+    dcel_init(&merged);
+    uint8_t is_merged = dcel_merge(&merged, pieces, 2, owners, count);
+    assert(! is_merged);
+    assert(0 == merged.half_edge_count);
+    dcel_destroy(&pieces[0]);
+    dcel_destroy(&pieces[1]);
+    dcel_destroy(&merged);
+}
+
+/**
+ * Returns whether the index is among the first count of the list
+ */
+static uint8_t list_contains(const size_t *list, size_t count, size_t index)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        if (list[i] == index) return 1;
+    }
+    return 0;
+}
+
+void test_dcel_diff()
+{
+    size_t count = 2000;
+    Point_t *points = malloc((count + 1) * sizeof(Point_t));
+    Point_t_ptr *sites = malloc((count + 1) * sizeof(Point_t_ptr));
+    for (size_t i = 0; i < count; i++)
+    {
+        point_init(&points[i], random_next(1000000), random_next(1000000));
+        sites[i] = &points[i];
+    }
+    DCEL_t before = voronoi_diagram(sites, count);
+
+    // The same sites give the same cells, even with the records in another order
+    DCEL_t after = voronoi_diagram(sites, count);
+    uint8_t is_reordered = dcel_reorder(&after, DCEL_CURVE_HILBERT);
+    assert(is_reordered);
+    DCEL_Diff_t diff;
+    uint8_t is_compared = dcel_diff(&diff, &before, &after);
+    assert(is_compared);
+    assert(0 == diff.added_count && 0 == diff.removed_count && 0 == diff.changed_count);
+    dcel_diff_destroy(&diff);
+    dcel_destroy(&after);
+
+    // Move one site, drop another and add a third. The drop shifts the indices of the later sites
+    point_init(&points[5], points[5].x + 3000, points[5].y);
+    memmove(&points[10], &points[11], (count - 11) * sizeof(Point_t));
+    point_init(&points[count - 1], 500000, 500000);
+    after = voronoi_diagram(sites, count);
+    is_compared = dcel_diff(&diff, &before, &after);
+    assert(is_compared);
+    assert(2 == diff.removed_count && 2 == diff.added_count);
+    assert(list_contains(diff.removed, 2, 5) && list_contains(diff.removed, 2, 10));
+    assert(list_contains(diff.added, 2, 5) && list_contains(diff.added, 2, count - 1));
+
+    // Exactly the neighbours of the cells that came or went change
+    Voronoi_Neighbours_t old_neighbours, new_neighbours;
+    voronoi_neighbours_init(&old_neighbours);
+    voronoi_neighbours_init(&new_neighbours);
+    uint8_t is_computed = voronoi_neighbours_compute(&old_neighbours, &before);
+    assert(is_computed);
+    is_computed = voronoi_neighbours_compute(&new_neighbours, &after);
+    assert(is_computed);
+    size_t expected = 0;
+    for (size_t i = 0; i < count; i++)
+    {
+        if (list_contains(diff.added, diff.added_count, i)) continue;
+        uint8_t is_touched = 0;
+        for (size_t k = new_neighbours.offsets[i]; k < new_neighbours.offsets[i + 1]; k++)
+        {
+            is_touched |= list_contains(diff.added, diff.added_count, new_neighbours.neighbours[k]);
+        }
+        // The same site in the earlier diagram, before the drop shifted it
+        size_t old = i < 10 ? i : i + 1;
+        for (size_t k = old_neighbours.offsets[old]; k < old_neighbours.offsets[old + 1]; k++)
+        {
+            is_touched |= list_contains(diff.removed, diff.removed_count, old_neighbours.neighbours[k]);
+        }
+        assert(is_touched == list_contains(diff.changed, diff.changed_count, i));
+        expected += is_touched;
+    }
+    assert(expected == diff.changed_count && expected > 0);
+    voronoi_neighbours_destroy(&old_neighbours);
+    voronoi_neighbours_destroy(&new_neighbours);
+    dcel_diff_destroy(&diff);
+    dcel_destroy(&after);
+    dcel_destroy(&before);
+    free(sites);
+    free(points);
+}
+
+static int compare_indices(const void *first, const void *second)
+{
+    uint32_t a = *(const uint32_t *) first;
+    uint32_t b = *(const uint32_t *) second;
+    return a < b ? -1 : a > b;
+}
+
+/**
+ * Checks that the tiled diagram has the cells of a single sweep: the same neighbours and vertices
+ */
+static void assert_tiled(Point_t_ptr *sites, size_t count, size_t tile_sites)
+{
+    DCEL_t reference = voronoi_diagram(sites, count);
+    DCEL_t tiled = voronoi_diagram_tiled(sites, count, tile_sites, NULL);
+    assert_dcel(&tiled);
+    assert(tiled.face_count == count);
+    assert(tiled.vertex_count == reference.vertex_count && tiled.half_edge_count == reference.half_edge_count);
+    Voronoi_Neighbours_t expected, actual;
+    voronoi_neighbours_init(&expected);
+    voronoi_neighbours_init(&actual);
+    uint8_t is_computed = voronoi_neighbours_compute(&expected, &reference);
+    assert(is_computed);
+    is_computed = voronoi_neighbours_compute(&actual, &tiled);
+    assert(is_computed);
+    assert(0 == memcmp(expected.offsets, actual.offsets, (count + 1) * sizeof(size_t)));
+    for (size_t i = 0; i < count; i++)
+    {
+        // The faces of the tiles start their walks elsewhere
+        size_t degree = expected.offsets[i + 1] - expected.offsets[i];
+        qsort(&expected.neighbours[expected.offsets[i]], degree, sizeof(uint32_t), compare_indices);
+        qsort(&actual.neighbours[actual.offsets[i]], degree, sizeof(uint32_t), compare_indices);
+        assert(0 == memcmp(&expected.neighbours[expected.offsets[i]], &actual.neighbours[actual.offsets[i]],
+                           degree * sizeof(uint32_t)));
+        Point_Real_t expected_centroid, actual_centroid;
+        uint8_t is_closed = voronoi_face_centroid(reference.faces[i], &expected_centroid);
+        uint8_t is_tiled_closed = voronoi_face_centroid(tiled.faces[i], &actual_centroid);
+        assert(is_closed == is_tiled_closed);
+        if (is_closed)
+        {
+            assert(fabs(expected_centroid.x - actual_centroid.x) < 1e-6);
+            assert(fabs(expected_centroid.y - actual_centroid.y) < 1e-6);
+        }
+    }
+    voronoi_neighbours_destroy(&expected);
+    voronoi_neighbours_destroy(&actual);
+    dcel_destroy(&tiled);
+    dcel_destroy(&reference);
+}
+
+void test_voronoi_tiled()
+{
+    size_t count = 20000;
+    Point_t *points = malloc(count * sizeof(Point_t));
+    Point_t_ptr *sites = malloc(count * sizeof(Point_t_ptr));
+    for (size_t i = 0; i < count; i++)
+    {
+        point_init(&points[i], random_next(1000000), random_next(1000000));
+        sites[i] = &points[i];
+    }
+    assert_tiled(sites, count, 500);
+
+    // Dense clusters in an empty plane, whose cells reach far beyond the first halo of their tiles
+    for (size_t i = 0; i < count; i++)
+    {
+        uint64_t cluster = random_next(5);
+        point_init(&points[i], 100000 + cluster * 190000 + random_next(5000), 100000 + cluster * cluster * 40000 +
+                                                                              random_next(5000));
+    }
+    assert_tiled(sites, count, 500);
+
+    // A grid, with four sites on every circle
+    for (size_t i = 0; i < count; i++)
+    {
+        point_init(&points[i], (i % 150) * 10, (i / 150) * 10);
+    }
+    assert_tiled(sites, count, 500);
+
+    // The clip polygon applies to the merged diagram
+    Point_Real_t corners[4];
+    Voronoi_Clip_t clip = voronoi_clip_rectangle(corners, 100, 100, 1200, 1000);
+    Voronoi_Options_t options = {NULL, &clip};
+    DCEL_t tiled = voronoi_diagram_tiled(sites, count, 500, &options);
+    assert_dcel(&tiled);
+    assert(fabs(closed_area(&tiled) - 1100 * 900) < 1e-6);
+    dcel_destroy(&tiled);
+    free(sites);
+    free(points);
+}
+
+void test_voronoi_offset()
+{
+    // A small cluster far from the origin, where the squares of the coordinates cancel each other out. Shifted by
+    // 1e9 the sites must have the same neighbours as near the origin
+    size_t count = 100;
+    Point_t points[100], shifted[100];
+    Point_t_ptr sites[100], shifted_sites[100];
+    for (size_t i = 0; i < count; i++)
+    {
+        point_init(&points[i], random_next(200), random_next(200));
+        point_init(&shifted[i], points[i].x + 1000000000, points[i].y + 1000000000);
+        sites[i] = &points[i];
+        shifted_sites[i] = &shifted[i];
+    }
+    DCEL_t reference = voronoi_diagram(sites, count);
+    DCEL_t dcel = voronoi_diagram(shifted_sites, count);
+    // The signed areas of assert_dcel cancel out just the same this far out, so only the topology is compared
+    assert(dcel.face_count == count);
+    assert(dcel.vertex_count == reference.vertex_count && dcel.half_edge_count == reference.half_edge_count);
+    Voronoi_Neighbours_t expected, actual;
+    voronoi_neighbours_init(&expected);
+    voronoi_neighbours_init(&actual);
+    uint8_t is_computed = voronoi_neighbours_compute(&expected, &reference);
+    assert(is_computed);
+    is_computed = voronoi_neighbours_compute(&actual, &dcel);
+    assert(is_computed);
+    assert(0 == memcmp(expected.offsets, actual.offsets, (count + 1) * sizeof(size_t)));
+    for (size_t i = 0; i < count; i++)
+    {
+        size_t degree = expected.offsets[i + 1] - expected.offsets[i];
+        qsort(&expected.neighbours[expected.offsets[i]], degree, sizeof(uint32_t), compare_indices);
+        qsort(&actual.neighbours[actual.offsets[i]], degree, sizeof(uint32_t), compare_indices);
+        assert(0 == memcmp(&expected.neighbours[expected.offsets[i]], &actual.neighbours[actual.offsets[i]],
+                           degree * sizeof(uint32_t)));
+    }
+    voronoi_neighbours_destroy(&expected);
+    voronoi_neighbours_destroy(&actual);
+    dcel_destroy(&dcel);
+    dcel_destroy(&reference);
+}
+
+#ifdef VORONOI_WEIGHTED
+/**
+ * Computes the weighted distance from the site to the position, see Point_t
+ */
+static double weighted_distance(Point_t *site, Point_Real_t position)
+{
+    return hypot((double) site->x - position.x, (double) site->y - position.y) - site->weight;
+}
+
+void test_voronoi_weighted()
+{
+    // The light site next to the heavy one lies in the cell of the heavy one, which hides it
+    Point_t points[400];
+    Point_t_ptr sites[400];
+    point_init_weighted(&points[0], 0, 0, 0);
+    point_init_weighted(&points[1], 100, 0, 0);
+    point_init_weighted(&points[2], 50, 80, 10);
+    point_init_weighted(&points[3], 51, 79, 0);
+    for (size_t i = 0; i < 4; i++)
+    {
+        sites[i] = &points[i];
+    }
+    DCEL_t dcel = voronoi_diagram(sites, 4);
+    assert(dcel.vertex_count == 1);
+    assert(NULL == dcel.faces[3]->inc_edge);
+    // The vertex is closer to the heavy site than to the other two
+    Point_Real_t vertex = dcel.vertices[0]->position;
+    assert(hypot(vertex.x - 50, vertex.y - 80) > hypot(vertex.x, vertex.y) + 9);
+    assert_dcel(&dcel);
+    dcel_destroy(&dcel);
+
+    size_t count = 400;
+    for (size_t i = 0; i < count; i++)
+    {
+        point_init_weighted(&points[i], random_next(10000), random_next(10000), (double) random_next(500));
+        sites[i] = &points[i];
+    }
+    dcel = voronoi_diagram(sites, count);
+    assert(dcel.face_count == count);
+    assert_dcel(&dcel);
+    size_t hidden = 0;
+    for (size_t i = 0; i < count; i++)
+    {
+        // A site is hidden if another site is closer to it than itself, weighted
+        Point_Real_t site = position(points, (uint32_t) i);
+        uint8_t is_hidden = 0;
+        for (size_t j = 0; j < count; j++)
+        {
+            is_hidden |= j != i && weighted_distance(&points[j], site) < -points[i].weight;
+        }
+        assert(is_hidden == (NULL == dcel.faces[i]->inc_edge));
+        hidden += is_hidden;
+    }
+    assert(hidden > 0 && hidden < count / 2);
+    // Every vertex has the same weighted distance to the sites around it and no site is closer
+    for (size_t i = 0; i < dcel.half_edge_count; i++)
+    {
+        DCEL_HalfEdge_ptr_t half_edge = dcel.half_edges[i];
+        if (! half_edge->origin) continue;
+        Point_Real_t vertex = half_edge->origin->position;
+        double distance = weighted_distance(&half_edge->inc_face->site, vertex);
+        for (size_t j = 0; j < count; j++)
+        {
+            assert(weighted_distance(&points[j], vertex) > distance - 1e-6);
+        }
+    }
+    dcel_destroy(&dcel);
+
+    // The clipped cells cover the rectangle
+    Point_Real_t corners[4];
+    Voronoi_Clip_t clip = voronoi_clip_rectangle(corners, -1000, -1000, 11000, 11000);
+    Voronoi_Options_t options = {NULL, &clip};
+    dcel = voronoi_diagram_with_options(sites, count, &options);
+    assert_dcel(&dcel);
+    assert(fabs(closed_area(&dcel) - 12000.0 * 12000.0) < 1e-3);
+    dcel_destroy(&dcel);
+}
+#endif
+
+int main(int argc, char *argv[])
+{
+    test_voronoi_square();
+    test_voronoi_random();
+    test_voronoi_duplicates();
+    test_voronoi_clip();
+    test_voronoi_lloyd();
+    test_voronoi_workspace();
+    test_voronoi_cells();
+    test_voronoi_neighbours();
+    test_voronoi_stats();
+    test_voronoi_trace();
+    test_voronoi_radix_queue();
+    test_voronoi_sites();
+    test_dcel_reorder();
+    test_dcel_merge();
+    test_dcel_diff();
+    test_voronoi_tiled();
+#ifdef VORONOI_WEIGHTED
+    test_voronoi_weighted();
+#endif
+    test_voronoi_offset();
+}
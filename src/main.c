@@ -1,10 +1,310 @@
+//
+// Computes the Voronoi diagram of the sites of a file and writes it to another file
+//
+// Usage: voronoi [options] <input> <output>
+//
+// The output is written to the standard output if its path is -, the time spent in each phase to the standard error.
+//
+
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+#include "Voronoi.h"
+#include "VoronoiInput.h"
+#include "VoronoiOutput.h"
+#include "VoronoiTiles.h"
+#include "VoronoiTrace.h"
+
+/**
+ * The contents of the output file
+ */
+typedef enum {
+    VORONOI_WRITE_EDGES, // See voronoi_output_edges
+    VORONOI_WRITE_DCEL, // See voronoi_output_dcel
+    VORONOI_WRITE_WKT, // See voronoi_output_wkt
+    VORONOI_WRITE_GEOJSON, // See voronoi_output_geojson
+    VORONOI_WRITE_DELAUNAY // See voronoi_output_delaunay
+} Voronoi_Write_t;
+
+/**
+ * The options of the command line
+ */
+typedef struct {
+    const char *input;
+    const char *output;
+    Voronoi_Input_Format_t format;
+    uint8_t has_format; // Whether format was given, otherwise it follows from the extension of the input
+    Voronoi_Write_t write;
+    uint8_t is_tiled; // Whether the diagram is computed tile by tile, see voronoi_diagram_tiled
+    size_t tile_sites; // The number of sites per tile, 0 for the default
+    Voronoi_Queue_t queue;
+    int threads; // The number of OpenMP threads, 0 for the default of the runtime
+    uint8_t has_clip; // Whether the diagram is clipped to clip_box
+    double clip_box[4]; // min_x, min_y, max_x, max_y
+    uint8_t has_reorder; // Whether the records are reordered along reorder before they are written
+    DCEL_Curve_t reorder;
+    const char *trace; // The path of the trace file, NULL if none is written
+} Voronoi_Command_t;
+
+static void usage(FILE *file)
+{
+    fprintf(file,
+            "Usage: voronoi [options] <input> <output>\n"
+            "\n"
+            "Computes the Voronoi diagram of the sites in input and writes it to output, - for the standard output.\n"
+            "The time spent in each phase is printed to the standard error.\n"
+            "\n"
+            "  --format text|csv|binary     the format of input, guessed from its extension by default:\n"
+            "                               .csv is csv, .bin is binary and anything else is text\n"
+            "  --write edges|dcel|wkt|geojson|delaunay\n"
+            "                               what to write, the edges as CSV by default\n"
+            "  --engine sweep|tiled         the algorithm, Fortune's sweep by default or the sweep tile by tile,\n"
+            "                               which cannot write delaunay\n"
+            "  --tile-sites <count>         the number of sites per tile of the tiled engine\n"
+            "  --queue heap|radix           the event queue of the sweep, heap by default\n"
+            "  --threads <count>            the number of threads of the parallel phases\n"
+            "  --clip <min_x,min_y,max_x,max_y>\n"
+            "                               clips the diagram to the rectangle\n"
+            "  --reorder morton|hilbert     reorders the records of the diagram along the curve before writing them\n"
+            "  --trace <path>               writes the phases as a Chrome trace\n"
+            "  --help                       prints this message\n");
+}
+
+/**
+ * Parses the value of an option into the command
+ *
+ * @param command the command
+ * @param option the name of the option
+ * @param value the value of the option
+ * @return 1 on success, 0 if the option or the value is unknown
+ */
+static uint8_t parse_option(Voronoi_Command_t *command, const char *option, const char *value)
+{
+    if (0 == strcmp(option, "--format"))
+    {
+        command->has_format = 1;
+        if (0 == strcmp(value, "text")) command->format = VORONOI_INPUT_TEXT;
+        else if (0 == strcmp(value, "csv")) command->format = VORONOI_INPUT_CSV;
+        else if (0 == strcmp(value, "binary")) command->format = VORONOI_INPUT_BINARY;
+        else return 0;
+    }
+    else if (0 == strcmp(option, "--write"))
+    {
+        if (0 == strcmp(value, "edges")) command->write = VORONOI_WRITE_EDGES;
+        else if (0 == strcmp(value, "dcel")) command->write = VORONOI_WRITE_DCEL;
+        else if (0 == strcmp(value, "wkt")) command->write = VORONOI_WRITE_WKT;
+        else if (0 == strcmp(value, "geojson")) command->write = VORONOI_WRITE_GEOJSON;
+        else if (0 == strcmp(value, "delaunay")) command->write = VORONOI_WRITE_DELAUNAY;
+        else return 0;
+    }
+    else if (0 == strcmp(option, "--engine"))
+    {
+        if (0 == strcmp(value, "sweep")) command->is_tiled = 0;
+        else if (0 == strcmp(value, "tiled")) command->is_tiled = 1;
+        else return 0;
+    }
+    else if (0 == strcmp(option, "--tile-sites"))
+    {
+        char *end;
+        long long tile_sites = strtoll(value, &end, 10);
+        if (*end != '\0' || tile_sites < 1) return 0;
+        command->tile_sites = (size_t) tile_sites;
+    }
+    else if (0 == strcmp(option, "--queue"))
+    {
+        if (0 == strcmp(value, "heap")) command->queue = VORONOI_QUEUE_HEAP;
+        else if (0 == strcmp(value, "radix")) command->queue = VORONOI_QUEUE_RADIX;
+        else return 0;
+    }
+    else if (0 == strcmp(option, "--threads"))
+    {
+        char *end;
+        long threads = strtol(value, &end, 10);
+        if (*end != '\0' || threads < 1) return 0;
+        command->threads = (int) threads;
+    }
+    else if (0 == strcmp(option, "--clip"))
+    {
+        double *box = command->clip_box;
+        int consumed = 0;
+        if (4 != sscanf(value, "%lf,%lf,%lf,%lf%n", &box[0], &box[1], &box[2], &box[3], &consumed)) return 0;
+        if (value[consumed] != '\0' || box[0] >= box[2] || box[1] >= box[3]) return 0;
+        command->has_clip = 1;
+    }
+    else if (0 == strcmp(option, "--reorder"))
+    {
+        command->has_reorder = 1;
+        if (0 == strcmp(value, "morton")) command->reorder = DCEL_CURVE_MORTON;
+        else if (0 == strcmp(value, "hilbert")) command->reorder = DCEL_CURVE_HILBERT;
+        else return 0;
+    }
+    else if (0 == strcmp(option, "--trace"))
+    {
+        command->trace = value;
+    }
+    else
+    {
+        return 0;
+    }
+    return 1;
+}
+
+/**
+ * Writes the diagram or the triangulation as the command asks
+ *
+ * @param command the command
+ * @param dcel the diagram
+ * @param delaunay the triangulation
+ * @return 1 on success, 0 if the output could not be written
+ */
+static uint8_t write_output(const Voronoi_Command_t *command, const DCEL_t *dcel, const Delaunay_t *delaunay)
+{
+    uint8_t to_stdout = 0 == strcmp(command->output, "-");
+    FILE *file = to_stdout ? stdout : fopen(command->output, "w");
+    if (NULL == file) return 0;
+    uint8_t success;
+    switch (command->write)
+    {
+        case VORONOI_WRITE_DCEL:
+            success = voronoi_output_dcel(file, dcel);
+            break;
+        case VORONOI_WRITE_WKT:
+            success = voronoi_output_wkt(file, dcel);
+            break;
+        case VORONOI_WRITE_GEOJSON:
+            success = voronoi_output_geojson(file, dcel);
+            break;
+        case VORONOI_WRITE_DELAUNAY:
+            success = voronoi_output_delaunay(file, delaunay);
+            break;
+        default:
+            success = voronoi_output_edges(file, dcel);
+            break;
+    }
+    success &= 0 == fflush(file);
+    if (! to_stdout) success &= 0 == fclose(file);
+    return success;
+}
 
 int main(int argc, char *argv[])
 {
-    #pragma omp parallel default(none)
+    Voronoi_Command_t command;
+    memset(&command, 0, sizeof(Voronoi_Command_t));
+    for (int i = 1; i < argc; i++)
+    {
+        if (0 == strcmp(argv[i], "--help"))
+        {
+            usage(stdout);
+            return EXIT_SUCCESS;
+        }
+        if (0 == strncmp(argv[i], "--", 2))
+        {
+            if (i + 1 == argc || ! parse_option(&command, argv[i], argv[i + 1]))
+            {
+                fprintf(stderr, "voronoi: invalid option %s%s%s\n", argv[i], i + 1 < argc ? " " : "",
+                        i + 1 < argc ? argv[i + 1] : "");
+                usage(stderr);
+                return EXIT_FAILURE;
+            }
+            i++;
+        }
+        else if (NULL == command.input) command.input = argv[i];
+        else if (NULL == command.output) command.output = argv[i];
+        else
+        {
+            fprintf(stderr, "voronoi: unexpected argument %s\n", argv[i]);
+            return EXIT_FAILURE;
+        }
+    }
+    if (NULL == command.output)
+    {
+        usage(stderr);
+        return EXIT_FAILURE;
+    }
+    if (command.is_tiled && VORONOI_WRITE_DELAUNAY == command.write)
+    {
+        fprintf(stderr, "voronoi: the tiled engine cannot write delaunay\n");
+        return EXIT_FAILURE;
+    }
+#ifdef _OPENMP
+    if (command.threads) omp_set_num_threads(command.threads);
+#endif
+    if (! command.has_format) command.format = voronoi_input_format(command.input);
+    // The phases are timed through the trace, which costs two clock reads per phase
+    if (! voronoi_trace_start())
+    {
+        fprintf(stderr, "voronoi: not enough memory\n");
+        return EXIT_FAILURE;
+    }
+
+    voronoi_trace_begin("total");
+    voronoi_trace_begin("read");
+    Voronoi_Input_t input;
+    if (! voronoi_input_read(&input, command.input, command.format))
+    {
+#ifdef VORONOI_WEIGHTED
+        const char *expected = "two unsigned integers and an optional unsigned weight";
+#else
+        const char *expected = "two unsigned integers";
+#endif
+        if (input.line) fprintf(stderr, "voronoi: %s:%zu: expected %s\n", command.input, input.line, expected);
+        else fprintf(stderr, "voronoi: could not read %s\n", command.input);
+        return EXIT_FAILURE;
+    }
+    voronoi_trace_end("read");
+
+    voronoi_trace_begin("diagram");
+    Delaunay_t delaunay;
+    delaunay_init(&delaunay);
+    Point_Real_t corners[4];
+    Voronoi_Clip_t clip;
+    Voronoi_Options_t options;
+    memset(&options, 0, sizeof(Voronoi_Options_t));
+    options.queue = command.queue;
+    if (VORONOI_WRITE_DELAUNAY == command.write) options.delaunay = &delaunay;
+    if (command.has_clip)
+    {
+        clip = voronoi_clip_rectangle(corners, command.clip_box[0], command.clip_box[1], command.clip_box[2],
+                                      command.clip_box[3]);
+        options.clip = &clip;
+    }
+    DCEL_t dcel = command.is_tiled ? voronoi_diagram_tiled(input.sites, input.count, command.tile_sites, &options)
+                                   : voronoi_diagram_with_options(input.sites, input.count, &options);
+    voronoi_trace_end("diagram");
+
+    if (command.has_reorder)
+    {
+        voronoi_trace_begin("reorder");
+        if (! dcel_reorder(&dcel, command.reorder))
+        {
+            fprintf(stderr, "voronoi: not enough memory to reorder the diagram\n");
+            return EXIT_FAILURE;
+        }
+        voronoi_trace_end("reorder");
+    }
+
+    voronoi_trace_begin("write");
+    if (! write_output(&command, &dcel, &delaunay))
+    {
+        fprintf(stderr, "voronoi: could not write %s\n", command.output);
+        return EXIT_FAILURE;
+    }
+    voronoi_trace_end("write");
+    voronoi_trace_end("total");
+
+    fprintf(stderr, "%zu sites, %zu vertices, %zu half-edges, %zu triangles\n", input.count, dcel.vertex_count,
+            dcel.half_edge_count, delaunay.count);
+    voronoi_trace_summary(stderr);
+    if (command.trace && ! voronoi_trace_write(command.trace))
     {
-        printf("Hello, World!\n");
+        fprintf(stderr, "voronoi: could not write the trace to %s\n", command.trace);
+        return EXIT_FAILURE;
     }
-    return 0;
+    dcel_destroy(&dcel);
+    delaunay_destroy(&delaunay);
+    voronoi_input_destroy(&input);
+    return EXIT_SUCCESS;
 }